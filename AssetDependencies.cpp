@@ -0,0 +1,147 @@
+#include "AssetDependencies.h"
+#include "FileWatcher.h"
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+	// FNV-1a over the whole file, never 0 for one that exists
+	unsigned long long Fingerprint(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return 0;
+
+		unsigned long long hash = 14695981039346656037ull;
+		char buffer[64 * 1024];
+		while (file)
+		{
+			file.read(buffer, sizeof(buffer));
+			std::streamsize count = file.gcount();
+			for (std::streamsize i = 0; i < count; i++)
+			{
+				hash ^= (unsigned char)buffer[i];
+				hash *= 1099511628211ull;
+			}
+		}
+		return hash ? hash : 1;
+	}
+
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of('/');
+		return slash == std::string::npos ? "." : path.substr(0, slash);
+	}
+
+	// The name in an #include line, "file" or <file>, if the line is one
+	bool ParseInclude(const std::string& line, std::string& name)
+	{
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 1, "#") != 0)
+			return false;
+		start = line.find_first_not_of(" \t", start + 1);
+		if (start == std::string::npos || line.compare(start, 7, "include") != 0)
+			return false;
+
+		size_t open = line.find_first_of("\"<", start + 7);
+		if (open == std::string::npos)
+			return false;
+		size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+		if (close == std::string::npos)
+			return false;
+
+		name = line.substr(open + 1, close - open - 1);
+		return true;
+	}
+}
+
+AssetId AssetDependencies::Add(const std::string& name, const std::vector<std::string>& files)
+{
+	AssetId asset = (AssetId)assets.size();
+	assets.push_back({ name, {} });
+	SetFiles(asset, files);
+	return asset;
+}
+
+void AssetDependencies::SetFiles(AssetId asset, const std::vector<std::string>& files)
+{
+	for (const std::string& file : assets[asset].Files)
+	{
+		std::vector<AssetId>& fileUsers = users[file];
+		fileUsers.erase(std::remove(fileUsers.begin(), fileUsers.end(), asset), fileUsers.end());
+	}
+
+	//files already known keep their fingerprint, so a change not yet reported still is
+	assets[asset].Files.clear();
+	for (const std::string& path : files)
+	{
+		std::string file = FileWatcher::NormalizePath(path);
+		std::vector<AssetId>& fileUsers = users[file];
+		if (std::find(fileUsers.begin(), fileUsers.end(), asset) != fileUsers.end())
+			continue;
+
+		fileUsers.push_back(asset);
+		assets[asset].Files.push_back(file);
+		if (fingerprints.find(file) == fingerprints.end())
+			fingerprints[file] = Fingerprint(file);
+	}
+}
+
+void AssetDependencies::GetDirectories(std::vector<std::string>& directories)
+{
+	for (auto& file : users)
+	{
+		std::string directory = GetDirectory(file.first);
+		if (!file.second.empty() && std::find(directories.begin(), directories.end(), directory) == directories.end())
+			directories.push_back(directory);
+	}
+	std::sort(directories.begin(), directories.end());
+}
+
+void AssetDependencies::GetChanged(const std::vector<std::string>& changedFiles, std::vector<AssetId>& changed)
+{
+	std::vector<bool> marked(assets.size(), false);
+	for (const std::string& path : changedFiles)
+	{
+		std::string file = FileWatcher::NormalizePath(path);
+		auto fileUsers = users.find(file);
+		if (fileUsers == users.end() || fileUsers->second.empty())
+			continue;
+
+		unsigned long long fingerprint = Fingerprint(file);
+		if (fingerprint == fingerprints[file])
+			continue;
+
+		fingerprints[file] = fingerprint;
+		for (AssetId asset : fileUsers->second)
+			marked[asset] = true;
+	}
+
+	for (AssetId asset = 0; asset < (AssetId)assets.size(); asset++)
+	{
+		if (marked[asset])
+			changed.push_back(asset);
+	}
+}
+
+void AssetDependencies::GetShaderFiles(const std::string& shaderPath, std::vector<std::string>& files)
+{
+	//breadth first, each file once, so include cycles end
+	size_t first = files.size();
+	files.push_back(FileWatcher::NormalizePath(shaderPath));
+	for (size_t next = first; next < files.size(); next++)
+	{
+		std::ifstream source(files[next]);
+		std::string line;
+		std::string name;
+		while (std::getline(source, line))
+		{
+			if (!ParseInclude(line, name))
+				continue;
+
+			std::string include = FileWatcher::NormalizePath(GetDirectory(files[next]) + "/" + name);
+			if (std::find(files.begin() + first, files.end(), include) == files.end())
+				files.push_back(include);
+		}
+	}
+}
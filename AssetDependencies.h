@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef unsigned int AssetId;
+
+// --------------------------------------------------------
+// Which files each reloadable asset is built from, and so
+// which assets a changed file affects. A file can feed
+// several assets (an include shared by shaders, one OBJ
+// behind two meshes) and an asset several files (a shader
+// and its includes, a packed map and its source PNGs).
+// Every file's contents are fingerprinted, so a save that
+// changes nothing reloads nothing. Paths are compared as
+// FileWatcher::NormalizePath gives them. Everything is for
+// one thread.
+// --------------------------------------------------------
+class AssetDependencies
+{
+public:
+	AssetId Add(const std::string& name, const std::vector<std::string>& files);
+
+	//Replaces the asset's files, as when a shader's includes change
+	void SetFiles(AssetId asset, const std::vector<std::string>& files);
+
+	const std::string& GetName(AssetId asset) { return assets[asset].Name; }
+	unsigned int GetCount() { return (unsigned int)assets.size(); }
+
+	//Every directory holding a file some asset uses, for watching
+	void GetDirectories(std::vector<std::string>& directories);
+
+	//Appends the assets with a file among changedFiles whose contents differ
+	//from last time, each once and in the order they were added
+	void GetChanged(const std::vector<std::string>& changedFiles, std::vector<AssetId>& changed);
+
+	//The shader source followed by every file it includes, directly or not,
+	//each found relative to the file including it. Includes that don't exist
+	//yet are listed too, so creating one is noticed.
+	static void GetShaderFiles(const std::string& shaderPath, std::vector<std::string>& files);
+
+private:
+	struct Asset
+	{
+		std::string Name;
+		std::vector<std::string> Files;
+	};
+
+	std::vector<Asset> assets;
+	std::unordered_map<std::string, std::vector<AssetId>> users; //by file
+	std::unordered_map<std::string, unsigned long long> fingerprints; //by file, 0 while it doesn't exist
+};
@@ -0,0 +1,159 @@
+#include "AssetLoader.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+AssetLoader::AssetLoader(std::shared_ptr<JobSystem> jobSystem)
+	: jobSystem(jobSystem), start(std::chrono::steady_clock::now()), firstFrame(-1.0), queuedCount(0), uploadedCount(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	//reads write into their requests, so those have to outlive them
+	if (jobSystem)
+	{
+		for (auto& request : requests)
+			jobSystem->Wait(&request->Counter);
+	}
+}
+
+AssetHandle AssetLoader::Queue(const std::string& name, const AssetRead& read)
+{
+	AssetHandle handle = (AssetHandle)requests.size();
+	requests.push_back(std::make_unique<Request>());
+	Request& request = *requests.back();
+	request.Name = name;
+	request.Read = read;
+	request.Uploaded = false;
+	request.Timing = {};
+	request.Timing.Queued = Now();
+	queuedCount++;
+
+	//the vector may grow while the read runs, so it gets the request itself
+	Request* queued = &request;
+	if (jobSystem)
+		jobSystem->Run([this, queued, handle]() { RunRead(*queued, handle); }, &request.Counter);
+	else
+		RunRead(request, handle);
+	return handle;
+}
+
+unsigned int AssetLoader::UploadReady(unsigned int maxUploads)
+{
+	std::vector<AssetHandle> uploads;
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		unsigned int count = std::min(maxUploads, (unsigned int)ready.size());
+		uploads.assign(ready.begin(), ready.begin() + count);
+		ready.erase(ready.begin(), ready.begin() + count);
+	}
+
+	for (AssetHandle handle : uploads)
+		RunUpload(handle);
+	return (unsigned int)uploads.size();
+}
+
+void AssetLoader::Finish(AssetHandle handle)
+{
+	Request& request = *requests[handle];
+	if (request.Uploaded)
+		return;
+
+	if (jobSystem)
+		jobSystem->Wait(&request.Counter);
+
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.erase(std::remove(ready.begin(), ready.end(), handle), ready.end());
+	}
+	RunUpload(handle);
+}
+
+void AssetLoader::FinishAll()
+{
+	for (AssetHandle handle = 0; handle < requests.size(); handle++)
+		Finish(handle);
+}
+
+void AssetLoader::MarkFirstFrame()
+{
+	if (firstFrame < 0.0)
+		firstFrame = Now();
+}
+
+void AssetLoader::WriteReport(std::ostream& out)
+{
+	char line[256];
+	snprintf(line, sizeof(line), "Startup asset loading: %u assets, %s\n", GetQueuedCount(),
+		jobSystem ? "reads on the job system" : "serial on one thread");
+	out << line;
+
+	//readers numbered in the order they first show up
+	std::vector<std::thread::id> threads;
+	double readWork = 0.0;
+	double uploadWork = 0.0;
+	double lastUpload = 0.0;
+	snprintf(line, sizeof(line), "%-28s %9s %9s %9s %9s %9s %7s\n", "Asset", "Queued", "Read at", "Read ms", "Upload ms", "Ready at", "Thread");
+	out << line;
+	for (auto& request : requests)
+	{
+		const AssetTiming& timing = request->Timing;
+		auto thread = std::find(threads.begin(), threads.end(), timing.ReadThread);
+		if (thread == threads.end())
+			thread = threads.insert(threads.end(), timing.ReadThread);
+
+		readWork += timing.ReadEnd - timing.ReadStart;
+		uploadWork += timing.UploadEnd - timing.UploadStart;
+		lastUpload = std::max(lastUpload, timing.UploadEnd);
+		snprintf(line, sizeof(line), "%-28s %9.2f %9.2f %9.2f %9.2f %9.2f %7u\n", request->Name.c_str(), timing.Queued,
+			timing.ReadStart, timing.ReadEnd - timing.ReadStart, timing.UploadEnd - timing.UploadStart, timing.UploadEnd,
+			(unsigned int)(thread - threads.begin()));
+		out << line;
+	}
+
+	snprintf(line, sizeof(line), "Read work: %.2f ms on %u threads, upload work: %.2f ms\n", readWork, (unsigned int)threads.size(), uploadWork);
+	out << line;
+	snprintf(line, sizeof(line), "Serial estimate: %.2f ms, everything loaded at: %.2f ms\n", readWork + uploadWork, lastUpload);
+	out << line;
+	if (firstFrame >= 0.0)
+	{
+		snprintf(line, sizeof(line), "First frame at: %.2f ms\n", firstFrame);
+		out << line;
+	}
+}
+
+double AssetLoader::Now()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AssetLoader::RunRead(Request& request, AssetHandle handle)
+{
+	PROFILE_SCOPE("Asset read");
+	request.Timing.ReadThread = std::this_thread::get_id();
+	request.Timing.ReadStart = Now();
+	request.Upload = request.Read();
+	request.Read = AssetRead();
+	request.Timing.ReadEnd = Now();
+
+	std::lock_guard<std::mutex> lock(readyMutex);
+	ready.push_back(handle);
+}
+
+void AssetLoader::RunUpload(AssetHandle handle)
+{
+	PROFILE_SCOPE("Asset upload");
+	Request& request = *requests[handle];
+	if (request.Uploaded)
+		return;
+
+	request.Timing.UploadStart = Now();
+	if (request.Upload)
+		request.Upload();
+	request.Upload = AssetUpload();
+	request.Timing.UploadEnd = Now();
+
+	request.Uploaded = true;
+	uploadedCount++;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+// The thread owning the device's half of a load: creates
+// resources from what the read produced
+typedef std::function<void()> AssetUpload;
+
+// The worker's half: reads files and decodes them, returning the
+// upload to run afterwards, or an empty one if there was nothing
+typedef std::function<AssetUpload()> AssetRead;
+
+typedef unsigned int AssetHandle;
+
+// When each part of a load ran, in ms since the loader was created
+struct AssetTiming
+{
+	double Queued;
+	double ReadStart;
+	double ReadEnd;
+	double UploadStart;
+	double UploadEnd;
+	std::thread::id ReadThread;
+};
+
+// --------------------------------------------------------
+// Loads assets in two halves: reads run as jobs, so files
+// are read and decoded on every core at once, and their
+// uploads are handed back to the owning thread, which
+// creates device resources a few at a time so frames keep
+// going while loading continues. Without a job system every
+// read runs as it's queued, which is the serial baseline the
+// timeline report is compared against. Queue and the upload
+// calls are for one thread at a time.
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	AssetLoader(std::shared_ptr<JobSystem> jobSystem);
+	~AssetLoader(); //waits for reads in flight, dropping their uploads
+
+	//Null when loading serially; reads can split their own work over it
+	JobSystem* GetJobSystem() { return jobSystem.get(); }
+
+	AssetHandle Queue(const std::string& name, const AssetRead& read);
+
+	//Runs up to maxUploads uploads whose reads are done, in the order
+	//they finished, and returns how many ran
+	unsigned int UploadReady(unsigned int maxUploads);
+
+	//Waits for the asset's read, helping with other jobs meanwhile,
+	//then uploads it if that hasn't happened yet
+	void Finish(AssetHandle handle);
+	void FinishAll();
+
+	//Either thread can read these, as the UI does while reloads queue
+	unsigned int GetQueuedCount() { return queuedCount.load(); }
+	unsigned int GetUploadedCount() { return uploadedCount.load(); }
+	bool IsDone() { return GetUploadedCount() == GetQueuedCount(); }
+
+	//The first call is reported as the first frame, the rest are ignored
+	void MarkFirstFrame();
+
+	//Every asset's timeline, then the total read work (what serial
+	//loading costs) against the time until everything was loaded
+	void WriteReport(std::ostream& out);
+
+private:
+	struct Request
+	{
+		std::string Name;
+		AssetRead Read;
+		AssetUpload Upload;
+		JobCounter Counter;
+		bool Uploaded;
+		AssetTiming Timing;
+	};
+
+	std::shared_ptr<JobSystem> jobSystem;
+	std::chrono::steady_clock::time_point start;
+	double firstFrame;
+
+	std::vector<std::unique_ptr<Request>> requests;
+	std::atomic<unsigned int> queuedCount;
+	std::atomic<unsigned int> uploadedCount;
+
+	//reads that finished, waiting for their uploads
+	std::mutex readyMutex;
+	std::vector<AssetHandle> ready;
+
+	double Now();
+	void RunRead(Request& request, AssetHandle handle);
+	void RunUpload(AssetHandle handle);
+};
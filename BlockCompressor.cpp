@@ -0,0 +1,721 @@
+#include "BlockCompressor.h"
+#include "DdsFile.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSOR_SSE2
+#endif
+
+// Block rows per job; a 1024 texture is 256 rows
+#define BLOCK_ROWS_PER_JOB 4
+
+// Rounds of index picking and least squares refitting per block
+#define BLOCK_REFINE_ITERATIONS 3
+
+namespace
+{
+	// A block's texels split by channel, so four texels sit in one register
+	struct BlockTexels
+	{
+		float Channels[4][16];
+	};
+
+	// Where each index lies between the endpoints, 0 at the first
+	const float bc1IndexPositions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	const float bc4IndexPositions[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+	const int bc7IndexWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// How much each channel counts toward the error
+	const float rgbWeights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+	const float rgbaWeights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	float Clamp255(float value)
+	{
+		return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+	}
+
+	// Picks the closest palette entry for every texel and returns the summed
+	// weighted squared error. Zero weight channels are skipped.
+	float SelectIndices(const BlockTexels& texels, const float (*palette)[4], unsigned int paletteSize, const float* weights, unsigned char* indices)
+	{
+#ifdef BLOCK_COMPRESSOR_SSE2
+		__m128 total = _mm_setzero_ps();
+		for (unsigned int group = 0; group < 16; group += 4)
+		{
+			__m128 channels[4];
+			for (unsigned int c = 0; c < 4; c++)
+				channels[c] = _mm_loadu_ps(&texels.Channels[c][group]);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (unsigned int i = 0; i < paletteSize; i++)
+			{
+				__m128 error = _mm_setzero_ps();
+				for (unsigned int c = 0; c < 4; c++)
+				{
+					if (weights[c] == 0.0f)
+						continue;
+					__m128 difference = _mm_sub_ps(channels[c], _mm_set1_ps(palette[i][c]));
+					error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(weights[c])));
+				}
+
+				//strictly closer, so ties keep the lower index like the scalar path
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, best));
+				best = _mm_min_ps(error, best);
+				bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32((int)i)));
+			}
+			total = _mm_add_ps(total, best);
+
+			int picked[4];
+			_mm_storeu_si128((__m128i*)picked, bestIndex);
+			for (unsigned int k = 0; k < 4; k++)
+				indices[group + k] = (unsigned char)picked[k];
+		}
+
+		float sums[4];
+		_mm_storeu_ps(sums, total);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+		float total = 0.0f;
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			float best = FLT_MAX;
+			for (unsigned int i = 0; i < paletteSize; i++)
+			{
+				float error = 0.0f;
+				for (unsigned int c = 0; c < 4; c++)
+				{
+					float difference = texels.Channels[c][t] - palette[i][c];
+					error += difference * difference * weights[c];
+				}
+				if (error < best)
+				{
+					best = error;
+					indices[t] = (unsigned char)i;
+				}
+			}
+			total += best;
+		}
+		return total;
+#endif
+	}
+
+	// Endpoints at the ends of the texels' spread along their principal axis
+	void FitEndpoints(const BlockTexels& texels, const float* weights, float* start, float* end)
+	{
+		float mean[4] = {};
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			for (unsigned int t = 0; t < 16; t++)
+				mean[c] += texels.Channels[c][t];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		float axis[4] = {};
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			float offset[4];
+			for (unsigned int c = 0; c < 4; c++)
+				offset[c] = (texels.Channels[c][t] - mean[c]) * (weights[c] > 0.0f ? 1.0f : 0.0f);
+			for (unsigned int i = 0; i < 4; i++)
+				for (unsigned int j = 0; j < 4; j++)
+					covariance[i][j] += offset[i] * offset[j];
+		}
+
+		//power iteration, starting from the widest channel
+		for (unsigned int c = 0; c < 4; c++)
+			axis[c] = covariance[c][c];
+		for (unsigned int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				for (unsigned int j = 0; j < 4; j++)
+					next[i] += covariance[i][j] * axis[j];
+				length = std::max(length, std::fabs(next[i]));
+			}
+			if (length == 0.0f)
+				break;
+			for (unsigned int i = 0; i < 4; i++)
+				axis[i] = next[i] / length;
+		}
+
+		float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+		float lowest = 0.0f;
+		float highest = 0.0f;
+		if (length > 0.0f)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+				axis[c] /= length;
+
+			lowest = FLT_MAX;
+			highest = -FLT_MAX;
+			for (unsigned int t = 0; t < 16; t++)
+			{
+				float projected = 0.0f;
+				for (unsigned int c = 0; c < 4; c++)
+					projected += (texels.Channels[c][t] - mean[c]) * axis[c];
+				lowest = std::min(lowest, projected);
+				highest = std::max(highest, projected);
+			}
+		}
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			start[c] = Clamp255(mean[c] + axis[c] * lowest);
+			end[c] = Clamp255(mean[c] + axis[c] * highest);
+		}
+	}
+
+	// Least squares endpoints for the chosen indices, where index i reconstructs
+	// as start + (end - start) * positions[i]. False when every texel picked the same spot.
+	bool RefineEndpoints(const BlockTexels& texels, const float* positions, const unsigned char* indices, float* start, float* end)
+	{
+		float startStart = 0.0f;
+		float startEnd = 0.0f;
+		float endEnd = 0.0f;
+		float towardStart[4] = {};
+		float towardEnd[4] = {};
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			float position = positions[indices[t]];
+			float inverse = 1.0f - position;
+			startStart += inverse * inverse;
+			startEnd += inverse * position;
+			endEnd += position * position;
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				towardStart[c] += inverse * texels.Channels[c][t];
+				towardEnd[c] += position * texels.Channels[c][t];
+			}
+		}
+
+		float determinant = startStart * endEnd - startEnd * startEnd;
+		if (std::fabs(determinant) < 1e-6f)
+			return false;
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			start[c] = Clamp255((endEnd * towardStart[c] - startEnd * towardEnd[c]) / determinant);
+			end[c] = Clamp255((startStart * towardEnd[c] - startEnd * towardStart[c]) / determinant);
+		}
+		return true;
+	}
+
+	// Little endian bit packing, for BC7's fields that cross byte boundaries
+	void WriteBits(unsigned char* block, unsigned int* offset, unsigned int value, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i++, (*offset)++)
+		{
+			if (value & (1u << i))
+				block[*offset / 8] |= (unsigned char)(1u << (*offset % 8));
+		}
+	}
+
+	unsigned int ReadBits(const unsigned char* block, unsigned int* offset, unsigned int count)
+	{
+		unsigned int value = 0;
+		for (unsigned int i = 0; i < count; i++, (*offset)++)
+		{
+			if (block[*offset / 8] & (1u << (*offset % 8)))
+				value |= 1u << i;
+		}
+		return value;
+	}
+
+	// ---- BC1 ----
+
+	unsigned short QuantizeRGB565(const float* color)
+	{
+		unsigned int r = (unsigned int)(color[0] * 31.0f / 255.0f + 0.5f);
+		unsigned int g = (unsigned int)(color[1] * 63.0f / 255.0f + 0.5f);
+		unsigned int b = (unsigned int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	void ExpandRGB565(unsigned short color, int* rgb)
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// Four colour mode palette; with equal endpoints every entry is the same
+	void BuildBC1Palette(unsigned short color0, unsigned short color1, int (*palette)[4])
+	{
+		ExpandRGB565(color0, palette[0]);
+		ExpandRGB565(color1, palette[1]);
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (unsigned int i = 0; i < 4; i++)
+			palette[i][3] = 255;
+	}
+
+	void EncodeBC1(const BlockTexels& texels, unsigned char* block)
+	{
+		float start[4];
+		float end[4];
+		FitEndpoints(texels, rgbWeights, start, end);
+
+		float bestError = FLT_MAX;
+		unsigned short bestColors[2] = {};
+		unsigned char bestIndices[16] = {};
+		for (unsigned int iteration = 0; iteration < BLOCK_REFINE_ITERATIONS; iteration++)
+		{
+			//the first colour must be the larger for four colour mode
+			unsigned short color0 = QuantizeRGB565(start);
+			unsigned short color1 = QuantizeRGB565(end);
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+				std::swap(start, end);
+			}
+
+			int expanded[4][4];
+			float palette[4][4];
+			BuildBC1Palette(color0, color1, expanded);
+			for (unsigned int i = 0; i < 4; i++)
+				for (unsigned int c = 0; c < 4; c++)
+					palette[i][c] = (float)expanded[i][c];
+
+			unsigned char indices[16];
+			float error = SelectIndices(texels, palette, 4, rgbWeights, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				bestColors[0] = color0;
+				bestColors[1] = color1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (error == 0.0f || !RefineEndpoints(texels, bc1IndexPositions, indices, start, end))
+				break;
+		}
+
+		//equal endpoints mean three colour mode, where index 3 is black
+		if (bestColors[0] == bestColors[1])
+			memset(bestIndices, 0, sizeof(bestIndices));
+
+		unsigned int packed = 0;
+		for (unsigned int t = 0; t < 16; t++)
+			packed |= (unsigned int)bestIndices[t] << (t * 2);
+
+		block[0] = (unsigned char)(bestColors[0] & 0xFF);
+		block[1] = (unsigned char)(bestColors[0] >> 8);
+		block[2] = (unsigned char)(bestColors[1] & 0xFF);
+		block[3] = (unsigned char)(bestColors[1] >> 8);
+		for (unsigned int i = 0; i < 4; i++)
+			block[4 + i] = (unsigned char)(packed >> (i * 8));
+	}
+
+	void DecodeBC1(const unsigned char* block, unsigned char* texels)
+	{
+		unsigned short color0 = (unsigned short)(block[0] | (block[1] << 8));
+		unsigned short color1 = (unsigned short)(block[2] | (block[3] << 8));
+
+		int palette[4][4];
+		BuildBC1Palette(color0, color1, palette);
+		if (color0 <= color1)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+			palette[3][3] = 0;
+		}
+
+		unsigned int packed = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			unsigned int index = (packed >> (t * 2)) & 3;
+			for (unsigned int c = 0; c < 4; c++)
+				texels[t * 4 + c] = (unsigned char)palette[index][c];
+		}
+	}
+
+	// ---- BC4 ----
+
+	// Eight value mode palette, needing value0 > value1; otherwise six value mode
+	void BuildBC4Palette(unsigned int value0, unsigned int value1, int* palette)
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if (value0 > value1)
+		{
+			for (unsigned int i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+		}
+		else
+		{
+			for (unsigned int i = 2; i < 6; i++)
+				palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void EncodeBC4(const BlockTexels& texels, unsigned int channel, unsigned char* block)
+	{
+		float weights[4] = {};
+		weights[channel] = 1.0f;
+
+		float start[4] = {};
+		float end[4] = {};
+		start[channel] = 0.0f;
+		end[channel] = 255.0f;
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			start[channel] = std::max(start[channel], texels.Channels[channel][t]);
+			end[channel] = std::min(end[channel], texels.Channels[channel][t]);
+		}
+
+		float bestError = FLT_MAX;
+		unsigned int bestValues[2] = {};
+		unsigned char bestIndices[16] = {};
+		for (unsigned int iteration = 0; iteration < BLOCK_REFINE_ITERATIONS; iteration++)
+		{
+			//the first value must be the larger for eight value mode
+			unsigned int value0 = (unsigned int)(start[channel] + 0.5f);
+			unsigned int value1 = (unsigned int)(end[channel] + 0.5f);
+			if (value0 < value1)
+			{
+				std::swap(value0, value1);
+				std::swap(start, end);
+			}
+
+			//with equal values every index decodes to value0
+			int values[8];
+			float palette[8][4] = {};
+			BuildBC4Palette(value0, value1, values);
+			unsigned int paletteSize = value0 > value1 ? 8 : 1;
+			for (unsigned int i = 0; i < paletteSize; i++)
+				palette[i][channel] = (float)values[i];
+
+			unsigned char indices[16];
+			float error = SelectIndices(texels, palette, paletteSize, weights, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				bestValues[0] = value0;
+				bestValues[1] = value1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (error == 0.0f || !RefineEndpoints(texels, bc4IndexPositions, indices, start, end))
+				break;
+		}
+
+		block[0] = (unsigned char)bestValues[0];
+		block[1] = (unsigned char)bestValues[1];
+		unsigned long long packed = 0;
+		for (unsigned int t = 0; t < 16; t++)
+			packed |= (unsigned long long)bestIndices[t] << (t * 3);
+		for (unsigned int i = 0; i < 6; i++)
+			block[2 + i] = (unsigned char)(packed >> (i * 8));
+	}
+
+	void DecodeBC4(const unsigned char* block, unsigned char* texels, unsigned int channel)
+	{
+		int palette[8];
+		BuildBC4Palette(block[0], block[1], palette);
+
+		unsigned long long packed = 0;
+		for (unsigned int i = 0; i < 6; i++)
+			packed |= (unsigned long long)block[2 + i] << (i * 8);
+		for (unsigned int t = 0; t < 16; t++)
+			texels[t * 4 + channel] = (unsigned char)palette[(packed >> (t * 3)) & 7];
+	}
+
+	// ---- BC7, mode 6: one subset, RGBA 7 bit endpoints with a p bit each, 4 bit indices ----
+
+	// 7 bit endpoint and the p bit shared by its channels, picked for the lower error
+	void QuantizeBC7Endpoint(const float* endpoint, unsigned int* quantized, unsigned int* pBit)
+	{
+		float bestError = FLT_MAX;
+		for (unsigned int p = 0; p < 2; p++)
+		{
+			unsigned int candidate[4];
+			float error = 0.0f;
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				int value = (int)std::floor((endpoint[c] - p) / 2.0f + 0.5f);
+				candidate[c] = (unsigned int)std::min(std::max(value, 0), 127);
+				float difference = (float)(candidate[c] * 2 + p) - endpoint[c];
+				error += difference * difference;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				*pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void BuildBC7Palette(const unsigned int* endpoint0, unsigned int pBit0, const unsigned int* endpoint1, unsigned int pBit1, int (*palette)[4])
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			int value0 = (int)(endpoint0[c] << 1 | pBit0);
+			int value1 = (int)(endpoint1[c] << 1 | pBit1);
+			for (unsigned int i = 0; i < 16; i++)
+				palette[i][c] = ((64 - bc7IndexWeights[i]) * value0 + bc7IndexWeights[i] * value1 + 32) >> 6;
+		}
+	}
+
+	void EncodeBC7(const BlockTexels& texels, unsigned char* block)
+	{
+		float positions[16];
+		for (unsigned int i = 0; i < 16; i++)
+			positions[i] = bc7IndexWeights[i] / 64.0f;
+
+		float start[4];
+		float end[4];
+		FitEndpoints(texels, rgbaWeights, start, end);
+
+		float bestError = FLT_MAX;
+		unsigned int bestEndpoints[2][4] = {};
+		unsigned int bestPBits[2] = {};
+		unsigned char bestIndices[16] = {};
+		for (unsigned int iteration = 0; iteration < BLOCK_REFINE_ITERATIONS; iteration++)
+		{
+			unsigned int endpoints[2][4];
+			unsigned int pBits[2];
+			QuantizeBC7Endpoint(start, endpoints[0], &pBits[0]);
+			QuantizeBC7Endpoint(end, endpoints[1], &pBits[1]);
+
+			int expanded[16][4];
+			float palette[16][4];
+			BuildBC7Palette(endpoints[0], pBits[0], endpoints[1], pBits[1], expanded);
+			for (unsigned int i = 0; i < 16; i++)
+				for (unsigned int c = 0; c < 4; c++)
+					palette[i][c] = (float)expanded[i][c];
+
+			unsigned char indices[16];
+			float error = SelectIndices(texels, palette, 16, rgbaWeights, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+				memcpy(bestPBits, pBits, sizeof(pBits));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			if (error == 0.0f || !RefineEndpoints(texels, positions, indices, start, end))
+				break;
+		}
+
+		//the first texel's index drops its top bit, so it must be below 8;
+		//the weights are symmetric, so swapping the endpoints flips every index
+		if (bestIndices[0] >= 8)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+				std::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+			std::swap(bestPBits[0], bestPBits[1]);
+			for (unsigned int t = 0; t < 16; t++)
+				bestIndices[t] = (unsigned char)(15 - bestIndices[t]);
+		}
+
+		memset(block, 0, 16);
+		unsigned int offset = 0;
+		WriteBits(block, &offset, 1u << 6, 7);
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			WriteBits(block, &offset, bestEndpoints[0][c], 7);
+			WriteBits(block, &offset, bestEndpoints[1][c], 7);
+		}
+		WriteBits(block, &offset, bestPBits[0], 1);
+		WriteBits(block, &offset, bestPBits[1], 1);
+		WriteBits(block, &offset, bestIndices[0], 3);
+		for (unsigned int t = 1; t < 16; t++)
+			WriteBits(block, &offset, bestIndices[t], 4);
+	}
+
+	// Only mode 6 is decoded, since it's the only one EncodeBC7 writes; other modes come out black
+	void DecodeBC7(const unsigned char* block, unsigned char* texels)
+	{
+		memset(texels, 0, 64);
+		if ((block[0] & 0x7F) != 0x40)
+			return;
+
+		unsigned int offset = 7;
+		unsigned int endpoints[2][4];
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			endpoints[0][c] = ReadBits(block, &offset, 7);
+			endpoints[1][c] = ReadBits(block, &offset, 7);
+		}
+		unsigned int pBit0 = ReadBits(block, &offset, 1);
+		unsigned int pBit1 = ReadBits(block, &offset, 1);
+
+		int palette[16][4];
+		BuildBC7Palette(endpoints[0], pBit0, endpoints[1], pBit1, palette);
+		for (unsigned int t = 0; t < 16; t++)
+		{
+			unsigned int index = ReadBits(block, &offset, t == 0 ? 3 : 4);
+			for (unsigned int c = 0; c < 4; c++)
+				texels[t * 4 + c] = (unsigned char)palette[index][c];
+		}
+	}
+
+	// The 4x4 block at (blockX, blockY) as RGBA texels, repeating the edge past the image
+	void GatherBlock(const TextureImage& image, unsigned int blockX, unsigned int blockY, unsigned char* texels)
+	{
+		for (unsigned int y = 0; y < 4; y++)
+		{
+			unsigned int sourceY = std::min(blockY * 4 + y, image.Height - 1);
+			for (unsigned int x = 0; x < 4; x++)
+			{
+				unsigned int sourceX = std::min(blockX * 4 + x, image.Width - 1);
+				const unsigned char* source = image.GetPixel(sourceX, sourceY);
+				unsigned char* texel = &texels[(y * 4 + x) * 4];
+				switch (image.Channels)
+				{
+				case 1: texel[0] = texel[1] = texel[2] = source[0]; texel[3] = 255; break;
+				case 2: texel[0] = source[0]; texel[1] = source[1]; texel[2] = 0; texel[3] = 255; break;
+				case 3: texel[0] = source[0]; texel[1] = source[1]; texel[2] = source[2]; texel[3] = 255; break;
+				default: memcpy(texel, source, 4); break;
+				}
+			}
+		}
+	}
+}
+
+unsigned int BlockCompressor::GetDdsFormat(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormatBC1: return DDS_FORMAT_BC1_UNORM;
+	case BlockFormatBC4: return DDS_FORMAT_BC4_UNORM;
+	case BlockFormatBC5: return DDS_FORMAT_BC5_UNORM;
+	case BlockFormatBC7: return DDS_FORMAT_BC7_UNORM;
+	}
+	return 0;
+}
+
+unsigned int BlockCompressor::GetBlockBytes(BlockFormat format)
+{
+	return format == BlockFormatBC1 || format == BlockFormatBC4 ? 8 : 16;
+}
+
+unsigned int BlockCompressor::GetChannelCount(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormatBC1: return 3;
+	case BlockFormatBC4: return 1;
+	case BlockFormatBC5: return 2;
+	case BlockFormatBC7: return 4;
+	}
+	return 0;
+}
+
+void BlockCompressor::Compress(const TextureImage& image, BlockFormat format, std::vector<unsigned char>& output, JobSystem* jobs)
+{
+	unsigned int blocksWide = (image.Width + 3) / 4;
+	unsigned int blocksHigh = (image.Height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	output.assign((size_t)blocksWide * blocksHigh * blockBytes, 0);
+
+	//every block writes only its own bytes, so rows need no locking
+	unsigned char* destination = output.data();
+	auto compressRows = [&image, format, destination, blocksWide, blockBytes](unsigned int begin, unsigned int end)
+	{
+		unsigned char texels[64];
+		for (unsigned int blockY = begin; blockY < end; blockY++)
+		{
+			for (unsigned int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				GatherBlock(image, blockX, blockY, texels);
+				CompressBlock(texels, format, destination + ((size_t)blockY * blocksWide + blockX) * blockBytes);
+			}
+		}
+	};
+
+	if (!jobs)
+	{
+		compressRows(0, blocksHigh);
+		return;
+	}
+
+	JobCounter counter;
+	jobs->ParallelFor(blocksHigh, BLOCK_ROWS_PER_JOB, compressRows, &counter);
+	jobs->Wait(&counter);
+}
+
+void BlockCompressor::Decompress(const unsigned char* data, unsigned int width, unsigned int height, BlockFormat format, TextureImage& image)
+{
+	unsigned int channels = GetChannelCount(format);
+	unsigned int blocksWide = (width + 3) / 4;
+	unsigned int blocksHigh = (height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	image.Allocate(width, height, channels);
+
+	unsigned char texels[64];
+	for (unsigned int blockY = 0; blockY < blocksHigh; blockY++)
+	{
+		for (unsigned int blockX = 0; blockX < blocksWide; blockX++)
+		{
+			DecompressBlock(data + ((size_t)blockY * blocksWide + blockX) * blockBytes, format, texels);
+
+			//texels past the edge were only padding
+			for (unsigned int y = 0; y < 4 && blockY * 4 + y < height; y++)
+			{
+				for (unsigned int x = 0; x < 4 && blockX * 4 + x < width; x++)
+					memcpy(image.GetPixel(blockX * 4 + x, blockY * 4 + y), &texels[(y * 4 + x) * 4], channels);
+			}
+		}
+	}
+}
+
+void BlockCompressor::CompressBlock(const unsigned char* texels, BlockFormat format, unsigned char* block)
+{
+	BlockTexels split;
+	for (unsigned int t = 0; t < 16; t++)
+		for (unsigned int c = 0; c < 4; c++)
+			split.Channels[c][t] = texels[t * 4 + c];
+
+	switch (format)
+	{
+	case BlockFormatBC1: EncodeBC1(split, block); break;
+	case BlockFormatBC4: EncodeBC4(split, 0, block); break;
+	case BlockFormatBC5: EncodeBC4(split, 0, block); EncodeBC4(split, 1, block + 8); break;
+	case BlockFormatBC7: EncodeBC7(split, block); break;
+	}
+}
+
+void BlockCompressor::DecompressBlock(const unsigned char* block, BlockFormat format, unsigned char* texels)
+{
+	switch (format)
+	{
+	case BlockFormatBC1:
+		DecodeBC1(block, texels);
+		break;
+	case BlockFormatBC4:
+		memset(texels, 0, 64);
+		DecodeBC4(block, texels, 0);
+		break;
+	case BlockFormatBC5:
+		memset(texels, 0, 64);
+		DecodeBC4(block, texels, 0);
+		DecodeBC4(block + 8, texels, 1);
+		break;
+	case BlockFormatBC7:
+		DecodeBC7(block, texels);
+		break;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "TextureImage.h"
+
+class JobSystem;
+
+// Block compressed formats the asset tools write
+enum BlockFormat
+{
+	BlockFormatBC1,	// RGB, 8 bytes per block
+	BlockFormatBC4,	// R, 8 bytes per block
+	BlockFormatBC5,	// RG as two BC4 blocks, 16 bytes per block
+	BlockFormatBC7	// RGBA, 16 bytes per block, mode 6 only
+};
+
+// --------------------------------------------------------
+// Compresses images into 4x4 block formats on the CPU, for
+// the offline tools. Endpoints start from the block's
+// principal axis and are refined by least squares against
+// the chosen indices; picking indices is the hot loop and
+// runs four texels at a time with SSE2 where available.
+// Rows of blocks are spread over a JobSystem when given
+// one.
+// --------------------------------------------------------
+class BlockCompressor
+{
+public:
+	//The format's DDS_FORMAT_ value, and its bytes per block
+	static unsigned int GetDdsFormat(BlockFormat format);
+	static unsigned int GetBlockBytes(BlockFormat format);
+
+	//Channels the format keeps, which is what Decompress returns
+	static unsigned int GetChannelCount(BlockFormat format);
+
+	//Whole image to rows of blocks; edge blocks repeat the last texel.
+	//One channel images read as grey, two channel ones as red and green.
+	static void Compress(const TextureImage& image, BlockFormat format, std::vector<unsigned char>& output, JobSystem* jobs = 0);
+
+	//Rows of blocks back to an image of GetChannelCount channels
+	static void Decompress(const unsigned char* data, unsigned int width, unsigned int height, BlockFormat format, TextureImage& image);
+
+	//A single block: 16 RGBA texels, row by row
+	static void CompressBlock(const unsigned char* texels, BlockFormat format, unsigned char* block);
+	static void DecompressBlock(const unsigned char* block, BlockFormat format, unsigned char* texels);
+};
@@ -42,6 +42,11 @@ DirectX::XMFLOAT3 Camera::GetAmbientColor()
 	return cameraAmbientColor;
 }
 
+float Camera::GetFarClipDistance()
+{
+	return farClipDistance;
+}
+
 void Camera::SetViewMatrix(DirectX::XMFLOAT4X4 newViewMatrix)
 {
 	DirectX::XMStoreFloat4x4(&viewMatrix, DirectX::XMLoadFloat4x4(&newViewMatrix));
@@ -91,8 +96,8 @@ void Camera::Update(float dt)
 		int cursorMovementX = input.GetMouseXDelta();
 		int cursorMovementY = input.GetMouseYDelta();
 
-		transform.Rotate(cursorMovementY * mouseLookSpeed * dt, 0, 0);
-		transform.Rotate(0, cursorMovementX * mouseLookSpeed * dt, 0);
+		//pitch and yaw composed into the orientation in a single call
+		transform.Rotate(cursorMovementY * mouseLookSpeed * dt, cursorMovementX * mouseLookSpeed * dt, 0);
 		////clamp x rotation
 		//float xRot = transform.GetPitchYawRoll().x;
 		//xRot = xRot > DirectX::XM_PIDIV2 ? DirectX::XM_PIDIV2 : (xRot < -1 * DirectX::XM_PIDIV2 ? -1 * DirectX::XM_PIDIV2 : xRot);
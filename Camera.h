@@ -14,6 +14,7 @@ public:
 	DirectX::XMFLOAT4X4	GetProjectionMatrix();
 	Transform* GetTransform();
 	DirectX::XMFLOAT3 GetAmbientColor();
+	float GetFarClipDistance();
 
 	//Setters
 	void SetViewMatrix(DirectX::XMFLOAT4X4);
@@ -23,6 +24,7 @@ public:
 	void Update(float dt);
 	void UpdateProjectionMatrix(float aspectRatio);
 	void SetAmbientColor(DirectX::XMFLOAT3);
+	void UpdateViewMatrix(); //after moving the transform directly
 
 private:
 	Transform transform;
@@ -36,8 +38,5 @@ private:
 	float movementSpeed;
 	float mouseLookSpeed;
 	bool isOrthographic;
-
-	//Private Updates
-	void UpdateViewMatrix();
 };
 
@@ -0,0 +1,54 @@
+#include "CameraPath.h"
+#include <cmath>
+
+using namespace DirectX;
+
+CameraPath::CameraPath() {}
+
+CameraPath::~CameraPath() {}
+
+void CameraPath::AddKeyframe(XMFLOAT3 position, XMFLOAT3 target)
+{
+	positions.push_back(position);
+	targets.push_back(target);
+}
+
+void CameraPath::Evaluate(float t, XMFLOAT3* position, float* pitch, float* yaw)
+{
+	unsigned int count = (unsigned int)positions.size();
+	if (count == 0)
+	{
+		*position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		*pitch = 0.0f;
+		*yaw = 0.0f;
+		return;
+	}
+
+	//which segment of the loop, and how far along it
+	float loop = (t - floorf(t)) * count;
+	unsigned int segment = (unsigned int)loop % count;
+	float s = loop - floorf(loop);
+
+	*position = Sample(positions, segment, s);
+	XMFLOAT3 target = Sample(targets, segment, s);
+
+	//forward is +z at zero rotation, pitching down toward -y
+	XMVECTOR direction = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&target), XMLoadFloat3(position)));
+	XMFLOAT3 d;
+	XMStoreFloat3(&d, direction);
+	*pitch = asinf(-d.y);
+	*yaw = atan2f(d.x, d.z);
+}
+
+XMFLOAT3 CameraPath::Sample(const std::vector<XMFLOAT3>& points, unsigned int segment, float s)
+{
+	unsigned int count = (unsigned int)points.size();
+	XMVECTOR p0 = XMLoadFloat3(&points[(segment + count - 1) % count]);
+	XMVECTOR p1 = XMLoadFloat3(&points[segment]);
+	XMVECTOR p2 = XMLoadFloat3(&points[(segment + 1) % count]);
+	XMVECTOR p3 = XMLoadFloat3(&points[(segment + 2) % count]);
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVectorCatmullRom(p0, p1, p2, p3, s));
+	return result;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// A closed camera fly-through. Position and look target
+// follow Catmull-Rom splines through the keyframes, so the
+// same t always gives the same view.
+// --------------------------------------------------------
+class CameraPath
+{
+public:
+	CameraPath();
+	~CameraPath();
+
+	void AddKeyframe(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 target);
+	unsigned int GetKeyframeCount() { return (unsigned int)positions.size(); }
+
+	//t in [0, 1) goes once around the loop; pitch and yaw are for
+	//Transform::SetRotation, looking from position at the target
+	void Evaluate(float t, DirectX::XMFLOAT3* position, float* pitch, float* yaw);
+
+private:
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> targets;
+
+	DirectX::XMFLOAT3 Sample(const std::vector<DirectX::XMFLOAT3>& points, unsigned int segment, float s);
+};
@@ -0,0 +1,134 @@
+#include "CommandRecorder.h"
+
+CommandRecorder::CommandRecorder(Microsoft::WRL::ComPtr<ID3D11Device> device, std::shared_ptr<SimpleRecordingContext> immediate, std::shared_ptr<JobSystem> jobSystem)
+{
+	this->immediate = immediate;
+	this->jobSystem = jobSystem;
+	this->immediateContext = immediate->GetContext();
+	immediateContext.As(&immediateContext1);
+
+	//slot 0 belongs to the immediate context
+	unsigned int workerCount = jobSystem->GetThreadCount();
+	if (workerCount > SIMPLE_SHADER_MAX_RECORDING_SLOTS - 1)
+		workerCount = SIMPLE_SHADER_MAX_RECORDING_SLOTS - 1;
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		Worker worker;
+		if (FAILED(device->CreateDeferredContext(0, worker.Context.GetAddressOf())))
+		{
+			workers.clear();
+			return;
+		}
+		worker.Context.As(&worker.Context1);
+		worker.Recording = std::make_shared<SimpleRecordingContext>(worker.Context, i + 1);
+		workers.push_back(worker);
+	}
+}
+
+CommandRecorder::~CommandRecorder() {}
+
+void CommandRecorder::Record(unsigned int jobCount, bool threaded, const std::function<void(unsigned int, RecordingTarget&)>& recordJob)
+{
+	commandLists.clear();
+
+	//in order on the immediate context, nothing to execute later
+	if (!threaded || workers.empty())
+	{
+		RecordingTarget target = {};
+		target.Context = immediateContext.Get();
+		target.Context1 = immediateContext1.Get();
+		target.Recording = immediate.get();
+		for (unsigned int j = 0; j < jobCount; j++)
+		{
+			recordJob(j, target);
+		}
+		return;
+	}
+
+	commandLists.resize(jobCount);
+
+	//one job per worker with anything to record, the calling thread helps
+	unsigned int workerJobs = jobCount < workers.size() ? jobCount : (unsigned int)workers.size();
+	JobCounter recorded;
+	for (unsigned int w = 0; w < workerJobs; w++)
+	{
+		jobSystem->Run([this, w, jobCount, &recordJob]() { RecordWorker(w, jobCount, recordJob); }, &recorded);
+	}
+	jobSystem->Wait(&recorded);
+}
+
+void CommandRecorder::RecordWorker(unsigned int workerIndex, unsigned int jobCount, const std::function<void(unsigned int, RecordingTarget&)>& recordJob)
+{
+	Worker& worker = workers[workerIndex];
+
+	//shaders used on this thread stage in the worker's slot, whichever
+	//thread picked up the job
+	SimpleRecordingContext* previous = SimpleRecordingContext::GetCurrent();
+	SimpleRecordingContext::Bind(worker.Recording.get());
+
+	RecordingTarget target = {};
+	target.Context = worker.Context.Get();
+	target.Context1 = worker.Context1.Get();
+	target.Recording = worker.Recording.get();
+
+	for (unsigned int j = workerIndex; j < jobCount; j += (unsigned int)workers.size())
+	{
+		//every command list starts from default state
+		worker.Recording->Begin();
+		recordJob(j, target);
+		worker.Context->FinishCommandList(FALSE, commandLists[j].GetAddressOf());
+	}
+
+	SimpleRecordingContext::Bind(previous);
+}
+
+void CommandRecorder::Execute()
+{
+	if (commandLists.empty())
+		return;
+
+	for (auto& commandList : commandLists)
+	{
+		if (commandList)
+		{
+			immediateContext->ExecuteCommandList(commandList.Get(), FALSE);
+		}
+	}
+	commandLists.clear();
+
+	//the lists reset state and rewrote shared constant buffers. Begin
+	//also starts the generation that threads with no recording context
+	//upload under, so slot 0's data goes up again whoever stages it.
+	//Anything else that runs command lists here must do the same.
+	immediate->Begin();
+}
+
+unsigned int CommandRecorder::GetIssuedCalls()
+{
+	unsigned int calls = immediate->GetStateTracker()->GetIssuedCalls();
+	for (Worker& worker : workers)
+	{
+		calls += worker.Recording->GetStateTracker()->GetIssuedCalls();
+	}
+	return calls;
+}
+
+unsigned int CommandRecorder::GetFilteredCalls()
+{
+	unsigned int calls = immediate->GetStateTracker()->GetFilteredCalls();
+	for (Worker& worker : workers)
+	{
+		calls += worker.Recording->GetStateTracker()->GetFilteredCalls();
+	}
+	return calls;
+}
+
+void CommandRecorder::ResetStats()
+{
+	immediate->GetStateTracker()->ResetStats();
+	for (Worker& worker : workers)
+	{
+		worker.Recording->GetStateTracker()->ResetStats();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11_1.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "SimpleShader/SimpleRecordingContext.h"
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// What a recording job issues its calls on
+// --------------------------------------------------------
+struct RecordingTarget
+{
+	ID3D11DeviceContext* Context;
+	ID3D11DeviceContext1* Context1;	// Null without D3D 11.1
+	SimpleRecordingContext* Recording;
+};
+
+// --------------------------------------------------------
+// Records jobs into command lists as job system jobs, one
+// per deferred context, each with its own SimpleShader
+// staging slot, then executes the lists in job order on the
+// immediate context. Without threading, or if deferred
+// contexts can't be made, jobs record in order straight
+// onto the immediate context instead.
+// --------------------------------------------------------
+class CommandRecorder
+{
+public:
+	//immediate must use staging slot 0, workers take slots 1 and up.
+	//There is one worker per job system thread.
+	CommandRecorder(Microsoft::WRL::ComPtr<ID3D11Device> device, std::shared_ptr<SimpleRecordingContext> immediate, std::shared_ptr<JobSystem> jobSystem);
+	~CommandRecorder();
+
+	bool IsSupported() { return !workers.empty(); }
+	unsigned int GetWorkerCount() { return (unsigned int)workers.size(); }
+
+	//Calls recordJob once for each job index. Worker w records jobs
+	//w, w + workerCount, ... each into its own command list.
+	void Record(unsigned int jobCount, bool threaded, const std::function<void(unsigned int, RecordingTarget&)>& recordJob);
+
+	//Executes and releases the lists from Record() in job order. This
+	//leaves the immediate context in its default state.
+	void Execute();
+
+	//State tracker counters summed over every context
+	unsigned int GetIssuedCalls();
+	unsigned int GetFilteredCalls();
+	void ResetStats();
+
+private:
+	struct Worker
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> Context;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext1> Context1;
+		std::shared_ptr<SimpleRecordingContext> Recording;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediateContext;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> immediateContext1;
+	std::shared_ptr<SimpleRecordingContext> immediate;
+	std::shared_ptr<JobSystem> jobSystem;
+	std::vector<Worker> workers;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11CommandList>> commandLists; //one per job
+
+	void RecordWorker(unsigned int workerIndex, unsigned int jobCount, const std::function<void(unsigned int, RecordingTarget&)>& recordJob);
+};
@@ -0,0 +1,93 @@
+#include "ConstantBufferRing.h"
+
+ConstantBufferRing::ConstantBufferRing(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int initialCapacity)
+	: ring(0, CONSTANT_BUFFER_OFFSET_ALIGNMENT)
+{
+	this->device = device;
+	this->supported = false;
+
+	//offset binding lives on the 11.1 context
+	if (FAILED(context.As(&this->context)))
+		return;
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		return;
+
+	supported = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+	if (supported)
+	{
+		supported = CreateBuffer(initialCapacity);
+	}
+}
+
+ConstantBufferRing::~ConstantBufferRing() {}
+
+void* ConstantBufferRing::Map(unsigned int size, unsigned int* offset)
+{
+	if (!supported)
+		return 0;
+
+	//grow to the next power of two so resizes stay rare
+	if (size > ring.GetCapacity())
+	{
+		unsigned int newCapacity = ring.GetCapacity() > 0 ? ring.GetCapacity() : CONSTANT_BUFFER_OFFSET_ALIGNMENT;
+		while (newCapacity < size)
+		{
+			newCapacity *= 2;
+		}
+		if (!CreateBuffer(newCapacity))
+		{
+			supported = false;
+			return 0;
+		}
+	}
+
+	bool wrapped = false;
+	*offset = ring.Allocate(size, &wrapped);
+
+	//blocks handed out earlier this frame are still to be read, so only discard on wrap
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(buffer.Get(), 0, wrapped ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped)))
+		return 0;
+
+	return (unsigned char*)mapped.pData + *offset;
+}
+
+void ConstantBufferRing::Unmap()
+{
+	context->Unmap(buffer.Get(), 0);
+}
+
+void ConstantBufferRing::BindVS(unsigned int slot, unsigned int offset, unsigned int size)
+{
+	BindVS(context.Get(), slot, offset, size);
+}
+
+void ConstantBufferRing::BindVS(ID3D11DeviceContext1* context, unsigned int slot, unsigned int offset, unsigned int size)
+{
+	//offsets and sizes are counted in 16 byte constants, sizes in multiples of 16 constants
+	UINT firstConstant = offset / 16;
+	UINT numConstants = (size + CONSTANT_BUFFER_OFFSET_ALIGNMENT - 1) / CONSTANT_BUFFER_OFFSET_ALIGNMENT * 16;
+	context->VSSetConstantBuffers1(slot, 1, buffer.GetAddressOf(), &firstConstant, &numConstants);
+}
+
+bool ConstantBufferRing::CreateBuffer(unsigned int capacity)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;	// Rewritten by the CPU every frame
+	desc.ByteWidth = capacity;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+
+	buffer.Reset();
+	if (FAILED(device->CreateBuffer(&desc, 0, buffer.GetAddressOf())))
+	{
+		ring.Reset(0);
+		return false;
+	}
+	ring.Reset(capacity);
+	return true;
+}
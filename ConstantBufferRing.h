@@ -0,0 +1,42 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11_1.h>
+#include "UploadRing.h"
+
+// Constant buffer offsets are in 16 constant (256 byte) steps
+#define CONSTANT_BUFFER_OFFSET_ALIGNMENT 256
+
+// --------------------------------------------------------
+// One large dynamic constant buffer that many small blocks
+// are written into each frame and bound with offsets.
+// Needs the D3D 11.1 offset binding and no-overwrite map
+// features; check IsSupported() and fall back otherwise.
+// A buffer that fails to create turns the ring off too.
+// --------------------------------------------------------
+class ConstantBufferRing
+{
+public:
+	ConstantBufferRing(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int initialCapacity);
+	~ConstantBufferRing();
+
+	bool IsSupported() { return supported; }
+
+	//Maps size bytes, discarding only when the ring wraps or grows.
+	//offset receives the byte offset of the returned memory.
+	void* Map(unsigned int size, unsigned int* offset);
+	void Unmap();
+
+	//Binds size bytes starting at offset to a vertex shader slot
+	void BindVS(unsigned int slot, unsigned int offset, unsigned int size);
+	void BindVS(ID3D11DeviceContext1* context, unsigned int slot, unsigned int offset, unsigned int size); //on a deferred context
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	UploadRing ring;
+	bool supported;
+
+	bool CreateBuffer(unsigned int capacity);
+};
@@ -0,0 +1,60 @@
+#include "D3D11QueryBackend.h"
+
+D3D11QueryBackend::D3D11QueryBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int timestampCount)
+{
+	this->context = context;
+
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+
+	for (unsigned int slot = 0; slot < GPU_TIMER_FRAME_LATENCY; slot++)
+	{
+		device->CreateQuery(&disjointDesc, disjointQueries[slot].GetAddressOf());
+
+		timestampQueries[slot].resize(timestampCount);
+		for (auto& query : timestampQueries[slot])
+		{
+			device->CreateQuery(&timestampDesc, query.GetAddressOf());
+		}
+	}
+}
+
+D3D11QueryBackend::~D3D11QueryBackend() {}
+
+void D3D11QueryBackend::BeginFrame(unsigned int slot)
+{
+	context->Begin(disjointQueries[slot].Get());
+}
+
+void D3D11QueryBackend::EndFrame(unsigned int slot)
+{
+	context->End(disjointQueries[slot].Get());
+}
+
+bool D3D11QueryBackend::ReadFrame(unsigned int slot, unsigned int timestampCount, unsigned long long* timestamps,
+	unsigned long long* frequency, bool* disjoint)
+{
+	//DONOTFLUSH: polling must not force the GPU to catch up
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData = {};
+	if (context->GetData(disjointQueries[slot].Get(), &disjointData, sizeof(disjointData), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	for (unsigned int i = 0; i < timestampCount && i < timestampQueries[slot].size(); i++)
+	{
+		UINT64 timestamp = 0;
+		if (context->GetData(timestampQueries[slot][i].Get(), &timestamp, sizeof(timestamp), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return false;
+		timestamps[i] = timestamp;
+	}
+
+	*frequency = disjointData.Frequency;
+	*disjoint = disjointData.Disjoint != FALSE;
+	return true;
+}
+
+void D3D11QueryBackend::Timestamp(ID3D11DeviceContext* context, unsigned int slot, unsigned int query)
+{
+	context->End(timestampQueries[slot][query].Get());
+}
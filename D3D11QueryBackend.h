@@ -0,0 +1,31 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11.h>
+#include <vector>
+#include "GpuTimer.h"
+
+// --------------------------------------------------------
+// GpuTimer queries on D3D11. The disjoint query runs on the
+// immediate context; timestamps can be ended on any context,
+// including deferred ones whose lists execute in the frame.
+// --------------------------------------------------------
+class D3D11QueryBackend : public IGpuQueryBackend
+{
+public:
+	D3D11QueryBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int timestampCount);
+	~D3D11QueryBackend();
+
+	void BeginFrame(unsigned int slot);
+	void EndFrame(unsigned int slot);
+	bool ReadFrame(unsigned int slot, unsigned int timestampCount, unsigned long long* timestamps,
+		unsigned long long* frequency, bool* disjoint);
+
+	//Ends one of the slot's timestamp queries on context
+	void Timestamp(ID3D11DeviceContext* context, unsigned int slot, unsigned int query);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	Microsoft::WRL::ComPtr<ID3D11Query> disjointQueries[GPU_TIMER_FRAME_LATENCY];
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> timestampQueries[GPU_TIMER_FRAME_LATENCY];
+};
@@ -0,0 +1,287 @@
+#include "DdsFile.h"
+#include <cstdio>
+#include <cstring>
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_FOURCC_DX10 0x30315844 // "DX10"
+
+// Header flags DirectXTK and most viewers expect
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xFC00
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_MISC_TEXTURECUBE 0x4
+
+// Older headers name formats with these instead
+#define DDS_FOURCC_DXT1 0x31545844 // "DXT1"
+#define DDS_FOURCC_RGBA16F 113 // D3DFMT_A16B16G16R16F
+#define DDS_FOURCC_RGBA32F 116 // D3DFMT_A32B32G32R32F
+
+namespace
+{
+	struct DdsPixelFormat
+	{
+		unsigned int Size;
+		unsigned int Flags;
+		unsigned int FourCC;
+		unsigned int RGBBitCount;
+		unsigned int RBitMask;
+		unsigned int GBitMask;
+		unsigned int BBitMask;
+		unsigned int ABitMask;
+	};
+
+	struct DdsHeader
+	{
+		unsigned int Size;
+		unsigned int Flags;
+		unsigned int Height;
+		unsigned int Width;
+		unsigned int PitchOrLinearSize;
+		unsigned int Depth;
+		unsigned int MipMapCount;
+		unsigned int Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		unsigned int Caps;
+		unsigned int Caps2;
+		unsigned int Caps3;
+		unsigned int Caps4;
+		unsigned int Reserved2;
+	};
+
+	struct DdsHeaderDX10
+	{
+		unsigned int Format;
+		unsigned int ResourceDimension;
+		unsigned int MiscFlag;
+		unsigned int ArraySize;
+		unsigned int MiscFlags2;
+	};
+
+	// The DXGI format an older header describes, 0 if it isn't one we read
+	unsigned int GetLegacyFormat(const DdsPixelFormat& format)
+	{
+		if (format.Flags & DDPF_FOURCC)
+		{
+			switch (format.FourCC)
+			{
+			case DDS_FOURCC_DXT1: return DDS_FORMAT_BC1_UNORM;
+			case DDS_FOURCC_RGBA16F: return DDS_FORMAT_R16G16B16A16_FLOAT;
+			case DDS_FOURCC_RGBA32F: return DDS_FORMAT_R32G32B32A32_FLOAT;
+			}
+			return 0;
+		}
+
+		if ((format.Flags & DDPF_RGB) && format.RGBBitCount == 32)
+		{
+			if (format.RBitMask == 0xFF && format.GBitMask == 0xFF00 && format.BBitMask == 0xFF0000)
+				return DDS_FORMAT_R8G8B8A8_UNORM;
+			if (format.RBitMask == 0xFF0000 && format.GBitMask == 0xFF00 && format.BBitMask == 0xFF)
+				return (format.Flags & DDPF_ALPHAPIXELS) ? DDS_FORMAT_B8G8R8A8_UNORM : DDS_FORMAT_B8G8R8X8_UNORM;
+		}
+		return 0;
+	}
+
+	// Leaves the file at the first level
+	bool ReadHeader(FILE* file, DdsInfo& info)
+	{
+		unsigned int magic = 0;
+		DdsHeader header = {};
+		DdsHeaderDX10 dx10 = {};
+		bool ok = fread(&magic, sizeof(magic), 1, file) == 1 && magic == DDS_MAGIC
+			&& fread(&header, sizeof(header), 1, file) == 1;
+
+		bool cube = false;
+		if (ok && header.PixelFormat.FourCC == DDS_FOURCC_DX10)
+		{
+			ok = fread(&dx10, sizeof(dx10), 1, file) == 1 && dx10.ArraySize <= 1;
+			info.Format = dx10.Format;
+			cube = (dx10.MiscFlag & DDS_MISC_TEXTURECUBE) != 0;
+		}
+		else
+		{
+			info.Format = GetLegacyFormat(header.PixelFormat);
+			cube = (header.Caps2 & DDSCAPS2_CUBEMAP) != 0;
+		}
+
+		info.Width = header.Width;
+		info.Height = header.Height;
+		info.MipCount = header.MipMapCount ? header.MipMapCount : 1;
+		info.Faces = cube ? 6 : 1;
+		return ok && DdsFile::GetLevelSize(info.Format, info.Width, info.Height) > 0;
+	}
+
+	bool WriteFile(const std::string& path, unsigned int format, const std::vector<DdsLevel>& levels, unsigned int faces)
+	{
+		if (levels.empty() || levels.size() % faces != 0 || DdsFile::GetLevelSize(format, levels[0].Width, levels[0].Height) == 0)
+			return false;
+
+		unsigned int mipCount = (unsigned int)levels.size() / faces;
+		DdsHeader header = {};
+		header.Size = sizeof(DdsHeader);
+		header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+		header.Height = levels[0].Height;
+		header.Width = levels[0].Width;
+		header.PitchOrLinearSize = (unsigned int)DdsFile::GetLevelSize(format, levels[0].Width, levels[0].Height);
+		header.MipMapCount = mipCount;
+		header.PixelFormat.Size = sizeof(DdsPixelFormat);
+		header.PixelFormat.Flags = DDPF_FOURCC;
+		header.PixelFormat.FourCC = DDS_FOURCC_DX10;
+		header.Caps = DDSCAPS_TEXTURE | (mipCount > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0) | (faces > 1 ? DDSCAPS_COMPLEX : 0);
+		header.Caps2 = faces > 1 ? DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES : 0;
+
+		DdsHeaderDX10 dx10 = {};
+		dx10.Format = format;
+		dx10.ResourceDimension = DDS_DIMENSION_TEXTURE2D;
+		dx10.MiscFlag = faces > 1 ? DDS_MISC_TEXTURECUBE : 0;
+		dx10.ArraySize = 1;
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		unsigned int magic = DDS_MAGIC;
+		bool ok = fwrite(&magic, sizeof(magic), 1, file) == 1
+			&& fwrite(&header, sizeof(header), 1, file) == 1
+			&& fwrite(&dx10, sizeof(dx10), 1, file) == 1;
+		for (const DdsLevel& level : levels)
+		{
+			ok = ok && level.Data.size() == DdsFile::GetLevelSize(format, level.Width, level.Height)
+				&& fwrite(level.Data.data(), 1, level.Data.size(), file) == level.Data.size();
+		}
+		fclose(file);
+		return ok;
+	}
+}
+
+bool DdsFile::Write(const std::string& path, unsigned int format, const std::vector<DdsLevel>& levels)
+{
+	return WriteFile(path, format, levels, 1);
+}
+
+bool DdsFile::WriteCube(const std::string& path, unsigned int format, const std::vector<DdsLevel>& levels)
+{
+	return WriteFile(path, format, levels, 6);
+}
+
+bool DdsFile::Read(const std::string& path, unsigned int* format, std::vector<DdsLevel>& levels)
+{
+	DdsInfo info = {};
+	if (!ReadInfo(path, info))
+		return false;
+
+	*format = info.Format;
+	return ReadLevels(path, 0, info.MipCount, levels);
+}
+
+bool DdsFile::ReadCube(const std::string& path, DdsInfo& info, std::vector<DdsLevel>& levels)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	bool ok = ReadHeader(file, info) && info.Faces == 6;
+
+	levels.clear();
+	for (unsigned int face = 0; ok && face < info.Faces; face++)
+	{
+		unsigned int width = info.Width;
+		unsigned int height = info.Height;
+		for (unsigned int i = 0; ok && i < info.MipCount; i++)
+		{
+			DdsLevel level = { width, height, {} };
+			level.Data.resize(GetLevelSize(info.Format, width, height));
+			ok = fread(level.Data.data(), 1, level.Data.size(), file) == level.Data.size();
+			levels.push_back(std::move(level));
+
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+	}
+	fclose(file);
+	return ok;
+}
+
+bool DdsFile::ReadInfo(const std::string& path, DdsInfo& info)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	bool ok = ReadHeader(file, info);
+	fclose(file);
+	return ok;
+}
+
+bool DdsFile::ReadLevels(const std::string& path, unsigned int firstLevel, unsigned int count, std::vector<DdsLevel>& levels)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	DdsInfo info = {};
+	bool ok = ReadHeader(file, info) && firstLevel + count <= info.MipCount;
+
+	levels.clear();
+	unsigned int width = info.Width;
+	unsigned int height = info.Height;
+	for (unsigned int i = 0; ok && i < firstLevel + count; i++)
+	{
+		size_t size = GetLevelSize(info.Format, width, height);
+		if (i < firstLevel)
+		{
+			ok = fseek(file, (long)size, SEEK_CUR) == 0;
+		}
+		else
+		{
+			DdsLevel level = { width, height, {} };
+			level.Data.resize(size);
+			ok = fread(level.Data.data(), 1, size, file) == size;
+			levels.push_back(std::move(level));
+		}
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	fclose(file);
+	return ok;
+}
+
+size_t DdsFile::GetLevelSize(unsigned int format, unsigned int width, unsigned int height)
+{
+	switch (format)
+	{
+	case DDS_FORMAT_R32G32B32A32_FLOAT: return (size_t)width * height * 16;
+	case DDS_FORMAT_R16G16B16A16_FLOAT: return (size_t)width * height * 8;
+	case DDS_FORMAT_R8G8B8A8_UNORM:
+	case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DDS_FORMAT_R16G16_FLOAT:
+	case DDS_FORMAT_B8G8R8A8_UNORM:
+	case DDS_FORMAT_B8G8R8X8_UNORM:
+	case DDS_FORMAT_B8G8R8A8_UNORM_SRGB: return (size_t)width * height * 4;
+	case DDS_FORMAT_R8G8_UNORM: return (size_t)width * height * 2;
+	}
+
+	//a partial block at the edge is still a whole block
+	size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+	switch (format)
+	{
+	case DDS_FORMAT_BC1_UNORM:
+	case DDS_FORMAT_BC1_UNORM_SRGB:
+	case DDS_FORMAT_BC4_UNORM: return blocks * 8;
+	case DDS_FORMAT_BC5_UNORM:
+	case DDS_FORMAT_BC7_UNORM: return blocks * 16;
+	}
+	return 0;
+}
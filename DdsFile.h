@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// DXGI_FORMAT values of the formats asset tools read and
+// write, so DDS files need no Direct3D headers
+#define DDS_FORMAT_R32G32B32A32_FLOAT 2
+#define DDS_FORMAT_R16G16B16A16_FLOAT 10
+#define DDS_FORMAT_R8G8B8A8_UNORM 28
+#define DDS_FORMAT_R8G8B8A8_UNORM_SRGB 29
+#define DDS_FORMAT_R16G16_FLOAT 34
+#define DDS_FORMAT_R8G8_UNORM 49
+#define DDS_FORMAT_BC1_UNORM 71
+#define DDS_FORMAT_BC1_UNORM_SRGB 72
+#define DDS_FORMAT_BC4_UNORM 80
+#define DDS_FORMAT_BC5_UNORM 83
+#define DDS_FORMAT_B8G8R8A8_UNORM 87
+#define DDS_FORMAT_B8G8R8X8_UNORM 88
+#define DDS_FORMAT_B8G8R8A8_UNORM_SRGB 91
+#define DDS_FORMAT_BC7_UNORM 98
+
+// --------------------------------------------------------
+// One mip level of a 2D texture, in the format's layout.
+// Block compressed levels are rows of 4x4 blocks.
+// --------------------------------------------------------
+struct DdsLevel
+{
+	unsigned int Width;
+	unsigned int Height;
+	std::vector<unsigned char> Data;
+};
+
+// What a DDS file's header says about its levels
+struct DdsInfo
+{
+	unsigned int Format;
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int MipCount;
+	unsigned int Faces;	// 6 for cube maps, otherwise 1
+};
+
+// --------------------------------------------------------
+// Reads and writes 2D and cube DDS files with the DX10
+// header, which DirectXTK's DDS loader reads straight into
+// a texture. Files with the older header are read too, in
+// the formats that header can describe.
+// --------------------------------------------------------
+class DdsFile
+{
+public:
+	static bool Write(const std::string& path, unsigned int format, const std::vector<DdsLevel>& levels);
+	static bool Read(const std::string& path, unsigned int* format, std::vector<DdsLevel>& levels);
+
+	//Cube maps: levels are face by face (+X, -X, +Y, -Y, +Z, -Z), each with all its mips
+	static bool WriteCube(const std::string& path, unsigned int format, const std::vector<DdsLevel>& levels);
+	static bool ReadCube(const std::string& path, DdsInfo& info, std::vector<DdsLevel>& levels);
+
+	//Just the header, so levels can be read a few at a time
+	static bool ReadInfo(const std::string& path, DdsInfo& info);
+
+	//count levels of the first face starting at firstLevel, seeking past the ones before
+	static bool ReadLevels(const std::string& path, unsigned int firstLevel, unsigned int count, std::vector<DdsLevel>& levels);
+
+	//Bytes of one level in the given format, 0 if unknown
+	static size_t GetLevelSize(unsigned int format, unsigned int width, unsigned int height);
+};
@@ -0,0 +1,205 @@
+#include "EntityRegistry.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// View iteration
+// --------------------------------------------------------
+EntityView::Iterator::Iterator(const unsigned int* flags, unsigned int count, unsigned int requiredFlags, unsigned int index)
+	: flags(flags), count(count), requiredFlags(requiredFlags), index(index)
+{
+	SkipFiltered();
+}
+
+EntityView::Iterator& EntityView::Iterator::operator++()
+{
+	index++;
+	SkipFiltered();
+	return *this;
+}
+
+void EntityView::Iterator::SkipFiltered()
+{
+	while (index < count && (flags[index] & requiredFlags) != requiredFlags)
+	{
+		index++;
+	}
+}
+
+EntityView::EntityView(const unsigned int* flags, unsigned int count, unsigned int requiredFlags)
+	: flags(flags), count(count), requiredFlags(requiredFlags)
+{
+}
+
+EntityView::Iterator EntityView::begin() const
+{
+	return Iterator(flags, count, requiredFlags, 0);
+}
+
+EntityView::Iterator EntityView::end() const
+{
+	return Iterator(flags, count, requiredFlags, count);
+}
+
+// --------------------------------------------------------
+// Registry
+// --------------------------------------------------------
+EntityRegistry::EntityRegistry() {}
+
+EntityRegistry::~EntityRegistry() {}
+
+EntityHandle EntityRegistry::Create(unsigned int meshHandle, unsigned int materialHandle, BoundingBox bounds, unsigned int entityFlags)
+{
+	//reuse a free slot if we have one
+	unsigned int slotIndex;
+	if (!freeSlots.empty())
+	{
+		slotIndex = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		slotIndex = (unsigned int)slots.size();
+		slots.push_back({ 0, 0 });
+	}
+
+	//append components to the end of the dense arrays
+	unsigned int denseIndex = (unsigned int)flags.size();
+	slots[slotIndex].DenseIndex = denseIndex;
+
+	transforms.emplace_back();
+	meshes.push_back(meshHandle);
+	materials.push_back(materialHandle);
+	localBounds.push_back(bounds);
+	worldBounds.push_back(bounds);
+	flags.push_back(entityFlags);
+	denseToSlot.push_back(slotIndex);
+
+	return { slotIndex, slots[slotIndex].Generation };
+}
+
+void EntityRegistry::Destroy(EntityHandle handle)
+{
+	if (!IsValid(handle)) return;
+
+	//swap the last entity into the removed entity's place to keep arrays dense
+	unsigned int denseIndex = slots[handle.Index].DenseIndex;
+	unsigned int lastIndex = (unsigned int)flags.size() - 1;
+	if (denseIndex != lastIndex)
+	{
+		transforms[denseIndex] = transforms[lastIndex];
+		meshes[denseIndex] = meshes[lastIndex];
+		materials[denseIndex] = materials[lastIndex];
+		localBounds[denseIndex] = localBounds[lastIndex];
+		worldBounds[denseIndex] = worldBounds[lastIndex];
+		flags[denseIndex] = flags[lastIndex];
+		denseToSlot[denseIndex] = denseToSlot[lastIndex];
+		slots[denseToSlot[denseIndex]].DenseIndex = denseIndex;
+	}
+
+	transforms.pop_back();
+	meshes.pop_back();
+	materials.pop_back();
+	localBounds.pop_back();
+	worldBounds.pop_back();
+	flags.pop_back();
+	denseToSlot.pop_back();
+
+	//invalidate outstanding handles to this slot
+	slots[handle.Index].Generation++;
+	freeSlots.push_back(handle.Index);
+}
+
+bool EntityRegistry::IsValid(EntityHandle handle)
+{
+	return handle.Index < slots.size() && slots[handle.Index].Generation == handle.Generation;
+}
+
+void EntityRegistry::Clear()
+{
+	//bump every generation so no old handle stays valid
+	freeSlots.clear();
+	for (unsigned int i = 0; i < slots.size(); i++)
+	{
+		slots[i].Generation++;
+		freeSlots.push_back(i);
+	}
+
+	transforms.clear();
+	meshes.clear();
+	materials.clear();
+	localBounds.clear();
+	worldBounds.clear();
+	flags.clear();
+	denseToSlot.clear();
+}
+
+Transform* EntityRegistry::GetTransform(EntityHandle handle)
+{
+	if (!IsValid(handle)) return 0;
+	return &transforms[DenseIndex(handle)];
+}
+
+unsigned int EntityRegistry::GetMesh(EntityHandle handle)
+{
+	if (!IsValid(handle)) return 0;
+	return meshes[DenseIndex(handle)];
+}
+
+unsigned int EntityRegistry::GetMaterial(EntityHandle handle)
+{
+	if (!IsValid(handle)) return 0;
+	return materials[DenseIndex(handle)];
+}
+
+unsigned int EntityRegistry::GetFlags(EntityHandle handle)
+{
+	if (!IsValid(handle)) return 0;
+	return flags[DenseIndex(handle)];
+}
+
+void EntityRegistry::SetMaterial(EntityHandle handle, unsigned int materialHandle)
+{
+	if (!IsValid(handle)) return;
+	materials[DenseIndex(handle)] = materialHandle;
+}
+
+void EntityRegistry::SetFlags(EntityHandle handle, unsigned int entityFlags)
+{
+	if (!IsValid(handle)) return;
+	flags[DenseIndex(handle)] = entityFlags;
+}
+
+void EntityRegistry::SetMeshBounds(unsigned int meshHandle, BoundingBox bounds)
+{
+	//world bounds follow with the next UpdateBounds
+	for (unsigned int i = 0; i < (unsigned int)meshes.size(); i++)
+	{
+		if (meshes[i] == meshHandle)
+			localBounds[i] = bounds;
+	}
+}
+
+EntityView EntityRegistry::View(unsigned int requiredFlags)
+{
+	return EntityView(flags.data(), (unsigned int)flags.size(), requiredFlags);
+}
+
+void EntityRegistry::UpdateBounds()
+{
+	UpdateBounds(0, GetCount());
+}
+
+void EntityRegistry::UpdateBounds(unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; i++)
+	{
+		XMFLOAT4X4 world = transforms[i].GetWorldMatrix();
+		localBounds[i].Transform(worldBounds[i], XMLoadFloat4x4(&world));
+	}
+}
+
+unsigned int EntityRegistry::DenseIndex(EntityHandle handle)
+{
+	return slots[handle.Index].DenseIndex;
+}
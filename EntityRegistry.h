@@ -0,0 +1,119 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include "Transform.h"
+
+#define ENTITY_FLAG_VISIBLE 1
+#define ENTITY_FLAG_CASTS_SHADOW 2
+
+// --------------------------------------------------------
+// Stable reference to an entity. The generation guards
+// against using a handle after its entity was destroyed.
+// --------------------------------------------------------
+struct EntityHandle
+{
+	unsigned int Index;			// Slot in the registry's sparse table
+	unsigned int Generation;	// Must match the slot's generation to be valid
+};
+
+class EntityRegistry;
+
+// --------------------------------------------------------
+// Iterates the dense index of every entity whose flags
+// contain all of the required flags
+// --------------------------------------------------------
+class EntityView
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(const unsigned int* flags, unsigned int count, unsigned int requiredFlags, unsigned int index);
+		unsigned int operator*() const { return index; }
+		Iterator& operator++();
+		bool operator!=(const Iterator& other) const { return index != other.index; }
+	private:
+		const unsigned int* flags;
+		unsigned int count;
+		unsigned int requiredFlags;
+		unsigned int index;
+		void SkipFiltered();
+	};
+
+	EntityView(const unsigned int* flags, unsigned int count, unsigned int requiredFlags);
+	Iterator begin() const;
+	Iterator end() const;
+
+private:
+	const unsigned int* flags;
+	unsigned int count;
+	unsigned int requiredFlags;
+};
+
+// --------------------------------------------------------
+// Owns every entity's components in dense, parallel arrays
+// so the draw loops walk contiguous memory instead of
+// chasing shared_ptrs. Meshes and materials are referenced
+// by their index in Game's mesh and material lists.
+// --------------------------------------------------------
+class EntityRegistry
+{
+public:
+	EntityRegistry();
+	~EntityRegistry();
+
+	EntityHandle Create(unsigned int meshHandle, unsigned int materialHandle, DirectX::BoundingBox localBounds,
+		unsigned int flags = ENTITY_FLAG_VISIBLE | ENTITY_FLAG_CASTS_SHADOW);
+	void Destroy(EntityHandle handle);
+	bool IsValid(EntityHandle handle);
+	void Clear();
+
+	//Per handle access, stale handles read 0 (or null) and write nothing
+	Transform* GetTransform(EntityHandle handle);
+	unsigned int GetMesh(EntityHandle handle);
+	unsigned int GetMaterial(EntityHandle handle);
+	unsigned int GetFlags(EntityHandle handle);
+	void SetMaterial(EntityHandle handle, unsigned int materialHandle);
+	void SetFlags(EntityHandle handle, unsigned int flags);
+
+	//For every entity drawing the mesh, as when it's reloaded with a new shape
+	void SetMeshBounds(unsigned int meshHandle, DirectX::BoundingBox localBounds);
+
+	//Dense access for iteration (index with the values produced by a view)
+	unsigned int GetCount() { return (unsigned int)flags.size(); }
+	Transform* GetTransforms() { return transforms.data(); }
+	const unsigned int* GetMeshes() { return meshes.data(); }
+	const unsigned int* GetMaterials() { return materials.data(); }
+	const DirectX::BoundingBox* GetWorldBounds() { return worldBounds.data(); }
+	const unsigned int* GetFlags() { return flags.data(); }
+
+	EntityView View(unsigned int requiredFlags);
+
+	//Recomputes world space bounds from the current transforms
+	void UpdateBounds();
+	void UpdateBounds(unsigned int begin, unsigned int end); //dense index range, safe to split across threads
+
+private:
+	struct Slot
+	{
+		unsigned int DenseIndex;
+		unsigned int Generation;
+	};
+
+	//sparse table indexed by handle, plus the free list of slots
+	std::vector<Slot> slots;
+	std::vector<unsigned int> freeSlots;
+
+	//dense component arrays, all the same length
+	std::vector<Transform> transforms;
+	std::vector<unsigned int> meshes;
+	std::vector<unsigned int> materials;
+	std::vector<DirectX::BoundingBox> localBounds;
+	std::vector<DirectX::BoundingBox> worldBounds;
+	std::vector<unsigned int> flags;
+	std::vector<unsigned int> denseToSlot;
+
+	unsigned int DenseIndex(EntityHandle handle);
+};
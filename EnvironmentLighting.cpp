@@ -0,0 +1,716 @@
+#include "EnvironmentLighting.h"
+#include "BlockCompressor.h"
+#include "DdsFile.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sys/stat.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENVIRONMENT_LIGHTING_SSE2
+#endif
+
+// Rows per job when filtering faces
+#define ENVIRONMENT_ROWS_PER_JOB 8
+
+namespace
+{
+	const float pi = 3.14159265358979f;
+
+	// Cosine lobe convolution of each band divided by pi: pi, 2pi/3 and pi/4 over pi
+	const float bandScales[ENVIRONMENT_SH_COEFFICIENTS] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+	// A texel's four channels, in a register where SSE2 is available
+#ifdef ENVIRONMENT_LIGHTING_SSE2
+	typedef __m128 Rgba;
+
+	Rgba Zero() { return _mm_setzero_ps(); }
+	Rgba Load(const float* texel) { return _mm_loadu_ps(texel); }
+	void Store(float* texel, Rgba value) { _mm_storeu_ps(texel, value); }
+
+	// sum + value * weight
+	Rgba AddWeighted(Rgba sum, Rgba value, float weight) { return _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weight))); }
+#else
+	struct Rgba
+	{
+		float Channels[4];
+	};
+
+	Rgba Zero() { return Rgba{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	Rgba Load(const float* texel) { return Rgba{ { texel[0], texel[1], texel[2], texel[3] } }; }
+	void Store(float* texel, Rgba value) { memcpy(texel, value.Channels, sizeof(value.Channels)); }
+
+	Rgba AddWeighted(Rgba sum, Rgba value, float weight)
+	{
+		for (unsigned int c = 0; c < 4; c++)
+			sum.Channels[c] += value.Channels[c] * weight;
+		return sum;
+	}
+#endif
+
+	// A GGX sample around +z, with the source level it reads
+	struct LobeSample
+	{
+		float Direction[3];
+		float Weight;
+		float Lod;
+	};
+
+	void RunRows(unsigned int rows, JobSystem* jobs, const std::function<void(unsigned int, unsigned int)>& body)
+	{
+		if (!jobs)
+		{
+			body(0, rows);
+			return;
+		}
+
+		JobCounter counter;
+		jobs->ParallelFor(rows, ENVIRONMENT_ROWS_PER_JOB, body, &counter);
+		jobs->Wait(&counter);
+	}
+
+	float Clamp(float value, float low, float high)
+	{
+		return value < low ? low : (value > high ? high : value);
+	}
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		v[0] /= length;
+		v[1] /= length;
+		v[2] /= length;
+	}
+
+	// Bands 0 to 2 of the real spherical harmonics at a unit direction
+	void EvaluateBasis(const float d[3], float basis[ENVIRONMENT_SH_COEFFICIENTS])
+	{
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * d[1];
+		basis[2] = 0.488603f * d[2];
+		basis[3] = 0.488603f * d[0];
+		basis[4] = 1.092548f * d[0] * d[1];
+		basis[5] = 1.092548f * d[1] * d[2];
+		basis[6] = 0.315392f * (3.0f * d[2] * d[2] - 1.0f);
+		basis[7] = 1.092548f * d[0] * d[2];
+		basis[8] = 0.546274f * (d[0] * d[0] - d[1] * d[1]);
+	}
+
+	// Direction through a point of a face, u and v from -1 to 1 across and down it
+	void GetFaceDirection(unsigned int face, float u, float v, float d[3])
+	{
+		switch (face)
+		{
+		case 0: d[0] = 1.0f; d[1] = -v; d[2] = -u; break;
+		case 1: d[0] = -1.0f; d[1] = -v; d[2] = u; break;
+		case 2: d[0] = u; d[1] = 1.0f; d[2] = v; break;
+		case 3: d[0] = u; d[1] = -1.0f; d[2] = -v; break;
+		case 4: d[0] = u; d[1] = -v; d[2] = 1.0f; break;
+		default: d[0] = -u; d[1] = -v; d[2] = -1.0f; break;
+		}
+	}
+
+	// The face a direction points at, and where on it from 0 to 1
+	void GetFaceCoordinates(const float d[3], unsigned int* face, float* s, float* t)
+	{
+		float x = std::fabs(d[0]);
+		float y = std::fabs(d[1]);
+		float z = std::fabs(d[2]);
+		float major, across, down;
+		if (x >= y && x >= z)
+		{
+			major = x;
+			*face = d[0] > 0.0f ? 0 : 1;
+			across = d[0] > 0.0f ? -d[2] : d[2];
+			down = -d[1];
+		}
+		else if (y >= z)
+		{
+			major = y;
+			*face = d[1] > 0.0f ? 2 : 3;
+			across = d[0];
+			down = d[1] > 0.0f ? d[2] : -d[2];
+		}
+		else
+		{
+			major = z;
+			*face = d[2] > 0.0f ? 4 : 5;
+			across = d[2] > 0.0f ? d[0] : -d[0];
+			down = -d[1];
+		}
+		*s = 0.5f * (across / major + 1.0f);
+		*t = 0.5f * (down / major + 1.0f);
+	}
+
+	// Bilinear within a face, clamped at its edges rather than crossing to the next
+	Rgba SampleFace(const CubeImage& level, unsigned int face, float s, float t)
+	{
+		float last = (float)(level.Size - 1);
+		float x = Clamp(s * level.Size - 0.5f, 0.0f, last);
+		float y = Clamp(t * level.Size - 0.5f, 0.0f, last);
+		unsigned int x0 = (unsigned int)x;
+		unsigned int y0 = (unsigned int)y;
+		unsigned int x1 = x0 + 1 < level.Size ? x0 + 1 : x0;
+		unsigned int y1 = y0 + 1 < level.Size ? y0 + 1 : y0;
+		float fx = x - x0;
+		float fy = y - y0;
+
+		Rgba sum = Zero();
+		sum = AddWeighted(sum, Load(level.GetTexel(face, x0, y0)), (1.0f - fx) * (1.0f - fy));
+		sum = AddWeighted(sum, Load(level.GetTexel(face, x1, y0)), fx * (1.0f - fy));
+		sum = AddWeighted(sum, Load(level.GetTexel(face, x0, y1)), (1.0f - fx) * fy);
+		sum = AddWeighted(sum, Load(level.GetTexel(face, x1, y1)), fx * fy);
+		return sum;
+	}
+
+	// Trilinear between the two levels around lod
+	Rgba SampleChain(const std::vector<CubeImage>& chain, const float d[3], float lod)
+	{
+		unsigned int face = 0;
+		float s = 0.0f;
+		float t = 0.0f;
+		GetFaceCoordinates(d, &face, &s, &t);
+
+		lod = Clamp(lod, 0.0f, (float)(chain.size() - 1));
+		unsigned int level = (unsigned int)lod;
+		float blend = lod - level;
+		Rgba result = SampleFace(chain[level], face, s, t);
+		if (blend > 0.0f && level + 1 < chain.size())
+			result = AddWeighted(AddWeighted(Zero(), result, 1.0f - blend), SampleFace(chain[level + 1], face, s, t), blend);
+		return result;
+	}
+
+	// 2x2 averages of each face down to 1x1, for the rough levels to read wide areas from
+	void BuildChain(const CubeImage& cube, std::vector<CubeImage>& chain, JobSystem* jobs)
+	{
+		chain.clear();
+		chain.push_back(cube);
+		while (chain.back().Size > 1)
+		{
+			const CubeImage& source = chain.back();
+			CubeImage next;
+			next.Allocate(source.Size / 2);
+			RunRows(ENVIRONMENT_FACES * next.Size, jobs, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int row = begin; row < end; row++)
+				{
+					unsigned int face = row / next.Size;
+					unsigned int y = row % next.Size;
+					for (unsigned int x = 0; x < next.Size; x++)
+					{
+						Rgba sum = Zero();
+						sum = AddWeighted(sum, Load(source.GetTexel(face, x * 2, y * 2)), 0.25f);
+						sum = AddWeighted(sum, Load(source.GetTexel(face, x * 2 + 1, y * 2)), 0.25f);
+						sum = AddWeighted(sum, Load(source.GetTexel(face, x * 2, y * 2 + 1)), 0.25f);
+						sum = AddWeighted(sum, Load(source.GetTexel(face, x * 2 + 1, y * 2 + 1)), 0.25f);
+						Store(next.GetTexel(face, x, y), sum);
+					}
+				}
+			});
+			chain.push_back(std::move(next));
+		}
+	}
+
+	// Second coordinate of the Hammersley set: the bits of i mirrored about the point
+	float RadicalInverse(unsigned int i)
+	{
+		i = (i << 16) | (i >> 16);
+		i = ((i & 0x55555555u) << 1) | ((i & 0xAAAAAAAAu) >> 1);
+		i = ((i & 0x33333333u) << 2) | ((i & 0xCCCCCCCCu) >> 2);
+		i = ((i & 0x0F0F0F0Fu) << 4) | ((i & 0xF0F0F0F0u) >> 4);
+		i = ((i & 0x00FF00FFu) << 8) | ((i & 0xFF00FF00u) >> 8);
+		return i * 2.3283064365386963e-10f;
+	}
+
+	// Half vector around +z distributed like GGX, alpha being roughness squared
+	void SampleGGX(unsigned int i, unsigned int count, float alpha, float h[3])
+	{
+		float phi = 2.0f * pi * (i + 0.5f) / count;
+		float e = RadicalInverse(i);
+		float cosTheta = std::sqrt((1.0f - e) / (1.0f + (alpha * alpha - 1.0f) * e));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		h[0] = sinTheta * std::cos(phi);
+		h[1] = sinTheta * std::sin(phi);
+		h[2] = cosTheta;
+	}
+
+	float DistributionGGX(float NdotH, float alpha)
+	{
+		float a2 = alpha * alpha;
+		float denominator = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (pi * denominator * denominator);
+	}
+
+	// Samples of one level's lobe, taking the view to be along the normal. Each reads
+	// the source level whose texels cover about the solid angle the sample stands for,
+	// so few samples still see the whole lobe without speckles.
+	void BuildLobe(float roughness, unsigned int count, float mirrorLod, float sourceTexelAngle, std::vector<LobeSample>& lobe)
+	{
+		lobe.clear();
+		float alpha = roughness * roughness;
+		for (unsigned int i = 0; roughness > 0.0f && i < count; i++)
+		{
+			float h[3];
+			SampleGGX(i, count, alpha, h);
+			LobeSample sample = {};
+			sample.Direction[0] = 2.0f * h[2] * h[0];
+			sample.Direction[1] = 2.0f * h[2] * h[1];
+			sample.Direction[2] = 2.0f * h[2] * h[2] - 1.0f;
+			sample.Weight = sample.Direction[2];
+			if (sample.Weight <= 0.0f)
+				continue;
+
+			//with the view along the normal, the pdf of the reflected direction is D / 4
+			float pdf = DistributionGGX(h[2], alpha) * 0.25f;
+			float sampleAngle = 1.0f / (count * pdf + 1e-6f);
+			sample.Lod = 0.5f * std::log2(sampleAngle / sourceTexelAngle) + 1.0f;
+			sample.Lod = sample.Lod > mirrorLod ? sample.Lod : mirrorLod;
+			lobe.push_back(sample);
+		}
+
+		//a mirror, or a lobe too narrow for any sample to miss the normal
+		if (lobe.empty())
+			lobe.push_back({ { 0.0f, 0.0f, 1.0f }, 1.0f, mirrorLod });
+	}
+
+	float GeometrySchlickGGX(float NdotX, float k)
+	{
+		return NdotX / (NdotX * (1.0f - k) + k);
+	}
+
+	// Half floats rounded to nearest, overflowing to infinity
+	unsigned short FloatToHalf(float value)
+	{
+		unsigned int bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+		float magnitude = std::fabs(value);
+		if (magnitude != magnitude)
+			return sign | 0x7E00;
+		if (magnitude >= 65520.0f)
+			return sign | 0x7C00;
+		if (magnitude < 6.103515625e-05f)
+			return sign | (unsigned short)std::lrint(magnitude * 16777216.0f);
+
+		//a mantissa rounding up to 1024 carries into the exponent, as it should
+		int exponent = 0;
+		float fraction = std::frexp(magnitude, &exponent);
+		unsigned int mantissa = (unsigned int)std::lrint((fraction * 2.0f - 1.0f) * 1024.0f);
+		return sign | (unsigned short)(((unsigned int)(exponent + 14) << 10) + mantissa);
+	}
+
+	float HalfToFloat(unsigned short half)
+	{
+		unsigned int exponent = (half >> 10) & 0x1F;
+		unsigned int mantissa = half & 0x3FF;
+		float value;
+		if (exponent == 0)
+			value = std::ldexp((float)mantissa, -24);
+		else if (exponent == 31)
+			value = mantissa ? NAN : INFINITY;
+		else
+			value = std::ldexp((float)(mantissa | 0x400), (int)exponent - 25);
+		return (half & 0x8000) ? -value : value;
+	}
+
+	// Linear RGB of a face's top level, alpha dropped
+	bool DecodeFace(const DdsLevel& level, unsigned int format, CubeImage& cube, unsigned int face)
+	{
+		TextureImage decoded;
+		if (format == DDS_FORMAT_BC1_UNORM || format == DDS_FORMAT_BC1_UNORM_SRGB)
+			BlockCompressor::Decompress(level.Data.data(), level.Width, level.Height, BlockFormatBC1, decoded);
+
+		bool bgr = format == DDS_FORMAT_B8G8R8A8_UNORM || format == DDS_FORMAT_B8G8R8X8_UNORM || format == DDS_FORMAT_B8G8R8A8_UNORM_SRGB;
+		for (unsigned int y = 0; y < cube.Size; y++)
+		{
+			for (unsigned int x = 0; x < cube.Size; x++)
+			{
+				size_t i = (size_t)y * cube.Size + x;
+				float* texel = cube.GetTexel(face, x, y);
+				switch (format)
+				{
+				case DDS_FORMAT_R32G32B32A32_FLOAT:
+					memcpy(texel, &level.Data[i * 16], 3 * sizeof(float));
+					break;
+				case DDS_FORMAT_R16G16B16A16_FLOAT:
+					for (unsigned int c = 0; c < 3; c++)
+					{
+						unsigned short half = 0;
+						memcpy(&half, &level.Data[i * 8 + c * 2], sizeof(half));
+						texel[c] = HalfToFloat(half);
+					}
+					break;
+				case DDS_FORMAT_BC1_UNORM:
+				case DDS_FORMAT_BC1_UNORM_SRGB:
+				case DDS_FORMAT_R8G8B8A8_UNORM:
+				case DDS_FORMAT_R8G8B8A8_UNORM_SRGB:
+				case DDS_FORMAT_B8G8R8A8_UNORM:
+				case DDS_FORMAT_B8G8R8X8_UNORM:
+				case DDS_FORMAT_B8G8R8A8_UNORM_SRGB:
+				{
+					//stored for display, so undone with the same 2.2 the shaders use
+					const unsigned char* bytes = decoded.Channels ? decoded.GetPixel(x, y) : &level.Data[i * 4];
+					for (unsigned int c = 0; c < 3; c++)
+						texel[c] = std::pow(bytes[bgr ? 2 - c : c] / 255.0f, 2.2f);
+					break;
+				}
+				default:
+					return false;
+				}
+				texel[3] = 1.0f;
+			}
+		}
+		return true;
+	}
+
+	bool IsNewer(const std::string& path, time_t than)
+	{
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 && info.st_mtime >= than;
+	}
+
+	// First line of the irradiance file, so a cache built with other settings is rebuilt
+	std::string DescribeSettings(const EnvironmentSettings& settings)
+	{
+		char line[160];
+		snprintf(line, sizeof(line), "# SH irradiance; specular %u x %u mips, %u samples; brdf %u, %u samples",
+			settings.SpecularSize, settings.SpecularMips, settings.SpecularSamples, settings.BrdfSize, settings.BrdfSamples);
+		return line;
+	}
+
+	std::string RemoveExtension(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of("/\\");
+		return dot == std::string::npos || (slash != std::string::npos && dot < slash) ? path : path.substr(0, dot);
+	}
+}
+
+bool EnvironmentLighting::ReadCube(const std::string& path, CubeImage& cube)
+{
+	DdsInfo info = {};
+	std::vector<DdsLevel> levels;
+	if (!DdsFile::ReadCube(path, info, levels) || info.Width != info.Height)
+		return false;
+
+	cube.Allocate(info.Width);
+	for (unsigned int face = 0; face < ENVIRONMENT_FACES; face++)
+	{
+		if (!DecodeFace(levels[face * info.MipCount], info.Format, cube, face))
+			return false;
+	}
+	return true;
+}
+
+void EnvironmentLighting::ProjectIrradiance(const CubeImage& cube, SHIrradiance& irradiance, JobSystem* jobs)
+{
+	//each row sums on its own, then rows add up in order so threads don't change the result
+	unsigned int rows = ENVIRONMENT_FACES * cube.Size;
+	std::vector<float> rowSums((size_t)rows * ENVIRONMENT_SH_COEFFICIENTS * 4);
+	std::vector<float> rowAngles(rows);
+	RunRows(rows, jobs, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int row = begin; row < end; row++)
+		{
+			unsigned int face = row / cube.Size;
+			unsigned int y = row % cube.Size;
+			Rgba sums[ENVIRONMENT_SH_COEFFICIENTS];
+			for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+				sums[k] = Zero();
+
+			float angle = 0.0f;
+			for (unsigned int x = 0; x < cube.Size; x++)
+			{
+				float direction[3];
+				float basis[ENVIRONMENT_SH_COEFFICIENTS];
+				GetTexelDirection(face, x, y, cube.Size, direction);
+				EvaluateBasis(direction, basis);
+				float texelAngle = GetTexelSolidAngle(x, y, cube.Size);
+
+				Rgba texel = Load(cube.GetTexel(face, x, y));
+				for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+					sums[k] = AddWeighted(sums[k], texel, basis[k] * texelAngle);
+				angle += texelAngle;
+			}
+
+			for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+				Store(&rowSums[((size_t)row * ENVIRONMENT_SH_COEFFICIENTS + k) * 4], sums[k]);
+			rowAngles[row] = angle;
+		}
+	});
+
+	double totals[ENVIRONMENT_SH_COEFFICIENTS][3] = {};
+	double angle = 0.0;
+	for (unsigned int row = 0; row < rows; row++)
+	{
+		for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+				totals[k][c] += rowSums[((size_t)row * ENVIRONMENT_SH_COEFFICIENTS + k) * 4 + c];
+		}
+		angle += rowAngles[row];
+	}
+
+	//texel solid angles only approximate the sphere, so they're scaled to cover it exactly
+	double scale = 4.0 * pi / angle;
+	for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+			irradiance.Coefficients[k][c] = (float)(totals[k][c] * scale * bandScales[k]);
+	}
+}
+
+void EnvironmentLighting::EvaluateIrradiance(const SHIrradiance& irradiance, const float direction[3], float color[3])
+{
+	float d[3] = { direction[0], direction[1], direction[2] };
+	Normalize(d);
+	float basis[ENVIRONMENT_SH_COEFFICIENTS];
+	EvaluateBasis(d, basis);
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		float sum = 0.0f;
+		for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+			sum += irradiance.Coefficients[k][c] * basis[k];
+
+		//three bands ring a little below zero opposite a bright sun
+		color[c] = sum > 0.0f ? sum : 0.0f;
+	}
+}
+
+void EnvironmentLighting::PrefilterSpecular(const CubeImage& cube, const EnvironmentSettings& settings, std::vector<CubeImage>& levels, JobSystem* jobs)
+{
+	std::vector<CubeImage> chain;
+	BuildChain(cube, chain, jobs);
+	float sourceTexelAngle = 4.0f * pi / (ENVIRONMENT_FACES * (float)cube.Size * cube.Size);
+
+	levels.assign(settings.SpecularMips, CubeImage());
+	std::vector<LobeSample> lobe;
+	for (unsigned int m = 0; m < settings.SpecularMips; m++)
+	{
+		CubeImage& level = levels[m];
+		unsigned int size = settings.SpecularSize >> m;
+		level.Allocate(size > 0 ? size : 1);
+
+		//the source level about this one's size, so even the mirror level doesn't alias
+		float mirrorLod = std::log2((float)cube.Size / level.Size);
+		mirrorLod = mirrorLod > 0.0f ? mirrorLod : 0.0f;
+		float roughness = settings.SpecularMips > 1 ? (float)m / (settings.SpecularMips - 1) : 0.0f;
+		BuildLobe(roughness, settings.SpecularSamples, mirrorLod, sourceTexelAngle, lobe);
+
+		RunRows(ENVIRONMENT_FACES * level.Size, jobs, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int row = begin; row < end; row++)
+			{
+				unsigned int face = row / level.Size;
+				unsigned int y = row % level.Size;
+				for (unsigned int x = 0; x < level.Size; x++)
+				{
+					float n[3];
+					GetTexelDirection(face, x, y, level.Size, n);
+
+					//a frame around the normal to turn the lobe into
+					float up[3] = { 0.0f, 0.0f, 1.0f };
+					if (std::fabs(n[2]) > 0.999f)
+					{
+						up[0] = 1.0f;
+						up[2] = 0.0f;
+					}
+					float t[3] = { up[1] * n[2] - up[2] * n[1], up[2] * n[0] - up[0] * n[2], up[0] * n[1] - up[1] * n[0] };
+					Normalize(t);
+					float b[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+					Rgba sum = Zero();
+					float weight = 0.0f;
+					for (const LobeSample& sample : lobe)
+					{
+						const float* l = sample.Direction;
+						float direction[3] =
+						{
+							t[0] * l[0] + b[0] * l[1] + n[0] * l[2],
+							t[1] * l[0] + b[1] * l[1] + n[1] * l[2],
+							t[2] * l[0] + b[2] * l[1] + n[2] * l[2]
+						};
+						sum = AddWeighted(sum, SampleChain(chain, direction, sample.Lod), sample.Weight);
+						weight += sample.Weight;
+					}
+					Store(level.GetTexel(face, x, y), AddWeighted(Zero(), sum, 1.0f / weight));
+				}
+			}
+		});
+	}
+}
+
+void EnvironmentLighting::IntegrateBrdf(const EnvironmentSettings& settings, std::vector<float>& table, JobSystem* jobs)
+{
+	unsigned int size = settings.BrdfSize;
+	table.assign((size_t)size * size * 2, 0.0f);
+	RunRows(size, jobs, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int y = begin; y < end; y++)
+		{
+			float roughness = (y + 0.5f) / size;
+			float alpha = roughness * roughness;
+
+			//image based lighting remaps k to alpha / 2, unlike the lights' (r + 1)^2 / 8
+			float k = alpha * 0.5f;
+			for (unsigned int x = 0; x < size; x++)
+			{
+				float NdotV = (x + 0.5f) / size;
+				float v[3] = { std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV };
+				float scale = 0.0f;
+				float bias = 0.0f;
+				for (unsigned int i = 0; i < settings.BrdfSamples; i++)
+				{
+					float h[3];
+					SampleGGX(i, settings.BrdfSamples, alpha, h);
+					float VdotH = v[0] * h[0] + v[1] * h[1] + v[2] * h[2];
+					float NdotL = 2.0f * VdotH * h[2] - v[2];
+					if (NdotL <= 0.0f || VdotH <= 0.0f)
+						continue;
+
+					//the pdf of GGX sampling cancels D, leaving G * VdotH / (NdotH * NdotV)
+					float visibility = GeometrySchlickGGX(NdotV, k) * GeometrySchlickGGX(NdotL, k) * VdotH / (h[2] * NdotV);
+					float fresnel = std::pow(1.0f - VdotH, 5.0f);
+					scale += (1.0f - fresnel) * visibility;
+					bias += fresnel * visibility;
+				}
+
+				float* texel = &table[((size_t)y * size + x) * 2];
+				texel[0] = scale / settings.BrdfSamples;
+				texel[1] = bias / settings.BrdfSamples;
+			}
+		}
+	});
+}
+
+void EnvironmentLighting::GetTexelDirection(unsigned int face, unsigned int x, unsigned int y, unsigned int size, float direction[3])
+{
+	GetFaceDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f, direction);
+	Normalize(direction);
+}
+
+float EnvironmentLighting::GetTexelSolidAngle(unsigned int x, unsigned int y, unsigned int size)
+{
+	float u = 2.0f * (x + 0.5f) / size - 1.0f;
+	float v = 2.0f * (y + 0.5f) / size - 1.0f;
+	float texel = 2.0f / size;
+	float distanceSquared = 1.0f + u * u + v * v;
+	return texel * texel / (distanceSquared * std::sqrt(distanceSquared));
+}
+
+bool EnvironmentLighting::WriteSpecular(const std::string& path, const std::vector<CubeImage>& levels)
+{
+	std::vector<DdsLevel> faces;
+	for (unsigned int face = 0; face < ENVIRONMENT_FACES; face++)
+	{
+		for (const CubeImage& level : levels)
+		{
+			DdsLevel out = { level.Size, level.Size, {} };
+			out.Data.resize((size_t)level.Size * level.Size * 8);
+			for (size_t i = 0; i < (size_t)level.Size * level.Size * 4; i++)
+			{
+				unsigned short half = FloatToHalf(level.Texels[(size_t)face * level.Size * level.Size * 4 + i]);
+				memcpy(&out.Data[i * 2], &half, sizeof(half));
+			}
+			faces.push_back(std::move(out));
+		}
+	}
+	return DdsFile::WriteCube(path, DDS_FORMAT_R16G16B16A16_FLOAT, faces);
+}
+
+bool EnvironmentLighting::WriteBrdf(const std::string& path, const std::vector<float>& table, unsigned int size)
+{
+	DdsLevel level = { size, size, {} };
+	level.Data.resize(table.size() * 2);
+	for (size_t i = 0; i < table.size(); i++)
+	{
+		unsigned short half = FloatToHalf(table[i]);
+		memcpy(&level.Data[i * 2], &half, sizeof(half));
+	}
+	return DdsFile::Write(path, DDS_FORMAT_R16G16_FLOAT, { level });
+}
+
+bool EnvironmentLighting::WriteIrradiance(const std::string& path, const SHIrradiance& irradiance, const EnvironmentSettings& settings)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+
+	bool ok = fprintf(file, "%s\n", DescribeSettings(settings).c_str()) > 0;
+	for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+	{
+		const float* rgb = irradiance.Coefficients[k];
+		ok = ok && fprintf(file, "%.9g %.9g %.9g\n", rgb[0], rgb[1], rgb[2]) > 0;
+	}
+	fclose(file);
+	return ok;
+}
+
+bool EnvironmentLighting::ReadIrradiance(const std::string& path, SHIrradiance& irradiance, const EnvironmentSettings& settings)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (!file)
+		return false;
+
+	char line[256] = {};
+	bool ok = fgets(line, sizeof(line), file) != 0 && DescribeSettings(settings) + "\n" == line;
+	for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+	{
+		float* rgb = irradiance.Coefficients[k];
+		ok = ok && fscanf(file, "%f %f %f", &rgb[0], &rgb[1], &rgb[2]) == 3;
+	}
+	fclose(file);
+	return ok;
+}
+
+std::string EnvironmentLighting::GetIrradiancePath(const std::string& cubePath)
+{
+	return RemoveExtension(cubePath) + ENVIRONMENT_IRRADIANCE_FILE;
+}
+
+std::string EnvironmentLighting::GetSpecularPath(const std::string& cubePath)
+{
+	return RemoveExtension(cubePath) + ENVIRONMENT_SPECULAR_FILE;
+}
+
+std::string EnvironmentLighting::GetBrdfPath(const std::string& cubePath)
+{
+	size_t slash = cubePath.find_last_of("/\\");
+	return (slash == std::string::npos ? std::string() : cubePath.substr(0, slash + 1)) + ENVIRONMENT_BRDF_FILE;
+}
+
+bool EnvironmentLighting::LoadOrBuild(const std::string& cubePath, const EnvironmentSettings& settings, SHIrradiance& irradiance, JobSystem* jobs,
+	bool* built)
+{
+	struct stat source;
+	if (stat(cubePath.c_str(), &source) != 0)
+		return false;
+
+	std::string irradiancePath = GetIrradiancePath(cubePath);
+	std::string specularPath = GetSpecularPath(cubePath);
+	std::string brdfPath = GetBrdfPath(cubePath);
+	bool current = IsNewer(specularPath, source.st_mtime) && IsNewer(brdfPath, source.st_mtime) && IsNewer(irradiancePath, source.st_mtime)
+		&& ReadIrradiance(irradiancePath, irradiance, settings);
+	if (built)
+		*built = !current;
+	if (current)
+		return true;
+
+	CubeImage cube;
+	if (!ReadCube(cubePath, cube))
+		return false;
+
+	std::vector<CubeImage> specular;
+	std::vector<float> brdf;
+	ProjectIrradiance(cube, irradiance, jobs);
+	PrefilterSpecular(cube, settings, specular, jobs);
+	IntegrateBrdf(settings, brdf, jobs);
+
+	//the irradiance goes last, since it's what says the others are done
+	return WriteSpecular(specularPath, specular) && WriteBrdf(brdfPath, brdf, settings.BrdfSize)
+		&& WriteIrradiance(irradiancePath, irradiance, settings);
+}
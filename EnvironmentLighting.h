@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Faces of a cube map, in D3D order: +X, -X, +Y, -Y, +Z, -Z
+#define ENVIRONMENT_FACES 6
+
+// Spherical harmonics coefficients of bands 0 to 2, all irradiance needs
+#define ENVIRONMENT_SH_COEFFICIENTS 9
+
+// What the cache files of a cube map are named, after its path without extension
+#define ENVIRONMENT_IRRADIANCE_FILE "_irradiance.txt"
+#define ENVIRONMENT_SPECULAR_FILE "_specular.dds"
+
+// The BRDF table doesn't depend on the cube map, so one sits in its folder
+#define ENVIRONMENT_BRDF_FILE "brdf_lut.dds"
+
+// --------------------------------------------------------
+// A square cube map in linear float RGBA, face after face,
+// rows top to bottom. Four floats per texel so a texel
+// fills a register.
+// --------------------------------------------------------
+struct CubeImage
+{
+	unsigned int Size = 0;
+	std::vector<float> Texels;
+
+	void Allocate(unsigned int size)
+	{
+		Size = size;
+		Texels.assign((size_t)ENVIRONMENT_FACES * size * size * 4, 0.0f);
+	}
+
+	float* GetTexel(unsigned int face, unsigned int x, unsigned int y) { return &Texels[(((size_t)face * Size + y) * Size + x) * 4]; }
+	const float* GetTexel(unsigned int face, unsigned int x, unsigned int y) const { return &Texels[(((size_t)face * Size + y) * Size + x) * 4]; }
+};
+
+// --------------------------------------------------------
+// Diffuse lighting from every direction as RGB spherical
+// harmonics, already convolved with the cosine lobe and
+// divided by pi: evaluated at a normal, it's what a white
+// Lambertian surface facing that way reflects
+// --------------------------------------------------------
+struct SHIrradiance
+{
+	float Coefficients[ENVIRONMENT_SH_COEFFICIENTS][3];
+};
+
+struct EnvironmentSettings
+{
+	unsigned int SpecularSize = 128;	// Top level of the prefiltered cube
+	unsigned int SpecularMips = 6;		// Roughness 0 to 1 across these
+	unsigned int SpecularSamples = 128;	// GGX samples per texel of the rough levels
+	unsigned int BrdfSize = 128;		// Of the square BRDF table
+	unsigned int BrdfSamples = 256;		// Per texel of the BRDF table
+};
+
+// --------------------------------------------------------
+// Preprocesses a sky cube map into image based lighting:
+// irradiance projected to spherical harmonics for diffuse,
+// a GGX prefiltered mip chain for specular (a roughness per
+// level, sampled with the reflection vector) and the split
+// sum BRDF table that scales and biases it by F0. Rows run
+// four channels at a time with SSE2 where available, spread
+// over a JobSystem when given one; results don't depend on
+// the thread count.
+// --------------------------------------------------------
+class EnvironmentLighting
+{
+public:
+	//A cube DDS of 8 bit colour (taken as gamma 2.2), BC1 or float texels, top level only
+	static bool ReadCube(const std::string& path, CubeImage& cube);
+
+	static void ProjectIrradiance(const CubeImage& cube, SHIrradiance& irradiance, JobSystem* jobs = 0);
+	static void EvaluateIrradiance(const SHIrradiance& irradiance, const float direction[3], float color[3]);
+
+	//levels[m] is for roughness m / (SpecularMips - 1), from SpecularSize down
+	static void PrefilterSpecular(const CubeImage& cube, const EnvironmentSettings& settings, std::vector<CubeImage>& levels, JobSystem* jobs = 0);
+
+	//Scale and bias of F0 per texel, rows by roughness and columns by NdotV
+	static void IntegrateBrdf(const EnvironmentSettings& settings, std::vector<float>& table, JobSystem* jobs = 0);
+
+	//Unit direction through the centre of a texel, and the solid angle it covers
+	static void GetTexelDirection(unsigned int face, unsigned int x, unsigned int y, unsigned int size, float direction[3]);
+	static float GetTexelSolidAngle(unsigned int x, unsigned int y, unsigned int size);
+
+	//Specular cube as RGBA16F and BRDF table as RG16F, for the game to load as they are
+	static bool WriteSpecular(const std::string& path, const std::vector<CubeImage>& levels);
+	static bool WriteBrdf(const std::string& path, const std::vector<float>& table, unsigned int size);
+
+	//Text, headed by the settings the cache was built with; reading fails for other settings
+	static bool WriteIrradiance(const std::string& path, const SHIrradiance& irradiance, const EnvironmentSettings& settings);
+	static bool ReadIrradiance(const std::string& path, SHIrradiance& irradiance, const EnvironmentSettings& settings);
+
+	//Cache files of a cube map, next to it
+	static std::string GetIrradiancePath(const std::string& cubePath);
+	static std::string GetSpecularPath(const std::string& cubePath);
+	static std::string GetBrdfPath(const std::string& cubePath);
+
+	//Reads the irradiance from the cache, building all three files first if any is
+	//missing, older than the cube map or made with other settings. built says which.
+	static bool LoadOrBuild(const std::string& cubePath, const EnvironmentSettings& settings, SHIrradiance& irradiance, JobSystem* jobs = 0,
+		bool* built = 0);
+};
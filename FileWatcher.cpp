@@ -0,0 +1,263 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <cctype>
+
+#if defined(_WIN32)
+#define FILE_WATCHER_WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#define FILE_WATCHER_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef FILE_WATCHER_WIN32
+
+namespace
+{
+	std::wstring ToWide(const std::string& text)
+	{
+		int length = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), 0, 0);
+		std::wstring wide(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), &wide[0], length);
+		return wide;
+	}
+
+	std::string ToNarrow(const wchar_t* text, int length)
+	{
+		int size = WideCharToMultiByte(CP_UTF8, 0, text, length, 0, 0, 0, 0);
+		std::string narrow(size, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, text, length, &narrow[0], size, 0, 0);
+		return narrow;
+	}
+}
+
+// One overlapped ReadDirectoryChangesW per directory, always in flight
+struct FileWatcher::Platform
+{
+	struct Directory
+	{
+		std::string Path;
+		HANDLE Handle;
+		OVERLAPPED Overlapped;
+		DWORD Buffer[16 * 1024]; //FILE_NOTIFY_INFORMATION needs DWORD alignment
+	};
+	std::vector<std::unique_ptr<Directory>> directories;
+
+	~Platform()
+	{
+		for (auto& directory : directories)
+		{
+			DWORD bytes = 0;
+			CancelIo(directory->Handle);
+			GetOverlappedResult(directory->Handle, &directory->Overlapped, &bytes, TRUE);
+			CloseHandle(directory->Overlapped.hEvent);
+			CloseHandle(directory->Handle);
+		}
+	}
+
+	static bool Issue(Directory& directory)
+	{
+		return ReadDirectoryChangesW(directory.Handle, directory.Buffer, sizeof(directory.Buffer), FALSE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, 0, &directory.Overlapped, 0) != 0;
+	}
+
+	bool Watch(const std::string& path)
+	{
+		std::unique_ptr<Directory> directory = std::make_unique<Directory>();
+		directory->Path = path;
+		directory->Handle = CreateFileW(ToWide(path).c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0);
+		if (directory->Handle == INVALID_HANDLE_VALUE)
+			return false;
+
+		directory->Overlapped = {};
+		directory->Overlapped.hEvent = CreateEventW(0, TRUE, FALSE, 0);
+		if (!Issue(*directory))
+		{
+			CloseHandle(directory->Overlapped.hEvent);
+			CloseHandle(directory->Handle);
+			return false;
+		}
+
+		directories.push_back(std::move(directory));
+		return true;
+	}
+
+	void Read(std::vector<std::string>& paths)
+	{
+		for (auto& directory : directories)
+		{
+			DWORD bytes = 0;
+			if (!GetOverlappedResult(directory->Handle, &directory->Overlapped, &bytes, FALSE))
+				continue;
+
+			//no bytes means the buffer overflowed and this batch is lost
+			const unsigned char* entry = (const unsigned char*)directory->Buffer;
+			while (bytes)
+			{
+				const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)entry;
+				if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+					paths.push_back(directory->Path + "/" + ToNarrow(info->FileName, (int)(info->FileNameLength / sizeof(wchar_t))));
+				if (!info->NextEntryOffset)
+					break;
+				entry += info->NextEntryOffset;
+			}
+
+			ResetEvent(directory->Overlapped.hEvent);
+			Issue(*directory);
+		}
+	}
+};
+
+#elif defined(FILE_WATCHER_INOTIFY)
+
+// One inotify instance, a watch per directory, read without blocking
+struct FileWatcher::Platform
+{
+	int descriptor;
+	std::unordered_map<int, std::string> directories; //by watch descriptor
+
+	Platform()
+	{
+		descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	}
+
+	~Platform()
+	{
+		if (descriptor >= 0)
+			close(descriptor);
+	}
+
+	bool Watch(const std::string& path)
+	{
+		if (descriptor < 0)
+			return false;
+
+		//modifications keep a file unsettled until it's closed or renamed into place
+		int watch = inotify_add_watch(descriptor, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (watch < 0)
+			return false;
+
+		directories[watch] = path;
+		return true;
+	}
+
+	void Read(std::vector<std::string>& paths)
+	{
+		if (descriptor < 0)
+			return;
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		for (;;)
+		{
+			ssize_t bytes = read(descriptor, buffer, sizeof(buffer));
+			if (bytes <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < bytes;)
+			{
+				const inotify_event* event = (const inotify_event*)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				auto directory = directories.find(event->wd);
+				if (event->len == 0 || (event->mask & IN_ISDIR) || directory == directories.end())
+					continue;
+				paths.push_back(directory->second + "/" + event->name);
+			}
+		}
+	}
+};
+
+#else
+
+// No notifications to watch with
+struct FileWatcher::Platform
+{
+	bool Watch(const std::string& path) { return false; }
+	void Read(std::vector<std::string>& paths) {}
+};
+
+#endif
+
+FileWatcher::FileWatcher(unsigned int settleMilliseconds)
+	: platform(std::make_unique<Platform>()), settle(std::chrono::milliseconds(settleMilliseconds))
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	return platform->Watch(NormalizePath(directory));
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+	//every event pushes its file's settle time back
+	std::vector<std::string> paths;
+	platform->Read(paths);
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	for (const std::string& path : paths)
+		unsettled[NormalizePath(path)] = now;
+
+	size_t first = changed.size();
+	for (auto file = unsettled.begin(); file != unsettled.end();)
+	{
+		if (now - file->second < settle)
+		{
+			++file;
+			continue;
+		}
+		changed.push_back(file->first);
+		file = unsettled.erase(file);
+	}
+
+	//the map's order isn't stable, this is
+	std::sort(changed.begin() + first, changed.end());
+}
+
+std::string FileWatcher::NormalizePath(const std::string& path)
+{
+	std::string unified = path;
+	for (char& c : unified)
+	{
+		if (c == '\\')
+			c = '/';
+#ifdef FILE_WATCHER_WIN32
+		c = (char)tolower((unsigned char)c);
+#endif
+	}
+
+	//a leading "/" or drive stays, and nothing goes above it
+	std::string root;
+	if (unified.size() >= 2 && unified[1] == ':')
+		root = unified.substr(0, unified.size() >= 3 && unified[2] == '/' ? 3 : 2);
+	else if (!unified.empty() && unified[0] == '/')
+		root = "/";
+
+	std::vector<std::string> segments;
+	size_t start = root.size();
+	while (start <= unified.size())
+	{
+		size_t end = unified.find('/', start);
+		if (end == std::string::npos)
+			end = unified.size();
+		std::string segment = unified.substr(start, end - start);
+		start = end + 1;
+
+		if (segment.empty() || segment == ".")
+			continue;
+		if (segment == ".." && !segments.empty() && segments.back() != "..")
+			segments.pop_back();
+		else if (segment != ".." || root.empty())
+			segments.push_back(segment);
+	}
+
+	std::string normalized = root;
+	for (size_t i = 0; i < segments.size(); i++)
+		normalized += (i ? "/" : "") + segments[i];
+	return normalized.empty() ? "." : normalized;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Reports files written in watched directories, through the
+// platform's change notifications: ReadDirectoryChangesW on
+// Windows and inotify on Linux. Editors and tools often
+// write a file in several goes, or to a temporary that's
+// renamed over it, so a file is only reported once its
+// events have been quiet for the settle time, and then just
+// once. Nothing blocks; Poll picks up whatever arrived since
+// the last call. Everything is for one thread. Has no
+// device dependency.
+// --------------------------------------------------------
+class FileWatcher
+{
+public:
+	FileWatcher(unsigned int settleMilliseconds = 100);
+	~FileWatcher();
+
+	//False if the directory can't be watched, or this platform has no notifications
+	bool Watch(const std::string& directory);
+
+	//Appends every file that settled since the last call, as NormalizePath gives it
+	void Poll(std::vector<std::string>& changed);
+
+	//The path with '/' separators and "." and ".." folded away, lower case on
+	//Windows, so two spellings of the same file compare equal. Doesn't touch the disk.
+	static std::string NormalizePath(const std::string& path);
+
+private:
+	//the OS's side, see FileWatcher.cpp
+	struct Platform;
+	std::unique_ptr<Platform> platform;
+
+	std::chrono::steady_clock::duration settle;
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> unsettled; //file, last event
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <chrono>
+#include <vector>
+#include "Transform.h"
+#include "Lights.h"
+#include "RenderQueue.h"
+#include "MipResidency.h"
+#include "AssetDependencies.h"
+#include "ImGui/imgui.h"
+
+// --------------------------------------------------------
+// What the render stage reported back for a packet, read
+// by the update stage the next time it gets the packet
+// --------------------------------------------------------
+struct FrameRenderResults
+{
+	RenderStats Stats;
+	unsigned int QueuedDraws;
+	unsigned int RecordingJobs;
+	unsigned int StateCallsIssued;
+	unsigned int StateCallsFiltered;
+	unsigned int BytesUploaded;
+	MipResidencyStats Streaming;
+	unsigned int TabledMaterials;
+	unsigned int TableSliceCopies;
+};
+
+// --------------------------------------------------------
+// Everything the render stage needs for one frame, copied
+// out of the simulation by the update stage. Once handed
+// to the render stage it is not touched by the update
+// stage until the pipeline gives it back.
+// --------------------------------------------------------
+struct FramePacket
+{
+	unsigned long long FrameIndex;
+	float DeltaTime;
+	float TotalTime;
+	std::chrono::steady_clock::time_point UpdateStart; //for latency
+
+	//Camera
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT3 CameraPosition;
+	DirectX::XMFLOAT3 AmbientColor;
+	float FarClip;
+
+	//Lights
+	std::vector<Light> Lights;
+	int LightCount;
+
+	//Entities, in the registry's dense order
+	std::vector<Transform> Transforms;
+	std::vector<DirectX::BoundingBox> WorldBounds;
+	std::vector<unsigned int> Meshes;
+	std::vector<unsigned int> Materials;
+	std::vector<unsigned int> Flags;
+
+	//Settings chosen in the UI for this frame
+	unsigned int Width;
+	unsigned int Height;
+	bool UseInstancing;
+	bool UseThreadedRecording;
+	bool UseMaterialTable;
+	bool UseFullscreenSky;
+	unsigned int StreamingBudgetMB;
+
+	//Assets whose files changed, for the render stage to reload
+	std::vector<AssetId> HotReloads;
+
+	//ImGui output, cloned so the next UI frame can start right away
+	std::vector<ImDrawList*> UIDrawLists;
+	ImDrawData UIDrawData;
+
+	FrameRenderResults Results;
+};
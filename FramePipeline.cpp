@@ -0,0 +1,181 @@
+#include "FramePipeline.h"
+
+FramePipeline::FramePipeline(unsigned int depth)
+{
+	this->depth = 0;
+	this->nextFrameIndex = 0;
+	this->stopping = false;
+
+	for (unsigned int i = 0; i < FRAME_PIPELINE_MAX_DEPTH; i++)
+	{
+		packets.push_back(std::unique_ptr<FramePacket>(new FramePacket()));
+		states.push_back(PacketFree);
+	}
+
+	windowStart = std::chrono::steady_clock::now();
+	windowFrames = 0;
+	windowLatencyMs = 0.0;
+	framesPerSecond = 0.0f;
+	averageLatencyMs = 0.0f;
+	framesReleased = 0;
+	totalLatencyMs = 0.0;
+
+	SetDepth(depth);
+}
+
+FramePipeline::~FramePipeline() {}
+
+void FramePipeline::SetDepth(unsigned int depth)
+{
+	if (depth < 1)
+		depth = 1;
+	if (depth > FRAME_PIPELINE_MAX_DEPTH)
+		depth = FRAME_PIPELINE_MAX_DEPTH;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	this->depth = depth;
+}
+
+FramePacket* FramePipeline::AcquireForUpdate()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	//only the first depth packets are in use
+	unsigned int index = 0;
+	changed.wait(lock, [&]()
+	{
+		for (index = 0; index < depth; index++)
+		{
+			if (states[index] == PacketFree)
+				return true;
+		}
+		return false;
+	});
+
+	states[index] = PacketUpdating;
+	FramePacket* packet = packets[index].get();
+	packet->FrameIndex = nextFrameIndex++;
+	packet->UpdateStart = std::chrono::steady_clock::now();
+	return packet;
+}
+
+void FramePipeline::Submit(FramePacket* packet)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		states[IndexOf(packet)] = PacketReady;
+	}
+	changed.notify_all();
+}
+
+FramePacket* FramePipeline::AcquireForRender()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [&]() { return stopping || HasState(PacketReady); });
+
+	//render in submission order
+	FramePacket* oldest = 0;
+	for (unsigned int i = 0; i < packets.size(); i++)
+	{
+		if (states[i] == PacketReady && (!oldest || packets[i]->FrameIndex < oldest->FrameIndex))
+		{
+			oldest = packets[i].get();
+		}
+	}
+	if (!oldest)
+		return 0;
+
+	states[IndexOf(oldest)] = PacketRendering;
+	return oldest;
+}
+
+void FramePipeline::Release(FramePacket* packet)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		states[IndexOf(packet)] = PacketFree;
+
+		double latencyMs = std::chrono::duration<double, std::milli>(now - packet->UpdateStart).count();
+		framesReleased++;
+		totalLatencyMs += latencyMs;
+		windowFrames++;
+		windowLatencyMs += latencyMs;
+
+		double windowSeconds = std::chrono::duration<double>(now - windowStart).count();
+		if (windowSeconds >= 1.0)
+		{
+			framesPerSecond = (float)(windowFrames / windowSeconds);
+			averageLatencyMs = (float)(windowLatencyMs / windowFrames);
+			windowStart = now;
+			windowFrames = 0;
+			windowLatencyMs = 0.0;
+		}
+	}
+	changed.notify_all();
+}
+
+void FramePipeline::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	changed.wait(lock, [&]() { return !HasState(PacketReady) && !HasState(PacketRendering); });
+}
+
+void FramePipeline::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	changed.notify_all();
+}
+
+void FramePipeline::Restart()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stopping = false;
+}
+
+float FramePipeline::GetFramesPerSecond()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return framesPerSecond;
+}
+
+float FramePipeline::GetAverageLatencyMs()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return averageLatencyMs;
+}
+
+unsigned long long FramePipeline::GetFramesReleased()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return framesReleased;
+}
+
+double FramePipeline::GetTotalLatencyMs()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return totalLatencyMs;
+}
+
+unsigned int FramePipeline::IndexOf(FramePacket* packet)
+{
+	for (unsigned int i = 0; i < packets.size(); i++)
+	{
+		if (packets[i].get() == packet)
+			return i;
+	}
+	return 0;
+}
+
+bool FramePipeline::HasState(PacketState state)
+{
+	for (PacketState s : states)
+	{
+		if (s == state)
+			return true;
+	}
+	return false;
+}
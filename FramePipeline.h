@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "FramePacket.h"
+
+// Most frame packets in flight, for triple buffering
+#define FRAME_PIPELINE_MAX_DEPTH 3
+
+// --------------------------------------------------------
+// Hands frame packets from the update stage to the render
+// stage and back. Each packet is owned by exactly one stage
+// at a time: free -> updating -> ready -> rendering -> free.
+// With a depth of 1 the stages take turns; with 2 or 3 the
+// update of the next frames overlaps rendering. Has no
+// device dependency.
+// --------------------------------------------------------
+class FramePipeline
+{
+public:
+	FramePipeline(unsigned int depth);
+	~FramePipeline();
+
+	//Changes the number of packets, only call while drained
+	void SetDepth(unsigned int depth);
+	unsigned int GetDepth() { return depth; }
+
+	//Update stage: waits for a free packet, fills it, submits it
+	FramePacket* AcquireForUpdate();
+	void Submit(FramePacket* packet);
+
+	//Render stage: waits for the oldest submitted packet, or returns
+	//null once stopped with nothing left to render
+	FramePacket* AcquireForRender();
+	void Release(FramePacket* packet);
+
+	//Waits until every submitted packet has been released
+	void Flush();
+
+	//Makes waiting render stages return null once drained, and
+	//Restart() undoes it
+	void Stop();
+	void Restart();
+
+	//Measured over the last second of released frames
+	float GetFramesPerSecond();
+	float GetAverageLatencyMs(); //update start to render release
+	unsigned long long GetFramesReleased();
+	double GetTotalLatencyMs(); //summed over every released frame
+
+	//Every packet, for cleanup while drained
+	FramePacket* GetPacket(unsigned int index) { return packets[index].get(); }
+
+private:
+	enum PacketState { PacketFree, PacketUpdating, PacketReady, PacketRendering };
+
+	std::vector<std::unique_ptr<FramePacket>> packets;
+	std::vector<PacketState> states;
+	unsigned int depth;
+	unsigned long long nextFrameIndex;
+	bool stopping;
+
+	std::mutex mutex;
+	std::condition_variable changed;
+
+	//timing window
+	std::chrono::steady_clock::time_point windowStart;
+	unsigned int windowFrames;
+	double windowLatencyMs;
+	float framesPerSecond;
+	float averageLatencyMs;
+	unsigned long long framesReleased;
+	double totalLatencyMs;
+
+	unsigned int IndexOf(FramePacket* packet);
+	bool HasState(PacketState state);
+};
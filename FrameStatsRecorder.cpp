@@ -0,0 +1,139 @@
+#include "FrameStatsRecorder.h"
+#include <algorithm>
+#include <cstdio>
+
+FrameStatsRecorder::FrameStatsRecorder(const std::string& frameSeries)
+{
+	this->frameSeries = frameSeries;
+	Reset();
+}
+
+FrameStatsRecorder::~FrameStatsRecorder() {}
+
+void FrameStatsRecorder::Reset()
+{
+	histograms.clear();
+	hitches.clear();
+	frameCount = 0;
+	hitchCount = 0;
+}
+
+void FrameStatsRecorder::AddSample(const std::string& series, float milliseconds)
+{
+	Histogram& histogram = histograms[series];
+	if (histogram.Buckets.empty())
+	{
+		histogram.Buckets.resize(FRAME_STATS_BUCKET_COUNT);
+		histogram.Min = milliseconds;
+		histogram.Max = milliseconds;
+	}
+
+	//judge the frame against the median before it joins the histogram
+	if (series == frameSeries)
+	{
+		if (histogram.Count >= FRAME_STATS_HITCH_MIN_FRAMES)
+		{
+			float median = Percentile(histogram, 0.5f);
+			if (milliseconds > median * FRAME_STATS_HITCH_FACTOR)
+			{
+				if (hitches.size() < FRAME_STATS_MAX_HITCHES)
+				{
+					FrameHitch hitch = { frameCount, milliseconds, median };
+					hitches.push_back(hitch);
+				}
+				hitchCount++;
+			}
+		}
+		frameCount++;
+	}
+
+	unsigned int bucket = (unsigned int)(std::max(milliseconds, 0.0f) / FRAME_STATS_BUCKET_MS);
+	histogram.Buckets[std::min(bucket, (unsigned int)FRAME_STATS_BUCKET_COUNT - 1)]++;
+	histogram.Count++;
+	histogram.Total += milliseconds;
+	histogram.Min = std::min(histogram.Min, milliseconds);
+	histogram.Max = std::max(histogram.Max, milliseconds);
+}
+
+bool FrameStatsRecorder::GetSummary(const std::string& series, TimingSummary* summary)
+{
+	auto found = histograms.find(series);
+	if (found == histograms.end() || found->second.Count == 0)
+		return false;
+
+	Histogram& histogram = found->second;
+	summary->Count = (unsigned int)histogram.Count;
+	summary->Min = histogram.Min;
+	summary->Average = (float)(histogram.Total / histogram.Count);
+	summary->Max = histogram.Max;
+	summary->P50 = Percentile(histogram, 0.50f);
+	summary->P95 = Percentile(histogram, 0.95f);
+	summary->P99 = Percentile(histogram, 0.99f);
+	return true;
+}
+
+void FrameStatsRecorder::WriteJson(std::ostream& stream, const std::string& runName)
+{
+	char line[256];
+
+	stream << "{\n  \"run\": \"" << runName << "\",\n";
+	stream << "  \"frames\": " << frameCount << ",\n";
+	stream << "  \"series\": {\n";
+
+	bool first = true;
+	for (auto& h : histograms)
+	{
+		TimingSummary s = {};
+		GetSummary(h.first, &s);
+		snprintf(line, sizeof(line),
+			"\"count\": %u, \"min\": %.3f, \"avg\": %.3f, \"max\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f",
+			s.Count, s.Min, s.Average, s.Max, s.P50, s.P95, s.P99);
+		stream << (first ? "" : ",\n") << "    \"" << h.first << "\": { " << line << " }";
+		first = false;
+	}
+
+	stream << "\n  },\n  \"hitches\": { \"count\": " << hitchCount << ", \"frames\": [";
+	for (unsigned int i = 0; i < hitches.size(); i++)
+	{
+		snprintf(line, sizeof(line), "%s\n    { \"frame\": %llu, \"ms\": %.3f, \"median\": %.3f }",
+			i == 0 ? "" : ",", hitches[i].Frame, hitches[i].Milliseconds, hitches[i].MedianMs);
+		stream << line;
+	}
+	stream << (hitches.empty() ? "" : "\n  ") << "] }\n}\n";
+}
+
+void FrameStatsRecorder::WriteCsv(std::ostream& stream)
+{
+	char line[256];
+
+	stream << "series,count,min,avg,max,p50,p95,p99\n";
+	for (auto& h : histograms)
+	{
+		TimingSummary s = {};
+		GetSummary(h.first, &s);
+		snprintf(line, sizeof(line), ",%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+			s.Count, s.Min, s.Average, s.Max, s.P50, s.P95, s.P99);
+		stream << h.first << line;
+	}
+	stream << "hitches," << hitchCount << ",,,,,,\n";
+}
+
+float FrameStatsRecorder::Percentile(const Histogram& histogram, float p)
+{
+	//first bucket whose running count reaches the rank
+	unsigned long long rank = (unsigned long long)(p * histogram.Count);
+	if (rank >= histogram.Count)
+		rank = histogram.Count - 1;
+
+	unsigned long long seen = 0;
+	for (unsigned int i = 0; i < histogram.Buckets.size(); i++)
+	{
+		seen += histogram.Buckets[i];
+		if (seen > rank)
+		{
+			float value = (i + 0.5f) * FRAME_STATS_BUCKET_MS;
+			return std::min(std::max(value, histogram.Min), histogram.Max);
+		}
+	}
+	return histogram.Max;
+}
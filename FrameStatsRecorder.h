@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "TimingStats.h"
+
+// Histogram buckets: 0.05 ms wide up to 100 ms, the last also
+// catches anything slower
+#define FRAME_STATS_BUCKET_MS 0.05f
+#define FRAME_STATS_BUCKET_COUNT 2000
+
+// A frame is a hitch when it takes this many times the median
+// so far, once enough frames have been seen to trust the median
+#define FRAME_STATS_HITCH_FACTOR 2.0f
+#define FRAME_STATS_HITCH_MIN_FRAMES 30
+#define FRAME_STATS_MAX_HITCHES 256
+
+// --------------------------------------------------------
+// A frame that took much longer than its neighbours
+// --------------------------------------------------------
+struct FrameHitch
+{
+	unsigned long long Frame; //index within the recording
+	float Milliseconds;
+	float MedianMs; //median when it happened
+};
+
+// --------------------------------------------------------
+// Records whole runs of frame and pass timings into fixed
+// size histograms, so memory stays flat however many frames
+// are recorded, and writes them as JSON or CSV reports that
+// can be diffed against a baseline. Samples of the frame
+// series also drive hitch detection. Not thread safe; feed
+// it through TimingStats::SetRecorder.
+// --------------------------------------------------------
+class FrameStatsRecorder
+{
+public:
+	FrameStatsRecorder(const std::string& frameSeries);
+	~FrameStatsRecorder();
+
+	void Reset();
+	void AddSample(const std::string& series, float milliseconds);
+
+	unsigned long long GetFrameCount() { return frameCount; }
+	const std::vector<FrameHitch>& GetHitches() { return hitches; }
+	unsigned long long GetHitchCount() { return hitchCount; } //including any past FRAME_STATS_MAX_HITCHES
+
+	//Percentiles are bucket midpoints, clamped to the recorded range
+	bool GetSummary(const std::string& series, TimingSummary* summary);
+
+	//One object per series plus the hitches, keys in a fixed order
+	void WriteJson(std::ostream& stream, const std::string& runName);
+	//One row per series
+	void WriteCsv(std::ostream& stream);
+
+private:
+	struct Histogram
+	{
+		std::vector<unsigned int> Buckets;
+		unsigned long long Count;
+		double Total;
+		float Min;
+		float Max;
+	};
+
+	std::string frameSeries;
+	std::map<std::string, Histogram> histograms;
+	unsigned long long frameCount;
+	std::vector<FrameHitch> hitches;
+	unsigned long long hitchCount;
+
+	static float Percentile(const Histogram& histogram, float p);
+};
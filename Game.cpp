@@ -2,7 +2,6 @@
 #include "Vertex.h"
 #include "Input.h"
 #include "Helpers.h"
-#include "Entity.h"
 
 #include "ImGui/imgui.h"
 #include "ImGui/backends/imgui_impl_dx11.h"
@@ -11,13 +10,34 @@
 // Needed for a helper function to load pre-compiled shader files
 #pragma comment(lib, "d3dcompiler.lib")
 #include <d3dcompiler.h>
+#include <climits>
+#include <fstream>
 
 // For the DirectX Math library
 using namespace DirectX;
 
 // DirectX Helper 
-#include "WICTextureLoader.h"
-#include "DDSTextureLoader.h"
+#include "TexturePacker.h"
+
+// Frames the headless benchmark runs at each pipeline depth
+#define HEADLESS_WARMUP_FRAMES 60
+#define HEADLESS_MEASURED_FRAMES 300
+
+// Frames the benchmark flies before it starts recording
+#define BENCHMARK_WARMUP_FRAMES 30
+
+// Loaded assets the render stage creates device resources for each frame
+#define ASSET_UPLOADS_PER_FRAME 4
+
+// Scope names for each light's shadow map pass
+static const char* shadowPassScopes[] = { "Shadow map light 1", "Shadow map light 2", "Shadow map light 3" };
+
+// GPU timer scopes, the render passes use their pass index
+#define GPU_SCOPE_SKY RENDER_PASS_COUNT
+#define GPU_SCOPE_UI (RENDER_PASS_COUNT + 1)
+#define GPU_SCOPE_FRAME (RENDER_PASS_COUNT + 2)
+#define GPU_SCOPE_COUNT (RENDER_PASS_COUNT + 3)
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -40,6 +60,46 @@ Game::Game(HINSTANCE hInstance)
 	CreateConsoleWindow(500, 120, 32, 120);
 	printf("Console window created successfully.  Feel free to printf() here.\n");
 #endif
+
+	// -headless benchmarks the frame pipeline with frames submitted to the
+	// null backend. DXCore still makes the device and window, and loading
+	// still creates shaders, meshes and textures on it; only frames skip it
+	headless = wcsstr(GetCommandLineW(), L"-headless") != 0;
+
+	// -benchmark flies the camera path for -frames=N frames and writes
+	// a report; combined with -headless its frames go to the null backend
+	benchmark = wcsstr(GetCommandLineW(), L"-benchmark") != 0;
+	benchmarkFrames = 1000;
+	const wchar_t* frames = wcsstr(GetCommandLineW(), L"-frames=");
+	if (frames && _wtoi(frames + 8) > 0)
+	{
+		benchmarkFrames = _wtoi(frames + 8);
+	}
+	benchmarkFrame = 0;
+
+	// -serialload reads startup assets one after another on the main
+	// thread, the baseline for the startup timeline report
+	serialLoading = wcsstr(GetCommandLineW(), L"-serialload") != 0;
+
+	// -nostream loads every mip of every texture; otherwise textures
+	// built by the asset tools stream within -streambudget=MB
+	textureStreaming = wcsstr(GetCommandLineW(), L"-nostream") == 0;
+	streamingBudgetMB = 64;
+	const wchar_t* budget = wcsstr(GetCommandLineW(), L"-streambudget=");
+	if (budget && _wtoi(budget + 14) > 0)
+	{
+		streamingBudgetMB = _wtoi(budget + 14);
+	}
+
+	// Assets reload when the files they're built from change, unless
+	// -nohotreload; never while benchmarking or headless
+	hotReload = !headless && !benchmark && wcsstr(GetCommandLineW(), L"-nohotreload") == 0;
+	hotReloadCount = 0;
+
+	assetReportWritten = false;
+	clampedKeysReported = false;
+	renderThreadRunning = false;
+	renderFrame = 0;
 }
 
 // --------------------------------------------------------
@@ -56,6 +116,25 @@ Game::~Game()
 	// Call Release() on any Direct3D objects made within this class
 	// - Note: this is unnecessary for D3D objects stored in ComPtrs
 
+	// The hot reload scan reads what Init registered
+	if (jobSystem)
+	{
+		jobSystem->Wait(&hotReloadScanned);
+	}
+
+	// Finish every frame in flight before tearing anything down
+	if (framePipeline)
+	{
+		StopRenderThread();
+		for (unsigned int i = 0; i < FRAME_PIPELINE_MAX_DEPTH; i++)
+		{
+			FreeUIDrawData(framePipeline->GetPacket(i));
+		}
+	}
+
+	// Shaders outlive the main thread's recording context
+	SimpleRecordingContext::Bind(0);
+
 	// ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -68,16 +147,108 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::Init()
 {
+	// Worker threads for frame tasks, this thread joins in while waiting
+	Profiler::GetInstance().SetThreadName("Main");
+	jobSystem = std::make_shared<JobSystem>(0);
+	queueBuilder = std::make_shared<RenderQueueBuilder>(jobSystem);
+
+	// Textures, meshes and the sky read in the background from here on
+	assetLoader = std::make_shared<AssetLoader>(serialLoading ? nullptr : jobSystem);
+
+	// Mips of tool built textures stream in and out from here on; the null
+	// backend takes textures as they are when it's set up, so not headless
+	if (textureStreaming && !headless)
+	{
+		MipResidencySettings streamingSettings;
+		streamingSettings.BudgetBytes = (size_t)streamingBudgetMB * 1024 * 1024;
+		textureStreamer = std::make_shared<TextureStreamer>(device, context, jobSystem, streamingSettings);
+	}
+
+	// The main thread records on the immediate context, through
+	// a state tracker that shaders bind through too
+	immediateRecording = std::make_shared<SimpleRecordingContext>(context, 0);
+	SimpleRecordingContext::Bind(immediateRecording.get());
+	stateTracker = immediateRecording->GetStateTracker();
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
 	LoadShaders();
+
+	// Materials drawn with the main pixel shader go in the material table;
+	// the null backend binds each material's textures, so not headless
+	if (!headless)
+	{
+		materialTable = std::make_shared<MaterialTableResources>(device, context, tablePixelShader, pixelShader);
+	}
+	useMaterialTable = true;
+	useFullscreenSky = true;
+
 	LoadTexturesAndSamplerState();
 	CreateMaterials();
 	CreateMeshesAndEntitites();
 	CreateLights();
 	CreateSkyBox();
+	CreateEnvironmentLighting();
 	CreateShadowMapResources();
+	CreateHotReload();
+
+	// Instance data for batched draws, grows on demand
+	instanceBuffer = std::make_shared<InstanceBuffer>(device, context, 64);
+	useInstancing = true;
+
+	// Per object constants ring, grows on demand
+	objectRing = std::make_shared<ConstantBufferRing>(device, context, 64 * CONSTANT_BUFFER_OFFSET_ALIGNMENT);
+	objectBlockOffset = 0;
+	objectBlocksReady = false;
+
+	// Deferred contexts for recording passes on the job system,
+	// one per thread up to the shader staging slots available
+	commandRecorder = std::make_shared<CommandRecorder>(device, immediateRecording, jobSystem);
+	useThreadedRecording = commandRecorder->IsSupported();
+
+	// Frame packets between Update and the render stage. Pipelining
+	// starts the render thread; headless runs always do, sweeping
+	// every depth from 1 up
+	framePipeline = std::make_shared<FramePipeline>(2);
+	pipelineDepth = 2;
+	usePipelining = false;
+	displayedResults = {};
+
+	// GPU pass timings, read back a few frames late into the same
+	// stats as the CPU timings
+	timingStats = std::make_shared<TimingStats>();
+	gpuQueries = std::make_shared<D3D11QueryBackend>(device, context, GPU_SCOPE_COUNT * 2);
+	gpuTimer = std::make_shared<GpuTimer>(gpuQueries, timingStats);
+	gpuTimer->RegisterScope("GPU shadow map light 1");
+	gpuTimer->RegisterScope("GPU shadow map light 2");
+	gpuTimer->RegisterScope("GPU shadow map light 3");
+	gpuTimer->RegisterScope("GPU main pass");
+	gpuTimer->RegisterScope("GPU sky");
+	gpuTimer->RegisterScope("GPU ImGui");
+	gpuTimer->RegisterScope("GPU frame");
+
+	// Whole run histograms of the same series for benchmark reports
+	frameStatsRecorder = std::make_shared<FrameStatsRecorder>("Frame");
+
+	// Timeline of the scopes above, exporting next to the executable
+	profilerWindow = std::make_shared<ProfilerWindow>(WideToNarrow(FixPath(L"profile_trace.json")), timingStats);
+
+	// Benchmarks measure the finished scene, and the null backend
+	// takes its resources as they are when it's set up
+	if (headless || benchmark)
+	{
+		assetLoader->FinishAll();
+	}
+
+	if (headless)
+	{
+		usePipelining = true;
+		pipelineDepth = benchmark ? 2 : 1;
+		headlessDepth = 1;
+		headlessFrame = 0;
+		CreateRenderBackendResources();
+	}
 
 	// Set initial graphics API state
 	//  - These settings persist until we change them
@@ -107,6 +278,13 @@ void Game::Init()
 
 		//set ambient color
 		mainCamera->SetAmbientColor(DirectX::XMFLOAT3(0.1f, 0.1f, 0.25f));
+
+		//benchmark fly-through, circling the row of entities
+		cameraPath.AddKeyframe(XMFLOAT3(0.0f, 2.0f, -15.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		cameraPath.AddKeyframe(XMFLOAT3(14.0f, 4.0f, -8.0f), XMFLOAT3(5.0f, 0.0f, 0.0f));
+		cameraPath.AddKeyframe(XMFLOAT3(12.0f, 6.0f, 10.0f), XMFLOAT3(0.0f, -1.0f, 0.0f));
+		cameraPath.AddKeyframe(XMFLOAT3(-12.0f, 3.0f, 10.0f), XMFLOAT3(-5.0f, 0.0f, 0.0f));
+		cameraPath.AddKeyframe(XMFLOAT3(-14.0f, 1.0f, -8.0f), XMFLOAT3(-10.0f, 0.0f, 0.0f));
 	}
 
 	// Initialize ImGui itself & platform/renderer backends
@@ -133,44 +311,87 @@ void Game::Init()
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
+	// Keep shader reflection data between launches so loading can skip reflection
+	CreateDirectoryW(FixPath(L"ShaderCache").c_str(), 0);
+	SimpleShaderReflectionCache::Directory = WideToNarrow(FixPath(L"ShaderCache\\"));
+
 	vertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader.cso").c_str());
 	pixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"PixelShader.cso").c_str());
 	
 	shadowVertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader_Shadow.cso").c_str());
+	instancedVertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader_Instanced.cso").c_str());
+	shadowInstancedVertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader_ShadowInstanced.cso").c_str());
 	customPixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"CustomPixelShader.cso").c_str());
+	tablePixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"PixelShader_MaterialTable.cso").c_str());
 	
 	skyVertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader_Sky.cso").c_str());
+	skyFullscreenVertexShader = std::make_shared<SimpleVertexShader>(device, context, FixPath(L"VertexShader_SkyFullscreen.cso").c_str());
 	skyPixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"PixelShader_Sky.cso").c_str());
+
+	// Compiled again from source, in place, when it or an include changes
+	AddShaderHotReload("VertexShader", vertexShader.get(), "vs_5_0");
+	AddShaderHotReload("PixelShader", pixelShader.get(), "ps_5_0");
+	AddShaderHotReload("VertexShader_Shadow", shadowVertexShader.get(), "vs_5_0");
+	AddShaderHotReload("VertexShader_Instanced", instancedVertexShader.get(), "vs_5_0");
+	AddShaderHotReload("VertexShader_ShadowInstanced", shadowInstancedVertexShader.get(), "vs_5_0");
+	AddShaderHotReload("CustomPixelShader", customPixelShader.get(), "ps_5_0");
+	AddShaderHotReload("PixelShader_MaterialTable", tablePixelShader.get(), "ps_5_0");
+	AddShaderHotReload("VertexShader_Sky", skyVertexShader.get(), "vs_5_0");
+	AddShaderHotReload("VertexShader_SkyFullscreen", skyFullscreenVertexShader.get(), "vs_5_0");
+	AddShaderHotReload("PixelShader_Sky", skyPixelShader.get(), "ps_5_0");
+
+	// The shaders drawing main and shadow passes, whose per frame data is set through handles
+	ISimpleShader* frameShaders[] = { vertexShader.get(), pixelShader.get(), shadowVertexShader.get(), instancedVertexShader.get(),
+		shadowInstancedVertexShader.get(), customPixelShader.get(), tablePixelShader.get() };
+	for (ISimpleShader* shader : frameShaders)
+	{
+		LookUpFrameShaderHandles(shader);
+	}
 }
 
 void Game::LoadTexturesAndSamplerState()
 {
-	//albedo textures
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/bronze_albedo.png").c_str(), 0, textureSRV1.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/cobblestone_albedo.png").c_str(), 0, textureSRV2.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/floor_albedo.png").c_str(), 0, textureSRV3.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/paint_albedo.png").c_str(), 0, textureSRV4.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/rough_albedo.png").c_str(), 0, textureSRV5.GetAddressOf());
-	//normal maps
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/bronze_normals.png").c_str(), 0, normalSRV1.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/cobblestone_normals.png").c_str(), 0, normalSRV2.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/floor_normals.png").c_str(), 0, normalSRV3.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/paint_normals.png").c_str(), 0, normalSRV4.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/rough_normals.png").c_str(), 0, normalSRV5.GetAddressOf());
-
-	//roughness maps
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/bronze_roughness.png").c_str(), 0, roughnessSRV1.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/cobblestone_roughness.png").c_str(), 0, roughnessSRV2.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/floor_roughness.png").c_str(), 0, roughnessSRV3.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/paint_roughness.png").c_str(), 0, roughnessSRV4.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/rough_roughness.png").c_str(), 0, roughnessSRV5.GetAddressOf());
-
-	//metalness maps
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/bronze_metal.png").c_str(), 0, metalnessSRV1.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/cobblestone_metal.png").c_str(), 0, metalnessSRV2.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/floor_metal.png").c_str(), 0, metalnessSRV3.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/paint_metal.png").c_str(), 0, metalnessSRV4.GetAddressOf());
-	DirectX::CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/PBR/rough_metal.png").c_str(), 0, metalnessSRV5.GetAddressOf());
+	//stand ins until the maps arrive: grey albedo, flat normals, fully rough dielectric surface
+	const unsigned char grey[] = { 128, 128, 128, 255 };
+	const unsigned char flat[] = { 128, 128 };
+	const unsigned char rough[] = { PACK_DEFAULT_ROUGHNESS, PACK_DEFAULT_METALNESS };
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> albedoPlaceholder;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalPlaceholder;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfacePlaceholder;
+	TextureLoader::CreatePlaceholder(device, 4, grey, albedoPlaceholder.GetAddressOf());
+	TextureLoader::CreatePlaceholder(device, 2, flat, normalPlaceholder.GetAddressOf());
+	TextureLoader::CreatePlaceholder(device, 2, rough, surfacePlaceholder.GetAddressOf());
+
+	//the table shader's defaults stand in for these, so they don't take slices
+	if (materialTable)
+	{
+		materialTable->SetDefaultTexture(MATERIAL_TABLE_ALBEDO, albedoPlaceholder);
+		materialTable->SetDefaultTexture(MATERIAL_TABLE_NORMALS, normalPlaceholder);
+		materialTable->SetDefaultTexture(MATERIAL_TABLE_SURFACE, surfacePlaceholder);
+	}
+
+	//albedo (block compressed by Tools/CompressTextures when built), then normal and
+	//surface maps (packed by Tools/PackTextures or Tools/CompressTextures, or at load time).
+	//Maps the tools built stream their mips, the rest load whole.
+	const char* names[] = { "bronze", "cobblestone", "floor", "paint", "rough" };
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* albedoSRVs[] = { &textureSRV1, &textureSRV2, &textureSRV3, &textureSRV4, &textureSRV5 };
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* normalSRVs[] = { &normalSRV1, &normalSRV2, &normalSRV3, &normalSRV4, &normalSRV5 };
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* surfaceSRVs[] = { &surfaceSRV1, &surfaceSRV2, &surfaceSRV3, &surfaceSRV4, &surfaceSRV5 };
+	materialStreams.resize(5);
+	for (unsigned int i = 0; i < 5; i++)
+	{
+		*albedoSRVs[i] = albedoPlaceholder;
+		*normalSRVs[i] = normalPlaceholder;
+		*surfaceSRVs[i] = surfacePlaceholder;
+
+		std::string basePath = WideToNarrow(FixPath(L"../../Assets/PBR/")) + names[i];
+		LoadMaterialMap(std::string(names[i]) + " albedo", TextureLoader::ReadAlbedo, TextureLoader::GetAlbedoFiles, TEXTURE_ALBEDO_DDS,
+			basePath, albedoSRVs[i], i, "AlbedoMap");
+		LoadMaterialMap(std::string(names[i]) + " normals", TextureLoader::ReadNormals, TextureLoader::GetNormalsFiles, TEXTURE_NORMALS_DDS,
+			basePath, normalSRVs[i], i, "NormalMap");
+		LoadMaterialMap(std::string(names[i]) + " surface", TextureLoader::ReadSurface, TextureLoader::GetSurfaceFiles, TEXTURE_SURFACE_DDS,
+			basePath, surfaceSRVs[i], i, "SurfaceMap");
+	}
 
 	D3D11_SAMPLER_DESC samplerDesc = {};
 	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -182,42 +403,128 @@ void Game::LoadTexturesAndSamplerState()
 	device->CreateSamplerState(&samplerDesc, samplerState.GetAddressOf());
 }
 
+// --------------------------------------------------------
+// Queues a material map: read on a worker, then created by
+// the render stage and swapped in for the placeholder both
+// in srv and in the material, once that exists
+// --------------------------------------------------------
+void Game::QueueMaterialTexture(const std::string& name, bool (*read)(const std::string&, TextureData&, JobSystem*), const std::string& basePath,
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex, const char* shaderName)
+{
+	JobSystem* jobs = assetLoader->GetJobSystem();
+	assetLoader->Queue(name, [this, read, basePath, jobs, srv, materialIndex, shaderName]() -> AssetUpload
+	{
+		std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+		if (!read(basePath, *data, jobs))
+			return AssetUpload();
+
+		return [this, data, srv, materialIndex, shaderName]()
+		{
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> loaded;
+			if (FAILED(TextureLoader::CreateTexture(device, *data, loaded.GetAddressOf())))
+				return;
+
+			*srv = loaded;
+			if (materialIndex < materials.size())
+			{
+				materials[materialIndex]->AddTextureSRV(shaderName, loaded);
+			}
+		};
+	});
+}
+
+// --------------------------------------------------------
+// Streams a material map from its DDS file, if there is one
+// and streaming is on. Only its header is read here; views
+// of the levels resident go to srv and the material as the
+// render stage streams them.
+// --------------------------------------------------------
+bool Game::StreamMaterialTexture(const std::string& ddsPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex,
+	const char* shaderName)
+{
+	if (!textureStreamer)
+		return false;
+
+	StreamingHandle handle = 0;
+	bool streamed = textureStreamer->Register(ddsPath, [this, srv, materialIndex, shaderName](Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view)
+	{
+		*srv = view;
+		if (materialIndex < materials.size())
+		{
+			materials[materialIndex]->AddTextureSRV(shaderName, view);
+		}
+	}, &handle);
+
+	if (streamed)
+	{
+		materialStreams[materialIndex].push_back(handle);
+	}
+	return streamed;
+}
+
+// --------------------------------------------------------
+// Streams or queues one material map, as above, and has it
+// load again when a file it's read from changes: a streamed
+// map reads its resident levels again, any other is queued
+// again from whichever of its files exist
+// --------------------------------------------------------
+void Game::LoadMaterialMap(const std::string& name, bool (*read)(const std::string&, TextureData&, JobSystem*),
+	void (*getFiles)(const std::string&, std::vector<std::string>&), const char* ddsSuffix, const std::string& basePath,
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex, const char* shaderName)
+{
+	if (StreamMaterialTexture(basePath + ddsSuffix, srv, materialIndex, shaderName))
+	{
+		StreamingHandle handle = materialStreams[materialIndex].back();
+		AddHotReload(name, { basePath + ddsSuffix }, [this, name, handle]()
+		{
+			if (!textureStreamer->Reload(handle))
+			{
+				printf("Hot reload: %s changed size, format or mip count; restart to stream it\n", name.c_str());
+			}
+		});
+		return;
+	}
+
+	QueueMaterialTexture(name, read, basePath, srv, materialIndex, shaderName);
+	std::vector<std::string> files;
+	getFiles(basePath, files);
+	AddHotReload(name, files, [this, name, read, basePath, srv, materialIndex, shaderName]()
+	{
+		QueueMaterialTexture(name, read, basePath, srv, materialIndex, shaderName);
+	});
+}
+
 void Game::CreateMaterials()
 {
 	//material 1
 	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, vertexShader, pixelShader)); 
 	materials[0]->AddTextureSRV("AlbedoMap", textureSRV1);
 	materials[0]->AddTextureSRV("NormalMap", normalSRV1);
-	materials[0]->AddTextureSRV("RoughnessMap", roughnessSRV1);
-	materials[0]->AddTextureSRV("MetalnessMap", metalnessSRV1);
+	materials[0]->AddTextureSRV("SurfaceMap", surfaceSRV1);
 
 	//material 2
 	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, vertexShader, pixelShader));
 	materials[1]->AddTextureSRV("AlbedoMap", textureSRV2);
 	materials[1]->AddTextureSRV("NormalMap", normalSRV2);
-	materials[1]->AddTextureSRV("RoughnessMap", roughnessSRV2);
-	materials[1]->AddTextureSRV("MetalnessMap", metalnessSRV2);
+	materials[1]->AddTextureSRV("SurfaceMap", surfaceSRV2);
 
 	//material 3
 	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, vertexShader, pixelShader));
 	materials[2]->AddTextureSRV("AlbedoMap", textureSRV3);
 	materials[2]->AddTextureSRV("NormalMap", normalSRV3);
-	materials[1]->AddTextureSRV("RoughnessMap", roughnessSRV3);
-	materials[1]->AddTextureSRV("MetalnessMap", metalnessSRV3);
+	materials[2]->AddTextureSRV("SurfaceMap", surfaceSRV3);
 
 	//material 4
 	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, vertexShader, pixelShader));
 	materials[3]->AddTextureSRV("AlbedoMap", textureSRV4);
 	materials[3]->AddTextureSRV("NormalMap", normalSRV4);
-	materials[3]->AddTextureSRV("RoughnessMap", roughnessSRV4);
-	materials[3]->AddTextureSRV("MetalnessMap", metalnessSRV4);
+	materials[3]->AddTextureSRV("SurfaceMap", surfaceSRV4);
 
 	//material 5
 	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, vertexShader, pixelShader));
 	materials[4]->AddTextureSRV("AlbedoMap", textureSRV5);
 	materials[4]->AddTextureSRV("NormalMap", normalSRV5);
-	materials[4]->AddTextureSRV("RoughnessMap", roughnessSRV5);
-	materials[4]->AddTextureSRV("MetalnessMap", metalnessSRV5);
+	materials[4]->AddTextureSRV("SurfaceMap", surfaceSRV5);
 
 	//Add sampler states
 	materials[0]->AddSampler("BasicSampler", samplerState);
@@ -225,6 +532,30 @@ void Game::CreateMaterials()
 	materials[2]->AddSampler("BasicSampler", samplerState);
 	materials[3]->AddSampler("BasicSampler", samplerState);
 	materials[4]->AddSampler("BasicSampler", samplerState);
+
+	//Instanced variant of the vertex shader for batched draws
+	for (auto& m : materials)
+	{
+		m->SetInstancedVertexShader(instancedVertexShader);
+	}
+
+	//Give each distinct vertex/pixel shader pair an id so draws can be sorted by it
+	std::vector<std::pair<SimpleVertexShader*, SimplePixelShader*>> shaderPairs;
+	for (auto& m : materials)
+	{
+		std::pair<SimpleVertexShader*, SimplePixelShader*> pair(m->GetVertexShader().get(), m->GetPixelShader().get());
+		unsigned int id = 0;
+		while (id < shaderPairs.size() && shaderPairs[id] != pair)
+		{
+			id++;
+		}
+		if (id == shaderPairs.size())
+		{
+			shaderPairs.push_back(pair);
+		}
+		materialShaderIds.push_back(id);
+	}
+	materialTableShaderId = (unsigned int)shaderPairs.size();
 }
 
 // --------------------------------------------------------
@@ -311,43 +642,97 @@ void Game::CreateMeshesAndEntitites()
 
 		//3D meshes
 		{
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cube.obj").c_str(), device, context));
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cylinder.obj").c_str(), device, context));
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/helix.obj").c_str(), device, context));
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/sphere.obj").c_str(), device, context));
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/torus.obj").c_str(), device, context));
-			gameMeshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cube.obj").c_str(), device, context));
+			//parsed on workers alongside the textures; entities need their
+			//bounds, so these are waited for rather than left to stream in
+			const wchar_t* files[] = { L"cube.obj", L"cylinder.obj", L"helix.obj", L"sphere.obj", L"torus.obj", L"cube.obj" };
+			std::vector<AssetHandle> meshLoads;
+			gameMeshes.resize(sizeof(files) / sizeof(files[0]));
+			for (unsigned int i = 0; i < gameMeshes.size(); i++)
+			{
+				std::wstring path = FixPath(std::wstring(L"../../Assets/Models/") + files[i]);
+				meshLoads.push_back(QueueMesh(WideToNarrow(files[i]), path, { i }));
+			}
+			for (AssetHandle load : meshLoads)
+			{
+				assetLoader->Finish(load);
+			}
+
+			//a changed file reloads every mesh made from it
+			for (unsigned int i = 0; i < gameMeshes.size(); i++)
+			{
+				std::vector<unsigned int> slots;
+				for (unsigned int j = 0; j < gameMeshes.size(); j++)
+				{
+					if (wcscmp(files[i], files[j]) == 0)
+						slots.push_back(j);
+				}
+				if (slots[0] != i)
+					continue;
+
+				std::string name = WideToNarrow(files[i]);
+				std::wstring path = FixPath(std::wstring(L"../../Assets/Models/") + files[i]);
+				AddHotReload(name, { WideToNarrow(path) }, [this, name, path, slots]()
+				{
+					QueueMesh(name, path, slots);
+				});
+			}
 		}
 	}
 
 	//Creating Entities
 	{
 		//Cube
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[0],materials[0]));
-		gameEntities[0]->GetTransform()->SetRotation(DirectX::XM_PIDIV4, DirectX::XM_PIDIV4, 0.0f);
+		entityHandles.push_back(gameEntities.Create(0, 0, gameMeshes[0]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[0])->SetRotation(DirectX::XM_PIDIV4, DirectX::XM_PIDIV4, 0.0f);
 		//Cylinder
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[1], materials[1]));
-		gameEntities[1]->GetTransform()->SetPosition(5.0f,0.0f,0.0f);
+		entityHandles.push_back(gameEntities.Create(1, 1, gameMeshes[1]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[1])->SetPosition(5.0f,0.0f,0.0f);
 		
 		//Helix 
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[2], materials[2]));
-		gameEntities[2]->GetTransform()->SetPosition(10.0f, 0.0f, 0.0f);
+		entityHandles.push_back(gameEntities.Create(2, 2, gameMeshes[2]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[2])->SetPosition(10.0f, 0.0f, 0.0f);
 
 		//Torus
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[3], materials[3]));
-		gameEntities[3]->GetTransform()->SetPosition(-5.0f, 0.0f, 0.0f);
+		entityHandles.push_back(gameEntities.Create(3, 3, gameMeshes[3]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[3])->SetPosition(-5.0f, 0.0f, 0.0f);
 
 		//Sphere
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[4], materials[4]));
-		gameEntities[4]->GetTransform()->SetPosition(-10.0f, 0.0f, 0.0f);
+		entityHandles.push_back(gameEntities.Create(4, 4, gameMeshes[4]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[4])->SetPosition(-10.0f, 0.0f, 0.0f);
 
 		//Ground
-		gameEntities.push_back(std::make_shared<Entity>(gameMeshes[5], materials[2]));
-		gameEntities[5]->GetTransform()->SetPosition(0.0f, -3.0f, 0.0f);
-		gameEntities[5]->GetTransform()->SetScale(20.0f, 1.0f, 20.0f);
+		entityHandles.push_back(gameEntities.Create(5, 2, gameMeshes[5]->GetBounds()));
+		gameEntities.GetTransform(entityHandles[5])->SetPosition(0.0f, -3.0f, 0.0f);
+		gameEntities.GetTransform(entityHandles[5])->SetScale(20.0f, 1.0f, 20.0f);
 	}
 }
 
+// --------------------------------------------------------
+// Queues an OBJ, parsed on a worker, then created by the
+// render stage as the mesh in each of slots. Their bounds
+// go to Update, which moves the entities using them over.
+// --------------------------------------------------------
+AssetHandle Game::QueueMesh(const std::string& name, const std::wstring& path, const std::vector<unsigned int>& slots)
+{
+	return assetLoader->Queue(name, [this, path, slots]() -> AssetUpload
+	{
+		std::shared_ptr<std::vector<Vertex>> vertices = std::make_shared<std::vector<Vertex>>();
+		std::shared_ptr<std::vector<unsigned int>> indices = std::make_shared<std::vector<unsigned int>>();
+		if (!Mesh::ReadObj(path.c_str(), *vertices, *indices))
+			return AssetUpload();
+
+		return [this, vertices, indices, slots]()
+		{
+			std::lock_guard<std::mutex> lock(reloadedMeshMutex);
+			for (unsigned int slot : slots)
+			{
+				gameMeshes[slot] = std::make_shared<Mesh>(vertices->data(), (unsigned int)vertices->size(), indices->data(), (unsigned int)indices->size(), device, context);
+				reloadedMeshBounds.push_back(std::make_pair(slot, gameMeshes[slot]->GetBounds()));
+			}
+		};
+	});
+}
+
 void Game::CreateLights()
 {
 	lights.clear();
@@ -394,11 +779,94 @@ void Game::CreateLights()
 
 void Game::CreateSkyBox()
 {
-	//load sky box cube map
-	DirectX::CreateDDSTextureFromFile(device.Get(), FixPath(L"../../Assets/Textures/SunnyCubeMap.dds").c_str(), 0, skySRV.GetAddressOf());
+	//create sky class object, black until the cube map arrives
+	skyBox = std::make_shared<Sky>(gameMeshes[0], samplerState, skySRV, skyPixelShader, skyVertexShader, skyFullscreenVertexShader, device);
+
+	//load sky box cube map, and again whenever it changes
+	std::string path = WideToNarrow(FixPath(L"../../Assets/Textures/SunnyCubeMap.dds"));
+	QueueSkyCubeMap(path);
+	AddHotReload("SunnyCubeMap.dds", { path }, [this, path]() { QueueSkyCubeMap(path); });
+}
+
+void Game::QueueSkyCubeMap(const std::string& path)
+{
+	assetLoader->Queue("SunnyCubeMap.dds", [this, path]() -> AssetUpload
+	{
+		std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+		if (!TextureLoader::ReadFile(path, data->DdsFile))
+			return AssetUpload();
 
-	//create sky class object
-	skyBox = std::make_shared<Sky>(gameMeshes[0], samplerState, skySRV, skyPixelShader, skyVertexShader, device);
+		return [this, data]()
+		{
+			if (SUCCEEDED(TextureLoader::CreateTexture(device, *data, skySRV.ReleaseAndGetAddressOf())))
+			{
+				skyBox->SetTextureSRV(skySRV);
+			}
+		};
+	});
+}
+
+// --------------------------------------------------------
+// Queues the sky's image based lighting: built from the cube
+// map on a worker the first time and cached next to it, read
+// from that cache after. Until the upload lands, shading
+// uses the flat ambient term.
+// --------------------------------------------------------
+void Game::CreateEnvironmentLighting()
+{
+	for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+	{
+		irradianceSH[k] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+	specularMipCount = 0;
+
+	//the BRDF table's edges are its extremes, and the specular cube is filtered already
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	device->CreateSamplerState(&samplerDesc, clampSampler.GetAddressOf());
+
+	//the null backend doesn't shade, so headless runs skip the build
+	if (headless)
+		return;
+
+	//the cache is older than a changed cube map, so a reload builds it again
+	std::string path = WideToNarrow(FixPath(L"../../Assets/Textures/SunnyCubeMap.dds"));
+	QueueEnvironmentLighting(path);
+	AddHotReload("Environment lighting", { path }, [this, path]() { QueueEnvironmentLighting(path); });
+}
+
+void Game::QueueEnvironmentLighting(const std::string& path)
+{
+	JobSystem* jobs = assetLoader->GetJobSystem();
+	assetLoader->Queue("Environment lighting", [this, path, jobs]() -> AssetUpload
+	{
+		EnvironmentSettings settings;
+		std::shared_ptr<SHIrradiance> irradiance = std::make_shared<SHIrradiance>();
+		std::shared_ptr<TextureData> specular = std::make_shared<TextureData>();
+		std::shared_ptr<TextureData> brdf = std::make_shared<TextureData>();
+		if (!EnvironmentLighting::LoadOrBuild(path, settings, *irradiance, jobs)
+			|| !TextureLoader::ReadFile(EnvironmentLighting::GetSpecularPath(path), specular->DdsFile)
+			|| !TextureLoader::ReadFile(EnvironmentLighting::GetBrdfPath(path), brdf->DdsFile))
+			return AssetUpload();
+
+		return [this, irradiance, specular, brdf, settings]()
+		{
+			if (FAILED(TextureLoader::CreateTexture(device, *specular, specularSRV.ReleaseAndGetAddressOf())) ||
+				FAILED(TextureLoader::CreateTexture(device, *brdf, brdfSRV.ReleaseAndGetAddressOf())))
+				return;
+
+			for (unsigned int k = 0; k < ENVIRONMENT_SH_COEFFICIENTS; k++)
+			{
+				const float* rgb = irradiance->Coefficients[k];
+				irradianceSH[k] = XMFLOAT4(rgb[0], rgb[1], rgb[2], 0.0f);
+			}
+			specularMipCount = (int)settings.SpecularMips;
+		};
+	});
 }
 
 void Game::CreateShadowMapResources()
@@ -540,143 +1008,795 @@ void Game::CreateShadowMapResources()
 	XMStoreFloat4x4(&shadowProjectionMatrix, shProj);
 }
 
-void Game::RenderShadowMaps()
+// --------------------------------------------------------
+// Mirrors the scene's meshes, materials, shaders and targets
+// in the null backend, with ids matching the render queue's
+// so the same queue can be submitted to it
+// --------------------------------------------------------
+void Game::CreateRenderBackendResources()
 {
-	// Need to create a viewport that matches the shadow map resolution
-	D3D11_VIEWPORT viewport = {};
-	viewport.TopLeftX = 0.0f;
-	viewport.TopLeftY = 0.0f;
-	viewport.Width = (float)shadowMapResolution;
-	viewport.Height = (float)shadowMapResolution;
-	viewport.MinDepth = 0.0f;
-	viewport.MaxDepth = 1.0f;
-	context->RSSetViewports(1, &viewport);
-	
-	float dScale = -1 * 20.0f;
-	
-	// Render 1st shadow map
+	renderBackend = std::make_shared<NullRenderBackend>();
+	queueSubmitter = std::make_shared<RenderQueueSubmitter>(renderBackend);
+
+	for (auto& mesh : gameMeshes)
 	{
-		// Initial pipeline setup - No RTV necessary - Clear shadow map
-		context->OMSetRenderTargets(0, 0, shadowDSV1.Get());
-		context->ClearDepthStencilView(shadowDSV1.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-		context->RSSetState(shadowRasterizer.Get());
+		D3D11_BUFFER_DESC vbDesc = {};
+		mesh->GetVertexBuffer()->GetDesc(&vbDesc);
+
+		SubmitMesh submitMesh = {};
+		submitMesh.VertexBuffer = renderBackend->CreateBuffer({ RenderBufferVertex, vbDesc.ByteWidth, false }, 0);
+		submitMesh.IndexBuffer = renderBackend->CreateBuffer({ RenderBufferIndex, mesh->GetIndexCount() * (unsigned int)sizeof(unsigned int), false }, 0);
+		submitMesh.IndexCount = mesh->GetIndexCount();
+		queueSubmitter->AddMesh(submitMesh);
+	}
 
-		// Update View matrix to light 1
-		XMMATRIX shView = XMMatrixLookAtLH(
-			XMVectorSet(dScale * lights[0].Direction.x, dScale * lights[0].Direction.y, dScale * lights[0].Direction.z, 0.0f),
-			XMVectorSet(0, 0, 0, 0),
-			XMVectorSet(0, 1, 0, 0));
-		XMStoreFloat4x4(&shadowViewMatrix1, shView);
+	//same textures CreateMaterials() gives each material
+	ID3D11ShaderResourceView* materialSRVs[5][SUBMIT_MATERIAL_TEXTURES] = {
+		{ textureSRV1.Get(), normalSRV1.Get(), surfaceSRV1.Get() },
+		{ textureSRV2.Get(), normalSRV2.Get(), surfaceSRV2.Get() },
+		{ textureSRV3.Get(), normalSRV3.Get(), surfaceSRV3.Get() },
+		{ textureSRV4.Get(), normalSRV4.Get(), surfaceSRV4.Get() },
+		{ textureSRV5.Get(), normalSRV5.Get(), surfaceSRV5.Get() } };
+	RenderHandle materialSampler = renderBackend->CreateSampler(false);
+	for (unsigned int m = 0; m < materials.size(); m++)
+	{
+		SubmitMaterial submitMaterial = {};
+		for (ID3D11ShaderResourceView* srv : materialSRVs[m % 5])
+		{
+			Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+			Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+			D3D11_TEXTURE2D_DESC textureDesc = {};
+			if (srv)
+			{
+				srv->GetResource(resource.GetAddressOf());
+			}
+			if (resource && SUCCEEDED(resource.As(&texture)))
+			{
+				texture->GetDesc(&textureDesc);
+			}
+			submitMaterial.Textures[submitMaterial.TextureCount++] = renderBackend->CreateTexture(
+				{ textureDesc.Width, textureDesc.Height, textureDesc.MipLevels, RenderFormatRGBA8, false, true }, 0);
+		}
+		submitMaterial.Sampler = materialSampler;
+		submitMaterial.ColorTint = materials[m]->GetColorTint();
+		queueSubmitter->AddMaterial(submitMaterial);
+	}
+
+	//one entry per shader pair id, from the first material using it
+	for (unsigned int m = 0; m < materials.size(); m++)
+	{
+		bool seen = false;
+		for (unsigned int other = 0; other < m; other++)
+		{
+			seen = seen || materialShaderIds[other] == materialShaderIds[m];
+		}
+		if (seen)
+			continue;
+
+		Microsoft::WRL::ComPtr<ID3DBlob> vs = materials[m]->GetVertexShader()->GetShaderBlob();
+		Microsoft::WRL::ComPtr<ID3DBlob> instancedVS = materials[m]->GetInstancedVertexShader()->GetShaderBlob();
+		Microsoft::WRL::ComPtr<ID3DBlob> ps = materials[m]->GetPixelShader()->GetShaderBlob();
+		SubmitShader submitShader = {};
+		submitShader.VertexShader = renderBackend->CreateShader(RenderStageVertex, vs->GetBufferPointer(), vs->GetBufferSize());
+		submitShader.InstancedVertexShader = renderBackend->CreateShader(RenderStageVertex, instancedVS->GetBufferPointer(), instancedVS->GetBufferSize());
+		submitShader.PixelShader = renderBackend->CreateShader(RenderStagePixel, ps->GetBufferPointer(), ps->GetBufferSize());
+		queueSubmitter->AddShader(submitShader);
+	}
+
+	Microsoft::WRL::ComPtr<ID3DBlob> shadowVS = shadowVertexShader->GetShaderBlob();
+	Microsoft::WRL::ComPtr<ID3DBlob> shadowInstancedVS = shadowInstancedVertexShader->GetShaderBlob();
+	queueSubmitter->SetShadowShaders(
+		renderBackend->CreateShader(RenderStageVertex, shadowVS->GetBufferPointer(), shadowVS->GetBufferSize()),
+		renderBackend->CreateShader(RenderStageVertex, shadowInstancedVS->GetBufferPointer(), shadowInstancedVS->GetBufferSize()));
+
+	RenderHandle shadowMaps[SUBMIT_SHADOW_MAPS] = {};
+	for (RenderHandle& shadowMap : shadowMaps)
+	{
+		shadowMap = renderBackend->CreateTexture({ (unsigned int)shadowMapResolution, (unsigned int)shadowMapResolution, 1, RenderFormatR32Typeless, true, true }, 0);
+	}
+	queueSubmitter->SetTargets(
+		renderBackend->CreateTexture({ (unsigned int)windowWidth, (unsigned int)windowHeight, 1, RenderFormatRGBA8, true, false }, 0),
+		renderBackend->CreateTexture({ (unsigned int)windowWidth, (unsigned int)windowHeight, 1, RenderFormatDepth24Stencil8, true, false }, 0),
+		shadowMaps,
+		renderBackend->CreateSampler(true));
+}
+
+// --------------------------------------------------------
+// Starts watching the files every asset registered above was
+// built from. Fingerprinting them reads each one whole, so
+// that runs as a job, and changes count once it's done.
+// --------------------------------------------------------
+void Game::CreateHotReload()
+{
+	if (!hotReload)
+		return;
+
+	fileWatcher = std::make_shared<FileWatcher>();
+	jobSystem->Run([this]()
+	{
+		for (unsigned int i = 0; i < hotReloadAssets.size(); i++)
+		{
+			std::vector<std::string>& files = hotReloadFiles[i].second;
+			if (!hotReloadAssets[i].ShaderSource.empty())
+			{
+				AssetDependencies::GetShaderFiles(hotReloadAssets[i].ShaderSource, files);
+			}
+			hotReloadDependencies.Add(hotReloadFiles[i].first, files);
+		}
+		hotReloadFiles.clear();
 
-		// Turn on our shadow map Vertex Shader
-		// and turn OFF the pixel shader entirely
-		shadowVertexShader->SetShader();
-		shadowVertexShader->SetMatrix4x4("view", shadowViewMatrix1);
-		shadowVertexShader->SetMatrix4x4("projection", shadowProjectionMatrix);
-		context->PSSetShader(0, 0, 0); // No PS
+		std::vector<std::string> directories;
+		hotReloadDependencies.GetDirectories(directories);
+		for (const std::string& directory : directories)
+		{
+			if (!fileWatcher->Watch(directory))
+			{
+				printf("Hot reload: can't watch %s\n", directory.c_str());
+			}
+		}
+	}, &hotReloadScanned);
+}
 
-		//create camera to pass to entity to draw. This camera is actually the light.
-		std::shared_ptr<Camera> lightCamera = std::make_shared<Camera>(1.0f, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XM_PI / 3, 0.01f, 1000.0f, 1.0f, 5.0f, false);
+// --------------------------------------------------------
+// Registers an asset for hot reload: reload runs on the
+// render stage after one of files changes, and queues the
+// asset on assetLoader again. A shader gives its source
+// instead, whose includes are found by the scan.
+// --------------------------------------------------------
+void Game::AddHotReload(const std::string& name, const std::vector<std::string>& files, const std::function<void()>& reload,
+	const std::string& shaderSource)
+{
+	if (!hotReload)
+		return;
+
+	hotReloadFiles.push_back(std::make_pair(name, files));
+	HotReloadAsset asset;
+	asset.Reload = reload;
+	asset.ShaderSource = shaderSource;
+	hotReloadAssets.push_back(asset);
+}
 
-		//set camera to the lights orientation and set projection to shadowMap viewport values
-		lightCamera->SetViewMatrix(shadowViewMatrix1);
-		lightCamera->SetProjectionMatrix(shadowProjectionMatrix);
+void Game::AddShaderHotReload(const std::string& name, ISimpleShader* shader, const char* target)
+{
+	std::string file = name + ".hlsl";
+	std::string path = WideToNarrow(FixPath(L"../../" + NarrowToWide(file)));
+	AddHotReload(file, {}, [this, file, path, shader, target]()
+	{
+		QueueShaderReload(file, path, shader, target);
+	}, path);
+}
 
-		// Loop and draw all entities
-		for (auto& e : gameEntities)
+// --------------------------------------------------------
+// Compiles a shader's source on a worker, then swaps it
+// into the shader the render stage already holds. A source
+// that doesn't compile prints its errors and changes
+// nothing, so the last good shader keeps drawing.
+// --------------------------------------------------------
+void Game::QueueShaderReload(const std::string& name, const std::string& path, ISimpleShader* shader, const char* target)
+{
+	assetLoader->Queue(name, [this, name, path, shader, target]() -> AssetUpload
+	{
+		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+		flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+		Microsoft::WRL::ComPtr<ID3DBlob> compiled;
+		Microsoft::WRL::ComPtr<ID3DBlob> errors;
+		HRESULT hr = D3DCompileFromFile(NarrowToWide(path).c_str(), 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", target, flags, 0,
+			compiled.GetAddressOf(), errors.GetAddressOf());
+		if (errors)
 		{
-			shadowVertexShader->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-			shadowVertexShader->CopyAllBufferData();
+			printf("%s", (const char*)errors->GetBufferPointer());
+		}
+		if (FAILED(hr))
+			return AssetUpload();
+
+		return [this, name, compiled, shader]()
+		{
+			if (!shader->Reload(compiled))
+			{
+				printf("Hot reload: %s couldn't be created, keeping the last one\n", name.c_str());
+				return;
+			}
+			RefreshShaderHandles(shader);
+		};
+	});
+}
 
-			// Draw the mesh
-			e->Draw(lightCamera);
+// --------------------------------------------------------
+// A reloaded shader's variables may have moved, so anything
+// keeping handles into it looks them up again
+// --------------------------------------------------------
+void Game::RefreshShaderHandles(ISimpleShader* shader)
+{
+	for (auto& material : materials)
+	{
+		if (material->GetVertexShader().get() == shader || material->GetPixelShader().get() == shader ||
+			material->GetInstancedVertexShader().get() == shader)
+		{
+			material->RefreshShaderHandles();
 		}
 	}
 
-	// Render 2nd shadow map
+	if (skyBox && (shader == skyPixelShader.get() || shader == skyVertexShader.get() || shader == skyFullscreenVertexShader.get()))
 	{
-		// Initial pipeline setup - No RTV necessary - Clear shadow map
-		context->OMSetRenderTargets(0, 0, shadowDSV2.Get());
-		context->ClearDepthStencilView(shadowDSV2.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-		context->RSSetState(shadowRasterizer.Get());
+		skyBox->RefreshShaderHandles();
+	}
 
-		// Update View matrix to light 2
-		XMMATRIX shView = XMMatrixLookAtLH(
-			XMVectorSet(dScale * lights[1].Direction.x, dScale * lights[1].Direction.y, dScale * lights[1].Direction.z, 0.0f),
-			XMVectorSet(0, 0, 0, 0),
-			XMVectorSet(0, 1, 0, 0));
-		XMStoreFloat4x4(&shadowViewMatrix2, shView);
+	if (materialTable && shader == tablePixelShader.get())
+	{
+		materialTable->RefreshShaderHandles();
+	}
 
-		// Turn on our shadow map Vertex Shader
-		// and turn OFF the pixel shader entirely
-		shadowVertexShader->SetShader();
-		shadowVertexShader->SetMatrix4x4("view", shadowViewMatrix2);
-		shadowVertexShader->SetMatrix4x4("projection", shadowProjectionMatrix);
-		context->PSSetShader(0, 0, 0); // No PS
+	if (frameShaderHandles.count(shader))
+	{
+		LookUpFrameShaderHandles(shader);
+	}
+}
 
-		//create camera to pass to entity to draw. This camera is actually the light.
-		std::shared_ptr<Camera> lightCamera = std::make_shared<Camera>(1.0f, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XM_PI / 3, 0.01f, 1000.0f, 1.0f, 5.0f, false);
+// --------------------------------------------------------
+// Looks up a shader's per frame variables by name, so
+// binding it each job only goes through handles
+// --------------------------------------------------------
+void Game::LookUpFrameShaderHandles(ISimpleShader* shader)
+{
+	FrameShaderHandles& handles = frameShaderHandles[shader];
+	handles.World = shader->GetVariableHandle("world");
+	handles.WorldInvTranspose = shader->GetVariableHandle("worldInvTranspose");
+	handles.MaterialIndex = shader->GetVariableHandle("materialIndex");
+	handles.View = shader->GetVariableHandle("view");
+	handles.Projection = shader->GetVariableHandle("projection");
+	handles.ShadowView = shader->GetVariableHandle("shadowView");
+	handles.ShadowProjection = shader->GetVariableHandle("shadowProjection");
+	handles.Lights = shader->GetVariableHandle("lights");
+	handles.LightCount = shader->GetVariableHandle("lightCount");
+	handles.ShadowMaps[0] = shader->GetShaderResourceViewHandle("ShadowMap1");
+	handles.ShadowMaps[1] = shader->GetShaderResourceViewHandle("ShadowMap2");
+	handles.ShadowMaps[2] = shader->GetShaderResourceViewHandle("ShadowMap3");
+	handles.ShadowSampler = shader->GetSamplerHandle("ShadowSampler");
+	handles.IrradianceSH = shader->GetVariableHandle("irradianceSH");
+	handles.SpecularMipCount = shader->GetVariableHandle("specularMipCount");
+	handles.SpecularMap = shader->GetShaderResourceViewHandle("SpecularMap");
+	handles.BrdfLut = shader->GetShaderResourceViewHandle("BrdfLut");
+	handles.ClampSampler = shader->GetSamplerHandle("ClampSampler");
+	handles.CameraPosition = shader->GetVariableHandle("cameraPosition");
+	handles.AmbientTerm = shader->GetVariableHandle("ambientTerm");
+	handles.BasicSampler = shader->GetSamplerHandle("BasicSampler");
+}
 
-		//set camera to the lights orientation and set projection to shadowMap viewport values
-		lightCamera->SetViewMatrix(shadowViewMatrix2);
-		lightCamera->SetProjectionMatrix(shadowProjectionMatrix);
+// --------------------------------------------------------
+// A shader's per frame handles, all invalid for a shader
+// LoadShaders didn't look up. Only reads the table, so
+// recording jobs can call it together.
+// --------------------------------------------------------
+const FrameShaderHandles& Game::GetFrameShaderHandles(ISimpleShader* shader)
+{
+	static const FrameShaderHandles none;
+	auto found = frameShaderHandles.find(shader);
+	return found != frameShaderHandles.end() ? found->second : none;
+}
 
-		// Loop and draw all entities
-		for (auto& e : gameEntities)
+// --------------------------------------------------------
+// Moves entities onto the bounds of meshes that reloaded,
+// then gathers the assets whose files changed for the next
+// packet. A shader's includes are scanned again first, as
+// the edit may have added one.
+// --------------------------------------------------------
+void Game::UpdateHotReload()
+{
+	{
+		std::lock_guard<std::mutex> lock(reloadedMeshMutex);
+		for (auto& mesh : reloadedMeshBounds)
 		{
-			shadowVertexShader->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-			shadowVertexShader->CopyAllBufferData();
+			gameEntities.SetMeshBounds(mesh.first, mesh.second);
+		}
+		reloadedMeshBounds.clear();
+	}
+
+	if (!fileWatcher || !hotReloadScanned.IsDone())
+		return;
 
-			// Draw the mesh
-			e->Draw(lightCamera);
+	std::vector<std::string> files;
+	fileWatcher->Poll(files);
+	if (files.empty())
+		return;
+
+	std::vector<AssetId> changed;
+	hotReloadDependencies.GetChanged(files, changed);
+	for (AssetId asset : changed)
+	{
+		const std::string& source = hotReloadAssets[asset].ShaderSource;
+		if (!source.empty())
+		{
+			std::vector<std::string> shaderFiles;
+			AssetDependencies::GetShaderFiles(source, shaderFiles);
+			hotReloadDependencies.SetFiles(asset, shaderFiles);
 		}
+
+		printf("Hot reload: %s\n", hotReloadDependencies.GetName(asset).c_str());
+		pendingHotReloads.push_back(asset);
+		hotReloadCount++;
 	}
+}
 
-	// Render 3rd shadow map
+// --------------------------------------------------------
+// Fills the render queue with every draw for this frame
+// (all shadow passes plus the culled main pass) and sorts
+// it so each pass can be walked in state order
+// --------------------------------------------------------
+void Game::BuildRenderQueue()
+{
+	//materials in the table share a shader and bindings, so they sort and batch as one
+	bool useTable = materialTable && renderFrame->UseMaterialTable;
+	queueMaterialKeys.resize(materials.size());
+	for (unsigned int m = 0; m < materials.size(); m++)
 	{
-		// Initial pipeline setup - No RTV necessary - Clear shadow map
-		context->OMSetRenderTargets(0, 0, shadowDSV3.Get());
-		context->ClearDepthStencilView(shadowDSV3.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-		context->RSSetState(shadowRasterizer.Get());
+		bool tabled = useTable && materialTable->IsInTable(m);
+		queueMaterialKeys[m].Shader = tabled ? materialTableShaderId : materialShaderIds[m];
+		queueMaterialKeys[m].Material = tabled ? 0 : m;
+	}
+
+	RenderQueueScene scene = {};
+	scene.EntityCount = (unsigned int)renderFrame->Flags.size();
+	scene.Flags = renderFrame->Flags.data();
+	scene.Meshes = renderFrame->Meshes.data();
+	scene.Materials = renderFrame->Materials.data();
+	scene.WorldBounds = renderFrame->WorldBounds.data();
+	scene.MaterialKeys = queueMaterialKeys.data();
+	scene.View = renderFrame->View;
+	scene.Projection = renderFrame->Projection;
+	scene.FarClip = renderFrame->FarClip;
+	queueBuilder->Build(scene, renderQueue);
+
+	if (renderQueue.GetClampedCount() && !clampedKeysReported)
+	{
+		printf("Render queue: %u draws have a shader, material or mesh id too large for the sort key\n", renderQueue.GetClampedCount());
+		clampedKeysReported = true;
+	}
+}
+
+// --------------------------------------------------------
+// Texture streaming feedback: each visible draw asks for
+// the mip its material's streamed textures are sampled at,
+// from how densely its UVs cover the screen at the nearest
+// point of its bounds
+// --------------------------------------------------------
+void Game::RequestStreamedMips()
+{
+	PROFILE_SCOPE("Streaming feedback");
+	MipResidency& residency = textureStreamer->GetResidency();
+	residency.SetBudget((size_t)renderFrame->StreamingBudgetMB * 1024 * 1024);
+
+	//pixels one unit covers at distance 1
+	float pixelsPerWorldUnit = renderFrame->Projection._22 * renderFrame->Height * 0.5f;
+	XMVECTOR cameraPosition = XMLoadFloat3(&renderFrame->CameraPosition);
+	for (unsigned int i = 0; i < renderFrame->Flags.size(); i++)
+	{
+		const std::vector<StreamingHandle>& streams = materialStreams[renderFrame->Materials[i]];
+		if (!queueBuilder->IsVisible(i) || streams.empty())
+			continue;
+
+		const BoundingBox& bounds = renderFrame->WorldBounds[i];
+		XMVECTOR outside = XMVectorAbs(cameraPosition - XMLoadFloat3(&bounds.Center)) - XMLoadFloat3(&bounds.Extents);
+		float distance = XMVectorGetX(XMVector3Length(XMVectorMax(outside, XMVectorZero())));
+
+		//scaling stretches the UVs, over the largest axis the most
+		XMFLOAT3 scale = renderFrame->Transforms[i].GetScale();
+		float largestScale = scale.x > scale.y ? scale.x : scale.y;
+		largestScale = scale.z > largestScale ? scale.z : largestScale;
+		float uvPerWorldUnit = gameMeshes[renderFrame->Meshes[i]]->GetUVDensity() / largestScale;
+		for (StreamingHandle stream : streams)
+		{
+			residency.Request(stream, MipResidency::ComputeMip(residency.GetWidth(stream), residency.GetHeight(stream), uvPerWorldUnit, distance, pixelsPerWorldUnit));
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Writes each entity's per object constants into its own
+// aligned block of the ring buffer, so draws only have to
+// bind an offset
+// --------------------------------------------------------
+void Game::UploadObjectConstants()
+{
+	objectBlocksReady = false;
+
+	unsigned int count = (unsigned int)renderFrame->Transforms.size();
+	if (count == 0 || !objectRing->IsSupported())
+		return;
+
+	unsigned char* blocks = (unsigned char*)objectRing->Map(count * CONSTANT_BUFFER_OFFSET_ALIGNMENT, &objectBlockOffset);
+	if (!blocks)
+		return;
+
+	Transform* transforms = renderFrame->Transforms.data();
+	const unsigned int* materialIds = renderFrame->Materials.data();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		PerObjectData* block = (PerObjectData*)(blocks + i * CONSTANT_BUFFER_OFFSET_ALIGNMENT);
+		block->World = transforms[i].GetWorldMatrix();
+		block->WorldInvTranspose = transforms[i].GetWorldInverseTransposeMatrix();
+		block->MaterialIndex = materialIds[i];
+	}
+	objectRing->Unmap();
+
+	objectBlocksReady = true;
+}
+
+// --------------------------------------------------------
+// Binds an entity's block of per object constants, which
+// goes around the state tracker
+// --------------------------------------------------------
+void Game::BindObjectConstants(unsigned int entityIndex, RecordingTarget& target)
+{
+	objectRing->BindVS(target.Context1, 1, objectBlockOffset + entityIndex * CONSTANT_BUFFER_OFFSET_ALIGNMENT, sizeof(PerObjectData));
+	target.Recording->GetStateTracker()->InvalidateVSConstantBuffer(1);
+}
+
+// --------------------------------------------------------
+// Points each shadow view at its light, done before any
+// recording since the main pass needs them too
+// --------------------------------------------------------
+void Game::UpdateShadowViews()
+{
+	float dScale = -1 * 20.0f;
 
-		// Update View matrix to light 2
+	XMFLOAT4X4* shadowViews[3] = { &shadowViewMatrix1, &shadowViewMatrix2, &shadowViewMatrix3 };
+	for (unsigned int i = 0; i < 3; i++)
+	{
 		XMMATRIX shView = XMMatrixLookAtLH(
-			XMVectorSet(dScale * lights[2].Direction.x, dScale * lights[2].Direction.y, dScale * lights[2].Direction.z, 0.0f),
+			XMVectorSet(dScale * renderFrame->Lights[i].Direction.x, dScale * renderFrame->Lights[i].Direction.y, dScale * renderFrame->Lights[i].Direction.z, 0.0f),
 			XMVectorSet(0, 0, 0, 0),
 			XMVectorSet(0, 1, 0, 0));
-		XMStoreFloat4x4(&shadowViewMatrix3, shView);
+		XMStoreFloat4x4(shadowViews[i], shView);
+	}
+}
+
+// --------------------------------------------------------
+// Splits the sorted queue into recording jobs: one per
+// shadow map and the main pass spread over the workers
+// --------------------------------------------------------
+void Game::BuildRecordingJobs()
+{
+	//below this many draws a job isn't worth its command list
+	const unsigned int minItemsPerJob = 64;
+
+	recordingJobs.clear();
+	const RenderItem* items = renderQueue.GetItems();
+	for (unsigned int pass = RENDER_PASS_SHADOW_0; pass <= RENDER_PASS_OPAQUE; pass++)
+	{
+		unsigned int count = 0;
+		renderQueue.GetPassItems(pass, &count);
+		unsigned int maxJobs = pass == RENDER_PASS_OPAQUE ? commandRecorder->GetWorkerCount() : 1;
+		RecordingPlan::AddPassJobs(pass, items, renderQueue.GetPassStart(pass), count, maxJobs, minItemsPerJob, recordingJobs);
+	}
+
+	RenderStats noStats = {};
+	jobStats.assign(recordingJobs.size(), noStats);
+	if (jobBatches.size() < recordingJobs.size())
+	{
+		jobBatches.resize(recordingJobs.size());
+	}
+}
 
-		// Turn on our shadow map Vertex Shader
-		// and turn OFF the pixel shader entirely
-		shadowVertexShader->SetShader();
-		shadowVertexShader->SetMatrix4x4("view", shadowViewMatrix3);
-		shadowVertexShader->SetMatrix4x4("projection", shadowProjectionMatrix);
-		context->PSSetShader(0, 0, 0); // No PS
+// --------------------------------------------------------
+// Records one job from top to bottom, possibly on a worker
+// thread. Deferred contexts start every command list in
+// default state, so each job sets up all it uses.
+// --------------------------------------------------------
+void Game::RecordJob(unsigned int jobIndex, RecordingTarget& target)
+{
+	const RecordingJob& job = recordingJobs[jobIndex];
+	SimpleStateTracker* tracker = target.Recording->GetStateTracker();
+
+	// Pass timings bracket the first and last job of each pass,
+	// whose lists execute in order
+	bool firstOfPass = jobIndex == 0 || recordingJobs[jobIndex - 1].Pass != job.Pass;
+	bool lastOfPass = jobIndex + 1 == recordingJobs.size() || recordingJobs[jobIndex + 1].Pass != job.Pass;
+	if (firstOfPass)
+	{
+		gpuQueries->Timestamp(target.Context, gpuTimer->GetFrameSlot(), GpuTimer::BeginQuery(job.Pass));
+	}
+
+	target.Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (renderFrame->UseInstancing)
+	{
+		instanceBuffer->Bind(target.Context);
+	}
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.TopLeftX = 0.0f;
+	viewport.TopLeftY = 0.0f;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+
+	if (job.Pass == RENDER_PASS_OPAQUE)
+	{
+		viewport.Width = (float)renderFrame->Width;
+		viewport.Height = (float)renderFrame->Height;
+		tracker->SetRenderTarget(backBufferRTV.Get(), depthBufferDSV.Get());
+		tracker->SetViewport(viewport);
+		DrawOpaqueEntities(jobIndex, target);
+	}
+	else
+	{
+		// Need a viewport that matches the shadow map resolution
+		viewport.Width = (float)shadowMapResolution;
+		viewport.Height = (float)shadowMapResolution;
+		tracker->SetViewport(viewport);
+		tracker->SetRasterizerState(shadowRasterizer.Get());
+
+		// No RTV necessary - Clear shadow map, each shadow pass is a single job
+		ID3D11DepthStencilView* shadowDSVs[3] = { shadowDSV1.Get(), shadowDSV2.Get(), shadowDSV3.Get() };
+		ID3D11DepthStencilView* shadowDSV = shadowDSVs[job.Pass - RENDER_PASS_SHADOW_0];
+		tracker->SetRenderTarget(0, shadowDSV);
+		target.Context->ClearDepthStencilView(shadowDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+		DrawShadowCasters(jobIndex, target);
+		tracker->SetRasterizerState(0);
+	}
 
-		//create camera to pass to entity to draw. This camera is actually the light.
-		std::shared_ptr<Camera> lightCamera = std::make_shared<Camera>(1.0f, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XM_PI / 3, 0.01f, 1000.0f, 1.0f, 5.0f, false);
+	if (lastOfPass)
+	{
+		gpuQueries->Timestamp(target.Context, gpuTimer->GetFrameSlot(), GpuTimer::EndQuery(job.Pass));
+	}
+}
 
-		//set camera to the lights orientation and set projection to shadowMap viewport values
-		lightCamera->SetViewMatrix(shadowViewMatrix3);
-		lightCamera->SetProjectionMatrix(shadowProjectionMatrix);
+void Game::DrawShadowCasters(unsigned int jobIndex, RecordingTarget& target)
+{
+	const RecordingJob& job = recordingJobs[jobIndex];
+	RenderStats& stats = jobStats[jobIndex];
+	const RenderItem* items = renderQueue.GetItems() + job.FirstItem;
+	unsigned int count = job.ItemCount;
+	PROFILE_SCOPE(shadowPassScopes[job.Pass - RENDER_PASS_SHADOW_0]);
+
+	XMFLOAT4X4 shadowViews[3] = { shadowViewMatrix1, shadowViewMatrix2, shadowViewMatrix3 };
+
+	// Turn on our shadow map Vertex Shader
+	// and turn OFF the pixel shader entirely
+	SimpleVertexShader* vs = renderFrame->UseInstancing ? shadowInstancedVertexShader.get() : shadowVertexShader.get();
+	const FrameShaderHandles& handles = GetFrameShaderHandles(vs);
+	vs->SetMatrix4x4(handles.View, shadowViews[job.Pass - RENDER_PASS_SHADOW_0]);
+	vs->SetMatrix4x4(handles.Projection, shadowProjectionMatrix);
+	vs->SetShader();
+	vs->CopyAllBufferData();
+	target.Recording->GetStateTracker()->SetPixelShader(0); // No PS
+	stats.ShaderBinds += 2;
+
+	// Items are sorted by mesh, so buffers only change between meshes
+	unsigned int boundMesh = UINT_MAX;
+
+	if (renderFrame->UseInstancing)
+	{
+		std::vector<InstanceBatch>& batches = jobBatches[jobIndex];
+		batches.clear();
+		InstanceBatcher::BuildBatches(items, count, job.FirstItem, batches);
+		for (InstanceBatch& batch : batches)
+		{
+			if (batch.Mesh != boundMesh)
+			{
+				gameMeshes[batch.Mesh]->SetBuffers(target.Context);
+				boundMesh = batch.Mesh;
+				stats.MeshBinds++;
+			}
+			gameMeshes[batch.Mesh]->DrawIndexedInstanced(target.Context, batch.InstanceCount, batch.FirstInstance);
+			stats.DrawCalls++;
+		}
+		return;
+	}
 
-		// Loop and draw all entities
-		for (auto& e : gameEntities)
+	Transform* transforms = renderFrame->Transforms.data();
+	for (unsigned int d = 0; d < count; d++)
+	{
+		unsigned int entity = items[d].EntityIndex;
+		if (objectBlocksReady && target.Context1)
+		{
+			BindObjectConstants(entity, target);
+		}
+		else
 		{
-			shadowVertexShader->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-			shadowVertexShader->CopyAllBufferData();
+			vs->SetMatrix4x4(handles.World, transforms[entity].GetWorldMatrix());
+			vs->CopyAllBufferData();
+		}
 
-			// Draw the mesh
-			e->Draw(lightCamera);
+		unsigned int mesh = RenderQueue::GetMesh(items[d].Key);
+		if (mesh != boundMesh)
+		{
+			gameMeshes[mesh]->SetBuffers(target.Context);
+			boundMesh = mesh;
+			stats.MeshBinds++;
 		}
+		gameMeshes[mesh]->DrawIndexed(target.Context);
+		stats.DrawCalls++;
 	}
+}
 
-	// After rendering the shadow map, go back to the screen
-	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthBufferDSV.Get());
-	viewport.Width = (float)this->windowWidth;
-	viewport.Height = (float)this->windowHeight;
-	context->RSSetViewports(1, &viewport);
-	context->RSSetState(0);
+// --------------------------------------------------------
+// Sets the per frame camera, shadow and light data for a
+// freshly bound main pass shader pair
+// --------------------------------------------------------
+void Game::SetFrameShaderData(SimpleVertexShader* vs, SimplePixelShader* ps, RenderStats& stats)
+{
+	XMFLOAT4X4 shadowViews[3] = { shadowViewMatrix1, shadowViewMatrix2, shadowViewMatrix3 };
+	const FrameShaderHandles& vsHandles = GetFrameShaderHandles(vs);
+	const FrameShaderHandles& psHandles = GetFrameShaderHandles(ps);
+
+	//set camera and shadow info for vertex shader
+	vs->SetMatrix4x4(vsHandles.View, renderFrame->View);
+	vs->SetMatrix4x4(vsHandles.Projection, renderFrame->Projection);
+	vs->SetData(vsHandles.ShadowView, shadowViews, sizeof(shadowViews));
+	vs->SetMatrix4x4(vsHandles.ShadowProjection, shadowProjectionMatrix);
+	vs->CopyAllBufferData();
+
+	//set lights for pixel shader
+	ps->SetData(psHandles.Lights, &renderFrame->Lights[0], sizeof(Light) * (int)renderFrame->Lights.size());
+	ps->SetInt(psHandles.LightCount, renderFrame->LightCount);
+	ps->SetShaderResourceView(psHandles.ShadowMaps[0], shadowSRV1.Get());
+	ps->SetShaderResourceView(psHandles.ShadowMaps[1], shadowSRV2.Get());
+	ps->SetShaderResourceView(psHandles.ShadowMaps[2], shadowSRV3.Get());
+	ps->SetSamplerState(psHandles.ShadowSampler, shadowSampler.Get());
+	stats.SRVBinds += 3;
+	stats.SamplerBinds += 1;
+
+	//sky lighting, if it's loaded yet
+	ps->SetData(psHandles.IrradianceSH, irradianceSH, sizeof(irradianceSH));
+	ps->SetInt(psHandles.SpecularMipCount, specularMipCount);
+	ps->SetShaderResourceView(psHandles.SpecularMap, specularSRV.Get());
+	ps->SetShaderResourceView(psHandles.BrdfLut, brdfSRV.Get());
+	ps->SetSamplerState(psHandles.ClampSampler, clampSampler.Get());
+	stats.SRVBinds += 2;
+	stats.SamplerBinds += 1;
+}
+
+// --------------------------------------------------------
+// Binds the table shader with everything the materials in
+// the table share, which is all they need: draws with it
+// pick their textures and tint by material index
+// --------------------------------------------------------
+void Game::BindMaterialTable(SimpleVertexShader* vs, RenderStats& stats)
+{
+	SimplePixelShader* ps = tablePixelShader.get();
+	const FrameShaderHandles& handles = GetFrameShaderHandles(ps);
+	SetFrameShaderData(vs, ps, stats);
+	vs->SetShader();
+	ps->SetShader();
+	stats.ShaderBinds += 2;
+
+	ps->SetFloat3(handles.CameraPosition, renderFrame->CameraPosition);
+	ps->SetFloat3(handles.AmbientTerm, renderFrame->AmbientColor);
+	ps->CopyAllBufferData();
+	ps->SetSamplerState(handles.BasicSampler, samplerState.Get());
+	stats.SRVBinds += materialTable->Bind();
+	stats.SamplerBinds += 1;
+}
+
+// --------------------------------------------------------
+// Draws a job's share of the main pass in render queue
+// order, only rebinding state when the sort key changes.
+// With instancing enabled each run of matching shader,
+// material and mesh is a single instanced draw. Draws of
+// the material table's shader bind no material at all.
+// --------------------------------------------------------
+void Game::DrawOpaqueEntities(unsigned int jobIndex, RecordingTarget& target)
+{
+	const RecordingJob& job = recordingJobs[jobIndex];
+	RenderStats& stats = jobStats[jobIndex];
+	const RenderItem* items = renderQueue.GetItems() + job.FirstItem;
+	unsigned int count = job.ItemCount;
+	PROFILE_SCOPE("Opaque entities");
+
+	// Default depth and rasterizer states, whatever drew last
+	SimpleStateTracker* tracker = target.Recording->GetStateTracker();
+	tracker->SetDepthStencilState(0, 0);
+	tracker->SetRasterizerState(0);
+
+	unsigned int boundShader = UINT_MAX;
+	unsigned int boundMaterial = UINT_MAX;
+	unsigned int boundMesh = UINT_MAX;
+
+	if (renderFrame->UseInstancing)
+	{
+		std::vector<InstanceBatch>& batches = jobBatches[jobIndex];
+		batches.clear();
+		InstanceBatcher::BuildBatches(items, count, job.FirstItem, batches);
+		for (InstanceBatch& batch : batches)
+		{
+			Material* material = materials[batch.Material].get();
+			bool table = batch.Shader == materialTableShaderId;
+
+			if (batch.Shader != boundShader && table)
+			{
+				BindMaterialTable(instancedVertexShader.get(), stats);
+				boundShader = batch.Shader;
+			}
+			else if (batch.Shader != boundShader)
+			{
+				SetFrameShaderData(material->GetInstancedVertexShader().get(), material->GetPixelShader().get(), stats);
+				material->SetShaders(true);
+				boundShader = batch.Shader;
+				boundMaterial = UINT_MAX;
+				stats.ShaderBinds += 2;
+			}
+
+			if (!table && batch.Material != boundMaterial)
+			{
+				material->PrepareMaterial(renderFrame->CameraPosition, renderFrame->AmbientColor);
+				boundMaterial = batch.Material;
+				stats.SRVBinds += material->GetTextureSRVCount();
+				stats.SamplerBinds += material->GetSamplerCount();
+			}
+
+			if (batch.Mesh != boundMesh)
+			{
+				gameMeshes[batch.Mesh]->SetBuffers(target.Context);
+				boundMesh = batch.Mesh;
+				stats.MeshBinds++;
+			}
+			gameMeshes[batch.Mesh]->DrawIndexedInstanced(target.Context, batch.InstanceCount, batch.FirstInstance);
+			stats.DrawCalls++;
+		}
+		return;
+	}
+
+	Transform* transforms = renderFrame->Transforms.data();
+	const FrameShaderHandles& handles = GetFrameShaderHandles(vertexShader.get());
+	for (unsigned int d = 0; d < count; d++)
+	{
+		unsigned long long key = items[d].Key;
+		unsigned int materialId = RenderQueue::GetMaterial(key);
+		Material* material = materials[materialId].get();
+		bool table = RenderQueue::GetShader(key) == materialTableShaderId;
+
+		if (RenderQueue::GetShader(key) != boundShader && table)
+		{
+			BindMaterialTable(vertexShader.get(), stats);
+			boundShader = RenderQueue::GetShader(key);
+		}
+		else if (RenderQueue::GetShader(key) != boundShader)
+		{
+			SetFrameShaderData(material->GetVertexShader().get(), material->GetPixelShader().get(), stats);
+			material->SetShaders();
+			boundShader = RenderQueue::GetShader(key);
+			boundMaterial = UINT_MAX;
+			stats.ShaderBinds += 2;
+		}
+
+		if (!table && materialId != boundMaterial)
+		{
+			material->PrepareMaterial(renderFrame->CameraPosition, renderFrame->AmbientColor);
+			boundMaterial = materialId;
+			stats.SRVBinds += material->GetTextureSRVCount();
+			stats.SamplerBinds += material->GetSamplerCount();
+		}
+
+		unsigned int entity = items[d].EntityIndex;
+		if (objectBlocksReady && target.Context1)
+		{
+			BindObjectConstants(entity, target);
+		}
+		else if (table)
+		{
+			//the key's material isn't the entity's, which the shader needs
+			vertexShader->SetMatrix4x4(handles.World, transforms[entity].GetWorldMatrix());
+			vertexShader->SetMatrix4x4(handles.WorldInvTranspose, transforms[entity].GetWorldInverseTransposeMatrix());
+			vertexShader->SetInt(handles.MaterialIndex, (int)renderFrame->Materials[entity]);
+			vertexShader->CopyAllBufferData();
+		}
+		else
+		{
+			material->PrepareObject(&transforms[entity]);
+		}
+
+		unsigned int mesh = RenderQueue::GetMesh(key);
+		if (mesh != boundMesh)
+		{
+			gameMeshes[mesh]->SetBuffers(target.Context);
+			boundMesh = mesh;
+			stats.MeshBinds++;
+		}
+		gameMeshes[mesh]->DrawIndexed(target.Context);
+		stats.DrawCalls++;
+	}
 }
 
 void Game::UpdateImGui(float deltaTime)
@@ -722,9 +1842,61 @@ void Game::UpdateStatsUI()
 {
 	ImGuiIO& io = ImGui::GetIO();
 
+	ImGui::Begin("Stats");
+
 	ImGui::Text("Framerate: %f", io.Framerate);
 	ImGui::Text("Window Size: %d x %d", windowWidth,windowHeight);
 
+	//counters from the last frame the render stage handed back
+	RenderStats& stats = displayedResults.Stats;
+	ImGui::Text("Queued draws: %u", displayedResults.QueuedDraws);
+	ImGui::Text("Draw calls: %u", stats.DrawCalls);
+	ImGui::Text("Shader binds: %u", stats.ShaderBinds);
+	ImGui::Text("SRV binds: %u", stats.SRVBinds);
+	ImGui::Text("Sampler binds: %u", stats.SamplerBinds);
+	ImGui::Text("Mesh binds: %u", stats.MeshBinds);
+	ImGui::Text("CB bytes uploaded: %u", displayedResults.BytesUploaded);
+	ImGui::Text("CB uploads skipped: %u", ISimpleShader::UploadsSkipped.load());
+	ImGui::Text("State calls issued: %u, filtered: %u", displayedResults.StateCallsIssued, displayedResults.StateCallsFiltered);
+	ImGui::Text("Recording jobs: %u", displayedResults.RecordingJobs);
+	ImGui::Text("Job threads: %u, jobs run: %u, stolen: %u", jobSystem->GetThreadCount(), jobSystem->GetJobsRun(), jobSystem->GetJobsStolen());
+	ImGui::Text("Reflection cache hits: %u, misses: %u", SimpleShaderReflectionCache::Hits, SimpleShaderReflectionCache::Misses);
+	ImGui::Text("Assets loaded: %u / %u%s", assetLoader->GetUploadedCount(), assetLoader->GetQueuedCount(), serialLoading ? " (serial)" : "");
+	if (hotReload)
+	{
+		ImGui::Text("Hot reloads: %u", hotReloadCount);
+	}
+
+	if (textureStreamer)
+	{
+		const MipResidencyStats& streaming = displayedResults.Streaming;
+		ImGui::Text("Streamed textures: %u, %u at requested mip, mip bias %u", streaming.TextureCount, streaming.TexturesAtRequest, streaming.MipBias);
+		ImGui::Text("Texture memory: %.1f MB resident, %.1f MB requested, %.1f MB loading", streaming.ResidentBytes / 1048576.0f,
+			streaming.RequestedBytes / 1048576.0f, streaming.PendingBytes / 1048576.0f);
+		ImGui::Text("Mip loads: %llu (%.1f MB), evictions: %llu, pending: %u", streaming.Loads, streaming.BytesLoaded / 1048576.0f,
+			streaming.Evictions, streaming.PendingLoads);
+		ImGui::SliderInt("Streaming budget (MB)", &streamingBudgetMB, 1, 512);
+	}
+
+	if (materialTable)
+	{
+		ImGui::Text("Material table: %u of %u materials, %u slice copies", displayedResults.TabledMaterials, (unsigned int)materials.size(),
+			displayedResults.TableSliceCopies);
+		ImGui::Checkbox("Material table", &useMaterialTable);
+	}
+
+	ImGui::Checkbox("Instanced draws", &useInstancing);
+	ImGui::Checkbox("Fullscreen sky", &useFullscreenSky);
+	if (commandRecorder->IsSupported())
+	{
+		ImGui::Checkbox("Threaded recording", &useThreadedRecording);
+	}
+
+	ImGui::Checkbox("Pipelined frames", &usePipelining);
+	ImGui::SliderInt("Pipeline depth", &pipelineDepth, 1, FRAME_PIPELINE_MAX_DEPTH);
+	ImGui::Text("Pipeline: %.1f fps, %.2f ms latency", framePipeline->GetFramesPerSecond(), framePipeline->GetAverageLatencyMs());
+
+	ImGui::End();
 }
 
 void Game::UpdateEntityCameraControlUI()
@@ -732,11 +1904,12 @@ void Game::UpdateEntityCameraControlUI()
 	ImGui::Begin("Entity and Camera Control");
 
 	//Entity Controls
-	XMFLOAT3 pos = gameEntities[0]->GetTransform()->GetPosition();
+	Transform* entityTransform = gameEntities.GetTransform(entityHandles[0]);
+	XMFLOAT3 pos = entityTransform->GetPosition();
 
 	if (ImGui::DragFloat3("Triangle 1 Position", &pos.x))
 	{
-		gameEntities[0]->GetTransform()->SetPosition(pos.x, pos.y, pos.z);
+		entityTransform->SetPosition(pos.x, pos.y, pos.z);
 	}
 
 	ImGui::End();
@@ -801,6 +1974,12 @@ void Game::UpdateLights()
 // --------------------------------------------------------
 void Game::OnResize()
 {
+	// The render stage must be done with the back buffer
+	if (framePipeline)
+	{
+		framePipeline->Flush();
+	}
+
 	// Handle base-level DX resize stuff
 	DXCore::OnResize();
 
@@ -816,16 +1995,36 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	//Update UI
-	UpdateImGui(deltaTime);
+	Profiler::GetInstance().BeginFrame();
+	PROFILE_SCOPE("Update");
+	long long updateStart = Profiler::GetInstance().Now();
+	timingStats->AddSample("Frame", deltaTime * 1000.0f);
+
+	//Start, stop or resize the pipeline between frames
+	ApplyPipelineSettings();
+
+	//Wait for a packet the render stage is done with
+	FramePacket* packet = 0;
+	{
+		PROFILE_SCOPE("Wait for free packet");
+		packet = framePipeline->AcquireForUpdate();
+	}
+	displayedResults = packet->Results;
 
-	//Display ImGUI windows
+	//Update UI
+	if (!headless)
 	{
+		PROFILE_SCOPE("Build UI");
+		UpdateImGui(deltaTime);
+
+		//Profiler timeline
+		profilerWindow->Draw();
+
 		//Update Lights
 		UpdateLights();
 
-		////Update Stats UI
-		//UpdateStatsUI();
+		//Update Stats UI
+		UpdateStatsUI();
 
 		////Update Entity and Camera Control UI
 		//UpdateEntityCameraControlUI();	
@@ -854,15 +2053,368 @@ void Game::Update(float deltaTime, float totalTime)
 		//gameEntities[4]->GetTransform()->Rotate(0.0f, 0.0f, 5*deltaTime);
 	}
 	
-	//Camera Update
-	mainCamera->Update(deltaTime);
+	//Camera Update, or the next step along the benchmark's path
+	if (benchmark)
+	{
+		UpdateBenchmark();
+	}
+	else
+	{
+		mainCamera->Update(deltaTime);
+	}
+
+	//Pick up files that changed, and bounds of meshes that reloaded
+	UpdateHotReload();
+
+	//Refresh world bounds now that transforms are final for this frame,
+	//which also brings every world matrix up to date for the draw jobs
+	PROFILE_SCOPE("Update bounds");
+	JobCounter boundsUpdated;
+	jobSystem->ParallelFor(gameEntities.GetCount(), 256, [this](unsigned int begin, unsigned int end)
+	{
+		gameEntities.UpdateBounds(begin, end);
+	}, &boundsUpdated);
+	jobSystem->Wait(&boundsUpdated);
+
+	//Snapshot the frame and hand it to the render stage
+	if (!headless)
+	{
+		PROFILE_SCOPE("Finish UI");
+		ImGui::Render();
+		CloneUIDrawData(packet);
+	}
+	FillFramePacket(packet, deltaTime, totalTime);
+	framePipeline->Submit(packet);
+	timingStats->AddSample("CPU update", (Profiler::GetInstance().Now() - updateStart) / 1000000.0f);
+
+	if (headless && !benchmark)
+	{
+		UpdateHeadless();
+	}
+}
+
+// --------------------------------------------------------
+// Copies everything the render stage reads out of the
+// simulation, so Update can move on to the next frame
+// while this one renders
+// --------------------------------------------------------
+void Game::FillFramePacket(FramePacket* packet, float deltaTime, float totalTime)
+{
+	PROFILE_SCOPE("Fill frame packet");
+	packet->DeltaTime = deltaTime;
+	packet->TotalTime = totalTime;
+
+	packet->View = mainCamera->GetViewMatrix();
+	packet->Projection = mainCamera->GetProjectionMatrix();
+	packet->CameraPosition = mainCamera->GetTransform()->GetPosition();
+	packet->AmbientColor = mainCamera->GetAmbientColor();
+	packet->FarClip = mainCamera->GetFarClipDistance();
+
+	packet->Lights = lights;
+	packet->LightCount = numOfLightsInGame;
+
+	//assign() reuses the packet's capacity once the scene stops growing
+	unsigned int count = gameEntities.GetCount();
+	packet->Transforms.assign(gameEntities.GetTransforms(), gameEntities.GetTransforms() + count);
+	packet->WorldBounds.assign(gameEntities.GetWorldBounds(), gameEntities.GetWorldBounds() + count);
+	packet->Meshes.assign(gameEntities.GetMeshes(), gameEntities.GetMeshes() + count);
+	packet->Materials.assign(gameEntities.GetMaterials(), gameEntities.GetMaterials() + count);
+	packet->Flags.assign(gameEntities.GetFlags(), gameEntities.GetFlags() + count);
+
+	packet->Width = this->windowWidth;
+	packet->Height = this->windowHeight;
+	packet->UseInstancing = useInstancing;
+	packet->UseThreadedRecording = useThreadedRecording;
+	packet->UseMaterialTable = useMaterialTable;
+	packet->UseFullscreenSky = useFullscreenSky;
+	packet->StreamingBudgetMB = (unsigned int)streamingBudgetMB;
+
+	packet->HotReloads.swap(pendingHotReloads);
+	pendingHotReloads.clear();
+}
+
+// --------------------------------------------------------
+// ImGui's draw lists are rebuilt by the next NewFrame(), so
+// each packet keeps its own copy to render from
+// --------------------------------------------------------
+void Game::CloneUIDrawData(FramePacket* packet)
+{
+	FreeUIDrawData(packet);
+
+	ImDrawData* drawData = ImGui::GetDrawData();
+	for (int i = 0; i < drawData->CmdListsCount; i++)
+	{
+		packet->UIDrawLists.push_back(drawData->CmdLists[i]->CloneOutput());
+	}
+	packet->UIDrawData = *drawData;
+	packet->UIDrawData.CmdLists = packet->UIDrawLists.data();
+}
+
+void Game::FreeUIDrawData(FramePacket* packet)
+{
+	for (ImDrawList* list : packet->UIDrawLists)
+	{
+		IM_DELETE(list);
+	}
+	packet->UIDrawLists.clear();
+	packet->UIDrawData.Clear();
+}
+
+// --------------------------------------------------------
+// Starts or stops the render thread and changes the depth
+// when the UI (or the headless sweep) asked for it. The
+// pipeline is drained first, so no packet is in flight.
+// --------------------------------------------------------
+void Game::ApplyPipelineSettings()
+{
+	if (usePipelining == renderThreadRunning && (unsigned int)pipelineDepth == framePipeline->GetDepth())
+		return;
+
+	StopRenderThread();
+	framePipeline->SetDepth(pipelineDepth);
+	if (usePipelining)
+	{
+		StartRenderThread();
+	}
+}
+
+void Game::StartRenderThread()
+{
+	renderThreadRunning = true;
+	renderThread = std::thread(&Game::RenderThreadLoop, this);
+}
+
+void Game::StopRenderThread()
+{
+	framePipeline->Flush();
+	if (renderThreadRunning)
+	{
+		framePipeline->Stop();
+		renderThread.join();
+		framePipeline->Restart();
+		renderThreadRunning = false;
+	}
+}
+
+// --------------------------------------------------------
+// The render stage when pipelining. Owns the immediate
+// context until it is stopped.
+// --------------------------------------------------------
+void Game::RenderThreadLoop()
+{
+	Profiler::GetInstance().SetThreadName("Render");
+	SimpleRecordingContext::Bind(immediateRecording.get());
+
+	//its waits on recording and packing jobs get a queue of their own
+	jobSystem->RegisterThread();
+
+	FramePacket* packet = 0;
+	while ((packet = framePipeline->AcquireForRender()))
+	{
+		RenderFrame(packet);
+		framePipeline->Release(packet);
+	}
+
+	jobSystem->UnregisterThread();
+	SimpleRecordingContext::Bind(0);
 }
 
 // --------------------------------------------------------
-// Clear the screen, redraw everything, present to the user
+// Places the camera along the fly-through, a fixed step per
+// frame so every run sees the same views. Records after a
+// warmup, then writes JSON and CSV reports to diff against
+// a baseline and quits.
+// --------------------------------------------------------
+void Game::UpdateBenchmark()
+{
+	unsigned int lastFrame = BENCHMARK_WARMUP_FRAMES + benchmarkFrames;
+	if (benchmarkFrame > lastFrame)
+		return;
+
+	XMFLOAT3 position;
+	float pitch = 0.0f;
+	float yaw = 0.0f;
+	cameraPath.Evaluate((float)benchmarkFrame / lastFrame, &position, &pitch, &yaw);
+	mainCamera->GetTransform()->SetPosition(position.x, position.y, position.z);
+	mainCamera->GetTransform()->SetRotation(pitch, yaw, 0.0f);
+	mainCamera->UpdateViewMatrix();
+
+	if (benchmarkFrame == BENCHMARK_WARMUP_FRAMES)
+	{
+		frameStatsRecorder->Reset();
+		timingStats->SetRecorder(frameStatsRecorder);
+	}
+	else if (benchmarkFrame == lastFrame)
+	{
+		framePipeline->Flush();
+		timingStats->SetRecorder(0);
+
+		std::ofstream json(FixPath(L"benchmark_report.json"));
+		frameStatsRecorder->WriteJson(json, headless ? "headless" : "d3d11");
+		std::ofstream csv(FixPath(L"benchmark_report.csv"));
+		frameStatsRecorder->WriteCsv(csv);
+
+		TimingSummary frame = {};
+		if (frameStatsRecorder->GetSummary("Frame", &frame))
+		{
+			printf("Benchmark: %u frames, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, %llu hitches\n",
+				frame.Count, frame.P50, frame.P95, frame.P99, frameStatsRecorder->GetHitchCount());
+		}
+		Quit();
+	}
+
+	benchmarkFrame++;
+}
+
+// --------------------------------------------------------
+// Measures each pipeline depth after a warmup, printing
+// throughput and update-to-release latency, then writes
+// the report and quits after the deepest one
+// --------------------------------------------------------
+void Game::UpdateHeadless()
+{
+	if (headlessDepth > FRAME_PIPELINE_MAX_DEPTH)
+		return;
+
+	headlessFrame++;
+	if (headlessFrame == HEADLESS_WARMUP_FRAMES)
+	{
+		framePipeline->Flush();
+		headlessStart = std::chrono::steady_clock::now();
+		headlessStartReleased = framePipeline->GetFramesReleased();
+		headlessStartLatencyMs = framePipeline->GetTotalLatencyMs();
+	}
+	else if (headlessFrame == HEADLESS_WARMUP_FRAMES + HEADLESS_MEASURED_FRAMES)
+	{
+		framePipeline->Flush();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - headlessStart).count();
+		unsigned long long frames = framePipeline->GetFramesReleased() - headlessStartReleased;
+		double latencyMs = framePipeline->GetTotalLatencyMs() - headlessStartLatencyMs;
+
+		//per frame counts are the null backend's, from the latest frame
+		char line[256];
+		sprintf_s(line, "Pipeline depth %u: %.1f frames/s, %.3f ms average latency, %u draws, %u bytes uploaded, %u state changes per frame\n",
+			headlessDepth, frames / seconds, latencyMs / frames,
+			displayedResults.Stats.DrawCalls, displayedResults.BytesUploaded, displayedResults.StateCallsIssued);
+		printf("%s", line);
+		headlessReport += line;
+
+		headlessDepth++;
+		headlessFrame = 0;
+		if (headlessDepth <= FRAME_PIPELINE_MAX_DEPTH)
+		{
+			pipelineDepth = headlessDepth;
+		}
+		else
+		{
+			std::ofstream report(FixPath(L"headless_pipeline.txt"));
+			report << headlessReport;
+			Quit();
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Renders the packet Update just submitted, unless the
+// render thread is taking packets itself
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
+	if (renderThreadRunning)
+		return;
+
+	FramePacket* packet = framePipeline->AcquireForRender();
+	RenderFrame(packet);
+	framePipeline->Release(packet);
+}
+
+// --------------------------------------------------------
+// Clear the screen, redraw everything, present to the user.
+// Reads the frame only from the packet, never from the
+// simulation, which may already be on a later frame.
+// --------------------------------------------------------
+void Game::RenderFrame(FramePacket* packet)
+{
+	PROFILE_SCOPE("Render frame");
+	long long renderStart = Profiler::GetInstance().Now();
+	renderFrame = packet;
+
+	// Swap in a few more loaded assets for their placeholders, ahead
+	// of anything that reads them this frame
+	assetLoader->MarkFirstFrame();
+	for (AssetId asset : packet->HotReloads)
+	{
+		hotReloadAssets[asset].Reload();
+	}
+	assetLoader->UploadReady(ASSET_UPLOADS_PER_FRAME);
+	if (assetLoader->IsDone() && !assetReportWritten)
+	{
+		std::ofstream report(FixPath(L"startup_timeline.txt"));
+		assetLoader->WriteReport(report);
+		assetReportWritten = true;
+	}
+
+	// Copy textures that loaded, or streamed last frame, into the material table
+	if (materialTable)
+	{
+		materialTable->Update(materials);
+	}
+
+	// Start counting this frame's constant buffer uploads and state calls
+	ISimpleShader::ResetUploadStats();
+	jobSystem->ResetStats();
+	commandRecorder->ResetStats();
+
+	// Queue and sort every draw for the frame
+	BuildRenderQueue();
+
+	// Stream texture mips toward what the visible draws sample, swapping
+	// in textures whose reads finished before anything records with them
+	if (textureStreamer)
+	{
+		RequestStreamedMips();
+		textureStreamer->Update();
+	}
+
+	// Headless frames go to the null backend through the submitter,
+	// instead of through the D3D11 draw loops below
+	if (headless)
+	{
+		SubmitFrame frame = {};
+		frame.View = packet->View;
+		frame.Projection = packet->Projection;
+		UpdateShadowViews();
+		frame.ShadowViews[0] = shadowViewMatrix1;
+		frame.ShadowViews[1] = shadowViewMatrix2;
+		frame.ShadowViews[2] = shadowViewMatrix3;
+		frame.ShadowProjection = shadowProjectionMatrix;
+		frame.CameraPosition = packet->CameraPosition;
+		frame.AmbientColor = packet->AmbientColor;
+		frame.Lights = packet->Lights.data();
+		frame.LightCount = packet->LightCount;
+		frame.Width = packet->Width;
+		frame.Height = packet->Height;
+		frame.ShadowResolution = shadowMapResolution;
+		frame.UseInstancing = packet->UseInstancing;
+
+		{
+			PROFILE_SCOPE("Submit to null backend");
+			renderBackend->BeginFrame();
+			queueSubmitter->Submit(renderQueue, packet->Transforms.data(), frame);
+			renderBackend->EndFrame();
+		}
+
+		RenderBackendStats backendStats = renderBackend->GetFrameStats();
+		packet->Results = {};
+		packet->Results.Stats.DrawCalls = backendStats.DrawCalls;
+		packet->Results.QueuedDraws = renderQueue.GetCount();
+		packet->Results.StateCallsIssued = backendStats.StateChanges;
+		packet->Results.StateCallsFiltered = backendStats.RedundantBinds;
+		packet->Results.BytesUploaded = backendStats.BytesUploaded;
+		timingStats->AddSample("CPU render frame", (Profiler::GetInstance().Now() - renderStart) / 1000000.0f);
+		return;
+	}
+
 	// Frame START
 	// - These things should happen ONCE PER FRAME
 	// - At the beginning of Game::Draw() before drawing *anything*
@@ -873,44 +2425,84 @@ void Game::Draw(float deltaTime, float totalTime)
 
 		// Clear the depth buffer (resets per-pixel occlusion information)
 		context->ClearDepthStencilView(depthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-	}
 
-	// Render the shadow map before rendering anything to the screen
-	RenderShadowMaps();
+		// Presenting, resizing and ImGui change bindings behind the tracker's back
+		stateTracker->Invalidate();
 
-	std::vector <DirectX::XMFLOAT4X4> viewMatrices;
-	viewMatrices.push_back(shadowViewMatrix1);
-	viewMatrices.push_back(shadowViewMatrix2);
-	viewMatrices.push_back(shadowViewMatrix3);
+		// Read back finished GPU timings and start this frame's
+		gpuTimer->BeginFrame();
+		gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::BeginQuery(GPU_SCOPE_FRAME));
+	}
 
-	//draw each entity
-	for (std::shared_ptr<Entity> entity : gameEntities)
+	// Write every queued draw's instance data once, shared by all passes
+	if (packet->UseInstancing)
 	{
-		std::shared_ptr<SimpleVertexShader> vs = entity->GetMaterial()->GetVertexShader();
-		std::shared_ptr<SimplePixelShader> ps = entity->GetMaterial()->GetPixelShader();
-		
-		//set shadow info for vertex shader
-		vs->SetData("shadowView", &viewMatrices[0],sizeof(DirectX::XMFLOAT4X4)*viewMatrices.size());
-		vs->SetMatrix4x4("shadowProjection", shadowProjectionMatrix);
+		PROFILE_SCOPE("Pack instances");
+		InstanceData* instances = instanceBuffer->Map(renderQueue.GetCount());
+		if (instances)
+		{
+			JobCounter packed;
+			jobSystem->ParallelFor(renderQueue.GetCount(), 512, [&](unsigned int begin, unsigned int end)
+			{
+				InstanceBatcher::PackInstances(renderQueue.GetItems() + begin, end - begin, packet->Transforms.data(), packet->Materials.data(), instances + begin);
+			}, &packed);
+			jobSystem->Wait(&packed);
+			instanceBuffer->Unmap();
+		}
+	}
+	else
+	{
+		// Otherwise write every entity's per object constants once for all passes
+		UploadObjectConstants();
+	}
 
-		//set lights for pixel shader
-		ps->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-		ps->SetInt("lightCount", numOfLightsInGame);
-		ps->SetShaderResourceView("ShadowMap1", shadowSRV1);
-		ps->SetShaderResourceView("ShadowMap2", shadowSRV2);
-		ps->SetShaderResourceView("ShadowMap3", shadowSRV3);
-		ps->SetSamplerState("ShadowSampler", shadowSampler);
+	// Record the shadow maps, then all visible entities, on worker
+	// threads when enabled; the lists execute in that order
+	UpdateShadowViews();
+	BuildRecordingJobs();
+	{
+		PROFILE_SCOPE("Record passes");
+		commandRecorder->Record((unsigned int)recordingJobs.size(), packet->UseThreadedRecording,
+			[this](unsigned int jobIndex, RecordingTarget& target) { RecordJob(jobIndex, target); });
+	}
+	{
+		PROFILE_SCOPE("Execute command lists");
+		commandRecorder->Execute();
+	}
 
-		//draw entity
-		entity->Draw(mainCamera);
+	RenderStats& stats = renderQueue.GetStats();
+	for (RenderStats& job : jobStats)
+	{
+		stats.DrawCalls += job.DrawCalls;
+		stats.ShaderBinds += job.ShaderBinds;
+		stats.SRVBinds += job.SRVBinds;
+		stats.SamplerBinds += job.SamplerBinds;
+		stats.MeshBinds += job.MeshBinds;
 	}
+
+	// Executed lists leave the immediate context in default state
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)packet->Width;
+	viewport.Height = (float)packet->Height;
+	viewport.MaxDepth = 1.0f;
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stateTracker->SetRenderTarget(backBufferRTV.Get(), depthBufferDSV.Get());
+	stateTracker->SetViewport(viewport);
 	
 	//draw skybox
-	skyBox->Draw(context, mainCamera);
+	gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::BeginQuery(GPU_SCOPE_SKY));
+	skyBox->Draw(stateTracker, packet->View, packet->Projection, packet->UseFullscreenSky);
+	gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::EndQuery(GPU_SCOPE_SKY));
 
-	// Draw ImGui
-	ImGui::Render();
-	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+	// Draw the UI built by this packet's update
+	{
+		PROFILE_SCOPE("Render ImGui");
+		gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::BeginQuery(GPU_SCOPE_UI));
+		ImGui_ImplDX11_RenderDrawData(&packet->UIDrawData);
+		gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::EndQuery(GPU_SCOPE_UI));
+	}
+	gpuQueries->Timestamp(context.Get(), gpuTimer->GetFrameSlot(), GpuTimer::EndQuery(GPU_SCOPE_FRAME));
+	gpuTimer->EndFrame();
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
@@ -919,9 +2511,28 @@ void Game::Draw(float deltaTime, float totalTime)
 		// Present the back buffer to the user
 		//  - Puts the results of what we've drawn onto the window
 		//  - Without this, the user never sees anything
+		PROFILE_SCOPE("Present");
 		swapChain->Present(vsync ? 1 : 0, 0);
 
 		// Must re-bind buffers after presenting, as they become unbound
 		context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthBufferDSV.Get());
 	}
+
+	// Counters for the update stage's stats UI
+	packet->Results.Stats = stats;
+	packet->Results.QueuedDraws = renderQueue.GetCount();
+	packet->Results.RecordingJobs = (unsigned int)recordingJobs.size();
+	packet->Results.StateCallsIssued = commandRecorder->GetIssuedCalls();
+	packet->Results.StateCallsFiltered = commandRecorder->GetFilteredCalls();
+	packet->Results.BytesUploaded = ISimpleShader::BytesUploaded;
+	if (textureStreamer)
+	{
+		packet->Results.Streaming = textureStreamer->GetResidency().GetStats();
+	}
+	if (materialTable)
+	{
+		packet->Results.TabledMaterials = materialTable->GetTabledCount();
+		packet->Results.TableSliceCopies = materialTable->GetSliceCopies();
+	}
+	timingStats->AddSample("CPU render frame", (Profiler::GetInstance().Now() - renderStart) / 1000000.0f);
 }
\ No newline at end of file
@@ -5,13 +5,84 @@
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 #include <vector>
 #include<memory>
+#include <string>
 #include "Mesh.h"
-#include "Entity.h"
+#include "EntityRegistry.h"
 #include "Camera.h"
 #include "SimpleShader/SimpleShader.h"
 #include "Material.h"
 #include "Lights.h"
 #include "Sky.h"
+#include "EnvironmentLighting.h"
+#include "RenderQueue.h"
+#include "RenderQueueBuilder.h"
+#include "InstanceBuffer.h"
+#include "ConstantBufferRing.h"
+#include "JobSystem.h"
+#include "CommandRecorder.h"
+#include "RecordingPlan.h"
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "ProfilerWindow.h"
+#include "TimingStats.h"
+#include "GpuTimer.h"
+#include "D3D11QueryBackend.h"
+#include "FrameStatsRecorder.h"
+#include "CameraPath.h"
+#include "NullRenderBackend.h"
+#include "RenderQueueSubmitter.h"
+#include "TextureLoader.h"
+#include "AssetLoader.h"
+#include "TextureStreamer.h"
+#include "MaterialTableResources.h"
+#include "FileWatcher.h"
+#include "AssetDependencies.h"
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Matches the PerObject cbuffer of the vertex shaders
+struct PerObjectData
+{
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 WorldInvTranspose;
+	unsigned int MaterialIndex;
+	unsigned int Padding[3];
+};
+
+// Per frame and per object variables of a main pass or shadow
+// shader, looked up once and again after the shader reloads.
+// Handles a shader doesn't have stay invalid and set nothing.
+struct FrameShaderHandles
+{
+	SimpleShaderHandle World;
+	SimpleShaderHandle WorldInvTranspose;
+	SimpleShaderHandle MaterialIndex;
+	SimpleShaderHandle View;
+	SimpleShaderHandle Projection;
+	SimpleShaderHandle ShadowView;
+	SimpleShaderHandle ShadowProjection;
+	SimpleShaderHandle Lights;
+	SimpleShaderHandle LightCount;
+	SimpleShaderHandle ShadowMaps[3];
+	SimpleShaderHandle ShadowSampler;
+	SimpleShaderHandle IrradianceSH;
+	SimpleShaderHandle SpecularMipCount;
+	SimpleShaderHandle SpecularMap;
+	SimpleShaderHandle BrdfLut;
+	SimpleShaderHandle ClampSampler;
+	SimpleShaderHandle CameraPosition;
+	SimpleShaderHandle AmbientTerm;
+	SimpleShaderHandle BasicSampler;
+};
+
+// An asset hot reload watches, by AssetId
+struct HotReloadAsset
+{
+	std::function<void()> Reload;	// Run by the render stage, queues the reload on the asset loader
+	std::string ShaderSource;		// Shaders only, scanned for includes again before each reload
+};
 
 class Game 
 	: public DXCore
@@ -33,12 +104,54 @@ private:
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadShaders();
 	void LoadTexturesAndSamplerState();
+	void QueueMaterialTexture(const std::string& name, bool (*read)(const std::string&, TextureData&, JobSystem*), const std::string& basePath,
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex, const char* shaderName);
+	bool StreamMaterialTexture(const std::string& ddsPath, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex,
+		const char* shaderName);
+	void LoadMaterialMap(const std::string& name, bool (*read)(const std::string&, TextureData&, JobSystem*),
+		void (*getFiles)(const std::string&, std::vector<std::string>&), const char* ddsSuffix, const std::string& basePath,
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* srv, unsigned int materialIndex, const char* shaderName);
+	AssetHandle QueueMesh(const std::string& name, const std::wstring& path, const std::vector<unsigned int>& slots);
+	void QueueSkyCubeMap(const std::string& path);
+	void QueueEnvironmentLighting(const std::string& path);
 	void CreateMaterials();
 	void CreateMeshesAndEntitites();
 	void CreateLights();
 	void CreateSkyBox();
+	void CreateEnvironmentLighting();
 	void CreateShadowMapResources();
-	void RenderShadowMaps();
+	void CreateRenderBackendResources();
+	void CreateHotReload();
+	void AddHotReload(const std::string& name, const std::vector<std::string>& files, const std::function<void()>& reload,
+		const std::string& shaderSource = std::string());
+	void AddShaderHotReload(const std::string& name, ISimpleShader* shader, const char* target);
+	void QueueShaderReload(const std::string& name, const std::string& path, ISimpleShader* shader, const char* target);
+	void RefreshShaderHandles(ISimpleShader* shader);
+	void LookUpFrameShaderHandles(ISimpleShader* shader);
+	const FrameShaderHandles& GetFrameShaderHandles(ISimpleShader* shader);
+	void UpdateHotReload();
+	void BuildRenderQueue();
+	void RequestStreamedMips();
+	void UploadObjectConstants();
+	void BindObjectConstants(unsigned int entityIndex, RecordingTarget& target);
+	void UpdateShadowViews();
+	void BuildRecordingJobs();
+	void RecordJob(unsigned int jobIndex, RecordingTarget& target);
+	void DrawShadowCasters(unsigned int jobIndex, RecordingTarget& target);
+	void SetFrameShaderData(SimpleVertexShader* vs, SimplePixelShader* ps, RenderStats& stats);
+	void BindMaterialTable(SimpleVertexShader* vs, RenderStats& stats);
+	void DrawOpaqueEntities(unsigned int jobIndex, RecordingTarget& target);
+
+	void FillFramePacket(FramePacket* packet, float deltaTime, float totalTime);
+	void RenderFrame(FramePacket* packet);
+	void RenderThreadLoop();
+	void StartRenderThread();
+	void StopRenderThread();
+	void ApplyPipelineSettings();
+	void UpdateHeadless();
+	void UpdateBenchmark();
+	void CloneUIDrawData(FramePacket* packet);
+	void FreeUIDrawData(FramePacket* packet);
 
 	void UpdateImGui(float deltaTime);
 	void UpdateStatsUI();
@@ -60,6 +173,13 @@ private:
 	//Custom Shaders
 	std::shared_ptr<SimpleVertexShader> shadowVertexShader;
 	std::shared_ptr<SimplePixelShader> customPixelShader;
+	//Instanced variants reading world matrices from the instance buffer
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
+	std::shared_ptr<SimpleVertexShader> shadowInstancedVertexShader;
+	//Draws every material in the material table, which replaces pixelShader for them
+	std::shared_ptr<SimplePixelShader> tablePixelShader;
+	//Handles SetFrameShaderData and the shadow pass set, by shader
+	std::unordered_map<ISimpleShader*, FrameShaderHandles> frameShaderHandles;
 
 	// Texture and texture-related constructs (how to have a vector of com pointers?)
 	//Albedo Map SRVs
@@ -68,24 +188,18 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV3;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV4;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureSRV5;
-	//Normal Map SRVs
+	//Normal Map SRVs (two channel)
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalSRV1;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalSRV2;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalSRV3;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalSRV4;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> normalSRV5;
-	//Roughness Map SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessSRV1;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessSRV2;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessSRV3;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessSRV4;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughnessSRV5;
-	//Metalness Map SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessSRV1;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessSRV2;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessSRV3;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessSRV4;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalnessSRV5;
+	//Surface Map SRVs (roughness, metalness and occlusion packed together)
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfaceSRV1;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfaceSRV2;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfaceSRV3;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfaceSRV4;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> surfaceSRV5;
 	//Sampler State
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
 
@@ -94,17 +208,132 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skySRV;
 	//shaders
 	std::shared_ptr<SimpleVertexShader> skyVertexShader;
+	std::shared_ptr<SimpleVertexShader> skyFullscreenVertexShader;
 	std::shared_ptr<SimplePixelShader> skyPixelShader;
 	//sky class
 	std::shared_ptr<Sky> skyBox;
+	bool useFullscreenSky; //one generated triangle instead of the cube mesh
 	/*Skybox related end*/
 
+	//Image based lighting from the sky: irradiance as spherical harmonics (rgb of each),
+	//a prefiltered specular cube and the BRDF table. specularMipCount is 0 until they
+	//load, which has the shaders fall back to ambientTerm.
+	DirectX::XMFLOAT4 irradianceSH[ENVIRONMENT_SH_COEFFICIENTS];
+	int specularMipCount;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> specularSRV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> brdfSRV;
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> clampSampler;
+
 	//Materials
 	std::vector<std::shared_ptr<Material>> materials;
+	std::vector<unsigned int> materialShaderIds; //shader pair id of each material, for draw sorting
+
+	//Materials compiled into texture arrays and a buffer of records, so their draws
+	//share one shader id and set of bindings and only pass a material index; null headless
+	std::shared_ptr<MaterialTableResources> materialTable;
+	unsigned int materialTableShaderId; //after every shader pair's id
+	bool useMaterialTable;
+	bool clampedKeysReported; //an id overflowed a sort key field, printed once
 
 	// Meshes and Entities
 	std::vector<std::shared_ptr<Mesh>> gameMeshes;
-	std::vector<std::shared_ptr<Entity>> gameEntities;
+	EntityRegistry gameEntities;
+	std::vector<EntityHandle> entityHandles; //in creation order, for UI access
+
+	//Worker threads for culling, bounds, instance packing and recording
+	std::shared_ptr<JobSystem> jobSystem;
+
+	//Startup assets, read on the job system (on this thread with -serialload)
+	//and uploaded a few per frame by the render stage, placeholders until then
+	std::shared_ptr<AssetLoader> assetLoader;
+	bool serialLoading;
+	bool assetReportWritten;
+
+	//Mips of the textures the asset tools built stream within a budget, from
+	//feedback on the visible draws; null with -nostream or headless
+	std::shared_ptr<TextureStreamer> textureStreamer;
+	std::vector<std::vector<StreamingHandle>> materialStreams; //streamed textures of each material
+	bool textureStreaming;
+	int streamingBudgetMB; //set in the UI, handed to the render stage with each packet
+
+	//Hot reload: the files every asset was built from are watched and, when one
+	//changes, only the assets using it load again through assetLoader, swapped in
+	//where they're already held. Off headless, benchmarking and with -nohotreload.
+	bool hotReload;
+	std::shared_ptr<FileWatcher> fileWatcher;
+	AssetDependencies hotReloadDependencies; //fingerprinted by a job at startup, then only used by Update
+	JobCounter hotReloadScanned;
+	std::vector<std::pair<std::string, std::vector<std::string>>> hotReloadFiles; //name and files of each asset, until that job adds them
+	std::vector<HotReloadAsset> hotReloadAssets;
+	std::vector<AssetId> pendingHotReloads; //for the next packet
+	unsigned int hotReloadCount;
+	std::mutex reloadedMeshMutex;
+	std::vector<std::pair<unsigned int, DirectX::BoundingBox>> reloadedMeshBounds; //from the render stage, set on entities by Update
+
+	//Sorted draws for the current frame, and what culls and fills them
+	RenderQueue renderQueue;
+	std::shared_ptr<RenderQueueBuilder> queueBuilder;
+	std::vector<RenderQueueMaterial> queueMaterialKeys; //per material, rebuilt each frame
+
+	//Main thread recording on the immediate context
+	std::shared_ptr<SimpleRecordingContext> immediateRecording;
+	SimpleStateTracker* stateTracker; //the immediate context's, filters redundant state changes
+
+	//Passes recorded as jobs, on worker threads with deferred contexts when threaded
+	std::shared_ptr<CommandRecorder> commandRecorder;
+	std::vector<RecordingJob> recordingJobs;
+	std::vector<RenderStats> jobStats; //merged into the queue's stats after recording
+	std::vector<std::vector<InstanceBatch>> jobBatches; //reused by each job
+	bool useThreadedRecording;
+
+	//Frame packets handed from Update to the render stage, which runs
+	//on its own thread when pipelining so the next update overlaps it
+	std::shared_ptr<FramePipeline> framePipeline;
+	std::thread renderThread;
+	bool renderThreadRunning;
+	bool usePipelining;
+	int pipelineDepth;
+	FramePacket* renderFrame; //the packet being rendered, only read by the render stage
+	FrameRenderResults displayedResults; //from the last packet rendered, for the stats UI
+
+	//CPU timeline, drawn with the rest of the UI
+	std::shared_ptr<ProfilerWindow> profilerWindow;
+
+	//CPU and GPU timing series, GPU passes timed with queries
+	std::shared_ptr<TimingStats> timingStats;
+	std::shared_ptr<D3D11QueryBackend> gpuQueries;
+	std::shared_ptr<GpuTimer> gpuTimer;
+
+	//Benchmark: scripted fly-through recorded into a report
+	bool benchmark;
+	unsigned int benchmarkFrames;
+	unsigned int benchmarkFrame;
+	CameraPath cameraPath;
+	std::shared_ptr<FrameStatsRecorder> frameStatsRecorder;
+
+	//Headless benchmark: the scene's draws go to the null backend (the device
+	//and window still exist), sweeps every pipeline depth then quits
+	bool headless;
+	unsigned int headlessDepth;
+	unsigned int headlessFrame;
+	std::chrono::steady_clock::time_point headlessStart;
+	unsigned long long headlessStartReleased;
+	double headlessStartLatencyMs;
+	std::string headlessReport;
+
+	//Headless frames are submitted to the null backend, which counts what
+	//the device would have been sent
+	std::shared_ptr<IRenderBackend> renderBackend;
+	std::shared_ptr<RenderQueueSubmitter> queueSubmitter;
+
+	//Instancing
+	std::shared_ptr<InstanceBuffer> instanceBuffer;
+	bool useInstancing;
+
+	//Per object constants for non instanced draws, one aligned block per entity
+	std::shared_ptr<ConstantBufferRing> objectRing;
+	unsigned int objectBlockOffset;
+	bool objectBlocksReady; //false if the ring is unsupported or wasn't written this frame
 
 	//Camera
 	std::shared_ptr<Camera> mainCamera;
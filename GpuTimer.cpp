@@ -0,0 +1,78 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer(std::shared_ptr<IGpuQueryBackend> backend, std::shared_ptr<TimingStats> stats)
+{
+	this->backend = backend;
+	this->stats = stats;
+	nextFrame = 0;
+	oldestPending = 0;
+	currentSlot = 0;
+	frameOpen = false;
+	framesResolved = 0;
+	framesDropped = 0;
+}
+
+GpuTimer::~GpuTimer() {}
+
+unsigned int GpuTimer::RegisterScope(const std::string& name)
+{
+	scopeNames.push_back(name);
+	timestamps.resize(scopeNames.size() * 2);
+	return (unsigned int)scopeNames.size() - 1;
+}
+
+void GpuTimer::BeginFrame()
+{
+	Resolve();
+
+	//every slot still waiting on the GPU: give up on the oldest
+	//rather than stall the CPU
+	if (nextFrame - oldestPending >= GPU_TIMER_FRAME_LATENCY)
+	{
+		oldestPending++;
+		framesDropped++;
+	}
+
+	currentSlot = (unsigned int)(nextFrame % GPU_TIMER_FRAME_LATENCY);
+	nextFrame++;
+	frameOpen = true;
+	backend->BeginFrame(currentSlot);
+}
+
+void GpuTimer::EndFrame()
+{
+	if (!frameOpen)
+		return;
+
+	backend->EndFrame(currentSlot);
+	frameOpen = false;
+}
+
+void GpuTimer::Resolve()
+{
+	//frames finish in order, so stop at the first that isn't ready
+	while (oldestPending < nextFrame)
+	{
+		unsigned int slot = (unsigned int)(oldestPending % GPU_TIMER_FRAME_LATENCY);
+		unsigned long long frequency = 0;
+		bool disjoint = false;
+		if (!backend->ReadFrame(slot, GetTimestampCount(), timestamps.data(), &frequency, &disjoint))
+			break;
+
+		oldestPending++;
+		if (disjoint || frequency == 0)
+		{
+			framesDropped++;
+			continue;
+		}
+
+		for (unsigned int i = 0; i < scopeNames.size(); i++)
+		{
+			unsigned long long begin = timestamps[BeginQuery(i)];
+			unsigned long long end = timestamps[EndQuery(i)];
+			float ms = end > begin ? (float)((end - begin) * 1000.0 / frequency) : 0.0f;
+			stats->AddSample(scopeNames[i], ms);
+		}
+		framesResolved++;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "TimingStats.h"
+
+// Frames of queries in flight before the oldest is dropped
+// instead of waiting on the GPU
+#define GPU_TIMER_FRAME_LATENCY 4
+
+// --------------------------------------------------------
+// Where a GpuTimer's queries live. Each frame slot has a
+// disjoint query around the frame and two timestamps per
+// scope, issued by whoever owns the backend; the timer only
+// starts, ends and reads back frames.
+// --------------------------------------------------------
+class IGpuQueryBackend
+{
+public:
+	virtual ~IGpuQueryBackend() {}
+
+	virtual void BeginFrame(unsigned int slot) = 0;
+	virtual void EndFrame(unsigned int slot) = 0;
+
+	//Never blocks: false until every query of the slot is ready
+	virtual bool ReadFrame(unsigned int slot, unsigned int timestampCount, unsigned long long* timestamps,
+		unsigned long long* frequency, bool* disjoint) = 0;
+};
+
+// --------------------------------------------------------
+// Times GPU scopes a few frames behind, without stalling.
+// Scopes are registered once and bracketed every frame by
+// the query pair BeginQuery()/EndQuery() name. Resolved
+// times go to the TimingStats series of the same name.
+// --------------------------------------------------------
+class GpuTimer
+{
+public:
+	GpuTimer(std::shared_ptr<IGpuQueryBackend> backend, std::shared_ptr<TimingStats> stats);
+	~GpuTimer();
+
+	//Before the first frame; scope indices count up from 0
+	unsigned int RegisterScope(const std::string& name);
+	unsigned int GetTimestampCount() { return (unsigned int)scopeNames.size() * 2; }
+
+	//Reads back finished frames, then starts the next in a free slot
+	void BeginFrame();
+	void EndFrame();
+	unsigned int GetFrameSlot() { return currentSlot; }
+
+	//Timestamp indices within a slot
+	static unsigned int BeginQuery(unsigned int scope) { return scope * 2; }
+	static unsigned int EndQuery(unsigned int scope) { return scope * 2 + 1; }
+
+	unsigned long long GetFramesResolved() { return framesResolved; }
+	unsigned long long GetFramesDropped() { return framesDropped; } //disjoint, or still pending when its slot came up again
+
+private:
+	std::shared_ptr<IGpuQueryBackend> backend;
+	std::shared_ptr<TimingStats> stats;
+	std::vector<std::string> scopeNames;
+	std::vector<unsigned long long> timestamps; //readback scratch
+
+	unsigned long long nextFrame;
+	unsigned long long oldestPending; //frames in [oldestPending, nextFrame) are in flight
+	unsigned int currentSlot;
+	bool frameOpen;
+
+	unsigned long long framesResolved;
+	unsigned long long framesDropped;
+
+	void Resolve();
+};
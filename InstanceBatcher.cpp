@@ -0,0 +1,39 @@
+#include "InstanceBatcher.h"
+
+void InstanceBatcher::BuildBatches(const RenderItem* items, unsigned int count, unsigned int firstInstance, std::vector<InstanceBatch>& batches)
+{
+	//everything above the depth bits has to match to share a draw
+	const unsigned long long stateMask = ~0xFFFFull;
+
+	unsigned int start = 0;
+	while (start < count)
+	{
+		unsigned long long state = items[start].Key & stateMask;
+		unsigned int end = start + 1;
+		while (end < count && (items[end].Key & stateMask) == state)
+		{
+			end++;
+		}
+
+		InstanceBatch batch = {};
+		batch.Shader = RenderQueue::GetShader(state);
+		batch.Material = RenderQueue::GetMaterial(state);
+		batch.Mesh = RenderQueue::GetMesh(state);
+		batch.FirstInstance = firstInstance + start;
+		batch.InstanceCount = end - start;
+		batches.push_back(batch);
+
+		start = end;
+	}
+}
+
+void InstanceBatcher::PackInstances(const RenderItem* items, unsigned int count, Transform* transforms, const unsigned int* materials, InstanceData* destination)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Transform& transform = transforms[items[i].EntityIndex];
+		destination[i].World = transform.GetWorldMatrix();
+		destination[i].WorldInvTranspose = transform.GetWorldInverseTransposeMatrix();
+		destination[i].MaterialIndex = materials ? materials[items[i].EntityIndex] : RenderQueue::GetMaterial(items[i].Key);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "RenderQueue.h"
+#include "Transform.h"
+
+// --------------------------------------------------------
+// Per instance vertex data, matching the _PER_INSTANCE
+// inputs of the instanced vertex shaders. Matrix inputs
+// are column major like constant buffers, so matrices are
+// stored as is and the shaders keep the same mul() order.
+// Padded to the size of the PerObject cbuffer it mirrors.
+// --------------------------------------------------------
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 WorldInvTranspose;
+	unsigned int MaterialIndex;	// Record in the material table
+	unsigned int Padding[3];
+};
+
+// --------------------------------------------------------
+// A run of queued draws sharing shader, material and mesh,
+// drawn with one instanced call
+// --------------------------------------------------------
+struct InstanceBatch
+{
+	unsigned int Shader;
+	unsigned int Material;
+	unsigned int Mesh;
+	unsigned int FirstInstance;	// Offset into the instance buffer
+	unsigned int InstanceCount;
+};
+
+// --------------------------------------------------------
+// Turns sorted render queue items into instanced batches
+// and packs their instance data.
+// --------------------------------------------------------
+class InstanceBatcher
+{
+public:
+	//Appends batches for consecutive items with matching shader, material and mesh.
+	//firstInstance is the instance buffer offset of items[0].
+	static void BuildBatches(const RenderItem* items, unsigned int count, unsigned int firstInstance, std::vector<InstanceBatch>& batches);
+
+	//Writes one InstanceData per item, in item order. materials holds each entity's
+	//material, or is null to take the material from the item's key.
+	static void PackInstances(const RenderItem* items, unsigned int count, Transform* transforms, const unsigned int* materials, InstanceData* destination);
+};
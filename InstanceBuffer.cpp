@@ -0,0 +1,64 @@
+#include "InstanceBuffer.h"
+
+InstanceBuffer::InstanceBuffer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int initialCapacity)
+{
+	this->device = device;
+	this->context = context;
+	this->capacity = 0;
+
+	CreateBuffer(initialCapacity);
+}
+
+InstanceBuffer::~InstanceBuffer() {}
+
+InstanceData* InstanceBuffer::Map(unsigned int instanceCount)
+{
+	//grow to the next power of two so resizes stay rare
+	if (instanceCount > capacity)
+	{
+		unsigned int newCapacity = capacity > 0 ? capacity : 1;
+		while (newCapacity < instanceCount)
+		{
+			newCapacity *= 2;
+		}
+		CreateBuffer(newCapacity);
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return 0;
+
+	return (InstanceData*)mapped.pData;
+}
+
+void InstanceBuffer::Unmap()
+{
+	context->Unmap(buffer.Get(), 0);
+}
+
+void InstanceBuffer::Bind()
+{
+	Bind(context.Get());
+}
+
+void InstanceBuffer::Bind(ID3D11DeviceContext* context)
+{
+	UINT stride = sizeof(InstanceData);
+	UINT offset = 0;
+	context->IASetVertexBuffers(1, 1, buffer.GetAddressOf(), &stride, &offset);
+}
+
+void InstanceBuffer::CreateBuffer(unsigned int instanceCapacity)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;	// Rewritten by the CPU every frame
+	desc.ByteWidth = sizeof(InstanceData) * instanceCapacity;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
+
+	buffer.Reset();
+	device->CreateBuffer(&desc, 0, buffer.GetAddressOf());
+	capacity = instanceCapacity;
+}
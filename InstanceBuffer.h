@@ -0,0 +1,32 @@
+#pragma once
+
+#include <wrl/client.h>
+#include <d3d11.h>
+#include "InstanceBatcher.h"
+
+// --------------------------------------------------------
+// Dynamic vertex buffer holding a frame's InstanceData,
+// bound to input slot 1 for the _PER_INSTANCE inputs
+// --------------------------------------------------------
+class InstanceBuffer
+{
+public:
+	InstanceBuffer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int initialCapacity);
+	~InstanceBuffer();
+
+	//Discards the previous contents, growing the buffer if needed
+	InstanceData* Map(unsigned int instanceCount);
+	void Unmap();
+
+	void Bind();
+	void Bind(ID3D11DeviceContext* context); //on a deferred context
+	unsigned int GetCapacity() { return capacity; }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	unsigned int capacity;
+
+	void CreateBuffer(unsigned int instanceCapacity);
+};
@@ -0,0 +1,275 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+// The system the current thread is registered with, and the queue it owns there
+static thread_local JobSystem* currentSystem = 0;
+static thread_local unsigned int currentQueueIndex = 0;
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: queuedJobs(0), jobsRun(0), jobsStolen(0)
+{
+	stopping = false;
+	blockedWaiters = 0;
+	for (unsigned int i = 0; i < JOB_SYSTEM_MAX_EXTERNAL_THREADS; i++)
+	{
+		externalInUse[i] = false;
+	}
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	this->threadCount = threadCount;
+
+	for (unsigned int i = 0; i < threadCount + JOB_SYSTEM_MAX_EXTERNAL_THREADS + 1; i++)
+	{
+		queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+
+	//the creating thread is worker 0, the rest get their own threads
+	currentSystem = this;
+	currentQueueIndex = 0;
+	for (unsigned int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	if (currentSystem == this)
+		currentSystem = 0;
+}
+
+bool JobSystem::RegisterThread()
+{
+	std::lock_guard<std::mutex> lock(registerMutex);
+	for (unsigned int i = 0; i < JOB_SYSTEM_MAX_EXTERNAL_THREADS; i++)
+	{
+		if (!externalInUse[i])
+		{
+			externalInUse[i] = true;
+			currentSystem = this;
+			currentQueueIndex = threadCount + i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::UnregisterThread()
+{
+	if (currentSystem != this || currentQueueIndex < threadCount)
+		return;
+
+	//jobs left in the queue are still stolen by the others
+	std::lock_guard<std::mutex> lock(registerMutex);
+	externalInUse[currentQueueIndex - threadCount] = false;
+	currentSystem = 0;
+}
+
+void JobSystem::Run(const Job& job, JobCounter* counter, JobCounter* dependency)
+{
+	if (counter)
+	{
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//wrap the job so finishing it signals its counter
+	Job counted = counter ? Job([this, job, counter]() { job(); Finish(counter); }) : job;
+
+	//hold it back until the dependency is done, rechecking under its lock
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (!dependency->IsDone())
+		{
+			dependency->continuations.push_back(counted);
+			return;
+		}
+	}
+
+	Push(counted);
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& body, JobCounter* counter)
+{
+	if (grainSize == 0)
+		grainSize = 1;
+
+	for (unsigned int begin = 0; begin < count; begin += grainSize)
+	{
+		unsigned int end = count - begin > grainSize ? begin + grainSize : count;
+		Run([body, begin, end]() { body(begin, end); }, counter);
+	}
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	//help out instead of blocking, which also keeps nested waits from deadlocking
+	unsigned int queueIndex = GetQueueIndex();
+	unsigned int idle = 0;
+	while (!counter->IsDone())
+	{
+		if (RunOne(queueIndex))
+		{
+			idle = 0;
+			continue;
+		}
+
+		//the last jobs are likely about to finish, so yield for a while
+		if (++idle < JOB_SYSTEM_WAIT_YIELDS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		//then sleep until they do, or there is something to run
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		blockedWaiters++;
+		waiting.wait(lock, [this, counter]() { return counter->IsDone() || queuedJobs.load() > 0; });
+		blockedWaiters--;
+		idle = 0;
+	}
+
+	//the last job may still be releasing continuations
+	std::lock_guard<std::mutex> lock(counter->mutex);
+}
+
+void JobSystem::ResetStats()
+{
+	jobsRun = 0;
+	jobsStolen = 0;
+}
+
+void JobSystem::Push(const Job& job)
+{
+	WorkerQueue& queue = *queues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	//taking the sleep lock means no worker or waiter can miss the new job
+	queuedJobs.fetch_add(1);
+	bool waiters;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		waiters = blockedWaiters > 0;
+	}
+	wake.notify_one();
+	if (waiters)
+		waiting.notify_all();
+}
+
+bool JobSystem::RunOne(unsigned int queueIndex)
+{
+	Job job;
+	bool found = false;
+
+	//newest job of our own first, it is the most likely to be in cache
+	{
+		WorkerQueue& own = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			found = true;
+		}
+	}
+
+	//otherwise steal the oldest job of another queue
+	for (unsigned int i = 1; !found && i < queues.size(); i++)
+	{
+		WorkerQueue& victim = *queues[(queueIndex + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			found = true;
+			jobsStolen++;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	queuedJobs.fetch_sub(1);
+	job();
+	jobsRun++;
+	return true;
+}
+
+void JobSystem::Finish(JobCounter* counter)
+{
+	//counting down under the lock means no continuation can be added
+	//after the release, and Wait() can't return while it is held
+	std::vector<Job> released;
+	bool done = false;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			released.swap(counter->continuations);
+			done = true;
+		}
+	}
+	for (Job& job : released)
+	{
+		Push(job);
+	}
+
+	if (done)
+		WakeWaiters();
+}
+
+void JobSystem::WakeWaiters()
+{
+	//a waiter checks its counter under the sleep lock, so once we hold
+	//it every waiter has either seen the count or is asleep to be woken
+	bool waiters;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		waiters = blockedWaiters > 0;
+	}
+	if (waiters)
+		waiting.notify_all();
+}
+
+void JobSystem::WorkerLoop(unsigned int workerIndex)
+{
+	currentSystem = this;
+	currentQueueIndex = workerIndex;
+	Profiler::GetInstance().SetThreadName("Job worker " + std::to_string(workerIndex));
+
+	while (true)
+	{
+		if (RunOne(workerIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return stopping || queuedJobs.load() > 0; });
+		if (stopping)
+			return;
+	}
+}
+
+unsigned int JobSystem::GetQueueIndex()
+{
+	//threads that aren't registered share the last queue
+	return currentSystem == this ? currentQueueIndex : (unsigned int)queues.size() - 1;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::function<void()> Job;
+
+// Threads outside the pool that can have a queue of their own
+#define JOB_SYSTEM_MAX_EXTERNAL_THREADS 8
+
+// Times Wait() yields with nothing to run before it blocks
+#define JOB_SYSTEM_WAIT_YIELDS 64
+
+// --------------------------------------------------------
+// Counts unfinished jobs. Jobs can be held back until a
+// counter reaches zero, which is how dependencies are
+// expressed. Only destroy a counter once Wait() on it
+// has returned.
+// --------------------------------------------------------
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) {}
+
+	bool IsDone() { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<unsigned int> pending;
+	std::mutex mutex;
+	std::vector<Job> continuations; //queued once pending reaches zero
+};
+
+// --------------------------------------------------------
+// Runs jobs on a pool of worker threads. Each worker owns a
+// deque it pushes and pops at the back, and idle workers
+// steal from the front of the others'. The thread that
+// creates the system is worker 0. Other threads register
+// for a queue of their own, or share one if they don't.
+// Any thread runs jobs while it waits on a counter, and
+// blocks once there are none.
+// --------------------------------------------------------
+class JobSystem
+{
+public:
+	//threadCount includes the calling thread, 0 means one per core
+	JobSystem(unsigned int threadCount);
+	~JobSystem();
+
+	//Pool threads, including the creating thread
+	unsigned int GetThreadCount() { return threadCount; }
+
+	//Gives the calling thread a queue of its own until it unregisters,
+	//returning false if none is left. A thread can be registered with
+	//one system at a time.
+	bool RegisterThread();
+	void UnregisterThread();
+
+	//Queues a job that decrements counter (if any) when done. With a
+	//dependency, the job is held until that counter reaches zero.
+	void Run(const Job& job, JobCounter* counter, JobCounter* dependency = 0);
+
+	//Queues jobs calling body(begin, end) over [0, count) in ranges of
+	//at most grainSize, all counted on counter
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& body, JobCounter* counter);
+
+	//Runs queued jobs on the calling thread until counter reaches zero,
+	//blocking while there are none to run
+	void Wait(JobCounter* counter);
+
+	//Jobs run since the last reset, and how many were stolen
+	unsigned int GetJobsRun() { return jobsRun.load(); }
+	unsigned int GetJobsStolen() { return jobsStolen.load(); }
+	void ResetStats();
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	//the pool's queues (0 is the creating thread's), then one per external
+	//slot, then the one unregistered threads share
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> threads;
+	unsigned int threadCount;
+
+	std::mutex registerMutex;
+	bool externalInUse[JOB_SYSTEM_MAX_EXTERNAL_THREADS];
+
+	//sleeping when there is nothing to run or steal, and waiting on a
+	//counter when there is nothing to run
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::condition_variable waiting;
+	std::atomic<unsigned int> queuedJobs;
+	unsigned int blockedWaiters;
+	bool stopping;
+
+	std::atomic<unsigned int> jobsRun;
+	std::atomic<unsigned int> jobsStolen;
+
+	void Push(const Job& job);
+	bool RunOne(unsigned int queueIndex);
+	void Finish(JobCounter* counter);
+	void WakeWaiters();
+	void WorkerLoop(unsigned int workerIndex);
+	unsigned int GetQueueIndex();
+};
@@ -7,6 +7,10 @@ Material::Material(DirectX::XMFLOAT3 colorTint, float roughness, std::shared_ptr
 	this->roughness = roughness;
 	this->vertexShader = vertexShader;
 	this->pixelShader = pixelShader;
+	this->revision = 0;
+
+	ResolveVertexHandles();
+	ResolvePixelHandles();
 }
 
 Material::~Material() {}
@@ -31,19 +35,33 @@ std::shared_ptr<SimplePixelShader> Material::GetPixelShader()
 	return pixelShader;
 }
 
+std::shared_ptr<SimpleVertexShader> Material::GetInstancedVertexShader()
+{
+	return instancedVertexShader;
+}
+
 void Material::SetColorTint(DirectX::XMFLOAT3 colorTint)
 {
 	this->colorTint = colorTint;
+	revision++;
 }
 
 void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vertexShader)
 {
 	this->vertexShader = vertexShader;
+	ResolveVertexHandles();
 }
 
 void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> pixelShader)
 {
 	this->pixelShader = pixelShader;
+	revision++;
+	ResolvePixelHandles();
+}
+
+void Material::SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> instancedVertexShader)
+{
+	this->instancedVertexShader = instancedVertexShader;
 }
 
 void Material::SetRoughness(float roughness)
@@ -51,43 +69,105 @@ void Material::SetRoughness(float roughness)
 	this->roughness = roughness;
 }
 
+void Material::RefreshShaderHandles()
+{
+	revision++;
+	ResolveVertexHandles();
+	ResolvePixelHandles();
+}
+
 void Material::AddTextureSRV(std::string textureName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
-	textureSRVs.insert({ textureName, srv });
+	//replaces any earlier texture of the same name, like a placeholder
+	textureSRVs[textureName] = srv;
+	revision++;
+	ResolvePixelHandles();
 }
 
 void Material::AddSampler(std::string samplerName, Microsoft::WRL::ComPtr<ID3D11SamplerState> ss)
 {
 	samplers.insert({ samplerName,ss });
+	ResolvePixelHandles();
+}
+
+unsigned int Material::GetTextureSRVCount()
+{
+	return (unsigned int)textureSRVs.size();
+}
+
+unsigned int Material::GetSamplerCount()
+{
+	return (unsigned int)samplers.size();
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Material::GetTextureSRV(const std::string& textureName)
+{
+	auto found = textureSRVs.find(textureName);
+	return found == textureSRVs.end() ? nullptr : found->second;
+}
+
+unsigned int Material::GetRevision()
+{
+	return revision;
 }
 
-void Material::PrepareMaterialForDraw(Transform* transform, std::shared_ptr<Camera> camera)
+void Material::SetShaders(bool instanced)
 {
-	//Set vertex shader constant buffer data
+	if (instanced)
 	{
-		vertexShader->SetMatrix4x4("world", transform->GetWorldMatrix());
-		vertexShader->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix());
-		vertexShader->SetMatrix4x4("view", camera->GetViewMatrix());
-		vertexShader->SetMatrix4x4("projection", camera->GetProjectionMatrix());
+		instancedVertexShader->SetShader();
 	}
-	vertexShader->CopyAllBufferData();
+	else
+	{
+		vertexShader->SetShader();
+	}
+	pixelShader->SetShader();
+}
 
+void Material::PrepareMaterial(const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT3& ambientColor)
+{
 	//Set pixel shader constant buffer data
 	{
-		pixelShader->SetFloat3("colorTint", colorTint);
-		pixelShader->SetFloat("roughness", roughness);
-		pixelShader->SetFloat3("cameraPosition", camera->GetTransform()->GetPosition());
-		pixelShader->SetFloat3("ambientTerm", camera->GetAmbientColor());
+		pixelShader->SetFloat3(colorTintHandle, colorTint);
+		pixelShader->SetFloat(roughnessHandle, roughness);
+		pixelShader->SetFloat3(cameraPositionHandle, cameraPosition);
+		pixelShader->SetFloat3(ambientTermHandle, ambientColor);
 	}
 	pixelShader->CopyAllBufferData();
 
 	//set pixel shader texture and sampler data
-	for (auto& t : textureSRVs) { pixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
-	for (auto& s : samplers) { pixelShader->SetSamplerState(s.first.c_str(), s.second); }
+	for (auto& t : textureBindings) { pixelShader->SetShaderResourceView(t.first, t.second); }
+	for (auto& s : samplerBindings) { pixelShader->SetSamplerState(s.first, s.second); }
+}
 
-	//Set shaders as active
-	vertexShader->SetShader();
-	pixelShader->SetShader();
+void Material::PrepareObject(Transform* transform)
+{
+	//Set vertex shader constant buffer data (per frame data is already current)
+	{
+		vertexShader->SetMatrix4x4(worldHandle, transform->GetWorldMatrix());
+		vertexShader->SetMatrix4x4(worldInvTransposeHandle, transform->GetWorldInverseTransposeMatrix());
+	}
+	vertexShader->CopyAllBufferData();
+}
+
+void Material::ResolveVertexHandles()
+{
+	worldHandle = vertexShader->GetVariableHandle("world");
+	worldInvTransposeHandle = vertexShader->GetVariableHandle("worldInvTranspose");
+}
+
+void Material::ResolvePixelHandles()
+{
+	colorTintHandle = pixelShader->GetVariableHandle("colorTint");
+	roughnessHandle = pixelShader->GetVariableHandle("roughness");
+	cameraPositionHandle = pixelShader->GetVariableHandle("cameraPosition");
+	ambientTermHandle = pixelShader->GetVariableHandle("ambientTerm");
+
+	//the maps keep the resources alive, the bindings just point at them
+	textureBindings.clear();
+	for (auto& t : textureSRVs) { textureBindings.push_back({ pixelShader->GetShaderResourceViewHandle(t.first.c_str()), t.second.Get() }); }
+	samplerBindings.clear();
+	for (auto& s : samplers) { samplerBindings.push_back({ pixelShader->GetSamplerHandle(s.first.c_str()), s.second.Get() }); }
 }
 
 
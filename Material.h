@@ -4,6 +4,7 @@
 #include <memory>
 #include "SimpleShader/SimpleShader.h"
 #include <unordered_map>
+#include <vector>
 #include "Transform.h"
 #include "Camera.h"
 
@@ -18,25 +19,52 @@ public:
 	float GetRoughness();
 	std::shared_ptr<SimpleVertexShader> GetVertexShader();
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader();
 	
 	//Setters
 	void SetColorTint(DirectX::XMFLOAT3);
 	void SetVertexShader(std::shared_ptr<SimpleVertexShader>);
 	void SetPixelShader(std::shared_ptr<SimplePixelShader>);
+	void SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader>);
 	void SetRoughness(float);
 
 	void AddTextureSRV(std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>);
 	void AddSampler(std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>);
 
-	//Before Draw
-	void PrepareMaterialForDraw(Transform*, std::shared_ptr<Camera>);
+	//After one of its shaders reloaded in place, which moves its variables
+	void RefreshShaderHandles();
+
+	unsigned int GetTextureSRVCount();
+	unsigned int GetSamplerCount();
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetTextureSRV(const std::string& textureName); //null if not added
+	unsigned int GetRevision(); //changes whenever the textures, tint or pixel shader do
+
+	//Before Draw (split so callers can skip work that is already bound)
+	void SetShaders(bool instanced = false);
+	void PrepareMaterial(const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT3& ambientColor); //per material pixel data, textures and samplers
+	void PrepareObject(Transform*); //per object vertex data, when not bound from a ring buffer
 private:
 	DirectX::XMFLOAT3 colorTint;
 	float roughness; //obsolete
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader; //variant reading world matrices per instance
+	unsigned int revision;
 
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
+
+	//handles resolved whenever shaders or resources change, so drawing does no name lookups
+	SimpleShaderHandle worldHandle;
+	SimpleShaderHandle worldInvTransposeHandle;
+	SimpleShaderHandle colorTintHandle;
+	SimpleShaderHandle roughnessHandle;
+	SimpleShaderHandle cameraPositionHandle;
+	SimpleShaderHandle ambientTermHandle;
+	std::vector<std::pair<SimpleShaderHandle, ID3D11ShaderResourceView*>> textureBindings;
+	std::vector<std::pair<SimpleShaderHandle, ID3D11SamplerState*>> samplerBindings;
+
+	void ResolveVertexHandles();
+	void ResolvePixelHandles();
 };
 
@@ -0,0 +1,174 @@
+#include "MaterialTable.h"
+
+const char* MaterialTable::MapNames[MATERIAL_TABLE_MAPS] = { "AlbedoMap", "NormalMap", "SurfaceMap" };
+
+namespace
+{
+	// The array of one map kind: the format most eligible materials
+	// use, sized by the largest texture in that format
+	MaterialArrayLayout ChooseArray(const std::vector<MaterialDesc>& materials, unsigned int map)
+	{
+		//formats in order of first use, so ties go to the earlier material
+		std::vector<std::pair<unsigned int, unsigned int>> formats;
+		for (const MaterialDesc& material : materials)
+		{
+			const MaterialMapDesc& desc = material.Maps[map];
+			if (!material.Eligible || desc.Width == 0)
+				continue;
+
+			unsigned int f = 0;
+			while (f < formats.size() && formats[f].first != desc.Format)
+				f++;
+			if (f == formats.size())
+				formats.push_back({ desc.Format, 0 });
+			formats[f].second++;
+		}
+
+		MaterialArrayLayout array = {};
+		if (formats.empty())
+			return array;
+
+		unsigned int best = 0;
+		for (unsigned int f = 1; f < formats.size(); f++)
+		{
+			if (formats[f].second > formats[best].second)
+				best = f;
+		}
+
+		array.Format = formats[best].first;
+		for (const MaterialDesc& material : materials)
+		{
+			const MaterialMapDesc& desc = material.Maps[map];
+			if (!material.Eligible || desc.Width == 0 || desc.Format != array.Format)
+				continue;
+
+			if ((unsigned long long)desc.Width * desc.Height > (unsigned long long)array.Width * array.Height)
+			{
+				array.Width = desc.Width;
+				array.Height = desc.Height;
+			}
+		}
+		array.MipCount = MaterialTable::GetFullMipCount(array.Width, array.Height);
+		return array;
+	}
+}
+
+void MaterialTable::Compile(const std::vector<MaterialDesc>& materials, const MaterialArrayLayout* previous, MaterialTableLayout& layout)
+{
+	unsigned int count = (unsigned int)materials.size();
+
+	for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+	{
+		MaterialArrayLayout array = ChooseArray(materials, map);
+
+		//keep the last array if the largest texture is still on its top two levels
+		if (previous && array.Width && previous[map].SliceCount && previous[map].Format == array.Format)
+		{
+			MaterialArrayLayout kept = previous[map];
+			MaterialMapDesc largest = { array.Format, array.Width, array.Height, array.MipCount };
+			unsigned int level = 0;
+			if (Fits(largest, kept, &level) && level <= 1)
+			{
+				array = kept;
+			}
+		}
+
+		array.SliceCount = 0;
+		layout.Arrays[map] = array;
+	}
+
+	//a material joins if every map it has fits its array
+	std::vector<unsigned int> firstLevels(count * MATERIAL_TABLE_MAPS, 0);
+	layout.InTable.assign(count, 0);
+	unsigned int tabled = 0;
+	for (unsigned int m = 0; m < count; m++)
+	{
+		if (!materials[m].Eligible || tabled == MATERIAL_TABLE_MAX_SLICES)
+			continue;
+
+		bool fits = true;
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+		{
+			const MaterialMapDesc& desc = materials[m].Maps[map];
+			if (desc.Width)
+			{
+				fits = fits && Fits(desc, layout.Arrays[map], &firstLevels[m * MATERIAL_TABLE_MAPS + map]);
+			}
+		}
+
+		if (fits)
+		{
+			layout.InTable[m] = 1;
+			tabled++;
+		}
+	}
+
+	//slices in material order, missing maps left to the shader's defaults
+	layout.Records.resize(count);
+	layout.Copies.clear();
+	for (unsigned int m = 0; m < count; m++)
+	{
+		MaterialRecord& record = layout.Records[m];
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			record.ColorTint[c] = materials[m].ColorTint[c];
+		}
+
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+		{
+			record.Slices[map] = MATERIAL_TABLE_NO_SLICE;
+			record.MinLods[map] = 0.0f;
+			if (!layout.InTable[m] || materials[m].Maps[map].Width == 0)
+				continue;
+
+			MaterialArrayLayout& array = layout.Arrays[map];
+			unsigned int firstLevel = firstLevels[m * MATERIAL_TABLE_MAPS + map];
+			MaterialSliceCopy copy = { m, map, array.SliceCount, firstLevel, array.MipCount - firstLevel };
+			layout.Copies.push_back(copy);
+
+			record.Slices[map] = (int)array.SliceCount;
+			record.MinLods[map] = (float)firstLevel;
+			array.SliceCount++;
+		}
+	}
+}
+
+unsigned int MaterialTable::GetFullMipCount(unsigned int width, unsigned int height)
+{
+	unsigned int largest = width > height ? width : height;
+	if (largest == 0)
+		return 0;
+
+	unsigned int count = 1;
+	while (largest > 1)
+	{
+		largest >>= 1;
+		count++;
+	}
+	return count;
+}
+
+bool MaterialTable::Fits(const MaterialMapDesc& map, const MaterialArrayLayout& array, unsigned int* firstLevel)
+{
+	if (map.Width == 0 || array.Width == 0 || map.Format != array.Format)
+		return false;
+
+	//the texture has to be the array's size at some level, with every level below it
+	for (unsigned int level = 0; level < array.MipCount; level++)
+	{
+		unsigned int width = map.Width << level;
+		unsigned int height = map.Height << level;
+		if (width > array.Width || height > array.Height)
+			return false;
+
+		if (width == array.Width && height == array.Height)
+		{
+			if (map.MipCount < array.MipCount - level)
+				return false;
+
+			*firstLevel = level;
+			return true;
+		}
+	}
+	return false;
+}
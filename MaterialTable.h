@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+
+// Map kinds the table holds, in the order of the pixel shader's arrays
+#define MATERIAL_TABLE_ALBEDO 0
+#define MATERIAL_TABLE_NORMALS 1
+#define MATERIAL_TABLE_SURFACE 2
+#define MATERIAL_TABLE_MAPS 3
+
+// Slice of a map the material doesn't have, the shader uses a default instead
+#define MATERIAL_TABLE_NO_SLICE -1
+
+// Slices a texture array can have (D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION)
+#define MATERIAL_TABLE_MAX_SLICES 2048
+
+// --------------------------------------------------------
+// One texture of a material as the table compiler sees it,
+// Width 0 if the material has none. Format is a DXGI_FORMAT.
+// --------------------------------------------------------
+struct MaterialMapDesc
+{
+	unsigned int Format;
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int MipCount;
+};
+
+// --------------------------------------------------------
+// A material to compile. Ineligible materials (drawn with
+// another shader) are left out of the table.
+// --------------------------------------------------------
+struct MaterialDesc
+{
+	bool Eligible;
+	float ColorTint[3];
+	MaterialMapDesc Maps[MATERIAL_TABLE_MAPS];
+};
+
+// --------------------------------------------------------
+// A material's entry in the structured buffer, matching
+// MaterialRecord in PixelShader_MaterialTable.hlsl
+// --------------------------------------------------------
+struct MaterialRecord
+{
+	float ColorTint[3];
+	int Slices[MATERIAL_TABLE_MAPS];	// Array slice of each map, or MATERIAL_TABLE_NO_SLICE
+	float MinLods[MATERIAL_TABLE_MAPS];	// Array level holding the top level of each map
+};
+
+// --------------------------------------------------------
+// The texture array of one map kind, SliceCount 0 if no
+// material in the table has that map
+// --------------------------------------------------------
+struct MaterialArrayLayout
+{
+	unsigned int Format;
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int MipCount;
+	unsigned int SliceCount;
+};
+
+// --------------------------------------------------------
+// Copies a material's map into its slice: the texture's
+// levels land on the array's levels from FirstLevel down
+// --------------------------------------------------------
+struct MaterialSliceCopy
+{
+	unsigned int Material;
+	unsigned int Map;
+	unsigned int Slice;
+	unsigned int FirstLevel;
+	unsigned int LevelCount;
+};
+
+// --------------------------------------------------------
+// Everything a compile produces: the arrays, one record per
+// material (table or not, indexed like the materials), and
+// the copies that fill the arrays
+// --------------------------------------------------------
+struct MaterialTableLayout
+{
+	MaterialArrayLayout Arrays[MATERIAL_TABLE_MAPS];
+	std::vector<MaterialRecord> Records;
+	std::vector<unsigned char> InTable;
+	std::vector<MaterialSliceCopy> Copies;
+};
+
+// --------------------------------------------------------
+// Compiles materials into a table: each map kind goes into
+// one texture array, in the format most materials use and
+// sized by its largest texture. Smaller textures of the same
+// aspect sit on the array's lower levels, with a minimum
+// LOD in the record so sampling never reaches above them.
+// A material is in the table only if all its maps fit;
+// the rest keep binding their own textures.
+// --------------------------------------------------------
+class MaterialTable
+{
+public:
+	//Names the materials bind each map kind by, in map order
+	static const char* MapNames[MATERIAL_TABLE_MAPS];
+
+	//previous is the last compile's arrays, or null. An array keeps its size while its
+	//largest texture is at most one level smaller, so streaming a level out doesn't
+	//recreate it.
+	static void Compile(const std::vector<MaterialDesc>& materials, const MaterialArrayLayout* previous, MaterialTableLayout& layout);
+
+	//Mips in a full chain for a texture of this size
+	static unsigned int GetFullMipCount(unsigned int width, unsigned int height);
+
+	//True if the texture fits the array, setting the level its top lands on
+	static bool Fits(const MaterialMapDesc& map, const MaterialArrayLayout& array, unsigned int* firstLevel);
+};
@@ -0,0 +1,239 @@
+#include "MaterialTableResources.h"
+#include "Profiler.h"
+
+namespace
+{
+	bool SameArray(const MaterialArrayLayout& a, const MaterialArrayLayout& b)
+	{
+		return a.Format == b.Format && a.Width == b.Width && a.Height == b.Height && a.MipCount == b.MipCount && a.SliceCount == b.SliceCount;
+	}
+
+	bool SameSlice(const MaterialSliceCopy& a, const MaterialSliceCopy& b)
+	{
+		return a.Slice == b.Slice && a.FirstLevel == b.FirstLevel && a.LevelCount == b.LevelCount;
+	}
+}
+
+MaterialTableResources::MaterialTableResources(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	std::shared_ptr<SimplePixelShader> tableShader, std::shared_ptr<SimplePixelShader> replacedShader)
+	: device(device), context(context), tableShader(tableShader), replacedShader(replacedShader), layout(), recordCapacity(0), sliceCopies(0)
+{
+	RefreshShaderHandles();
+}
+
+void MaterialTableResources::RefreshShaderHandles()
+{
+	arrayHandles[MATERIAL_TABLE_ALBEDO] = tableShader->GetShaderResourceViewHandle("AlbedoMaps");
+	arrayHandles[MATERIAL_TABLE_NORMALS] = tableShader->GetShaderResourceViewHandle("NormalMaps");
+	arrayHandles[MATERIAL_TABLE_SURFACE] = tableShader->GetShaderResourceViewHandle("SurfaceMaps");
+	recordsHandle = tableShader->GetShaderResourceViewHandle("MaterialRecords");
+}
+
+void MaterialTableResources::SetDefaultTexture(unsigned int map, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+	defaults[map] = srv;
+}
+
+void MaterialTableResources::Update(const std::vector<std::shared_ptr<Material>>& materials)
+{
+	//materials only change as their textures load or stream, most frames none have
+	unsigned int count = (unsigned int)materials.size();
+	bool changed = count != revisions.size();
+	revisions.resize(count, 0);
+	for (unsigned int m = 0; m < count; m++)
+	{
+		unsigned int revision = materials[m]->GetRevision();
+		changed = changed || revision != revisions[m];
+		revisions[m] = revision;
+	}
+	if (!changed)
+		return;
+
+	PROFILE_SCOPE("Compile material table");
+
+	std::vector<MaterialDesc> descs(count);
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> textures(count * MATERIAL_TABLE_MAPS);
+	for (unsigned int m = 0; m < count; m++)
+	{
+		MaterialDesc& desc = descs[m];
+		desc = {};
+		desc.Eligible = materials[m]->GetPixelShader() == replacedShader;
+		DirectX::XMFLOAT3 tint = materials[m]->GetColorTint();
+		desc.ColorTint[0] = tint.x;
+		desc.ColorTint[1] = tint.y;
+		desc.ColorTint[2] = tint.z;
+
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+		{
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv = materials[m]->GetTextureSRV(MaterialTable::MapNames[map]);
+			if (!srv || srv == defaults[map])
+				continue;
+
+			Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+			Microsoft::WRL::ComPtr<ID3D11Texture2D>& texture = textures[m * MATERIAL_TABLE_MAPS + map];
+			srv->GetResource(resource.GetAddressOf());
+			D3D11_TEXTURE2D_DESC textureDesc = {};
+			if (FAILED(resource.As(&texture)))
+			{
+				desc.Eligible = false;
+				continue;
+			}
+			texture->GetDesc(&textureDesc);
+
+			//arrays and cubes can't become a single slice
+			if (textureDesc.ArraySize != 1)
+			{
+				desc.Eligible = false;
+				continue;
+			}
+			desc.Maps[map] = { (unsigned int)textureDesc.Format, textureDesc.Width, textureDesc.Height, textureDesc.MipLevels };
+		}
+	}
+
+	MaterialArrayLayout previous[MATERIAL_TABLE_MAPS];
+	for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+	{
+		previous[map] = layout.Arrays[map];
+	}
+	MaterialTable::Compile(descs, previous, layout);
+
+	//a new array starts empty, so every slice of it is copied again
+	bool recreated[MATERIAL_TABLE_MAPS] = {};
+	for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+	{
+		if (SameArray(layout.Arrays[map], previous[map]) && (arrays[map] || layout.Arrays[map].SliceCount == 0))
+			continue;
+
+		recreated[map] = true;
+		if (!CreateArray(map))
+		{
+			for (const MaterialSliceCopy& copy : layout.Copies)
+			{
+				if (copy.Map == map)
+					layout.InTable[copy.Material] = 0;
+			}
+		}
+	}
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> copied(count * MATERIAL_TABLE_MAPS);
+	std::vector<MaterialSliceCopy> slices(count * MATERIAL_TABLE_MAPS);
+	for (const MaterialSliceCopy& copy : layout.Copies)
+	{
+		if (!arrays[copy.Map])
+			continue;
+
+		unsigned int index = copy.Material * MATERIAL_TABLE_MAPS + copy.Map;
+		copied[index] = textures[index];
+		slices[index] = copy;
+
+		bool current = !recreated[copy.Map] && index < copiedTextures.size() && copiedTextures[index] == textures[index] && SameSlice(copiedSlices[index], copy);
+		if (current)
+			continue;
+
+		unsigned int arrayMips = layout.Arrays[copy.Map].MipCount;
+		for (unsigned int level = 0; level < copy.LevelCount; level++)
+		{
+			context->CopySubresourceRegion(arrays[copy.Map].Get(), D3D11CalcSubresource(copy.FirstLevel + level, copy.Slice, arrayMips), 0, 0, 0,
+				textures[index].Get(), level, 0);
+		}
+		sliceCopies++;
+	}
+	copiedTextures.swap(copied);
+	copiedSlices.swap(slices);
+
+	UploadRecords();
+}
+
+unsigned int MaterialTableResources::Bind()
+{
+	for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+	{
+		tableShader->SetShaderResourceView(arrayHandles[map], arraySRVs[map].Get());
+	}
+	tableShader->SetShaderResourceView(recordsHandle, recordsSRV.Get());
+	return MATERIAL_TABLE_MAPS + 1;
+}
+
+unsigned int MaterialTableResources::GetTabledCount()
+{
+	if (!recordsSRV || !tableShader->IsShaderValid())
+		return 0;
+
+	unsigned int count = 0;
+	for (unsigned char inTable : layout.InTable)
+	{
+		count += inTable;
+	}
+	return count;
+}
+
+bool MaterialTableResources::CreateArray(unsigned int map)
+{
+	arrays[map].Reset();
+	arraySRVs[map].Reset();
+
+	const MaterialArrayLayout& array = layout.Arrays[map];
+	if (array.SliceCount == 0)
+		return true;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = array.Width;
+	desc.Height = array.Height;
+	desc.MipLevels = array.MipCount;
+	desc.ArraySize = array.SliceCount;
+	desc.Format = (DXGI_FORMAT)array.Format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	if (FAILED(device->CreateTexture2D(&desc, 0, arrays[map].GetAddressOf())))
+		return false;
+
+	if (FAILED(device->CreateShaderResourceView(arrays[map].Get(), 0, arraySRVs[map].GetAddressOf())))
+	{
+		arrays[map].Reset();
+		return false;
+	}
+	return true;
+}
+
+void MaterialTableResources::UploadRecords()
+{
+	unsigned int count = (unsigned int)layout.Records.size();
+	if (count == 0)
+		return;
+
+	//grow to the next power of two so resizes stay rare
+	if (count > recordCapacity)
+	{
+		unsigned int capacity = recordCapacity > 0 ? recordCapacity : 1;
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DEFAULT;	// Rewritten only when materials change
+		desc.ByteWidth = sizeof(MaterialRecord) * capacity;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		desc.StructureByteStride = sizeof(MaterialRecord);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = capacity;
+
+		records.Reset();
+		recordsSRV.Reset();
+		recordCapacity = 0;
+		if (FAILED(device->CreateBuffer(&desc, 0, records.GetAddressOf())) ||
+			FAILED(device->CreateShaderResourceView(records.Get(), &srvDesc, recordsSRV.GetAddressOf())))
+			return;
+		recordCapacity = capacity;
+	}
+
+	D3D11_BOX box = { 0, 0, 0, count * (UINT)sizeof(MaterialRecord), 1, 1 };
+	context->UpdateSubresource(records.Get(), 0, &box, layout.Records.data(), 0, 0);
+}
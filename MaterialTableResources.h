@@ -0,0 +1,71 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "Material.h"
+#include "MaterialTable.h"
+
+// --------------------------------------------------------
+// The material table on the device: a texture array per
+// map kind and a structured buffer of MaterialRecords, so
+// every material in it draws with one set of bindings and
+// picks its slices by index. Recompiled whenever a material
+// changes (a texture loads or streams), recreating only the
+// arrays whose layout changed and copying only the slices
+// whose texture or place did. The arrays hold their own
+// copy of each texture. Update is for the thread that owns
+// the device context.
+// --------------------------------------------------------
+class MaterialTableResources
+{
+public:
+	//Materials drawn with replacedShader go in the table, drawn with tableShader instead
+	MaterialTableResources(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		std::shared_ptr<SimplePixelShader> tableShader, std::shared_ptr<SimplePixelShader> replacedShader);
+
+	//A texture standing in for a missing map, left to the shader's default like no texture at all
+	void SetDefaultTexture(unsigned int map, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+
+	//Recompiles if any material changed since the last call
+	void Update(const std::vector<std::shared_ptr<Material>>& materials);
+
+	//Binds the arrays and records to the table shader, returns the views bound
+	unsigned int Bind();
+
+	//After the table shader reloaded in place
+	void RefreshShaderHandles();
+
+	//False for every material if the table shader failed to create, so they keep their own bindings
+	bool IsInTable(unsigned int material) { return recordsSRV && tableShader->IsShaderValid() && material < layout.InTable.size() && layout.InTable[material]; }
+	unsigned int GetTabledCount();
+	unsigned int GetSliceCopies() { return sliceCopies; } //since creation
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::shared_ptr<SimplePixelShader> tableShader;
+	std::shared_ptr<SimplePixelShader> replacedShader;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> defaults[MATERIAL_TABLE_MAPS];
+
+	MaterialTableLayout layout;
+	std::vector<unsigned int> revisions; //of each material when last compiled
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> arrays[MATERIAL_TABLE_MAPS];
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> arraySRVs[MATERIAL_TABLE_MAPS];
+	Microsoft::WRL::ComPtr<ID3D11Buffer> records;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> recordsSRV;
+	unsigned int recordCapacity;
+
+	//what each material's maps were last copied from and to, by material * MATERIAL_TABLE_MAPS + map
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> copiedTextures;
+	std::vector<MaterialSliceCopy> copiedSlices;
+	unsigned int sliceCopies;
+
+	SimpleShaderHandle arrayHandles[MATERIAL_TABLE_MAPS];
+	SimpleShaderHandle recordsHandle;
+
+	bool CreateArray(unsigned int map);
+	void UploadRecords();
+};
@@ -1,6 +1,7 @@
 #include "Mesh.h"
 #include <fstream>
 #include <vector>
+#include <cmath>
 
 using namespace DirectX;
 
@@ -15,6 +16,16 @@ Mesh::Mesh(Vertex* vertices,
 }
 
 Mesh::Mesh(const wchar_t* filename, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	if (ReadObj(filename, verts, indices))
+	{
+		InitMeshAndCreateBuffers(&verts[0], (unsigned int)verts.size(), &indices[0], (unsigned int)indices.size(), device, context);
+	}
+}
+
+bool Mesh::ReadObj(const wchar_t* filename, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
 {
 	// Author: Chris Cascioli
 	// Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
@@ -30,14 +41,14 @@ Mesh::Mesh(const wchar_t* filename, Microsoft::WRL::ComPtr<ID3D11Device> device,
 
 	// Check for successful open
 	if (!obj.is_open())
-		return;
+		return false;
 
 	// Variables used while reading the file
 	std::vector<DirectX::XMFLOAT3> positions;	// Positions from the file
 	std::vector<DirectX::XMFLOAT3> normals;		// Normals from the file
 	std::vector<DirectX::XMFLOAT2> uvs;			// UVs from the file
-	std::vector<Vertex> verts;					// Verts we're assembling
-	std::vector<UINT> indices;					// Indices of these verts
+	verts.clear();								// Verts we're assembling
+	indices.clear();							// Indices of these verts
 	int vertCounter = 0;						// Count of vertices
 	int indexCounter = 0;						// Count of indices
 	char chars[100];							// String for line reading
@@ -233,7 +244,7 @@ Mesh::Mesh(const wchar_t* filename, Microsoft::WRL::ComPtr<ID3D11Device> device,
 		//    sophisticated model loading library like TinyOBJLoader or The Open Asset Importer Library
 	}
 
-	InitMeshAndCreateBuffers(&verts[0], vertCounter, &indices[0], indexCounter, device, context);
+	return !verts.empty();
 }
 
 Mesh::~Mesh()
@@ -258,26 +269,88 @@ unsigned int Mesh::GetIndexCount()
 	return this->indexCount;
 }
 
+//returns local space axis aligned bounds
+DirectX::BoundingBox Mesh::GetBounds()
+{
+	return this->bounds;
+}
+
+float Mesh::GetUVDensity()
+{
+	return this->uvDensity;
+}
+
 void Mesh::Draw()
+{
+	SetBuffers();
+	DrawIndexed();
+}
+
+void Mesh::SetBuffers()
+{
+	SetBuffers(context.Get());
+}
+
+void Mesh::DrawIndexed()
+{
+	DrawIndexed(context.Get());
+}
+
+void Mesh::DrawIndexedInstanced(unsigned int instanceCount, unsigned int startInstance)
+{
+	DrawIndexedInstanced(context.Get(), instanceCount, startInstance);
+}
+
+void Mesh::SetBuffers(ID3D11DeviceContext* context)
 {
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
 
 	context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
 	context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+}
 
+void Mesh::DrawIndexed(ID3D11DeviceContext* context)
+{
 	context->DrawIndexed(
 		indexCount,     // The number of indices to use (we could draw a subset if we wanted)
 		0,     // Offset to the first index we want to use
 		0);
 }
 
+void Mesh::DrawIndexedInstanced(ID3D11DeviceContext* context, unsigned int instanceCount, unsigned int startInstance)
+{
+	context->DrawIndexedInstanced(
+		indexCount,		// Indices per instance
+		instanceCount,	// Number of instances to draw
+		0,				// Offset to the first index
+		0,				// Offset added to each index
+		startInstance);	// Offset to the first instance's data
+}
+
 void Mesh::InitMeshAndCreateBuffers(Vertex* vertices, unsigned int verticesNum, unsigned int* indices, unsigned int indicesNum, Microsoft::WRL::ComPtr<ID3D11Device> device,
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context)
 {	
 	//calculate tangents
 	CalculateTangents(vertices, verticesNum, indices, indicesNum);
 
+	//calculate local bounds for culling
+	BoundingBox::CreateFromPoints(bounds, verticesNum, &vertices[0].Position, sizeof(Vertex));
+
+	//UV units per local unit of surface, averaged by area, for texture streaming
+	float surfaceArea = 0.0f;
+	float uvArea = 0.0f;
+	for (unsigned int i = 0; i + 2 < indicesNum; i += 3)
+	{
+		Vertex& v0 = vertices[indices[i]];
+		Vertex& v1 = vertices[indices[i + 1]];
+		Vertex& v2 = vertices[indices[i + 2]];
+		XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+		surfaceArea += 0.5f * XMVectorGetX(XMVector3Length(XMVector3Cross(XMLoadFloat3(&v1.Position) - p0, XMLoadFloat3(&v2.Position) - p0)));
+		uvArea += 0.5f * fabsf((v1.UV.x - v0.UV.x) * (v2.UV.y - v0.UV.y) - (v2.UV.x - v0.UV.x) * (v1.UV.y - v0.UV.y));
+	}
+	uvDensity = surfaceArea > 0.0f ? sqrtf(uvArea / surfaceArea) : 0.0f;
+
 	//Vertex Buffer Creation
 	{
 		D3D11_BUFFER_DESC vbd = {};
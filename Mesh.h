@@ -2,6 +2,8 @@
 
 #include <wrl/client.h>
 #include <d3d11.h>
+#include <DirectXCollision.h>
+#include <vector>
 #include "Vertex.h"
 
 class Mesh
@@ -19,10 +21,25 @@ public:
 		Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context);
 	
 	~Mesh();
+
+	//Parses an OBJ into vertices and indices without touching the device,
+	//so it can run on a worker thread. False if the file can't be read.
+	static bool ReadObj(const wchar_t* filename, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 	unsigned int GetIndexCount();
+	DirectX::BoundingBox GetBounds();
+	float GetUVDensity(); //UV units per local unit of surface
 	void Draw();
+	void SetBuffers(); //bind vertex and index buffers only
+	void DrawIndexed(); //draw with whatever buffers are bound
+	void DrawIndexedInstanced(unsigned int instanceCount, unsigned int startInstance); //instance data must be bound to slot 1
+
+	//same as above, recorded on another context (deferred contexts)
+	void SetBuffers(ID3D11DeviceContext* context);
+	void DrawIndexed(ID3D11DeviceContext* context);
+	void DrawIndexedInstanced(ID3D11DeviceContext* context, unsigned int instanceCount, unsigned int startInstance);
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
@@ -31,6 +48,8 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context;
 
 	unsigned int indexCount;
+	DirectX::BoundingBox bounds; //local space bounds of the vertices
+	float uvDensity;
 
 	void InitMeshAndCreateBuffers(Vertex* vertices,
 		unsigned int verticesNum,
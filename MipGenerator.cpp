@@ -0,0 +1,319 @@
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2
+#endif
+
+// Rows per job when filtering a level
+#define MIP_ROWS_PER_JOB 16
+
+// Radius of the windowed sinc kernels, in texels of the smaller level
+#define MIP_SINC_RADIUS 3.0f
+
+// Shape of the Kaiser window; higher is smoother with less ringing
+#define MIP_KAISER_ALPHA 4.0f
+
+namespace
+{
+	const float pi = 3.14159265358979f;
+
+	// Four floats per texel whatever the channel count, so a texel fills a register
+	struct FloatImage
+	{
+		unsigned int Width = 0;
+		unsigned int Height = 0;
+		std::vector<float> Texels;
+
+		void Allocate(unsigned int width, unsigned int height)
+		{
+			Width = width;
+			Height = height;
+			Texels.assign((size_t)width * height * 4, 0.0f);
+		}
+
+		float* GetTexel(unsigned int x, unsigned int y) { return &Texels[((size_t)y * Width + x) * 4]; }
+		const float* GetTexel(unsigned int x, unsigned int y) const { return &Texels[((size_t)y * Width + x) * 4]; }
+	};
+
+	// Source texels and weights for each texel along one axis of the smaller level
+	struct FilterTaps
+	{
+		std::vector<unsigned int> First;	// Offset of each texel's taps
+		std::vector<unsigned int> Indices;	// Source texel, already wrapped or clamped
+		std::vector<float> Weights;			// Sum to one per texel
+	};
+
+	float Sinc(float x)
+	{
+		return x == 0.0f ? 1.0f : std::sin(pi * x) / (pi * x);
+	}
+
+	// Zeroth order modified Bessel function of the first kind, by its series
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (unsigned int k = 1; k < 32 && term > sum * 1e-8f; k++)
+		{
+			term *= (x * x) / (4.0f * k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float GetFilterRadius(MipFilter filter)
+	{
+		return filter == MipFilterBox ? 0.5f : MIP_SINC_RADIUS;
+	}
+
+	// The kernel at x, in texels of the smaller level
+	float EvaluateFilter(MipFilter filter, float x)
+	{
+		float radius = GetFilterRadius(filter);
+		if (std::fabs(x) > radius)
+			return 0.0f;
+
+		switch (filter)
+		{
+		case MipFilterBox:
+			return 1.0f;
+		case MipFilterKaiser:
+		{
+			float t = x / radius;
+			return Sinc(x) * BesselI0(MIP_KAISER_ALPHA * std::sqrt(1.0f - t * t)) / BesselI0(MIP_KAISER_ALPHA);
+		}
+		case MipFilterLanczos:
+			return Sinc(x) * Sinc(x / radius);
+		}
+		return 0.0f;
+	}
+
+	void BuildTaps(unsigned int sourceSize, unsigned int destinationSize, const MipSettings& settings, FilterTaps& taps)
+	{
+		float scale = (float)sourceSize / destinationSize;
+		float radius = GetFilterRadius(settings.Filter) * scale;
+
+		taps.First.clear();
+		taps.Indices.clear();
+		taps.Weights.clear();
+		for (unsigned int d = 0; d < destinationSize; d++)
+		{
+			taps.First.push_back((unsigned int)taps.Indices.size());
+
+			float center = (d + 0.5f) * scale;
+			int first = (int)std::floor(center - radius);
+			int last = (int)std::ceil(center + radius);
+			float total = 0.0f;
+			for (int s = first; s <= last; s++)
+			{
+				float weight = EvaluateFilter(settings.Filter, (s + 0.5f - center) / scale);
+				if (weight == 0.0f)
+					continue;
+
+				int size = (int)sourceSize;
+				int index = settings.Wrap ? ((s % size) + size) % size : std::min(std::max(s, 0), size - 1);
+				taps.Indices.push_back((unsigned int)index);
+				taps.Weights.push_back(weight);
+				total += weight;
+			}
+
+			for (unsigned int i = taps.First.back(); i < taps.Weights.size(); i++)
+				taps.Weights[i] /= total;
+		}
+		taps.First.push_back((unsigned int)taps.Indices.size());
+	}
+
+	// Weighted sum of texels into destination, four channels at once
+	void Accumulate(const FilterTaps& taps, unsigned int d, const float* texels, size_t stride, float* destination)
+	{
+#ifdef MIP_GENERATOR_SSE2
+		__m128 sum = _mm_setzero_ps();
+		for (unsigned int i = taps.First[d]; i < taps.First[d + 1]; i++)
+		{
+			__m128 texel = _mm_loadu_ps(texels + taps.Indices[i] * stride);
+			sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(taps.Weights[i])));
+		}
+		_mm_storeu_ps(destination, sum);
+#else
+		float sum[4] = {};
+		for (unsigned int i = taps.First[d]; i < taps.First[d + 1]; i++)
+		{
+			const float* texel = texels + taps.Indices[i] * stride;
+			for (unsigned int c = 0; c < 4; c++)
+				sum[c] += texel[c] * taps.Weights[i];
+		}
+		for (unsigned int c = 0; c < 4; c++)
+			destination[c] = sum[c];
+#endif
+	}
+
+	void RunRows(unsigned int rows, JobSystem* jobs, const std::function<void(unsigned int, unsigned int)>& body)
+	{
+		if (!jobs)
+		{
+			body(0, rows);
+			return;
+		}
+
+		JobCounter counter;
+		jobs->ParallelFor(rows, MIP_ROWS_PER_JOB, body, &counter);
+		jobs->Wait(&counter);
+	}
+
+	// Across then down; an axis already at 1 texel is left alone
+	void Downsample(const FloatImage& source, FloatImage& destination, const MipSettings& settings, JobSystem* jobs)
+	{
+		unsigned int width = source.Width > 1 ? source.Width / 2 : 1;
+		unsigned int height = source.Height > 1 ? source.Height / 2 : 1;
+
+		FilterTaps across;
+		FilterTaps down;
+		BuildTaps(source.Width, width, settings, across);
+		BuildTaps(source.Height, height, settings, down);
+
+		FloatImage narrow;
+		narrow.Allocate(width, source.Height);
+		RunRows(source.Height, jobs, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int y = begin; y < end; y++)
+			{
+				for (unsigned int x = 0; x < width; x++)
+					Accumulate(across, x, source.GetTexel(0, y), 4, narrow.GetTexel(x, y));
+			}
+		});
+
+		destination.Allocate(width, height);
+		RunRows(height, jobs, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int y = begin; y < end; y++)
+			{
+				for (unsigned int x = 0; x < width; x++)
+					Accumulate(down, y, narrow.GetTexel(x, 0), (size_t)width * 4, destination.GetTexel(x, y));
+			}
+		});
+	}
+
+	float DecodeSRGB(unsigned char value)
+	{
+		static const std::vector<float> table = []()
+		{
+			std::vector<float> decoded(256);
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				float v = i / 255.0f;
+				decoded[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+			}
+			return decoded;
+		}();
+		return table[value];
+	}
+
+	float EncodeSRGB(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Colour channels are the first three; a fourth is always alpha
+	bool IsColorChannel(const MipSettings& settings, unsigned int channel)
+	{
+		return settings.Content != MipContentLinear && channel < 3;
+	}
+
+	void ToFloat(const TextureImage& image, const MipSettings& settings, FloatImage& floats)
+	{
+		floats.Allocate(image.Width, image.Height);
+		for (unsigned int y = 0; y < image.Height; y++)
+		{
+			for (unsigned int x = 0; x < image.Width; x++)
+			{
+				const unsigned char* texel = image.GetPixel(x, y);
+				float* result = floats.GetTexel(x, y);
+				for (unsigned int c = 0; c < image.Channels && c < 4; c++)
+				{
+					if (!IsColorChannel(settings, c))
+						result[c] = texel[c] / 255.0f;
+					else if (settings.Content == MipContentSRGB)
+						result[c] = DecodeSRGB(texel[c]);
+					else
+						result[c] = texel[c] / 255.0f * 2.0f - 1.0f;
+				}
+
+				//two channel normals only store x and y
+				if (settings.Content == MipContentNormals && image.Channels < 3)
+					result[2] = std::sqrt(std::max(0.0f, 1.0f - result[0] * result[0] - result[1] * result[1]));
+			}
+		}
+	}
+
+	void Renormalize(FloatImage& floats)
+	{
+		for (size_t i = 0; i < floats.Texels.size(); i += 4)
+		{
+			float* normal = &floats.Texels[i];
+			float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 1e-6f)
+			{
+				normal[0] /= length;
+				normal[1] /= length;
+				normal[2] /= length;
+			}
+			else
+			{
+				//opposing normals cancelled out, so fall back to flat
+				normal[0] = 0.0f;
+				normal[1] = 0.0f;
+				normal[2] = 1.0f;
+			}
+		}
+	}
+
+	void ToBytes(const FloatImage& floats, unsigned int channels, const MipSettings& settings, TextureImage& image)
+	{
+		image.Allocate(floats.Width, floats.Height, channels);
+		for (unsigned int y = 0; y < floats.Height; y++)
+		{
+			for (unsigned int x = 0; x < floats.Width; x++)
+			{
+				const float* texel = floats.GetTexel(x, y);
+				unsigned char* result = image.GetPixel(x, y);
+				for (unsigned int c = 0; c < channels && c < 4; c++)
+				{
+					float value = texel[c];
+					if (IsColorChannel(settings, c))
+						value = settings.Content == MipContentSRGB ? EncodeSRGB(value) : value * 0.5f + 0.5f;
+
+					//sinc kernels overshoot at hard edges
+					value = std::min(std::max(value, 0.0f), 1.0f);
+					result[c] = (unsigned char)(value * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+void MipGenerator::Generate(const TextureImage& image, std::vector<TextureImage>& levels, const MipSettings& settings, JobSystem* jobs)
+{
+	levels.clear();
+	levels.push_back(image);
+
+	//each level comes from the float one above, not the rounded bytes
+	FloatImage current;
+	ToFloat(image, settings, current);
+	while (current.Width > 1 || current.Height > 1)
+	{
+		FloatImage next;
+		Downsample(current, next, settings, jobs);
+		if (settings.Content == MipContentNormals)
+			Renormalize(next);
+
+		TextureImage level;
+		ToBytes(next, image.Channels, settings, level);
+		levels.push_back(std::move(level));
+		current = std::move(next);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "TextureImage.h"
+
+class JobSystem;
+
+// Kernels for going down a level
+enum MipFilter
+{
+	MipFilterBox,		// 2x2 average, cheapest and softest
+	MipFilterKaiser,	// Kaiser windowed sinc, sharp with little ringing
+	MipFilterLanczos	// Lanczos 3, sharpest, rings the most
+};
+
+// What the texels hold, which decides the space they're filtered in
+enum MipContent
+{
+	MipContentLinear,	// Data like roughness, filtered as stored
+	MipContentSRGB,		// Colour in sRGB, filtered in linear; alpha stays linear
+	MipContentNormals	// Unit vectors stored as x and y (z rebuilt) or xyz, renormalized per level
+};
+
+struct MipSettings
+{
+	MipFilter Filter = MipFilterKaiser;
+	MipContent Content = MipContentLinear;
+	bool Wrap = true;	// Tiling textures filter across their edges, others clamp
+};
+
+// --------------------------------------------------------
+// Builds the mip chain of an image on the CPU, so offline
+// tools and the texture loader get the same levels. Each
+// level is filtered from the one above with a separable
+// kernel, kept in float throughout so rounding doesn't
+// build up. Rows run four channels at a time with SSE2
+// where available, spread over a JobSystem when given
+// one.
+// --------------------------------------------------------
+class MipGenerator
+{
+public:
+	//levels[0] is a copy of the image, down to 1x1
+	static void Generate(const TextureImage& image, std::vector<TextureImage>& levels, const MipSettings& settings = MipSettings(), JobSystem* jobs = 0);
+};
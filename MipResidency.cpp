@@ -0,0 +1,200 @@
+#include "MipResidency.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// How full the budget may be for the bias to drop a level again
+#define MIP_BIAS_HEADROOM_PERCENT 85
+
+MipResidency::MipResidency(const MipResidencySettings& settings)
+	: settings(settings), frame(0), stats()
+{
+}
+
+StreamingHandle MipResidency::Register(const std::string& name, const std::vector<size_t>& levelBytes, unsigned int width, unsigned int height)
+{
+	Texture texture = {};
+	texture.Name = name;
+	texture.Width = width;
+	texture.Height = height;
+	texture.LevelBytes = levelBytes;
+
+	texture.BytesFrom.assign(levelBytes.size() + 1, 0);
+	for (size_t i = levelBytes.size(); i > 0; i--)
+		texture.BytesFrom[i - 1] = texture.BytesFrom[i] + levelBytes[i - 1];
+
+	//the first level that fits in the tail, or the last level if none does
+	unsigned int mipCount = (unsigned int)levelBytes.size();
+	texture.TailMip = 0;
+	while (texture.TailMip + 1 < mipCount && std::max(width >> texture.TailMip, height >> texture.TailMip) > settings.TailSize)
+		texture.TailMip++;
+
+	texture.FrameRequest = -1.0f;
+	texture.HeldMip = texture.TailMip;
+	texture.TargetMip = texture.TailMip;
+	texture.ResidentMip = mipCount;
+	textures.push_back(texture);
+	UpdateStats();
+	return (StreamingHandle)(textures.size() - 1);
+}
+
+float MipResidency::ComputeMip(unsigned int width, unsigned int height, float uvPerWorldUnit, float distance, float pixelsPerWorldUnit)
+{
+	//texels of the top level per pixel along the larger axis, each
+	//doubling of which is one mip down
+	float texelsPerWorldUnit = std::max(width, height) * uvPerWorldUnit;
+	float pixelsPerWorldUnitHere = pixelsPerWorldUnit / std::max(distance, 1e-4f);
+	float texelsPerPixel = texelsPerWorldUnit / pixelsPerWorldUnitHere;
+	return texelsPerPixel > 1.0f ? std::log2(texelsPerPixel) : 0.0f;
+}
+
+void MipResidency::Request(StreamingHandle texture, float mip)
+{
+	Texture& requested = textures[texture];
+	if (requested.FrameRequest < 0.0f || mip < requested.FrameRequest)
+		requested.FrameRequest = std::max(mip, 0.0f);
+}
+
+void MipResidency::Update(std::vector<MipTransition>& loads, std::vector<MipTransition>& evictions)
+{
+	loads.clear();
+	evictions.clear();
+	frame++;
+
+	//this frame's requests, finer ones held until they've gone unasked for a while
+	for (Texture& texture : textures)
+	{
+		unsigned int wanted = texture.TailMip;
+		if (texture.FrameRequest >= 0.0f)
+			wanted = std::min((unsigned int)texture.FrameRequest, texture.TailMip);
+		texture.FrameRequest = -1.0f;
+
+		texture.WantedMip = wanted;
+		if (wanted <= texture.HeldMip || frame - texture.HeldFrame > settings.RetainFrames)
+		{
+			texture.HeldMip = wanted;
+			texture.HeldFrame = frame;
+		}
+	}
+
+	//holding on is only worth it while there's room; what this frame's
+	//draws asked for comes first
+	if (GetTargetBytes(0) > settings.BudgetBytes)
+	{
+		for (Texture& texture : textures)
+		{
+			texture.HeldMip = texture.WantedMip;
+			texture.HeldFrame = frame;
+		}
+	}
+
+	//drop a level from every texture until the requests fit. The bias only
+	//comes back down with room to spare, or every texture would reload a
+	//level and drop it again as the requests hover around the budget.
+	unsigned int bias = 0;
+	size_t tailBytes = GetTargetBytes(UINT_MAX);
+	while (GetTargetBytes(bias) > settings.BudgetBytes && GetTargetBytes(bias) > tailBytes)
+		bias++;
+	while (bias < stats.MipBias && GetTargetBytes(bias) > settings.BudgetBytes / 100 * MIP_BIAS_HEADROOM_PERCENT)
+		bias++;
+	stats.MipBias = bias;
+
+	for (Texture& texture : textures)
+		texture.TargetMip = std::min(texture.HeldMip + bias, texture.TailMip);
+
+	//evictions free memory right away; a texture mid load waits until it lands
+	for (StreamingHandle handle = 0; handle < textures.size(); handle++)
+	{
+		Texture& texture = textures[handle];
+		if (texture.Loading || texture.ResidentMip >= texture.TargetMip)
+			continue;
+
+		evictions.push_back({ handle, texture.ResidentMip, texture.TargetMip });
+		texture.ResidentMip = texture.TargetMip;
+		stats.Evictions++;
+	}
+
+	//loads, the ones furthest from their target first
+	std::vector<StreamingHandle> candidates;
+	unsigned int loading = 0;
+	for (StreamingHandle handle = 0; handle < textures.size(); handle++)
+	{
+		Texture& texture = textures[handle];
+		if (texture.Loading)
+			loading++;
+		else if (!texture.Failed && texture.ResidentMip > texture.TargetMip)
+			candidates.push_back(handle);
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [this](StreamingHandle a, StreamingHandle b)
+	{
+		return textures[a].ResidentMip - textures[a].TargetMip > textures[b].ResidentMip - textures[b].TargetMip;
+	});
+
+	for (StreamingHandle handle : candidates)
+	{
+		if (loading >= settings.MaxLoads)
+			break;
+
+		Texture& texture = textures[handle];
+		loads.push_back({ handle, texture.ResidentMip, texture.TargetMip });
+		texture.Loading = true;
+		texture.LoadMip = texture.TargetMip;
+		loading++;
+	}
+
+	UpdateStats();
+}
+
+void MipResidency::CompleteLoad(const MipTransition& load, bool succeeded)
+{
+	Texture& texture = textures[load.Texture];
+	texture.Loading = false;
+	if (succeeded)
+	{
+		texture.ResidentMip = load.ToMip;
+		stats.Loads++;
+		stats.BytesLoaded += texture.BytesFrom[load.ToMip] - texture.BytesFrom[load.FromMip];
+	}
+	else
+	{
+		texture.Failed = true;
+	}
+	UpdateStats();
+}
+
+size_t MipResidency::GetTargetBytes(unsigned int bias)
+{
+	size_t bytes = 0;
+	for (Texture& texture : textures)
+	{
+		//failed textures stay as they are
+		if (texture.Failed)
+			bytes += texture.BytesFrom[texture.ResidentMip];
+		else
+			bytes += texture.BytesFrom[std::min(texture.HeldMip + std::min(bias, texture.TailMip), texture.TailMip)];
+	}
+	return bytes;
+}
+
+void MipResidency::UpdateStats()
+{
+	stats.TextureCount = (unsigned int)textures.size();
+	stats.TexturesAtRequest = 0;
+	stats.PendingLoads = 0;
+	stats.BudgetBytes = settings.BudgetBytes;
+	stats.ResidentBytes = 0;
+	stats.PendingBytes = 0;
+	stats.RequestedBytes = 0;
+	for (Texture& texture : textures)
+	{
+		stats.ResidentBytes += texture.BytesFrom[texture.ResidentMip];
+		stats.RequestedBytes += texture.BytesFrom[texture.HeldMip];
+		if (texture.ResidentMip <= texture.HeldMip)
+			stats.TexturesAtRequest++;
+		if (texture.Loading)
+		{
+			stats.PendingLoads++;
+			stats.PendingBytes += texture.BytesFrom[texture.LoadMip] - texture.BytesFrom[texture.ResidentMip];
+		}
+	}
+}
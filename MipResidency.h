@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+typedef unsigned int StreamingHandle;
+
+struct MipResidencySettings
+{
+	size_t BudgetBytes = 64 * 1024 * 1024;
+	unsigned int TailSize = 64;		// Levels this size and smaller never leave
+	unsigned int RetainFrames = 60;	// Frames a finer request holds before a coarser one replaces it
+	unsigned int MaxLoads = 4;		// Loads in flight at once
+};
+
+// A change of a texture's most detailed resident level: loads
+// go finer (ToMip < FromMip), evictions coarser
+struct MipTransition
+{
+	StreamingHandle Texture;
+	unsigned int FromMip;
+	unsigned int ToMip;
+};
+
+struct MipResidencyStats
+{
+	unsigned int TextureCount;
+	unsigned int TexturesAtRequest;	// Resident at or finer than feedback asked for
+	unsigned int PendingLoads;
+	unsigned int MipBias;			// Levels dropped from every request to fit the budget
+	size_t BudgetBytes;
+	size_t ResidentBytes;
+	size_t PendingBytes;
+	size_t RequestedBytes;			// If every texture had what feedback asked for
+	unsigned long long Loads;		// Totals since creation
+	unsigned long long Evictions;
+	unsigned long long BytesLoaded;
+};
+
+// --------------------------------------------------------
+// Decides which mips of each streamed texture should be
+// resident. Draws report the mip they sample, estimated
+// from screen space UV density; once a frame, Update turns
+// the finest request per texture into loads and evictions
+// that fit the memory budget. Finer requests are held for
+// a while so textures don't thrash as objects move, while
+// there's room for them, and when this frame's requests
+// don't fit, every texture drops the same number of levels. Textures nothing asked for fall
+// back to their tail, the small levels that always stay.
+// Everything is for one thread.
+// --------------------------------------------------------
+class MipResidency
+{
+public:
+	MipResidency(const MipResidencySettings& settings);
+
+	//levelBytes holds each level's size, most detailed first. Starts with
+	//nothing resident, so the first Update loads the tail.
+	StreamingHandle Register(const std::string& name, const std::vector<size_t>& levelBytes, unsigned int width, unsigned int height);
+
+	void SetBudget(size_t budgetBytes) { settings.BudgetBytes = budgetBytes; }
+	size_t GetBudget() { return settings.BudgetBytes; }
+
+	//Mip a draw samples when width x height texels are spread over
+	//uvPerWorldUnit UV per world unit, seen from distance away by a
+	//projection covering pixelsPerWorldUnit pixels per unit at distance 1
+	static float ComputeMip(unsigned int width, unsigned int height, float uvPerWorldUnit, float distance, float pixelsPerWorldUnit);
+
+	//Feedback for the current frame, keeping the finest mip asked for
+	void Request(StreamingHandle texture, float mip);
+
+	//Ends the frame's feedback. Evictions have already happened as far as
+	//the policy is concerned; loads are to be reported with CompleteLoad.
+	void Update(std::vector<MipTransition>& loads, std::vector<MipTransition>& evictions);
+	void CompleteLoad(const MipTransition& load, bool succeeded);
+
+	unsigned int GetResidentMip(StreamingHandle texture) { return textures[texture].ResidentMip; } //mip count when nothing is
+	unsigned int GetMipCount(StreamingHandle texture) { return (unsigned int)textures[texture].LevelBytes.size(); }
+	unsigned int GetWidth(StreamingHandle texture) { return textures[texture].Width; }
+	unsigned int GetHeight(StreamingHandle texture) { return textures[texture].Height; }
+	const std::string& GetName(StreamingHandle texture) { return textures[texture].Name; }
+	const MipResidencyStats& GetStats() { return stats; }
+
+private:
+	struct Texture
+	{
+		std::string Name;
+		unsigned int Width;
+		unsigned int Height;
+		std::vector<size_t> LevelBytes;
+		std::vector<size_t> BytesFrom;	// Bytes of every level from each mip down, one extra for none
+		unsigned int TailMip;
+		float FrameRequest;				// Finest mip asked for this frame, negative if none
+		unsigned int WantedMip;			// This frame's request
+		unsigned int HeldMip;			// Request after holding finer ones
+		unsigned long long HeldFrame;
+		unsigned int TargetMip;			// Held request after the budget's bias
+		unsigned int ResidentMip;
+		bool Loading;
+		unsigned int LoadMip;			// What the load in flight brings it to
+		bool Failed;					// Its file couldn't be read, so it isn't tried again
+	};
+
+	MipResidencySettings settings;
+	std::vector<Texture> textures;
+	unsigned long long frame;
+	MipResidencyStats stats;
+
+	size_t GetTargetBytes(unsigned int bias);
+	void UpdateStats();
+};
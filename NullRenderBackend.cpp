@@ -0,0 +1,154 @@
+#include "NullRenderBackend.h"
+
+NullRenderBackend::NullRenderBackend()
+{
+	liveResources = 0;
+}
+
+NullRenderBackend::~NullRenderBackend() {}
+
+RenderHandle NullRenderBackend::CreateBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+	if (initialData)
+		bindings.CountUpload(desc.Size);
+	return AddResource(ResourceBuffer, desc.Size);
+}
+
+RenderHandle NullRenderBackend::CreateTexture(const RenderTextureDesc& desc, const void* initialData)
+{
+	//only RGBA8 textures come with data
+	if (initialData)
+		bindings.CountUpload(desc.Width * desc.Height * 4);
+	return AddResource(ResourceTexture, 0);
+}
+
+RenderHandle NullRenderBackend::CreateShader(RenderShaderStage /*stage*/, const void* /*bytecode*/, size_t bytecodeSize)
+{
+	return AddResource(ResourceShader, (unsigned int)bytecodeSize);
+}
+
+RenderHandle NullRenderBackend::CreateSampler(bool /*comparison*/)
+{
+	return AddResource(ResourceSampler, 0);
+}
+
+void NullRenderBackend::DestroyResource(RenderHandle handle)
+{
+	if (handle == RENDER_HANDLE_NULL || handle > resources.size() || resources[handle - 1].Kind == ResourceFree)
+		return;
+
+	resources[handle - 1].Kind = ResourceFree;
+	bindings.Unbind(handle);
+	liveResources--;
+}
+
+void NullRenderBackend::UpdateBuffer(RenderHandle buffer, const void* /*data*/, unsigned int size)
+{
+	if (!IsKind(buffer, ResourceBuffer) || size > resources[buffer - 1].Size)
+		return;
+
+	bindings.CountUpload(size);
+	Record(RenderCommandUpdateBuffer, buffer, size);
+}
+
+void NullRenderBackend::SetShader(RenderShaderStage stage, RenderHandle shader)
+{
+	if (bindings.BindShader(stage, shader))
+		Record(RenderCommandSetShader, stage, shader);
+}
+
+void NullRenderBackend::SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride)
+{
+	if (bindings.BindVertexBuffer(slot, buffer))
+		Record(RenderCommandSetVertexBuffer, slot, buffer, stride);
+}
+
+void NullRenderBackend::SetIndexBuffer(RenderHandle buffer)
+{
+	if (bindings.BindIndexBuffer(buffer))
+		Record(RenderCommandSetIndexBuffer, buffer);
+}
+
+void NullRenderBackend::SetConstantBuffer(RenderShaderStage stage, unsigned int slot, RenderHandle buffer)
+{
+	if (bindings.BindConstantBuffer(stage, slot, buffer))
+		Record(RenderCommandSetConstantBuffer, stage, slot, buffer);
+}
+
+void NullRenderBackend::SetTexture(RenderShaderStage stage, unsigned int slot, RenderHandle texture)
+{
+	if (bindings.BindTexture(stage, slot, texture))
+		Record(RenderCommandSetTexture, stage, slot, texture);
+}
+
+void NullRenderBackend::SetSampler(RenderShaderStage stage, unsigned int slot, RenderHandle sampler)
+{
+	if (bindings.BindSampler(stage, slot, sampler))
+		Record(RenderCommandSetSampler, stage, slot, sampler);
+}
+
+void NullRenderBackend::SetRenderTarget(RenderHandle color, RenderHandle depth)
+{
+	if (bindings.BindRenderTarget(color, depth))
+		Record(RenderCommandSetRenderTarget, color, depth);
+}
+
+void NullRenderBackend::SetViewport(float width, float height)
+{
+	if (bindings.BindViewport(width, height))
+		Record(RenderCommandSetViewport, (unsigned int)width, (unsigned int)height);
+}
+
+void NullRenderBackend::ClearDepth(RenderHandle depth)
+{
+	Record(RenderCommandClearDepth, depth);
+}
+
+void NullRenderBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	bindings.CountDraw(1);
+	Record(RenderCommandDrawIndexed, indexCount, startIndex, (unsigned int)baseVertex);
+}
+
+void NullRenderBackend::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	bindings.CountDraw(instanceCount);
+	Record(RenderCommandDrawIndexedInstanced, indexCount, instanceCount, startIndex, (unsigned int)baseVertex, startInstance);
+}
+
+void NullRenderBackend::BeginFrame()
+{
+	//keeps its capacity, so steady state frames don't allocate
+	commands.clear();
+	bindings.Reset();
+}
+
+void NullRenderBackend::EndFrame() {}
+
+RenderHandle NullRenderBackend::AddResource(ResourceKind kind, unsigned int size)
+{
+	liveResources++;
+
+	//reuse a destroyed slot before growing
+	for (unsigned int i = 0; i < resources.size(); i++)
+	{
+		if (resources[i].Kind == ResourceFree)
+		{
+			resources[i] = { kind, size };
+			return i + 1;
+		}
+	}
+
+	resources.push_back({ kind, size });
+	return (RenderHandle)resources.size();
+}
+
+bool NullRenderBackend::IsKind(RenderHandle handle, ResourceKind kind)
+{
+	return handle != RENDER_HANDLE_NULL && handle <= resources.size() && resources[handle - 1].Kind == kind;
+}
+
+void NullRenderBackend::Record(RenderCommandType type, unsigned int a, unsigned int b, unsigned int c, unsigned int d, unsigned int e)
+{
+	commands.push_back({ type, { a, b, c, d, e } });
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include "RenderBackend.h"
+#include "RenderBindingCache.h"
+
+enum RenderCommandType
+{
+	RenderCommandSetShader,
+	RenderCommandSetVertexBuffer,
+	RenderCommandSetIndexBuffer,
+	RenderCommandSetConstantBuffer,
+	RenderCommandSetTexture,
+	RenderCommandSetSampler,
+	RenderCommandSetRenderTarget,
+	RenderCommandSetViewport,
+	RenderCommandUpdateBuffer,
+	RenderCommandClearDepth,
+	RenderCommandDrawIndexed,
+	RenderCommandDrawIndexedInstanced
+};
+
+// --------------------------------------------------------
+// One call that reached the null backend, with its
+// arguments in call order (viewport sizes are truncated)
+// --------------------------------------------------------
+struct RenderCommand
+{
+	RenderCommandType Type;
+	unsigned int Args[5];
+};
+
+// --------------------------------------------------------
+// Backend with no device behind it. Hands out handles,
+// records the commands that get past the binding filter and
+// keeps the per frame stats, so scene, culling and shadow
+// logic can run and be measured on machines without a GPU.
+// --------------------------------------------------------
+class NullRenderBackend : public IRenderBackend
+{
+public:
+	NullRenderBackend();
+	~NullRenderBackend();
+
+	RenderHandle CreateBuffer(const RenderBufferDesc& desc, const void* initialData) override;
+	RenderHandle CreateTexture(const RenderTextureDesc& desc, const void* initialData) override;
+	RenderHandle CreateShader(RenderShaderStage stage, const void* bytecode, size_t bytecodeSize) override;
+	RenderHandle CreateSampler(bool comparison) override;
+	void DestroyResource(RenderHandle handle) override;
+	void UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size) override;
+
+	void SetShader(RenderShaderStage stage, RenderHandle shader) override;
+	void SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride) override;
+	void SetIndexBuffer(RenderHandle buffer) override;
+	void SetConstantBuffer(RenderShaderStage stage, unsigned int slot, RenderHandle buffer) override;
+	void SetTexture(RenderShaderStage stage, unsigned int slot, RenderHandle texture) override;
+	void SetSampler(RenderShaderStage stage, unsigned int slot, RenderHandle sampler) override;
+	void SetRenderTarget(RenderHandle color, RenderHandle depth) override;
+	void SetViewport(float width, float height) override;
+
+	void ClearDepth(RenderHandle depth) override;
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance) override;
+
+	void BeginFrame() override;
+	void EndFrame() override;
+	RenderBackendStats GetFrameStats() override { return bindings.GetStats(); }
+
+	//Commands of the current frame, or the last one after EndFrame
+	const std::vector<RenderCommand>& GetCommands() { return commands; }
+	unsigned int GetLiveResourceCount() { return liveResources; }
+
+private:
+	enum ResourceKind
+	{
+		ResourceFree,
+		ResourceBuffer,
+		ResourceTexture,
+		ResourceShader,
+		ResourceSampler
+	};
+
+	struct Resource
+	{
+		ResourceKind Kind;
+		unsigned int Size; //buffer bytes, for bounds checking updates
+	};
+
+	std::vector<Resource> resources; //handle - 1 indexes in
+	std::vector<RenderCommand> commands;
+	RenderBindingCache bindings;
+	unsigned int liveResources;
+
+	RenderHandle AddResource(ResourceKind kind, unsigned int size);
+	bool IsKind(RenderHandle handle, ResourceKind kind);
+	void Record(RenderCommandType type, unsigned int a = 0, unsigned int b = 0, unsigned int c = 0, unsigned int d = 0, unsigned int e = 0);
+};
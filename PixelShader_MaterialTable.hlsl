@@ -0,0 +1,50 @@
+#include "ShaderIncludes.hlsli"
+#include "ShaderHelpers.hlsli"
+
+//every material of the table in one array per map kind, a slice each
+Texture2DArray AlbedoMaps : register(t0);
+Texture2DArray NormalMaps : register(t1); //tangent space x and y only
+Texture2DArray SurfaceMaps : register(t2); //roughness (r), metalness (g), occlusion (b) if packed with it
+
+//matches MaterialRecord in MaterialTable.h
+struct MaterialRecord
+{
+    float3 colorTint;
+    int3 slices; //-1 for a map the material doesn't have
+    float3 minLods; //array level holding the top of each map
+};
+StructuredBuffer<MaterialRecord> MaterialRecords : register(t6);
+
+#include "PixelShading.hlsli"
+
+//same values as the placeholders Game creates: grey albedo, flat normals, fully rough dielectric surface
+static const float3 DEFAULT_ALBEDO = float3(128.0f, 128.0f, 128.0f) / 255.0f;
+static const float2 DEFAULT_NORMAL = float2(128.0f, 128.0f) / 255.0f;
+static const float2 DEFAULT_SURFACE = float2(1.0f, 0.0f);
+
+//samples a map no higher than the level its top is on; the LOD clamp overload of Sample
+//needs tiled resources tier 2, so instead the gradients are scaled up until the level
+//the hardware picks (anisotropy included) is at least minLod
+float4 SampleFromLevel(Texture2DArray maps, float2 uv, int slice, float minLod)
+{
+    float2 dx = ddx(uv);
+    float2 dy = ddy(uv);
+    float lod = maps.CalculateLevelOfDetailUnclamped(BasicSampler, uv);
+    float scale = exp2(max(minLod - lod, 0.0f));
+    return maps.SampleGrad(BasicSampler, float3(uv, max(slice, 0)), dx * scale, dy * scale);
+}
+
+float4 main(VertexToPixel input) : SV_TARGET
+{
+    MaterialRecord material = MaterialRecords[input.materialIndex];
+
+    //sampled unconditionally so derivatives stay valid, then swapped for defaults
+    float3 albedoColor = SampleFromLevel(AlbedoMaps, input.uv, material.slices.x, material.minLods.x).rgb;
+    float2 packedNormal = SampleFromLevel(NormalMaps, input.uv, material.slices.y, material.minLods.y).rg;
+    float2 surface = SampleFromLevel(SurfaceMaps, input.uv, material.slices.z, material.minLods.z).rg;
+    albedoColor = material.slices.x >= 0 ? albedoColor : DEFAULT_ALBEDO;
+    packedNormal = material.slices.y >= 0 ? packedNormal : DEFAULT_NORMAL;
+    surface = material.slices.z >= 0 ? surface : DEFAULT_SURFACE;
+
+    return ShadePixel(input, albedoColor, packedNormal, surface, material.colorTint);
+}
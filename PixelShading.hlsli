@@ -0,0 +1,157 @@
+#ifndef __GGP_PIXEL_SHADING__
+#define __GGP_PIXEL_SHADING__
+
+#include "ShaderIncludes.hlsli"
+#include "ShaderHelpers.hlsli"
+
+//lighting shared by the main pass pixel shaders, which declare their own material textures in t0-t2
+
+//shadow map textures (fixed 3, ideally would prefer some sort of array for dynamic number of lights and shadows)
+Texture2D ShadowMap1 : register(t3);
+Texture2D ShadowMap2 : register(t4);
+Texture2D ShadowMap3 : register(t5);
+
+//image based lighting from the sky, prefiltered by EnvironmentLighting: a roughness per specular mip,
+//and the split sum scale (r) and bias (g) of F0 by NdotV across and roughness down
+TextureCube SpecularMap : register(t7);
+Texture2D BrdfLut : register(t8);
+
+//samplers
+SamplerState BasicSampler : register(s0); // "s" registers for samplers 
+SamplerComparisonState ShadowSampler : register(s1);
+SamplerState ClampSampler : register(s2);
+
+//constant buffer definition
+cbuffer ExternalData : register(b0)
+{
+    float3 colorTint;
+    float3 cameraPosition;
+    float3 ambientTerm;
+    Light lights[MAX_LIGHTS];
+    int lightCount;
+    float4 irradianceSH[9]; //rgb, already convolved and divided by pi
+    int specularMipCount; //0 until the sky's lighting has loaded
+}
+
+//diffuse light reaching a white surface facing n, from the sky's spherical harmonics
+float3 SkyIrradiance(float3 n)
+{
+    float3 result = irradianceSH[0].rgb * 0.282095f;
+    result += irradianceSH[1].rgb * 0.488603f * n.y;
+    result += irradianceSH[2].rgb * 0.488603f * n.z;
+    result += irradianceSH[3].rgb * 0.488603f * n.x;
+    result += irradianceSH[4].rgb * 1.092548f * n.x * n.y;
+    result += irradianceSH[5].rgb * 1.092548f * n.y * n.z;
+    result += irradianceSH[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+    result += irradianceSH[7].rgb * 1.092548f * n.x * n.z;
+    result += irradianceSH[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+    return max(result, 0.0f);
+}
+
+//light from the sky in every direction, or the flat ambient term until that has loaded
+float3 Ambient(float3 normal, float3 worldPosition, float roughness, float metalness, float3 specularColor, float3 surfaceColor)
+{
+    if (specularMipCount == 0)
+        return ambientTerm * surfaceColor;
+
+    float3 dirToView = normalize(cameraPosition - worldPosition);
+    float NdotV = saturate(dot(normal, dirToView));
+    float3 prefiltered = SpecularMap.SampleLevel(ClampSampler, reflect(-dirToView, normal), roughness * (specularMipCount - 1)).rgb;
+    float2 brdf = BrdfLut.SampleLevel(ClampSampler, float2(NdotV, roughness), 0).rg;
+    float3 reflected = specularColor * brdf.x + brdf.y;
+
+    //what the specular term reflects isn't diffused, and metals don't diffuse at all
+    float3 diffuse = SkyIrradiance(normal) * surfaceColor * (1.0f - reflected) * (1.0f - metalness);
+    return diffuse + prefiltered * reflected;
+}
+
+//lights a pixel from its sampled albedo, tangent space normal (xy) and surface (roughness, metalness)
+float4 ShadePixel(VertexToPixel input, float3 albedoColor, float2 packedNormal, float2 surface, float3 tint)
+{
+    float3 surfaceColor = pow(albedoColor, 2.2f) * tint;
+    
+    //Normalize normal and tanget
+    input.normal = normalize(input.normal); 
+    input.tangent = normalize(input.tangent); 
+    
+    // Gram-Schmidt orthonormalization
+    input.tangent = normalize(input.tangent - input.normal * dot(input.tangent, input.normal)); 
+    
+    //Calculate bitangent and TBN matrix
+    float3 biTangent = cross(input.tangent, input.normal);
+    float3x3 TBN = float3x3(input.tangent, biTangent, input.normal);
+
+    //Unpacking the normal map sample
+    float3 unpackedNormal;
+    unpackedNormal.xy = packedNormal * 2 - 1;
+    unpackedNormal.z = sqrt(saturate(1 - dot(unpackedNormal.xy, unpackedNormal.xy)));
+    //Transforming the unpacked normal
+    input.normal = mul(unpackedNormal, TBN);
+    
+    //Roughness and metalness from the surface map
+    float roughness = surface.r;
+    float metalness = surface.g;
+    
+    // Specular color determination
+    // Assume albedo texture is actually holding specular color where metalness == 1
+    // Note the use of lerp here - metal is generally 0 or 1, but might be in between
+    // because of linear texture sampling, so we lerp the specular color to match
+    float3 specularColor = lerp(F0_NON_METAL.rrr, albedoColor.rgb, metalness);
+    
+    float3 finalColor = float3(0.0f, 0.0f, 0.0f);
+    
+    //directional and point terms
+    for (int i = 0; i < lightCount; i++)
+    {
+        float shadowAmount = 1.0f;
+        
+        //first 3 lights are directional lights with shadows
+        if(i<3)
+        {
+            // SHADOW MAPPING --------------------------------
+	        // Note: This is only for a SINGLE light!  If you want multiple lights to cast shadows,
+	        // you need to do all of this multiple times IN THIS SHADER.
+            float2 shadowUV = input.posForShadow[i].xy / input.posForShadow[i].w * 0.5f + 0.5f;
+            shadowUV.y = 1.0f - shadowUV.y;
+
+             // Calculate this pixel's depth from the light
+            float depthFromLight = input.posForShadow[i].z / input.posForShadow[i].w;
+    
+             // Sample the shadow map using a comparison sampler, which
+	         // will compare the depth from the light and the value in the shadow map
+	         // Note: This is applied below, after we calc our DIRECTIONAL LIGHT
+            switch (i)
+            {
+                case 0:
+                    shadowAmount = ShadowMap1.SampleCmpLevelZero(ShadowSampler, shadowUV, depthFromLight);
+                    break;
+                case 1:
+                    shadowAmount = ShadowMap2.SampleCmpLevelZero(ShadowSampler, shadowUV, depthFromLight);
+                    break;
+                case 2:
+                    shadowAmount = ShadowMap3.SampleCmpLevelZero(ShadowSampler, shadowUV, depthFromLight);
+                    break;
+            } 
+        }
+        
+        if (lights[i].Type == LIGHT_TYPE_DIRECTIONAL)
+        {
+            float3 directionalColor = Directional(lights[i], input.normal, cameraPosition, input.worldPosition, roughness, metalness, specularColor, surfaceColor);
+            finalColor += directionalColor * (lights[i].CastsShadows ? shadowAmount : 1.0f);
+        }
+        else if (lights[i].Type == LIGHT_TYPE_POINT)
+        {
+            finalColor += Point(lights[i], input.normal, cameraPosition, input.worldPosition, roughness, metalness, specularColor, surfaceColor);
+        }
+        else if (lights[i].Type == LIGHT_TYPE_SPOT)
+        {
+            //do nothing for now
+        }
+    }
+    
+    finalColor += Ambient(input.normal, input.worldPosition, roughness, metalness, specularColor, surfaceColor);
+    
+    return float4(pow(finalColor, 1.0f / 2.2f), 1.0f);
+}
+
+#endif
@@ -0,0 +1,465 @@
+#include "PngDecoder.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+// Deflate limits, from RFC 1951
+#define INFLATE_MAX_BITS 15
+#define INFLATE_MAX_LENGTH_CODES 286
+#define INFLATE_MAX_DISTANCE_CODES 30
+#define INFLATE_FIXED_LENGTH_CODES 288
+
+namespace
+{
+	// LSB first bit reader over the deflate stream
+	struct BitReader
+	{
+		const unsigned char* Data;
+		size_t Size;
+		size_t Position;
+		unsigned int Buffer;
+		unsigned int Count;
+		bool Overrun;
+
+		unsigned int Bits(unsigned int need)
+		{
+			while (Count < need)
+			{
+				if (Position >= Size)
+				{
+					Overrun = true;
+					return 0;
+				}
+				Buffer |= (unsigned int)Data[Position++] << Count;
+				Count += 8;
+			}
+			unsigned int value = Buffer & ((1u << need) - 1);
+			Buffer >>= need;
+			Count -= need;
+			return value;
+		}
+	};
+
+	// Canonical Huffman code as symbol counts per length and
+	// symbols in code order, decoded a bit at a time
+	struct Huffman
+	{
+		short Counts[INFLATE_MAX_BITS + 1];
+		short Symbols[INFLATE_FIXED_LENGTH_CODES];
+
+		bool Build(const short* lengths, int count)
+		{
+			memset(Counts, 0, sizeof(Counts));
+			for (int s = 0; s < count; s++)
+			{
+				Counts[lengths[s]]++;
+			}
+			if (Counts[0] == count)
+				return true; //no codes, only an error if one is used
+
+			//over-subscribed sets can't be decoded
+			int left = 1;
+			for (int len = 1; len <= INFLATE_MAX_BITS; len++)
+			{
+				left = (left << 1) - Counts[len];
+				if (left < 0)
+					return false;
+			}
+
+			short offsets[INFLATE_MAX_BITS + 1];
+			offsets[1] = 0;
+			for (int len = 1; len < INFLATE_MAX_BITS; len++)
+			{
+				offsets[len + 1] = offsets[len] + Counts[len];
+			}
+			for (int s = 0; s < count; s++)
+			{
+				if (lengths[s] != 0)
+					Symbols[offsets[lengths[s]]++] = (short)s;
+			}
+			return true;
+		}
+
+		int Decode(BitReader& bits) const
+		{
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for (int len = 1; len <= INFLATE_MAX_BITS; len++)
+			{
+				code |= (int)bits.Bits(1);
+				int count = Counts[len];
+				if (code - count < first)
+					return Symbols[index + (code - first)];
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+				if (bits.Overrun)
+					return -1;
+			}
+			return -1;
+		}
+	};
+
+	const short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const short lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const short distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	bool InflateCodes(BitReader& bits, const Huffman& lengths, const Huffman& distances, std::vector<unsigned char>& output)
+	{
+		while (true)
+		{
+			int symbol = lengths.Decode(bits);
+			if (symbol < 0)
+				return false;
+			if (symbol < 256)
+			{
+				output.push_back((unsigned char)symbol);
+				continue;
+			}
+			if (symbol == 256)
+				return true;
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+			unsigned int length = lengthBase[symbol] + bits.Bits(lengthExtra[symbol]);
+
+			int distanceSymbol = distances.Decode(bits);
+			if (distanceSymbol < 0 || distanceSymbol >= 30)
+				return false;
+			size_t distance = distanceBase[distanceSymbol] + bits.Bits(distanceExtra[distanceSymbol]);
+			if (bits.Overrun || distance > output.size())
+				return false;
+
+			//byte at a time, copies may overlap what they write
+			size_t from = output.size() - distance;
+			for (unsigned int i = 0; i < length; i++)
+			{
+				output.push_back(output[from + i]);
+			}
+		}
+	}
+
+	bool InflateDynamic(BitReader& bits, std::vector<unsigned char>& output)
+	{
+		static const unsigned char codeOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		unsigned int lengthCount = bits.Bits(5) + 257;
+		unsigned int distanceCount = bits.Bits(5) + 1;
+		unsigned int codeCount = bits.Bits(4) + 4;
+		if (lengthCount > INFLATE_MAX_LENGTH_CODES || distanceCount > INFLATE_MAX_DISTANCE_CODES)
+			return false;
+
+		short lengths[INFLATE_MAX_LENGTH_CODES + INFLATE_MAX_DISTANCE_CODES] = {};
+		for (unsigned int i = 0; i < codeCount; i++)
+		{
+			lengths[codeOrder[i]] = (short)bits.Bits(3);
+		}
+		Huffman codeLengths;
+		if (!codeLengths.Build(lengths, 19))
+			return false;
+
+		//literal/length and distance code lengths, run length coded
+		unsigned int index = 0;
+		while (index < lengthCount + distanceCount)
+		{
+			int symbol = codeLengths.Decode(bits);
+			if (symbol < 0)
+				return false;
+			if (symbol < 16)
+			{
+				lengths[index++] = (short)symbol;
+				continue;
+			}
+
+			short repeated = 0;
+			unsigned int repeat = 0;
+			if (symbol == 16)
+			{
+				if (index == 0)
+					return false;
+				repeated = lengths[index - 1];
+				repeat = 3 + bits.Bits(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + bits.Bits(3);
+			}
+			else
+			{
+				repeat = 11 + bits.Bits(7);
+			}
+			if (index + repeat > lengthCount + distanceCount)
+				return false;
+			while (repeat--)
+			{
+				lengths[index++] = repeated;
+			}
+		}
+		if (lengths[256] == 0)
+			return false; //no end of block code
+
+		Huffman literalCodes;
+		Huffman distanceCodes;
+		if (!literalCodes.Build(lengths, lengthCount) || !distanceCodes.Build(lengths + lengthCount, distanceCount))
+			return false;
+		return InflateCodes(bits, literalCodes, distanceCodes, output);
+	}
+
+	bool InflateFixed(BitReader& bits, std::vector<unsigned char>& output)
+	{
+		static Huffman literalCodes;
+		static Huffman distanceCodes;
+		static bool built = false;
+		if (!built)
+		{
+			short lengths[INFLATE_FIXED_LENGTH_CODES];
+			int s = 0;
+			for (; s < 144; s++) lengths[s] = 8;
+			for (; s < 256; s++) lengths[s] = 9;
+			for (; s < 280; s++) lengths[s] = 7;
+			for (; s < INFLATE_FIXED_LENGTH_CODES; s++) lengths[s] = 8;
+			literalCodes.Build(lengths, INFLATE_FIXED_LENGTH_CODES);
+
+			for (s = 0; s < INFLATE_MAX_DISTANCE_CODES; s++) lengths[s] = 5;
+			distanceCodes.Build(lengths, INFLATE_MAX_DISTANCE_CODES);
+			built = true;
+		}
+		return InflateCodes(bits, literalCodes, distanceCodes, output);
+	}
+
+	unsigned int ReadBigEndian(const unsigned char* bytes)
+	{
+		return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3];
+	}
+
+	unsigned char Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return (unsigned char)a;
+		return (unsigned char)(pb <= pc ? b : c);
+	}
+}
+
+bool PngDecoder::Load(const std::string& path, TextureImage& image, unsigned int* sourceChannels)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	std::vector<unsigned char> data;
+	unsigned char chunk[65536];
+	size_t read = 0;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + read);
+	}
+	fclose(file);
+
+	return Decode(data.data(), data.size(), image, sourceChannels);
+}
+
+bool PngDecoder::Decode(const unsigned char* data, size_t size, TextureImage& image, unsigned int* sourceChannels)
+{
+	static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (size < 8 || memcmp(data, signature, 8) != 0)
+		return false;
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int bitDepth = 0;
+	unsigned int colorType = 0;
+	std::vector<unsigned char> compressed;
+	std::vector<unsigned char> palette(256 * 4, 255);
+
+	//chunks: length, type, data, crc (crc isn't checked)
+	size_t offset = 8;
+	while (offset + 12 <= size)
+	{
+		unsigned int length = ReadBigEndian(data + offset);
+		const unsigned char* type = data + offset + 4;
+		const unsigned char* body = data + offset + 8;
+		if (length > size - offset - 12)
+			return false;
+
+		if (memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			width = ReadBigEndian(body);
+			height = ReadBigEndian(body + 4);
+			bitDepth = body[8];
+			colorType = body[9];
+			if (body[12] != 0)
+				return false; //interlaced
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			for (unsigned int i = 0; i < length / 3 && i < 256; i++)
+			{
+				palette[i * 4 + 0] = body[i * 3 + 0];
+				palette[i * 4 + 1] = body[i * 3 + 1];
+				palette[i * 4 + 2] = body[i * 3 + 2];
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0 && colorType == 3)
+		{
+			for (unsigned int i = 0; i < length && i < 256; i++)
+			{
+				palette[i * 4 + 3] = body[i];
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), body, body + length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+		offset += 12 + (size_t)length;
+	}
+
+	unsigned int channels = 0;
+	switch (colorType)
+	{
+	case 0: channels = 1; break;
+	case 2: channels = 3; break;
+	case 3: channels = 1; break;
+	case 4: channels = 2; break;
+	case 6: channels = 4; break;
+	default: return false;
+	}
+	if (width == 0 || height == 0 || (bitDepth != 8 && bitDepth != 16) || (colorType == 3 && bitDepth != 8))
+		return false;
+
+	std::vector<unsigned char> raw;
+	if (!Inflate(compressed.data(), compressed.size(), raw))
+		return false;
+
+	//undo the per row filters in place, each row starts with its filter type
+	unsigned int bytesPerPixel = channels * bitDepth / 8;
+	size_t stride = (size_t)width * bytesPerPixel;
+	if (raw.size() < (stride + 1) * height)
+		return false;
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned char filter = raw[y * (stride + 1)];
+		unsigned char* row = &raw[y * (stride + 1) + 1];
+		const unsigned char* above = y > 0 ? row - (stride + 1) : 0;
+		for (size_t x = 0; x < stride; x++)
+		{
+			int a = x >= bytesPerPixel ? row[x - bytesPerPixel] : 0;
+			int b = above ? above[x] : 0;
+			int c = (above && x >= bytesPerPixel) ? above[x - bytesPerPixel] : 0;
+			switch (filter)
+			{
+			case 0: break;
+			case 1: row[x] = (unsigned char)(row[x] + a); break;
+			case 2: row[x] = (unsigned char)(row[x] + b); break;
+			case 3: row[x] = (unsigned char)(row[x] + ((a + b) >> 1)); break;
+			case 4: row[x] = (unsigned char)(row[x] + Paeth(a, b, c)); break;
+			default: return false;
+			}
+		}
+	}
+
+	if (sourceChannels)
+	{
+		*sourceChannels = colorType == 3 ? 4 : channels;
+	}
+
+	//expand to RGBA8
+	image.Allocate(width, height, 4);
+	unsigned int sampleBytes = bitDepth / 8;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned char* row = &raw[y * (stride + 1) + 1];
+		for (unsigned int x = 0; x < width; x++)
+		{
+			const unsigned char* source = row + (size_t)x * bytesPerPixel;
+			unsigned char* destination = image.GetPixel(x, y);
+			unsigned char samples[4];
+			for (unsigned int c = 0; c < channels; c++)
+			{
+				samples[c] = source[c * sampleBytes]; //high byte of 16 bit samples
+			}
+
+			switch (colorType)
+			{
+			case 0:
+				destination[0] = destination[1] = destination[2] = samples[0];
+				destination[3] = 255;
+				break;
+			case 2:
+				destination[0] = samples[0];
+				destination[1] = samples[1];
+				destination[2] = samples[2];
+				destination[3] = 255;
+				break;
+			case 3:
+				memcpy(destination, &palette[samples[0] * 4], 4);
+				break;
+			case 4:
+				destination[0] = destination[1] = destination[2] = samples[0];
+				destination[3] = samples[1];
+				break;
+			case 6:
+				memcpy(destination, samples, 4);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+bool PngDecoder::Inflate(const unsigned char* data, size_t size, std::vector<unsigned char>& output)
+{
+	//zlib header: deflate, no preset dictionary
+	if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+		return false;
+
+	BitReader bits = { data + 2, size - 2, 0, 0, 0, false };
+	output.clear();
+
+	bool last = false;
+	while (!last)
+	{
+		last = bits.Bits(1) != 0;
+		unsigned int type = bits.Bits(2);
+		bool ok = false;
+		if (type == 0)
+		{
+			//stored: byte aligned length, its complement, then raw bytes
+			bits.Buffer = 0;
+			bits.Count = 0;
+			if (bits.Position + 4 > bits.Size)
+				return false;
+			unsigned int length = bits.Data[bits.Position] | (bits.Data[bits.Position + 1] << 8);
+			unsigned int complement = bits.Data[bits.Position + 2] | (bits.Data[bits.Position + 3] << 8);
+			bits.Position += 4;
+			if (length != (~complement & 0xFFFF) || bits.Position + length > bits.Size)
+				return false;
+			output.insert(output.end(), bits.Data + bits.Position, bits.Data + bits.Position + length);
+			bits.Position += length;
+			ok = true;
+		}
+		else if (type == 1)
+		{
+			ok = InflateFixed(bits, output);
+		}
+		else if (type == 2)
+		{
+			ok = InflateDynamic(bits, output);
+		}
+
+		if (!ok || bits.Overrun)
+			return false;
+	}
+	return true;
+}
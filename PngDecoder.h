@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TextureImage.h"
+
+// --------------------------------------------------------
+// Decodes PNG files into RGBA8 images without WIC, so asset
+// tools run anywhere. Handles 8 and 16 bit grey, grey and
+// alpha, RGB, RGBA and palette images (16 bit channels keep
+// their high byte); interlaced images are rejected. Has no
+// device dependency.
+// --------------------------------------------------------
+class PngDecoder
+{
+public:
+	//sourceChannels, if given, gets the file's channel count before expansion
+	static bool Load(const std::string& path, TextureImage& image, unsigned int* sourceChannels = 0);
+	static bool Decode(const unsigned char* data, size_t size, TextureImage& image, unsigned int* sourceChannels = 0);
+
+	//zlib stream to raw bytes, public for other formats that use it
+	static bool Inflate(const unsigned char* data, size_t size, std::vector<unsigned char>& output);
+};
@@ -0,0 +1,176 @@
+#include "Profiler.h"
+#include <cstdio>
+
+//each thread's buffer, found once and then cached
+static thread_local void* currentThreadBuffer = 0;
+
+Profiler::Profiler()
+{
+	start = std::chrono::steady_clock::now();
+	frameCount = 0;
+	for (unsigned int i = 0; i < PROFILER_FRAME_HISTORY; i++)
+	{
+		frameStarts[i] = 0;
+	}
+}
+
+Profiler::~Profiler() {}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	buffer->Name = name;
+}
+
+void Profiler::BeginFrame()
+{
+	long long now = Now();
+	std::lock_guard<std::mutex> lock(framesMutex);
+	frameStarts[frameCount % PROFILER_FRAME_HISTORY] = now;
+	frameCount++;
+}
+
+long long Profiler::BeginScope()
+{
+	GetThreadBuffer()->Depth++;
+	return Now();
+}
+
+void Profiler::EndScope(const char* name, long long begin)
+{
+	long long end = Now();
+	ThreadBuffer* buffer = GetThreadBuffer();
+	buffer->Depth--;
+
+	//only this thread writes the buffer, so a relaxed read of the
+	//count is enough; the release store publishes the event. The fence
+	//orders the last count stored before this slot's stores, so a reader
+	//that sees any of them then sees a count that tells it to drop the slot
+	unsigned long long written = buffer->Written.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	EventSlot& slot = buffer->Events[written & (PROFILER_EVENTS_PER_THREAD - 1)];
+	slot.Name.store(name, std::memory_order_relaxed);
+	slot.Begin.store(begin, std::memory_order_relaxed);
+	slot.End.store(end, std::memory_order_relaxed);
+	slot.Depth.store(buffer->Depth, std::memory_order_relaxed);
+	buffer->Written.store(written + 1, std::memory_order_release);
+}
+
+long long Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Profiler::Capture(long long since, std::vector<ProfileThreadCapture>& captures)
+{
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	captures.resize(threads.size());
+
+	for (unsigned int t = 0; t < threads.size(); t++)
+	{
+		ThreadBuffer& buffer = *threads[t];
+		ProfileThreadCapture& capture = captures[t];
+		capture.Name = buffer.Name;
+		capture.Events.clear();
+
+		//events are stored in the order they ended, so walk back from
+		//the newest until they end before the window; the slot of event
+		//written - N is the one the owner may be writing now, so stop after it
+		unsigned long long written = buffer.Written.load(std::memory_order_acquire);
+		unsigned long long oldest = written >= PROFILER_EVENTS_PER_THREAD ? written - PROFILER_EVENTS_PER_THREAD + 1 : 0;
+		unsigned long long first = written;
+		while (first > oldest)
+		{
+			EventSlot& slot = buffer.Events[(first - 1) & (PROFILER_EVENTS_PER_THREAD - 1)];
+			if (slot.End.load(std::memory_order_relaxed) < since)
+				break;
+			first--;
+		}
+
+		for (unsigned long long i = first; i < written; i++)
+		{
+			EventSlot& slot = buffer.Events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+			ProfileEvent event = {};
+			event.Name = slot.Name.load(std::memory_order_relaxed);
+			event.Begin = slot.Begin.load(std::memory_order_relaxed);
+			event.End = slot.End.load(std::memory_order_relaxed);
+			event.Depth = slot.Depth.load(std::memory_order_relaxed);
+			capture.Events.push_back(event);
+		}
+
+		//the owner may have lapped the copy, drop what it overwrote and the
+		//event whose slot it may be writing now (after - N shares a slot with
+		//after); the fence keeps the slot reads above before this count read
+		std::atomic_thread_fence(std::memory_order_acquire);
+		unsigned long long after = buffer.Written.load(std::memory_order_relaxed);
+		if (after >= PROFILER_EVENTS_PER_THREAD && after - PROFILER_EVENTS_PER_THREAD >= first)
+		{
+			unsigned long long overwritten = after - PROFILER_EVENTS_PER_THREAD + 1 - first;
+			if (overwritten > capture.Events.size())
+				overwritten = capture.Events.size();
+			capture.Events.erase(capture.Events.begin(), capture.Events.begin() + (size_t)overwritten);
+		}
+	}
+}
+
+void Profiler::GetFrameStarts(std::vector<long long>& starts)
+{
+	std::lock_guard<std::mutex> lock(framesMutex);
+	starts.clear();
+
+	unsigned long long count = frameCount < PROFILER_FRAME_HISTORY ? frameCount : PROFILER_FRAME_HISTORY;
+	for (unsigned long long i = frameCount - count; i < frameCount; i++)
+	{
+		starts.push_back(frameStarts[i % PROFILER_FRAME_HISTORY]);
+	}
+}
+
+void Profiler::ExportChromeTrace(std::ostream& stream)
+{
+	std::vector<ProfileThreadCapture> captures;
+	Capture(0, captures);
+
+	//complete ("X") events in microseconds, one tid per thread
+	stream << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (unsigned int t = 0; t < captures.size(); t++)
+	{
+		std::string threadName = captures[t].Name.empty() ? "Thread " + std::to_string(t) : captures[t].Name;
+		stream << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t
+			<< ",\"args\":{\"name\":\"" << threadName << "\"}}";
+		first = false;
+
+		for (ProfileEvent& event : captures[t].Events)
+		{
+			stream << ",\n{\"name\":\"";
+			for (const char* c = event.Name; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					stream << '\\';
+				stream << *c;
+			}
+			//fixed point keeps nanosecond precision on long captures
+			char times[64];
+			snprintf(times, sizeof(times), ",\"ts\":%.3f,\"dur\":%.3f}", event.Begin / 1000.0, (event.End - event.Begin) / 1000.0);
+			stream << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t << times;
+		}
+	}
+	stream << "\n]}\n";
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	if (!currentThreadBuffer)
+	{
+		std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+		buffer->Events.reset(new EventSlot[PROFILER_EVENTS_PER_THREAD]());
+		buffer->Written.store(0);
+		buffer->Depth = 0;
+
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		currentThreadBuffer = buffer.get();
+		threads.push_back(std::move(buffer));
+	}
+	return (ThreadBuffer*)currentThreadBuffer;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile every PROFILE_SCOPE out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Events each thread keeps before the oldest are overwritten (power of two)
+#define PROFILER_EVENTS_PER_THREAD 8192
+
+// Frame start times kept for the view
+#define PROFILER_FRAME_HISTORY 128
+
+// --------------------------------------------------------
+// One finished scope. Times are nanoseconds since the
+// profiler was created; depth is the nesting level on its
+// thread.
+// --------------------------------------------------------
+struct ProfileEvent
+{
+	const char* Name; //must outlive the profiler, usually a literal
+	long long Begin;
+	long long End;
+	unsigned int Depth;
+};
+
+// --------------------------------------------------------
+// A copy of one thread's recent events, oldest first
+// --------------------------------------------------------
+struct ProfileThreadCapture
+{
+	std::string Name;
+	std::vector<ProfileEvent> Events;
+};
+
+// --------------------------------------------------------
+// Hierarchical CPU profiler. Every thread that opens a
+// scope gets its own ring buffer, written only by that
+// thread without locking; readers copy out what they need
+// and drop anything overwritten while they copied. Has no
+// platform or device dependency.
+// --------------------------------------------------------
+class Profiler
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static Profiler& GetInstance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	Profiler(Profiler const&) = delete;
+	void operator=(Profiler const&) = delete;
+
+private:
+	Profiler();
+#pragma endregion
+
+public:
+	~Profiler();
+
+	//Names the calling thread in captures and traces
+	void SetThreadName(const std::string& name);
+
+	//Marks the start of a frame on the update thread
+	void BeginFrame();
+
+	//Scope recording, normally through PROFILE_SCOPE
+	long long BeginScope();
+	void EndScope(const char* name, long long begin);
+
+	//Nanoseconds since the profiler was created
+	long long Now();
+
+	//Copies every thread's events that ended at or after since
+	void Capture(long long since, std::vector<ProfileThreadCapture>& threads);
+	void GetFrameStarts(std::vector<long long>& frameStarts); //oldest first
+
+	//Writes every buffered event as Chrome trace JSON (chrome://tracing, Perfetto)
+	void ExportChromeTrace(std::ostream& stream);
+
+private:
+	struct EventSlot
+	{
+		std::atomic<const char*> Name;
+		std::atomic<long long> Begin;
+		std::atomic<long long> End;
+		std::atomic<unsigned int> Depth;
+	};
+
+	struct ThreadBuffer
+	{
+		std::string Name;
+		std::unique_ptr<EventSlot[]> Events;
+		std::atomic<unsigned long long> Written; //total events ever written
+		unsigned int Depth; //only touched by the owning thread
+	};
+
+	std::chrono::steady_clock::time_point start;
+
+	//thread buffers are created once per thread and never freed
+	std::mutex threadsMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+	std::mutex framesMutex;
+	long long frameStarts[PROFILER_FRAME_HISTORY];
+	unsigned long long frameCount;
+
+	ThreadBuffer* GetThreadBuffer();
+};
+
+// --------------------------------------------------------
+// Times the enclosing block
+// --------------------------------------------------------
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name) : name(name) { begin = Profiler::GetInstance().BeginScope(); }
+	~ProfileScope() { Profiler::GetInstance().EndScope(name, begin); }
+
+private:
+	const char* name;
+	long long begin;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
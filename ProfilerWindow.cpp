@@ -0,0 +1,192 @@
+#include "ProfilerWindow.h"
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include "ImGui/imgui.h"
+
+// Height of one nesting level in a lane, in pixels
+#define PROFILER_ROW_HEIGHT 18.0f
+
+ProfilerWindow::ProfilerWindow(const std::string& tracePath, std::shared_ptr<TimingStats> timingStats)
+{
+	this->tracePath = tracePath;
+	this->timingStats = timingStats;
+	paused = false;
+	windowMs = 50.0f;
+	captureEnd = 0;
+}
+
+ProfilerWindow::~ProfilerWindow() {}
+
+void ProfilerWindow::Draw()
+{
+	Profiler& profiler = Profiler::GetInstance();
+
+	ImGui::Begin("Profiler");
+
+	ImGui::Checkbox("Pause", &paused);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200.0f);
+	ImGui::SliderFloat("Window (ms)", &windowMs, 5.0f, 500.0f, "%.0f");
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace"))
+	{
+		std::ofstream trace(tracePath);
+		profiler.ExportChromeTrace(trace);
+	}
+
+	long long windowNs = (long long)(windowMs * 1000000.0f);
+	if (!paused)
+	{
+		captureEnd = profiler.Now();
+		profiler.Capture(captureEnd - windowNs, captures);
+		profiler.GetFrameStarts(frameStarts);
+	}
+
+	DrawTimeline(captureEnd - windowNs, windowNs);
+	DrawTotals();
+	DrawTimingStats();
+
+	ImGui::End();
+}
+
+void ProfilerWindow::DrawTimeline(long long windowStart, long long windowNs)
+{
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	float width = ImGui::GetContentRegionAvail().x;
+	ImVec2 mouse = ImGui::GetIO().MousePos;
+
+	for (ProfileThreadCapture& thread : captures)
+	{
+		if (thread.Events.empty())
+			continue;
+
+		unsigned int depthCount = 0;
+		for (ProfileEvent& event : thread.Events)
+		{
+			depthCount = std::max(depthCount, event.Depth + 1);
+		}
+
+		ImGui::TextUnformatted(thread.Name.empty() ? "Thread" : thread.Name.c_str());
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		float laneHeight = depthCount * PROFILER_ROW_HEIGHT;
+		drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + laneHeight), IM_COL32(30, 30, 30, 255));
+
+		for (ProfileEvent& event : thread.Events)
+		{
+			float x0 = origin.x + width * (float)(event.Begin - windowStart) / windowNs;
+			float x1 = origin.x + width * (float)(event.End - windowStart) / windowNs;
+			x0 = std::max(x0, origin.x);
+			x1 = std::max(x1, x0 + 1.0f);
+			float y0 = origin.y + event.Depth * PROFILER_ROW_HEIGHT;
+			float y1 = y0 + PROFILER_ROW_HEIGHT - 1.0f;
+
+			//same scope, same colour every frame
+			size_t hash = std::hash<std::string>()(event.Name);
+			ImU32 color = ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.7f);
+			drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), color);
+
+			float ms = (event.End - event.Begin) / 1000000.0f;
+			if (x1 - x0 > 40.0f)
+			{
+				drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+				drawList->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(255, 255, 255, 255), event.Name);
+				drawList->PopClipRect();
+			}
+
+			if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1)
+			{
+				ImGui::SetTooltip("%s: %.3f ms", event.Name, ms);
+			}
+		}
+
+		//frame boundaries from the update thread
+		for (long long frameStart : frameStarts)
+		{
+			if (frameStart < windowStart)
+				continue;
+			float x = origin.x + width * (float)(frameStart - windowStart) / windowNs;
+			drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, origin.y + laneHeight), IM_COL32(255, 255, 0, 160));
+		}
+
+		ImGui::Dummy(ImVec2(width, laneHeight));
+	}
+}
+
+void ProfilerWindow::DrawTotals()
+{
+	struct ScopeTotal
+	{
+		const char* Name;
+		unsigned int Calls;
+		long long Time;
+	};
+
+	//summed by name across every thread in the window
+	std::unordered_map<std::string, ScopeTotal> totals;
+	for (ProfileThreadCapture& thread : captures)
+	{
+		for (ProfileEvent& event : thread.Events)
+		{
+			ScopeTotal& total = totals.emplace(event.Name, ScopeTotal{ event.Name, 0, 0 }).first->second;
+			total.Calls++;
+			total.Time += event.End - event.Begin;
+		}
+	}
+
+	std::vector<ScopeTotal> sorted;
+	for (auto& t : totals) { sorted.push_back(t.second); }
+	std::sort(sorted.begin(), sorted.end(), [](const ScopeTotal& a, const ScopeTotal& b) { return a.Time > b.Time; });
+
+	if (ImGui::BeginTable("Scope totals", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Total (ms)");
+		ImGui::TableHeadersRow();
+
+		for (ScopeTotal& total : sorted)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(total.Name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", total.Calls);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", total.Time / 1000000.0);
+		}
+		ImGui::EndTable();
+	}
+}
+
+void ProfilerWindow::DrawTimingStats()
+{
+	if (!ImGui::CollapsingHeader("Timings (ms)", ImGuiTreeNodeFlags_DefaultOpen))
+		return;
+
+	timingStats->GetSeriesNames(seriesNames);
+	if (ImGui::BeginTable("Timing series", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		const char* headers[] = { "Series", "Min", "Avg", "Max", "P50", "P95", "P99" };
+		for (const char* header : headers) { ImGui::TableSetupColumn(header); }
+		ImGui::TableHeadersRow();
+
+		for (std::string& name : seriesNames)
+		{
+			TimingSummary summary = {};
+			if (!timingStats->GetSummary(name, &summary))
+				continue;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(name.c_str());
+			float values[] = { summary.Min, summary.Average, summary.Max, summary.P50, summary.P95, summary.P99 };
+			for (float value : values)
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", value);
+			}
+		}
+		ImGui::EndTable();
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Profiler.h"
+#include "TimingStats.h"
+
+// --------------------------------------------------------
+// ImGui view of the profiler: a rolling timeline with one
+// lane per thread, nested scopes stacked below their
+// parents, frame starts marked, and the scopes that took
+// the most time in the window listed underneath, then the
+// CPU and GPU timing series
+// --------------------------------------------------------
+class ProfilerWindow
+{
+public:
+	ProfilerWindow(const std::string& tracePath, std::shared_ptr<TimingStats> timingStats);
+	~ProfilerWindow();
+
+	void Draw();
+
+private:
+	std::string tracePath; //where Export writes the Chrome trace
+	std::shared_ptr<TimingStats> timingStats;
+	std::vector<std::string> seriesNames;
+	bool paused;
+	float windowMs;
+
+	//last capture, kept while paused
+	long long captureEnd;
+	std::vector<ProfileThreadCapture> captures;
+	std::vector<long long> frameStarts;
+
+	void DrawTimeline(long long windowStart, long long windowNs);
+	void DrawTotals();
+	void DrawTimingStats();
+};
@@ -0,0 +1,37 @@
+#include "RecordingPlan.h"
+
+void RecordingPlan::AddPassJobs(unsigned int pass, const RenderItem* items, unsigned int firstItem, unsigned int count,
+	unsigned int maxJobs, unsigned int minItemsPerJob, std::vector<RecordingJob>& jobs)
+{
+	//everything above the depth bits is draw state
+	const unsigned long long stateMask = ~0xFFFFull;
+
+	//spread the items evenly, without going under the minimum
+	unsigned int jobCount = maxJobs > 0 ? maxJobs : 1;
+	unsigned int target = (count + jobCount - 1) / jobCount;
+	if (target < minItemsPerJob)
+		target = minItemsPerJob;
+	if (target == 0)
+		target = 1;
+
+	unsigned int end = firstItem + count;
+	unsigned int start = firstItem;
+	do
+	{
+		//push the split forward past the end of the current state run,
+		//which can only make jobs longer, so maxJobs still holds
+		unsigned int split = end - start > target ? start + target : end;
+		while (split < end && (items[split].Key & stateMask) == (items[split - 1].Key & stateMask))
+		{
+			split++;
+		}
+
+		RecordingJob job = {};
+		job.Pass = pass;
+		job.FirstItem = start;
+		job.ItemCount = split - start;
+		jobs.push_back(job);
+
+		start = split;
+	} while (start < end);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include "RenderQueue.h"
+
+// --------------------------------------------------------
+// A range of one pass's sorted queue items, recorded into
+// its own command list
+// --------------------------------------------------------
+struct RecordingJob
+{
+	unsigned int Pass;
+	unsigned int FirstItem;	// Index into the whole queue
+	unsigned int ItemCount;
+};
+
+// --------------------------------------------------------
+// Splits render queue passes into recording jobs. Has no
+// device dependency.
+// --------------------------------------------------------
+class RecordingPlan
+{
+public:
+	//Appends at most maxJobs jobs covering count items starting at firstItem,
+	//each at least minItemsPerJob long. Jobs only split where shader,
+	//material or mesh change, so no instanced batch is cut in two.
+	//An empty pass still gets one job, it may have targets to clear.
+	static void AddPassJobs(unsigned int pass, const RenderItem* items, unsigned int firstItem, unsigned int count,
+		unsigned int maxJobs, unsigned int minItemsPerJob, std::vector<RecordingJob>& jobs);
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+
+// Resources are referred to by handle; 0 is never a valid one
+typedef unsigned int RenderHandle;
+#define RENDER_HANDLE_NULL 0
+
+enum RenderBufferType
+{
+	RenderBufferVertex,
+	RenderBufferIndex,
+	RenderBufferConstant
+};
+
+enum RenderShaderStage
+{
+	RenderStageVertex,
+	RenderStagePixel,
+	RenderStageCount
+};
+
+// Formats the scene actually uses
+enum RenderFormat
+{
+	RenderFormatRGBA8,
+	RenderFormatDepth24Stencil8,
+	RenderFormatR32Typeless //shadow maps, sampled as R32 and written as D32
+};
+
+struct RenderBufferDesc
+{
+	RenderBufferType Type;
+	unsigned int Size;	// Bytes
+	bool Dynamic;		// Rewritten by the CPU, through UpdateBuffer
+};
+
+struct RenderTextureDesc
+{
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int MipLevels;
+	RenderFormat Format;
+	bool RenderTarget;	// Colour or depth target, by format
+	bool ShaderResource;
+};
+
+// --------------------------------------------------------
+// Per frame counters every backend keeps, reset by
+// BeginFrame
+// --------------------------------------------------------
+struct RenderBackendStats
+{
+	unsigned int DrawCalls;
+	unsigned int Instances;
+	unsigned int BytesUploaded;
+	unsigned int StateChanges;	// Binds that changed what was bound
+	unsigned int RedundantBinds;	// Binds of what was already bound
+};
+
+// --------------------------------------------------------
+// Thin interface over a graphics API: buffers, textures,
+// shaders, bindings and draw submission, with everything
+// referred to by handle so callers need no API headers.
+// Bindings are filtered the same way in every backend, so
+// stats compare across them. NullRenderBackend is the only
+// backend, fed by RenderQueueSubmitter. Game's D3D11 frames
+// don't go through it: RecordJob, DrawShadowCasters and
+// DrawOpaqueEntities record through SimpleShader and the
+// command recorder, and Mesh, Material, Sky and DXCore call
+// D3D11 directly.
+// --------------------------------------------------------
+class IRenderBackend
+{
+public:
+	virtual ~IRenderBackend() {}
+
+	//Resources; initialData may be null
+	virtual RenderHandle CreateBuffer(const RenderBufferDesc& desc, const void* initialData) = 0;
+	virtual RenderHandle CreateTexture(const RenderTextureDesc& desc, const void* initialData) = 0;
+	virtual RenderHandle CreateShader(RenderShaderStage stage, const void* bytecode, size_t bytecodeSize) = 0;
+	virtual RenderHandle CreateSampler(bool comparison) = 0; //comparison samplers are for shadow maps
+	virtual void DestroyResource(RenderHandle handle) = 0;
+	virtual void UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size) = 0;
+
+	//State
+	virtual void SetShader(RenderShaderStage stage, RenderHandle shader) = 0;
+	virtual void SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride) = 0;
+	virtual void SetIndexBuffer(RenderHandle buffer) = 0;
+	virtual void SetConstantBuffer(RenderShaderStage stage, unsigned int slot, RenderHandle buffer) = 0;
+	virtual void SetTexture(RenderShaderStage stage, unsigned int slot, RenderHandle texture) = 0;
+	virtual void SetSampler(RenderShaderStage stage, unsigned int slot, RenderHandle sampler) = 0;
+	virtual void SetRenderTarget(RenderHandle color, RenderHandle depth) = 0;
+	virtual void SetViewport(float width, float height) = 0;
+
+	//Draws
+	virtual void ClearDepth(RenderHandle depth) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+
+	//Frame boundaries, which forget bindings and reset the stats
+	virtual void BeginFrame() = 0;
+	virtual void EndFrame() = 0;
+	virtual RenderBackendStats GetFrameStats() = 0;
+};
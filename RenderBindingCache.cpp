@@ -0,0 +1,169 @@
+#include "RenderBindingCache.h"
+
+RenderBindingCache::RenderBindingCache()
+{
+	Reset();
+}
+
+RenderBindingCache::~RenderBindingCache() {}
+
+void RenderBindingCache::Reset()
+{
+	for (unsigned int stage = 0; stage < RenderStageCount; stage++)
+	{
+		shaders[stage] = RENDER_HANDLE_NULL;
+		for (unsigned int slot = 0; slot < RENDER_BINDING_SLOTS; slot++)
+		{
+			constantBuffers[stage][slot] = RENDER_HANDLE_NULL;
+			textures[stage][slot] = RENDER_HANDLE_NULL;
+			samplers[stage][slot] = RENDER_HANDLE_NULL;
+		}
+	}
+	for (unsigned int slot = 0; slot < RENDER_BINDING_SLOTS; slot++)
+	{
+		vertexBuffers[slot] = RENDER_HANDLE_NULL;
+	}
+	indexBuffer = RENDER_HANDLE_NULL;
+	colorTarget = RENDER_HANDLE_NULL;
+	depthTarget = RENDER_HANDLE_NULL;
+
+	//no viewport matches these, so the first one always binds
+	viewportWidth = -1.0f;
+	viewportHeight = -1.0f;
+
+	stats = {};
+}
+
+bool RenderBindingCache::BindShader(RenderShaderStage stage, RenderHandle shader)
+{
+	return Change(shaders[stage], shader);
+}
+
+bool RenderBindingCache::BindVertexBuffer(unsigned int slot, RenderHandle buffer)
+{
+	if (slot >= RENDER_BINDING_SLOTS)
+	{
+		stats.StateChanges++;
+		return true;
+	}
+	return Change(vertexBuffers[slot], buffer);
+}
+
+bool RenderBindingCache::BindIndexBuffer(RenderHandle buffer)
+{
+	return Change(indexBuffer, buffer);
+}
+
+bool RenderBindingCache::BindConstantBuffer(RenderShaderStage stage, unsigned int slot, RenderHandle buffer)
+{
+	if (slot >= RENDER_BINDING_SLOTS)
+	{
+		stats.StateChanges++;
+		return true;
+	}
+	return Change(constantBuffers[stage][slot], buffer);
+}
+
+bool RenderBindingCache::BindTexture(RenderShaderStage stage, unsigned int slot, RenderHandle texture)
+{
+	if (slot >= RENDER_BINDING_SLOTS)
+	{
+		stats.StateChanges++;
+		return true;
+	}
+	return Change(textures[stage][slot], texture);
+}
+
+bool RenderBindingCache::BindSampler(RenderShaderStage stage, unsigned int slot, RenderHandle sampler)
+{
+	if (slot >= RENDER_BINDING_SLOTS)
+	{
+		stats.StateChanges++;
+		return true;
+	}
+	return Change(samplers[stage][slot], sampler);
+}
+
+bool RenderBindingCache::BindRenderTarget(RenderHandle color, RenderHandle depth)
+{
+	if (colorTarget == color && depthTarget == depth)
+	{
+		stats.RedundantBinds++;
+		return false;
+	}
+
+	colorTarget = color;
+	depthTarget = depth;
+	stats.StateChanges++;
+	return true;
+}
+
+bool RenderBindingCache::BindViewport(float width, float height)
+{
+	if (viewportWidth == width && viewportHeight == height)
+	{
+		stats.RedundantBinds++;
+		return false;
+	}
+
+	viewportWidth = width;
+	viewportHeight = height;
+	stats.StateChanges++;
+	return true;
+}
+
+void RenderBindingCache::Unbind(RenderHandle handle)
+{
+	RenderHandle* all[] = { &indexBuffer, &colorTarget, &depthTarget };
+	for (RenderHandle* bound : all)
+	{
+		if (*bound == handle)
+			*bound = RENDER_HANDLE_NULL;
+	}
+
+	for (unsigned int stage = 0; stage < RenderStageCount; stage++)
+	{
+		if (shaders[stage] == handle)
+			shaders[stage] = RENDER_HANDLE_NULL;
+
+		for (unsigned int slot = 0; slot < RENDER_BINDING_SLOTS; slot++)
+		{
+			if (constantBuffers[stage][slot] == handle)
+				constantBuffers[stage][slot] = RENDER_HANDLE_NULL;
+			if (textures[stage][slot] == handle)
+				textures[stage][slot] = RENDER_HANDLE_NULL;
+			if (samplers[stage][slot] == handle)
+				samplers[stage][slot] = RENDER_HANDLE_NULL;
+		}
+	}
+
+	for (unsigned int slot = 0; slot < RENDER_BINDING_SLOTS; slot++)
+	{
+		if (vertexBuffers[slot] == handle)
+			vertexBuffers[slot] = RENDER_HANDLE_NULL;
+	}
+}
+
+void RenderBindingCache::CountDraw(unsigned int instances)
+{
+	stats.DrawCalls++;
+	stats.Instances += instances;
+}
+
+void RenderBindingCache::CountUpload(unsigned int bytes)
+{
+	stats.BytesUploaded += bytes;
+}
+
+bool RenderBindingCache::Change(RenderHandle& bound, RenderHandle handle)
+{
+	if (bound == handle)
+	{
+		stats.RedundantBinds++;
+		return false;
+	}
+
+	bound = handle;
+	stats.StateChanges++;
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Slots tracked per stage, binds past these always go through
+#define RENDER_BINDING_SLOTS 16
+
+// --------------------------------------------------------
+// What a backend has bound, so binding the same thing again
+// can be skipped, and the per frame counters every backend
+// reports. Shared by the backends so their numbers match.
+// --------------------------------------------------------
+class RenderBindingCache
+{
+public:
+	RenderBindingCache();
+	~RenderBindingCache();
+
+	//Forgets every binding and zeroes the stats
+	void Reset();
+
+	//True when the bind changes what is bound; counted either way
+	bool BindShader(RenderShaderStage stage, RenderHandle shader);
+	bool BindVertexBuffer(unsigned int slot, RenderHandle buffer);
+	bool BindIndexBuffer(RenderHandle buffer);
+	bool BindConstantBuffer(RenderShaderStage stage, unsigned int slot, RenderHandle buffer);
+	bool BindTexture(RenderShaderStage stage, unsigned int slot, RenderHandle texture);
+	bool BindSampler(RenderShaderStage stage, unsigned int slot, RenderHandle sampler);
+	bool BindRenderTarget(RenderHandle color, RenderHandle depth);
+	bool BindViewport(float width, float height);
+
+	//A destroyed resource must not count as still bound
+	void Unbind(RenderHandle handle);
+
+	void CountDraw(unsigned int instances);
+	void CountUpload(unsigned int bytes);
+	RenderBackendStats GetStats() { return stats; }
+
+private:
+	RenderHandle shaders[RenderStageCount];
+	RenderHandle vertexBuffers[RENDER_BINDING_SLOTS];
+	RenderHandle indexBuffer;
+	RenderHandle constantBuffers[RenderStageCount][RENDER_BINDING_SLOTS];
+	RenderHandle textures[RenderStageCount][RENDER_BINDING_SLOTS];
+	RenderHandle samplers[RenderStageCount][RENDER_BINDING_SLOTS];
+	RenderHandle colorTarget;
+	RenderHandle depthTarget;
+	float viewportWidth;
+	float viewportHeight;
+
+	RenderBackendStats stats;
+
+	bool Change(RenderHandle& bound, RenderHandle handle);
+};
@@ -0,0 +1,108 @@
+#include "RenderQueue.h"
+
+RenderQueue::RenderQueue()
+{
+	Clear();
+}
+
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	stats = {};
+	clampedCount = 0;
+	for (unsigned int p = 0; p <= RENDER_PASS_COUNT; p++)
+	{
+		passStart[p] = 0;
+	}
+}
+
+void RenderQueue::Add(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth, unsigned int entityIndex)
+{
+	if (shader > RENDER_KEY_MAX_SHADER || material > RENDER_KEY_MAX_MATERIAL || mesh > RENDER_KEY_MAX_MESH)
+		clampedCount++;
+
+	items.push_back({ MakeKey(pass, shader, material, mesh, depth), entityIndex });
+}
+
+unsigned long long RenderQueue::MakeKey(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth)
+{
+	//depth is expected in [0,1], front to back
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	unsigned long long quantizedDepth = (unsigned long long)(depth * 65535.0f);
+
+	//an id too large would wrap into another id's key, clamping keeps it past them all
+	shader = shader > RENDER_KEY_MAX_SHADER ? RENDER_KEY_MAX_SHADER : shader;
+	material = material > RENDER_KEY_MAX_MATERIAL ? RENDER_KEY_MAX_MATERIAL : material;
+	mesh = mesh > RENDER_KEY_MAX_MESH ? RENDER_KEY_MAX_MESH : mesh;
+
+	return ((unsigned long long)(pass & 0xF) << 60) |
+		((unsigned long long)shader << 48) |
+		((unsigned long long)material << 32) |
+		((unsigned long long)mesh << 16) |
+		quantizedDepth;
+}
+
+void RenderQueue::Sort()
+{
+	unsigned int count = (unsigned int)items.size();
+	scratch.resize(count);
+
+	//LSD radix sort, one byte of the key per pass
+	RenderItem* src = items.data();
+	RenderItem* dst = scratch.data();
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned int histogram[256] = {};
+		for (unsigned int i = 0; i < count; i++)
+		{
+			histogram[(src[i].Key >> shift) & 0xFF]++;
+		}
+
+		//every key shares this byte, nothing to reorder
+		if (count == 0 || histogram[(src[0].Key >> shift) & 0xFF] == count)
+			continue;
+
+		unsigned int offset = 0;
+		for (unsigned int b = 0; b < 256; b++)
+		{
+			unsigned int bucketSize = histogram[b];
+			histogram[b] = offset;
+			offset += bucketSize;
+		}
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			dst[histogram[(src[i].Key >> shift) & 0xFF]++] = src[i];
+		}
+
+		RenderItem* temp = src;
+		src = dst;
+		dst = temp;
+	}
+
+	//make sure the result ends up in items
+	if (src != items.data())
+	{
+		items.swap(scratch);
+	}
+
+	//find where each pass begins
+	unsigned int i = 0;
+	for (unsigned int p = 0; p < RENDER_PASS_COUNT; p++)
+	{
+		passStart[p] = i;
+		while (i < count && GetPass(items[i].Key) == p)
+		{
+			i++;
+		}
+	}
+	passStart[RENDER_PASS_COUNT] = count;
+}
+
+const RenderItem* RenderQueue::GetPassItems(unsigned int pass, unsigned int* count)
+{
+	*count = passStart[pass + 1] - passStart[pass];
+	return items.data() + passStart[pass];
+}
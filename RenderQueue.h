@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+// Passes in the order they are rendered each frame
+#define RENDER_PASS_SHADOW_0 0
+#define RENDER_PASS_SHADOW_1 1
+#define RENDER_PASS_SHADOW_2 2
+#define RENDER_PASS_OPAQUE 3
+#define RENDER_PASS_COUNT 4
+
+// Largest id each key field holds; larger ids are clamped and counted
+#define RENDER_KEY_MAX_SHADER 0xFFF
+#define RENDER_KEY_MAX_MATERIAL 0xFFFF
+#define RENDER_KEY_MAX_MESH 0xFFFF
+
+// --------------------------------------------------------
+// A single draw waiting in the queue. The key packs, from
+// most to least significant bits:
+//   pass (4) | shader (12) | material (16) | mesh (16) | depth (16)
+// so sorting by key groups draws by pass, then state.
+// --------------------------------------------------------
+struct RenderItem
+{
+	unsigned long long Key;
+	unsigned int EntityIndex;	// Dense index into the entity registry
+};
+
+// --------------------------------------------------------
+// Per frame counters of state changes the draw loops issue
+// --------------------------------------------------------
+struct RenderStats
+{
+	unsigned int DrawCalls;
+	unsigned int ShaderBinds;
+	unsigned int SRVBinds;
+	unsigned int SamplerBinds;
+	unsigned int MeshBinds;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void Clear();
+	void Add(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth, unsigned int entityIndex);
+	void Sort();
+
+	//Items of one pass, valid after Sort()
+	const RenderItem* GetPassItems(unsigned int pass, unsigned int* count);
+	unsigned int GetPassStart(unsigned int pass) { return passStart[pass]; }
+	const RenderItem* GetItems() { return items.data(); }
+	unsigned int GetCount() { return (unsigned int)items.size(); }
+
+	//Items added since Clear() with an id too large for its key field; they sort
+	//with the largest id in the field, so any is a bug in the caller
+	unsigned int GetClampedCount() { return clampedCount; }
+
+	//Key field helpers
+	static unsigned long long MakeKey(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth);
+	static unsigned int GetPass(unsigned long long key) { return (unsigned int)(key >> 60) & 0xF; }
+	static unsigned int GetShader(unsigned long long key) { return (unsigned int)(key >> 48) & 0xFFF; }
+	static unsigned int GetMaterial(unsigned long long key) { return (unsigned int)(key >> 32) & 0xFFFF; }
+	static unsigned int GetMesh(unsigned long long key) { return (unsigned int)(key >> 16) & 0xFFFF; }
+
+	//Stats for the frame being recorded, reset by Clear()
+	RenderStats& GetStats() { return stats; }
+
+private:
+	std::vector<RenderItem> items;
+	std::vector<RenderItem> scratch; //radix sort ping-pong buffer
+	unsigned int passStart[RENDER_PASS_COUNT + 1];
+	RenderStats stats;
+	unsigned int clampedCount;
+};
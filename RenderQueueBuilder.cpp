@@ -0,0 +1,68 @@
+#include "RenderQueueBuilder.h"
+#include "EntityRegistry.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+RenderQueueBuilder::RenderQueueBuilder(std::shared_ptr<JobSystem> jobSystem)
+{
+	this->jobSystem = jobSystem;
+	visibleCount = 0;
+}
+
+RenderQueueBuilder::~RenderQueueBuilder() {}
+
+void RenderQueueBuilder::Build(const RenderQueueScene& scene, RenderQueue& queue)
+{
+	PROFILE_SCOPE("Build render queue");
+	queue.Clear();
+
+	unsigned int entityCount = scene.EntityCount;
+	const unsigned int* flags = scene.Flags;
+	const BoundingBox* bounds = scene.WorldBounds;
+
+	//shadow casters go in every shadow pass, the lights see the whole scene
+	for (unsigned int i : EntityView(flags, entityCount, ENTITY_FLAG_CASTS_SHADOW))
+	{
+		queue.Add(RENDER_PASS_SHADOW_0, 0, 0, scene.Meshes[i], 0.0f, i);
+		queue.Add(RENDER_PASS_SHADOW_1, 0, 0, scene.Meshes[i], 0.0f, i);
+		queue.Add(RENDER_PASS_SHADOW_2, 0, 0, scene.Meshes[i], 0.0f, i);
+	}
+
+	//camera frustum in world space for culling
+	XMMATRIX view = XMLoadFloat4x4(&scene.View);
+	BoundingFrustum cameraFrustum(XMLoadFloat4x4(&scene.Projection));
+	cameraFrustum.Transform(cameraFrustum, XMMatrixInverse(0, view));
+	float farClip = scene.FarClip;
+
+	//cull in parallel, recording each visible entity's view depth
+	cullVisible.resize(entityCount);
+	cullDepths.resize(entityCount);
+	JobCounter culled;
+	jobSystem->ParallelFor(entityCount, 256, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			cullVisible[i] = (flags[i] & ENTITY_FLAG_VISIBLE) && cameraFrustum.Intersects(bounds[i]);
+			if (cullVisible[i])
+			{
+				cullDepths[i] = XMVectorGetZ(XMVector3Transform(XMLoadFloat3(&bounds[i].Center), view)) / farClip;
+			}
+		}
+	}, &culled);
+	jobSystem->Wait(&culled);
+
+	//visible entities sorted by shader, material, mesh then front to back
+	visibleCount = 0;
+	for (unsigned int i : EntityView(flags, entityCount, ENTITY_FLAG_VISIBLE))
+	{
+		if (!cullVisible[i])
+			continue;
+
+		const RenderQueueMaterial& key = scene.MaterialKeys[scene.Materials[i]];
+		queue.Add(RENDER_PASS_OPAQUE, key.Shader, key.Material, scene.Meshes[i], cullDepths[i], i);
+		visibleCount++;
+	}
+
+	queue.Sort();
+}
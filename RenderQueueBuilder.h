@@ -0,0 +1,63 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <memory>
+#include <vector>
+#include "RenderQueue.h"
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// How a material's draws sort: its shader pair and its own
+// id, or for materials in the material table, the table's
+// shader and 0, since they share one set of bindings
+// --------------------------------------------------------
+struct RenderQueueMaterial
+{
+	unsigned int Shader;
+	unsigned int Material;
+};
+
+// --------------------------------------------------------
+// One frame's entities (dense arrays, as the entity
+// registry keeps them) and the camera they're culled to
+// --------------------------------------------------------
+struct RenderQueueScene
+{
+	unsigned int EntityCount;
+	const unsigned int* Flags;
+	const unsigned int* Meshes;
+	const unsigned int* Materials;
+	const DirectX::BoundingBox* WorldBounds;
+	const RenderQueueMaterial* MaterialKeys;	// Indexed by material id
+
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	float FarClip;
+};
+
+// --------------------------------------------------------
+// Fills a render queue with a frame's draws: every shadow
+// caster in each shadow pass, and every visible entity the
+// camera frustum touches in the opaque pass, with its view
+// depth for front to back order. Culls on the job system.
+// --------------------------------------------------------
+class RenderQueueBuilder
+{
+public:
+	RenderQueueBuilder(std::shared_ptr<JobSystem> jobSystem);
+	~RenderQueueBuilder();
+
+	//Clears the queue, adds the frame's draws and sorts it
+	void Build(const RenderQueueScene& scene, RenderQueue& queue);
+
+	//Entities the last Build found in the camera frustum
+	unsigned int GetVisibleCount() { return visibleCount; }
+	bool IsVisible(unsigned int entityIndex) { return cullVisible[entityIndex] != 0; }
+
+private:
+	std::shared_ptr<JobSystem> jobSystem;
+	std::vector<unsigned char> cullVisible; //per entity, written by the culling jobs
+	std::vector<float> cullDepths; //per entity view depth, valid if visible
+	unsigned int visibleCount;
+};
@@ -0,0 +1,260 @@
+#include "RenderQueueSubmitter.h"
+#include "Vertex.h"
+#include <climits>
+
+using namespace DirectX;
+
+RenderQueueSubmitter::RenderQueueSubmitter(std::shared_ptr<IRenderBackend> backend)
+{
+	this->backend = backend;
+	shadowVertexShader = RENDER_HANDLE_NULL;
+	shadowInstancedVertexShader = RENDER_HANDLE_NULL;
+	colorTarget = RENDER_HANDLE_NULL;
+	depthTarget = RENDER_HANDLE_NULL;
+	for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+	{
+		shadowMaps[i] = RENDER_HANDLE_NULL;
+	}
+	shadowSampler = RENDER_HANDLE_NULL;
+
+	frameBuffer = backend->CreateBuffer({ RenderBufferConstant, sizeof(FrameConstants), true }, 0);
+	shadowBuffer = backend->CreateBuffer({ RenderBufferConstant, sizeof(ShadowConstants), true }, 0);
+	objectBuffer = backend->CreateBuffer({ RenderBufferConstant, sizeof(InstanceData), true }, 0);
+	pixelBuffer = backend->CreateBuffer({ RenderBufferConstant, sizeof(PixelConstants), true }, 0);
+	instanceBuffer = RENDER_HANDLE_NULL;
+	instanceCapacity = 0;
+}
+
+RenderQueueSubmitter::~RenderQueueSubmitter()
+{
+	backend->DestroyResource(frameBuffer);
+	backend->DestroyResource(shadowBuffer);
+	backend->DestroyResource(objectBuffer);
+	backend->DestroyResource(pixelBuffer);
+	backend->DestroyResource(instanceBuffer);
+}
+
+unsigned int RenderQueueSubmitter::AddMesh(const SubmitMesh& mesh)
+{
+	meshes.push_back(mesh);
+	return (unsigned int)meshes.size() - 1;
+}
+
+unsigned int RenderQueueSubmitter::AddMaterial(const SubmitMaterial& material)
+{
+	materials.push_back(material);
+	return (unsigned int)materials.size() - 1;
+}
+
+unsigned int RenderQueueSubmitter::AddShader(const SubmitShader& shader)
+{
+	shaders.push_back(shader);
+	return (unsigned int)shaders.size() - 1;
+}
+
+void RenderQueueSubmitter::SetShadowShaders(RenderHandle vertexShader, RenderHandle instancedVertexShader)
+{
+	shadowVertexShader = vertexShader;
+	shadowInstancedVertexShader = instancedVertexShader;
+}
+
+void RenderQueueSubmitter::SetTargets(RenderHandle color, RenderHandle depth, const RenderHandle shadowMaps[SUBMIT_SHADOW_MAPS], RenderHandle shadowSampler)
+{
+	colorTarget = color;
+	depthTarget = depth;
+	for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+	{
+		this->shadowMaps[i] = shadowMaps[i];
+	}
+	this->shadowSampler = shadowSampler;
+}
+
+void RenderQueueSubmitter::Submit(RenderQueue& queue, Transform* transforms, const SubmitFrame& frame)
+{
+	if (frame.UseInstancing)
+	{
+		PackInstances(queue, transforms);
+	}
+
+	for (unsigned int pass = RENDER_PASS_SHADOW_0; pass <= RENDER_PASS_SHADOW_2; pass++)
+	{
+		SubmitShadowPass(queue, pass, transforms, frame);
+	}
+	SubmitOpaquePass(queue, transforms, frame);
+}
+
+// --------------------------------------------------------
+// Writes every queued draw's instance data once, in queue
+// order, so batches index it by queue position
+// --------------------------------------------------------
+void RenderQueueSubmitter::PackInstances(RenderQueue& queue, Transform* transforms)
+{
+	unsigned int count = queue.GetCount();
+	if (count == 0)
+		return;
+
+	if (count > instanceCapacity)
+	{
+		backend->DestroyResource(instanceBuffer);
+		instanceCapacity = instanceCapacity ? instanceCapacity : 64;
+		while (instanceCapacity < count)
+		{
+			instanceCapacity *= 2;
+		}
+		instanceBuffer = backend->CreateBuffer({ RenderBufferVertex, instanceCapacity * (unsigned int)sizeof(InstanceData), true }, 0);
+	}
+
+	instances.resize(count);
+	InstanceBatcher::PackInstances(queue.GetItems(), count, transforms, 0, instances.data());
+	backend->UpdateBuffer(instanceBuffer, instances.data(), count * sizeof(InstanceData));
+}
+
+void RenderQueueSubmitter::SubmitShadowPass(RenderQueue& queue, unsigned int pass, Transform* transforms, const SubmitFrame& frame)
+{
+	unsigned int count = 0;
+	const RenderItem* items = queue.GetPassItems(pass, &count);
+	RenderHandle shadowMap = shadowMaps[pass - RENDER_PASS_SHADOW_0];
+
+	//depth only, at the shadow map's resolution
+	backend->SetRenderTarget(RENDER_HANDLE_NULL, shadowMap);
+	backend->ClearDepth(shadowMap);
+	backend->SetViewport((float)frame.ShadowResolution, (float)frame.ShadowResolution);
+	backend->SetShader(RenderStageVertex, frame.UseInstancing ? shadowInstancedVertexShader : shadowVertexShader);
+	backend->SetShader(RenderStagePixel, RENDER_HANDLE_NULL);
+
+	ShadowConstants constants = {};
+	constants.View = frame.ShadowViews[pass - RENDER_PASS_SHADOW_0];
+	constants.Projection = frame.ShadowProjection;
+	backend->UpdateBuffer(shadowBuffer, &constants, sizeof(constants));
+	backend->SetConstantBuffer(RenderStageVertex, 0, shadowBuffer);
+	backend->SetConstantBuffer(RenderStageVertex, 1, objectBuffer);
+
+	if (frame.UseInstancing)
+	{
+		batches.clear();
+		InstanceBatcher::BuildBatches(items, count, queue.GetPassStart(pass), batches);
+		for (InstanceBatch& batch : batches)
+		{
+			BindMesh(batch.Mesh, true);
+			backend->DrawIndexedInstanced(meshes[batch.Mesh].IndexCount, batch.InstanceCount, 0, 0, batch.FirstInstance);
+		}
+		return;
+	}
+
+	for (unsigned int d = 0; d < count; d++)
+	{
+		DrawObject(RenderQueue::GetMesh(items[d].Key), transforms[items[d].EntityIndex]);
+	}
+}
+
+void RenderQueueSubmitter::SubmitOpaquePass(RenderQueue& queue, Transform* transforms, const SubmitFrame& frame)
+{
+	unsigned int count = 0;
+	const RenderItem* items = queue.GetPassItems(RENDER_PASS_OPAQUE, &count);
+
+	backend->SetRenderTarget(colorTarget, depthTarget);
+	backend->SetViewport((float)frame.Width, (float)frame.Height);
+
+	//camera and shadow matrices are the same for every shader
+	FrameConstants frameConstants = {};
+	frameConstants.View = frame.View;
+	frameConstants.Projection = frame.Projection;
+	for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+	{
+		frameConstants.ShadowViews[i] = frame.ShadowViews[i];
+	}
+	frameConstants.ShadowProjection = frame.ShadowProjection;
+	backend->UpdateBuffer(frameBuffer, &frameConstants, sizeof(frameConstants));
+	backend->SetConstantBuffer(RenderStageVertex, 0, frameBuffer);
+	backend->SetConstantBuffer(RenderStageVertex, 1, objectBuffer);
+	backend->SetConstantBuffer(RenderStagePixel, 0, pixelBuffer);
+
+	//shadow maps follow the material textures
+	for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+	{
+		backend->SetTexture(RenderStagePixel, SUBMIT_MATERIAL_TEXTURES + i, shadowMaps[i]);
+	}
+	backend->SetSampler(RenderStagePixel, 1, shadowSampler);
+
+	//lights and camera go with each material's tint
+	PixelConstants pixelConstants = {};
+	pixelConstants.CameraPosition = frame.CameraPosition;
+	pixelConstants.AmbientColor = frame.AmbientColor;
+	pixelConstants.LightCount = frame.LightCount < MAX_LIGHTS ? frame.LightCount : MAX_LIGHTS;
+	for (int i = 0; i < pixelConstants.LightCount; i++)
+	{
+		pixelConstants.Lights[i] = frame.Lights[i];
+	}
+
+	unsigned int boundShader = UINT_MAX;
+	unsigned int boundMaterial = UINT_MAX;
+
+	if (frame.UseInstancing)
+	{
+		batches.clear();
+		InstanceBatcher::BuildBatches(items, count, queue.GetPassStart(RENDER_PASS_OPAQUE), batches);
+	}
+	unsigned int drawCount = frame.UseInstancing ? (unsigned int)batches.size() : count;
+
+	for (unsigned int d = 0; d < drawCount; d++)
+	{
+		unsigned int shaderId = frame.UseInstancing ? batches[d].Shader : RenderQueue::GetShader(items[d].Key);
+		unsigned int materialId = frame.UseInstancing ? batches[d].Material : RenderQueue::GetMaterial(items[d].Key);
+		unsigned int meshId = frame.UseInstancing ? batches[d].Mesh : RenderQueue::GetMesh(items[d].Key);
+
+		if (shaderId != boundShader)
+		{
+			SubmitShader& shader = shaders[shaderId];
+			backend->SetShader(RenderStageVertex, frame.UseInstancing ? shader.InstancedVertexShader : shader.VertexShader);
+			backend->SetShader(RenderStagePixel, shader.PixelShader);
+			boundShader = shaderId;
+		}
+
+		if (materialId != boundMaterial)
+		{
+			SubmitMaterial& material = materials[materialId];
+			pixelConstants.ColorTint = material.ColorTint;
+			backend->UpdateBuffer(pixelBuffer, &pixelConstants, sizeof(pixelConstants));
+			for (unsigned int t = 0; t < material.TextureCount; t++)
+			{
+				backend->SetTexture(RenderStagePixel, t, material.Textures[t]);
+			}
+			backend->SetSampler(RenderStagePixel, 0, material.Sampler);
+			boundMaterial = materialId;
+		}
+
+		if (frame.UseInstancing)
+		{
+			BindMesh(meshId, true);
+			backend->DrawIndexedInstanced(meshes[meshId].IndexCount, batches[d].InstanceCount, 0, 0, batches[d].FirstInstance);
+		}
+		else
+		{
+			DrawObject(meshId, transforms[items[d].EntityIndex]);
+		}
+	}
+}
+
+void RenderQueueSubmitter::BindMesh(unsigned int mesh, bool instanced)
+{
+	backend->SetVertexBuffer(0, meshes[mesh].VertexBuffer, sizeof(Vertex));
+	backend->SetIndexBuffer(meshes[mesh].IndexBuffer);
+	if (instanced)
+	{
+		backend->SetVertexBuffer(1, instanceBuffer, sizeof(InstanceData));
+	}
+}
+
+// --------------------------------------------------------
+// One non instanced draw, with its own per object upload
+// --------------------------------------------------------
+void RenderQueueSubmitter::DrawObject(unsigned int mesh, Transform& transform)
+{
+	InstanceData object = {};
+	object.World = transform.GetWorldMatrix();
+	object.WorldInvTranspose = transform.GetWorldInverseTransposeMatrix();
+	backend->UpdateBuffer(objectBuffer, &object, sizeof(object));
+
+	BindMesh(mesh, false);
+	backend->DrawIndexed(meshes[mesh].IndexCount, 0, 0);
+}
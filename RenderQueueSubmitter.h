@@ -0,0 +1,139 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <memory>
+#include <vector>
+#include "RenderBackend.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "Transform.h"
+#include "Lights.h"
+
+// Texture slots of the main pixel shader, materials use the first ones
+#define SUBMIT_MATERIAL_TEXTURES 3
+#define SUBMIT_SHADOW_MAPS 3
+
+struct SubmitMesh
+{
+	RenderHandle VertexBuffer;
+	RenderHandle IndexBuffer;
+	unsigned int IndexCount;
+};
+
+struct SubmitMaterial
+{
+	RenderHandle Textures[SUBMIT_MATERIAL_TEXTURES];
+	unsigned int TextureCount;
+	RenderHandle Sampler;
+	DirectX::XMFLOAT3 ColorTint;
+};
+
+// Vertex shaders for plain and instanced draws, sharing a pixel shader
+struct SubmitShader
+{
+	RenderHandle VertexShader;
+	RenderHandle InstancedVertexShader;
+	RenderHandle PixelShader;
+};
+
+// --------------------------------------------------------
+// Camera, lights and targets for one frame of submission
+// --------------------------------------------------------
+struct SubmitFrame
+{
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT4X4 ShadowViews[SUBMIT_SHADOW_MAPS];
+	DirectX::XMFLOAT4X4 ShadowProjection;
+	DirectX::XMFLOAT3 CameraPosition;
+	DirectX::XMFLOAT3 AmbientColor;
+	const Light* Lights;
+	int LightCount;
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int ShadowResolution;
+	bool UseInstancing;
+};
+
+// --------------------------------------------------------
+// Walks a sorted render queue and issues every pass through
+// an IRenderBackend: the shadow maps, then the main pass,
+// rebinding only when the sort key changes. It mirrors
+// Game's D3D11 draw loops rather than sharing them, so a
+// change to one needs the same change in the other. Owns
+// the constant and instance buffers it uploads.
+// --------------------------------------------------------
+class RenderQueueSubmitter
+{
+public:
+	RenderQueueSubmitter(std::shared_ptr<IRenderBackend> backend);
+	~RenderQueueSubmitter();
+
+	//Ids match the ones in render queue keys
+	unsigned int AddMesh(const SubmitMesh& mesh);
+	unsigned int AddMaterial(const SubmitMaterial& material);
+	unsigned int AddShader(const SubmitShader& shader);
+	void SetShadowShaders(RenderHandle vertexShader, RenderHandle instancedVertexShader);
+	void SetTargets(RenderHandle color, RenderHandle depth, const RenderHandle shadowMaps[SUBMIT_SHADOW_MAPS], RenderHandle shadowSampler);
+
+	//Issues every pass of the queue, between the backend's BeginFrame and EndFrame
+	void Submit(RenderQueue& queue, Transform* transforms, const SubmitFrame& frame);
+
+private:
+	// Constant buffer layouts, padded like HLSL packs them
+	struct FrameConstants
+	{
+		DirectX::XMFLOAT4X4 View;
+		DirectX::XMFLOAT4X4 Projection;
+		DirectX::XMFLOAT4X4 ShadowViews[SUBMIT_SHADOW_MAPS];
+		DirectX::XMFLOAT4X4 ShadowProjection;
+	};
+
+	struct ShadowConstants
+	{
+		DirectX::XMFLOAT4X4 View;
+		DirectX::XMFLOAT4X4 Projection;
+	};
+
+	struct PixelConstants
+	{
+		DirectX::XMFLOAT3 ColorTint;
+		float Padding0;
+		DirectX::XMFLOAT3 CameraPosition;
+		float Padding1;
+		DirectX::XMFLOAT3 AmbientColor;
+		float Padding2;
+		Light Lights[MAX_LIGHTS];
+		int LightCount;
+		float Padding3[3];
+	};
+
+	std::shared_ptr<IRenderBackend> backend;
+	std::vector<SubmitMesh> meshes;
+	std::vector<SubmitMaterial> materials;
+	std::vector<SubmitShader> shaders;
+	RenderHandle shadowVertexShader;
+	RenderHandle shadowInstancedVertexShader;
+
+	RenderHandle colorTarget;
+	RenderHandle depthTarget;
+	RenderHandle shadowMaps[SUBMIT_SHADOW_MAPS];
+	RenderHandle shadowSampler;
+
+	RenderHandle frameBuffer;
+	RenderHandle shadowBuffer;
+	RenderHandle objectBuffer;
+	RenderHandle pixelBuffer;
+
+	//Instance data for the whole queue, grows on demand
+	RenderHandle instanceBuffer;
+	unsigned int instanceCapacity;
+	std::vector<InstanceData> instances;
+	std::vector<InstanceBatch> batches;
+
+	void PackInstances(RenderQueue& queue, Transform* transforms);
+	void SubmitShadowPass(RenderQueue& queue, unsigned int pass, Transform* transforms, const SubmitFrame& frame);
+	void SubmitOpaquePass(RenderQueue& queue, Transform* transforms, const SubmitFrame& frame);
+	void BindMesh(unsigned int mesh, bool instanced);
+	void DrawObject(unsigned int mesh, Transform& transform);
+};
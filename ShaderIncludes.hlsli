@@ -9,6 +9,18 @@ struct VertexShaderInput
 	float2 uv               : TEXCOORD;		//UV
 };
 
+//per vertex data in slot 0, per instance matrices and material in slot 1
+struct VertexShaderInput_Instanced
+{ 
+	float3 localPosition	: POSITION;     // XYZ position
+	float3 normal			: NORMAL;		//Normal
+    float3 tangent          : TANGENT;      //Tanget
+	float2 uv               : TEXCOORD;		//UV
+    matrix world            : WORLD_PER_INSTANCE;
+    matrix worldInvTranspose : WORLDINVTRANSPOSE_PER_INSTANCE;
+    uint materialIndex      : MATERIAL_PER_INSTANCE;
+};
+
 
 struct VertexToPixel
 {
@@ -18,6 +30,7 @@ struct VertexToPixel
     float3 tangent : TANGENT;
     float3 worldPosition : POSITION;
     float4 posForShadow[3] : SHADOWPOS;
+    nointerpolation uint materialIndex : MATERIAL; //record of the material table
 };
 
 struct VertexToPixel_Sky
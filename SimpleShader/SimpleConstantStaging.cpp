@@ -0,0 +1,81 @@
+#include "SimpleConstantStaging.h"
+
+#include <cstring>
+
+std::atomic<unsigned int> SimpleConstantStaging::BytesUploaded(0);
+std::atomic<unsigned int> SimpleConstantStaging::UploadsSkipped(0);
+std::atomic<unsigned int> SimpleConstantStaging::latestGeneration(1);
+
+SimpleConstantStaging::SimpleConstantStaging()
+{
+	size = 0;
+	slotCount = 0;
+}
+
+SimpleConstantStaging::~SimpleConstantStaging() {}
+
+void SimpleConstantStaging::Resize(unsigned int size, unsigned int slotCount)
+{
+	this->size = size;
+	this->slotCount = slotCount;
+
+	data.assign((size_t)size * slotCount, 0);
+
+	SlotState initial = {};
+	initial.UploadedGeneration = 0;
+	initial.Dirty = true;
+	slots.assign(slotCount, initial);
+}
+
+bool SimpleConstantStaging::Write(unsigned int slot, unsigned int offset, const void* source, unsigned int length)
+{
+	//only flag the slot if the bytes actually change
+	unsigned char* dest = GetData(slot) + offset;
+	if (memcmp(dest, source, length) == 0)
+		return false;
+
+	memcpy(dest, source, length);
+	slots[slot].Dirty = true;
+	return true;
+}
+
+bool SimpleConstantStaging::NeedsUpload(unsigned int slot, unsigned int generation)
+{
+	return slots[slot].Dirty || slots[slot].UploadedGeneration != generation;
+}
+
+void SimpleConstantStaging::MarkUploaded(unsigned int slot, unsigned int generation)
+{
+	slots[slot].Dirty = false;
+	slots[slot].UploadedGeneration = generation;
+}
+
+bool SimpleConstantStaging::Upload(unsigned int slot, unsigned int generation, ISimpleConstantUploader* uploader)
+{
+	//the last upload is still current
+	if (!NeedsUpload(slot, generation))
+	{
+		UploadsSkipped++;
+		return false;
+	}
+
+	uploader->Upload(GetData(slot), size);
+	MarkUploaded(slot, generation);
+	BytesUploaded += size;
+	return true;
+}
+
+unsigned int SimpleConstantStaging::NextGeneration()
+{
+	//skip 0 when the counter wraps
+	unsigned int generation = ++latestGeneration;
+	while (generation == 0)
+		generation = ++latestGeneration;
+	return generation;
+}
+
+void SimpleConstantStaging::ResetStats()
+{
+	BytesUploaded = 0;
+	UploadsSkipped = 0;
+}
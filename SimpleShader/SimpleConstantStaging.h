@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Most threads that can stage shader data at once; slot 0 is
+// used by threads without a recording context
+#define SIMPLE_SHADER_MAX_RECORDING_SLOTS 8
+
+// --------------------------------------------------------
+// Where a slot's data goes when it needs uploading, such as
+// a device context updating the constant buffer
+// --------------------------------------------------------
+class ISimpleConstantUploader
+{
+public:
+	virtual ~ISimpleConstantUploader() {}
+	virtual void Upload(const void* data, unsigned int size) = 0;
+};
+
+// --------------------------------------------------------
+// The local copies of one constant buffer's data, one per
+// recording slot, so threads recording at the same time
+// never touch the same bytes. Each slot remembers if its
+// data changed since its last upload, and the recording
+// generation that upload belongs to.
+// --------------------------------------------------------
+class SimpleConstantStaging
+{
+public:
+	SimpleConstantStaging();
+	~SimpleConstantStaging();
+
+	//Zeroes size bytes for each slot, all needing an upload
+	void Resize(unsigned int size, unsigned int slotCount);
+
+	unsigned int GetSize() { return size; }
+	unsigned int GetSlotCount() { return slotCount; }
+	unsigned char* GetData(unsigned int slot) { return &data[slot * size]; }
+
+	//Copies length bytes to offset in a slot's data.
+	//Returns true if any of them changed.
+	bool Write(unsigned int slot, unsigned int offset, const void* source, unsigned int length);
+
+	//A slot's data must be uploaded if it changed, or if the
+	//last upload was recorded under a different generation
+	bool NeedsUpload(unsigned int slot, unsigned int generation);
+	void MarkUploaded(unsigned int slot, unsigned int generation);
+
+	//Hands a slot's data to the uploader and marks it uploaded if it
+	//needs an upload, counting it either way. Returns true if uploaded.
+	bool Upload(unsigned int slot, unsigned int generation, ISimpleConstantUploader* uploader);
+
+	//Recording generations, unique across every context so the last
+	//one started can stand for "anything since then" (never 0, which
+	//slots start at). Threads with no recording context upload under
+	//the latest one, so theirs go up again after any context begins.
+	static unsigned int NextGeneration();
+	static unsigned int GetLatestGeneration() { return latestGeneration; }
+
+	//Upload counters across every buffer and thread
+	static std::atomic<unsigned int> BytesUploaded;
+	static std::atomic<unsigned int> UploadsSkipped;
+	static void ResetStats();
+
+private:
+	struct SlotState
+	{
+		unsigned int UploadedGeneration;
+		bool Dirty;
+	};
+
+	unsigned int size;
+	unsigned int slotCount;
+	std::vector<unsigned char> data; //slotCount copies of size bytes
+	std::vector<SlotState> slots;
+
+	static std::atomic<unsigned int> latestGeneration;
+};
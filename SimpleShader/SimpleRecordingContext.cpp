@@ -0,0 +1,31 @@
+#include "SimpleRecordingContext.h"
+
+// Nothing bound until a thread asks for it
+thread_local SimpleRecordingContext* SimpleRecordingContext::current = 0;
+
+SimpleRecordingContext::SimpleRecordingContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int slot)
+	: stateTracker(context)
+{
+	this->context = context;
+	this->slot = slot;
+	this->generation = SimpleConstantStaging::NextGeneration();
+}
+
+SimpleRecordingContext::~SimpleRecordingContext()
+{
+	if (current == this)
+		current = 0;
+}
+
+void SimpleRecordingContext::Begin()
+{
+	stateTracker.Invalidate();
+
+	//a new generation makes every shader upload its data again
+	generation = SimpleConstantStaging::NextGeneration();
+}
+
+void SimpleRecordingContext::Bind(SimpleRecordingContext* recording)
+{
+	current = recording;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "SimpleStateTracker.h"
+#include "SimpleConstantStaging.h"
+
+// --------------------------------------------------------
+// What one thread records SimpleShader calls with: a device
+// context, a state tracker for it and the staging slot its
+// constant data goes in. Bind one on each thread that
+// records; shaders used on a thread with none bound fall
+// back to their own context, no tracking and slot 0, under
+// the latest generation any recording context began.
+// --------------------------------------------------------
+class SimpleRecordingContext
+{
+public:
+	SimpleRecordingContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, unsigned int slot);
+	~SimpleRecordingContext();
+
+	ID3D11DeviceContext* GetContext() { return context.Get(); }
+	SimpleStateTracker* GetStateTracker() { return &stateTracker; }
+	unsigned int GetSlot() { return slot; }
+	unsigned int GetGeneration() { return generation; }
+
+	// Call when starting a command list, or after other work
+	// ran on the context (executed command lists, presenting).
+	// Bindings and constant buffer contents are unknown again.
+	void Begin();
+
+	// The recording context of the calling thread, or null
+	static void Bind(SimpleRecordingContext* recording);
+	static SimpleRecordingContext* GetCurrent() { return current; }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	SimpleStateTracker stateTracker;
+	unsigned int slot;
+	unsigned int generation; //from SimpleConstantStaging::NextGeneration()
+
+	static thread_local SimpleRecordingContext* current;
+};
@@ -11,6 +11,33 @@ bool ISimpleShader::ReportWarnings = false;
 // ISimpleShader::ReportErrors = true;
 // ISimpleShader::ReportWarnings = true;
 
+// Constant buffer upload counters
+std::atomic<unsigned int>& ISimpleShader::BytesUploaded = SimpleConstantStaging::BytesUploaded;
+std::atomic<unsigned int>& ISimpleShader::UploadsSkipped = SimpleConstantStaging::UploadsSkipped;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Uploads staged data to a constant buffer through a
+	// device context
+	// --------------------------------------------------------
+	class ContextUploader : public ISimpleConstantUploader
+	{
+	public:
+		ContextUploader(ID3D11DeviceContext* context, ID3D11Buffer* buffer) : context(context), buffer(buffer) {}
+
+		void Upload(const void* data, unsigned int size)
+		{
+			//constant buffers can only be updated as a whole
+			context->UpdateSubresource(buffer, 0, 0, data, 0, 0);
+		}
+
+	private:
+		ID3D11DeviceContext* context;
+		ID3D11Buffer* buffer;
+	};
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -45,25 +72,24 @@ ISimpleShader::~ISimpleShader()
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
-	// Handle constant buffers and local data buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		delete[] constantBuffers[i].LocalDataBuffer;
-	}
-
+	// Handle constant buffers (local data goes with them)
 	if (constantBuffers)
 	{
 		delete[] constantBuffers;
+		constantBuffers = 0;
 		constantBufferCount = 0;
 	}
 
 	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
 		delete shaderResourceViews[i];
+	shaderResourceViews.clear();
 	
 	for (unsigned int i = 0; i < samplerStates.size(); i++)
 		delete samplerStates[i];
+	samplerStates.clear();
 
 	// Clean up tables
+	variables.clear();
 	varTable.clear();
 	cbTable.clear();
 	samplerTable.clear();
@@ -81,7 +107,8 @@ void ISimpleShader::CleanUp()
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 {
 	// Load the shader to a blob and ensure it worked
-	HRESULT hr = D3DReadFileToBlob(shaderFile, shaderBlob.GetAddressOf());
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	HRESULT hr = D3DReadFileToBlob(shaderFile, blob.GetAddressOf());
 	if (hr != S_OK)
 	{
 		if (ReportErrors)
@@ -94,10 +121,8 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
-	// Create the shader - Calls an overloaded version of this abstract
-	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
-	if (!shaderValid)
+	// Create the shader and its tables from the blob
+	if (!LoadShaderBlob(blob))
 	{
 		if (ReportErrors)
 		{
@@ -109,6 +134,145 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// All set
+	return true;
+}
+
+// --------------------------------------------------------
+// Swaps in another compiled shader of the same type, in
+// place, so everything holding this object uses it from
+// the next draw on. Handles must be looked up again.
+//
+// compiledShader - The new shader's compiled code
+//
+// Returns false, keeping the current shader, if the new
+// one can't be created
+// --------------------------------------------------------
+bool ISimpleShader::Reload(Microsoft::WRL::ComPtr<ID3DBlob> compiledShader)
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> current = shaderBlob;
+	if (LoadShaderBlob(compiledShader))
+		return true;
+
+	// Creating the new shader cleared the old one, so build it again
+	if (current)
+		LoadShaderBlob(current);
+	return false;
+}
+
+// --------------------------------------------------------
+// Creates the shader from compiled code and builds the
+// variable table using shader reflection
+//
+// blob - The compiled shader
+//
+// Returns true if the shader is created properly
+// --------------------------------------------------------
+bool ISimpleShader::LoadShaderBlob(Microsoft::WRL::ComPtr<ID3DBlob> blob)
+{
+	shaderBlob = blob;
+
+	// Get the reflection data, skipping reflection entirely
+	// if this exact blob has been seen before
+	unsigned long long hash = SimpleShaderReflectionCache::HashBlob(
+		shaderBlob->GetBufferPointer(),
+		shaderBlob->GetBufferSize());
+	if (!SimpleShaderReflectionCache::Find(hash, reflection))
+	{
+		ReflectShader(shaderBlob, reflection);
+		SimpleShaderReflectionCache::Store(hash, reflection);
+	}
+
+	// Create the shader - Calls an overloaded version of this abstract
+	// method in the appropriate child class
+	shaderValid = CreateShader(shaderBlob);
+	if (!shaderValid)
+		return false;
+
+	// Create resource arrays
+	constantBufferCount = (unsigned int)reflection.ConstantBuffers.size();
+	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
+
+	// Handle bound textures
+	for (unsigned int r = 0; r < reflection.ShaderResourceViews.size(); r++)
+	{
+		// Create the SRV wrapper
+		SimpleSRV* srv = new SimpleSRV();
+		srv->BindIndex = reflection.ShaderResourceViews[r].BindIndex;	// Shader bind point
+		srv->Index = (unsigned int)shaderResourceViews.size();			// Raw index
+
+		textureTable.insert(std::pair<std::string, SimpleSRV*>(reflection.ShaderResourceViews[r].Name, srv));
+		shaderResourceViews.push_back(srv);
+	}
+
+	// Handle bound samplers
+	for (unsigned int r = 0; r < reflection.Samplers.size(); r++)
+	{
+		// Create the sampler wrapper
+		SimpleSampler* samp = new SimpleSampler();
+		samp->BindIndex = reflection.Samplers[r].BindIndex;		// Shader bind point
+		samp->Index = (unsigned int)samplerStates.size();		// Raw index
+
+		samplerTable.insert(std::pair<std::string, SimpleSampler*>(reflection.Samplers[r].Name, samp));
+		samplerStates.push_back(samp);
+	}
+
+	// Loop through all constant buffers
+	for (unsigned int b = 0; b < constantBufferCount; b++)
+	{
+		const SimpleReflectedBuffer& bufferDesc = reflection.ConstantBuffers[b];
+
+		// Save the type, which we reference when setting these buffers
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)bufferDesc.Type;
+		
+		// Set up the buffer and put its pointer in the table
+		constantBuffers[b].BindIndex = bufferDesc.BindIndex;
+		constantBuffers[b].Name = bufferDesc.Name;
+		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
+
+		// Create this constant buffer
+		D3D11_BUFFER_DESC newBuffDesc = {};
+		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
+		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
+		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		newBuffDesc.CPUAccessFlags = 0;
+		newBuffDesc.MiscFlags = 0;
+		newBuffDesc.StructureByteStride = 0;
+		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
+
+		// Set up the data buffer for this constant buffer
+		constantBuffers[b].Size = bufferDesc.Size;
+		constantBuffers[b].Staging.Resize(bufferDesc.Size, SIMPLE_SHADER_MAX_RECORDING_SLOTS);
+
+		// Loop through all variables in this buffer
+		for (unsigned int v = 0; v < bufferDesc.Variables.size(); v++)
+		{
+			// Create the variable struct
+			SimpleShaderVariable varStruct = {};
+			varStruct.ConstantBufferIndex = b;
+			varStruct.ByteOffset = bufferDesc.Variables[v].ByteOffset;
+			varStruct.Size = bufferDesc.Variables[v].Size;
+
+			// Add this variable to the table and the constant buffer
+			varTable.insert(std::pair<std::string, unsigned int>(bufferDesc.Variables[v].Name, (unsigned int)variables.size()));
+			variables.push_back(varStruct);
+			constantBuffers[b].Variables.push_back(varStruct);
+		}
+	}
+
+	// All set
+	return true;
+}
+
+// --------------------------------------------------------
+// Uses shader reflection to gather everything SimpleShader
+// needs about a compiled shader: constant buffers and their
+// variables, bound resources and input elements
+// --------------------------------------------------------
+void ISimpleShader::ReflectShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob, SimpleShaderReflection& reflection)
+{
+	reflection = SimpleShaderReflection();
+
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
@@ -122,10 +286,6 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
 	// Handle bound resources (like shaders and samplers)
 	unsigned int resourceCount = shaderDesc.BoundResources;
 	for (unsigned int r = 0; r < resourceCount; r++)
@@ -134,38 +294,26 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
 		refl->GetResourceBindingDesc(r, &resourceDesc);
 
+		SimpleReflectedResource resource;
+		resource.Name = resourceDesc.Name;
+		resource.BindIndex = resourceDesc.BindPoint;
+
 		// Check the type
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
 		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
-
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
+			reflection.ShaderResourceViews.push_back(resource);
 			break;
 
 		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
-
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
+			reflection.Samplers.push_back(resource);
 			break;
 		}
 	}
 
 	// Loop through all constant buffers
-	for (unsigned int b = 0; b < constantBufferCount; b++)
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
 	{
 		// Get this buffer
 		ID3D11ShaderReflectionConstantBuffer* cb =
@@ -175,62 +323,89 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		D3D11_SHADER_BUFFER_DESC bufferDesc;
 		cb->GetDesc(&bufferDesc);
 
-		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-		
 		// Get the description of the resource binding, so
 		// we know exactly how it's bound in the shader
 		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
 		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
-		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
-
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc = {};
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
 
-		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		SimpleReflectedBuffer buffer;
+		buffer.Name = bufferDesc.Name;
+		buffer.Type = bufferDesc.Type;
+		buffer.Size = bufferDesc.Size;
+		buffer.BindIndex = bindDesc.BindPoint;
 
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
-			// Get this variable
+			// Get the description of this variable
 			ID3D11ShaderReflectionVariable* var =
 				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
 			D3D11_SHADER_VARIABLE_DESC varDesc;
 			var->GetDesc(&varDesc);
 
-			// Create the variable struct
-			SimpleShaderVariable varStruct = {};
-			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
-
-			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
-			constantBuffers[b].Variables.push_back(varStruct);
+			SimpleReflectedVariable variable;
+			variable.Name = varDesc.Name;
+			variable.ByteOffset = varDesc.StartOffset;
+			variable.Size = varDesc.Size;
+			buffer.Variables.push_back(variable);
 		}
+
+		reflection.ConstantBuffers.push_back(buffer);
 	}
 
-	// All set
-	return true;
+	// Loop through the shader inputs, which vertex shaders
+	// use to build a matching input layout
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+		refl->GetInputParameterDesc(i, &paramDesc);
+
+		// System values like SV_VertexID come from the pipeline, not a buffer
+		if (paramDesc.SystemValueType != D3D_NAME_UNDEFINED)
+			continue;
+
+		// Check the semantic name for "_PER_INSTANCE"
+		std::string perInstanceStr = "_PER_INSTANCE";
+		std::string sem = paramDesc.SemanticName;
+		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
+		bool isPerInstance = 
+			lenDiff >= 0 &&
+			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+
+		// Determine DXGI format
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		if (paramDesc.Mask == 1)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) format = DXGI_FORMAT_R32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) format = DXGI_FORMAT_R32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) format = DXGI_FORMAT_R32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 3)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) format = DXGI_FORMAT_R32G32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) format = DXGI_FORMAT_R32G32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) format = DXGI_FORMAT_R32G32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 7)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) format = DXGI_FORMAT_R32G32B32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) format = DXGI_FORMAT_R32G32B32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) format = DXGI_FORMAT_R32G32B32_FLOAT;
+		}
+		else if (paramDesc.Mask <= 15)
+		{
+			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) format = DXGI_FORMAT_R32G32B32A32_UINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) format = DXGI_FORMAT_R32G32B32A32_SINT;
+			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		}
+
+		SimpleReflectedInput input;
+		input.SemanticName = paramDesc.SemanticName;
+		input.SemanticIndex = paramDesc.SemanticIndex;
+		input.Format = format;
+		input.PerInstance = isPerInstance;
+		reflection.Inputs.push_back(input);
+	}
 }
 
 // --------------------------------------------------------
@@ -240,18 +415,18 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 // name - the name of the variable to look for
 // size - the size of the variable (for verification), or -1 to bypass
 // --------------------------------------------------------
-SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
+SimpleShaderVariable* ISimpleShader::FindVariable(const char* name, int size)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
+	std::unordered_map<std::string, unsigned int>::iterator result =
 		varTable.find(name);
 
 	// Did we find the key?
 	if (result == varTable.end())
 		return 0;
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
+	// Grab the variable the result points at
+	SimpleShaderVariable* var = &variables[result->second];
 
 	// Is the data size correct ?
 	if (size > 0 && var->Size != size)
@@ -264,7 +439,7 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 // --------------------------------------------------------
 // Helper for looking up a constant buffer by name
 // --------------------------------------------------------
-SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
+SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
@@ -345,13 +520,10 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy any that changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		CopyBufferDataIfDirty(&constantBuffers[i]);
 	}
 }
 
@@ -380,9 +552,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	CopyBufferDataIfDirty(cb);
 }
 
 // --------------------------------------------------------
@@ -392,7 +562,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 //              Useful for updating more frequently-changing
 //              variables without having to re-copy all buffers.
 // --------------------------------------------------------
-void ISimpleShader::CopyBufferData(std::string bufferName)
+void ISimpleShader::CopyBufferData(const char* bufferName)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
@@ -402,9 +572,66 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	CopyBufferDataIfDirty(cb);
+}
+
+// --------------------------------------------------------
+// Copies the calling thread's local data for a constant
+// buffer to the GPU, unless nothing has changed since it
+// was last copied in the same recording generation.
+// Without a recording context that's the latest generation
+// begun anywhere, so executing command lists (which ends
+// with the immediate context beginning a new one) makes
+// slot 0 upload again. Constant buffers can only be
+// updated as a whole, so any change uploads the entire
+// buffer.
+// --------------------------------------------------------
+void ISimpleShader::CopyBufferDataIfDirty(SimpleConstantBuffer* cb)
+{
+	SimpleRecordingContext* recording = SimpleRecordingContext::GetCurrent();
+	unsigned int slot = recording ? recording->GetSlot() : 0;
+	unsigned int generation = recording ? recording->GetGeneration() : SimpleConstantStaging::GetLatestGeneration();
+
+	// Copy the entire local data buffer, unless the GPU copy is still current
+	ContextUploader uploader(GetContext(), cb->ConstantBuffer.Get());
+	cb->Staging.Upload(slot, generation, &uploader);
+}
+
+// --------------------------------------------------------
+// Gets the context to issue calls on: the calling thread's
+// recording context, or the one this shader was made with
+// --------------------------------------------------------
+ID3D11DeviceContext* ISimpleShader::GetContext()
+{
+	SimpleRecordingContext* recording = SimpleRecordingContext::GetCurrent();
+	return recording ? recording->GetContext() : deviceContext.Get();
+}
+
+// --------------------------------------------------------
+// Gets the state tracker to bind through, if the calling
+// thread has a recording context
+// --------------------------------------------------------
+SimpleStateTracker* ISimpleShader::GetStateTracker()
+{
+	SimpleRecordingContext* recording = SimpleRecordingContext::GetCurrent();
+	return recording ? recording->GetStateTracker() : 0;
+}
+
+// --------------------------------------------------------
+// Gets the slot of local data the calling thread uses
+// --------------------------------------------------------
+unsigned int ISimpleShader::GetStagingSlot()
+{
+	SimpleRecordingContext* recording = SimpleRecordingContext::GetCurrent();
+	return recording ? recording->GetSlot() : 0;
+}
+
+// --------------------------------------------------------
+// Resets the constant buffer upload counters
+// --------------------------------------------------------
+void ISimpleShader::ResetUploadStats()
+{
+	SimpleConstantStaging::ResetStats();
 }
 
 
@@ -417,7 +644,7 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 //
 // Returns true if data is copied, false if variable doesn't exist
 // --------------------------------------------------------
-bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
+bool ISimpleShader::SetData(const char* name, const void* data, unsigned int size)
 {
 	// Look for the variable and verify
 	SimpleShaderVariable* var = FindVariable(name, -1);
@@ -445,11 +672,40 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 	}
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	// Set the data through the variable's handle
+	SimpleShaderHandle handle;
+	handle.Index = (int)(var - &variables[0]);
+	return SetData(handle, data, size);
+}
+
+// --------------------------------------------------------
+// Sets a variable through its handle with arbitrary data
+// of the specified size
+//
+// handle - The variable's handle from GetVariableHandle()
+// data - The data to set in the buffer
+// size - The size of the data (this must be less than or equal to the variable's size)
+//
+// Returns true if data is copied, false if the handle is invalid
+// --------------------------------------------------------
+bool ISimpleShader::SetData(SimpleShaderHandle handle, const void* data, unsigned int size)
+{
+	// Validate the handle and the data size
+	if (handle.Index < 0 || handle.Index >= (int)variables.size())
+		return false;
+
+	SimpleShaderVariable* var = &variables[handle.Index];
+	if (size > var->Size)
+	{
+		if (ReportWarnings)
+			LogWarning("SimpleShader::SetData() - Data is larger than the shader variable behind the handle.\n");
+		return false;
+	}
+
+	// Set the data in this thread's copy of the local data,
+	// flagging it for upload only if the bytes actually change
+	SimpleConstantBuffer* cb = &constantBuffers[var->ConstantBufferIndex];
+	cb->Staging.Write(GetStagingSlot(), var->ByteOffset, data, size);
 
 	// Success
 	return true;
@@ -458,7 +714,7 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
-bool ISimpleShader::SetInt(std::string name, int data)
+bool ISimpleShader::SetInt(const char* name, int data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(int));
 }
@@ -466,7 +722,7 @@ bool ISimpleShader::SetInt(std::string name, int data)
 // --------------------------------------------------------
 // Sets a FLOAT variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat(std::string name, float data)
+bool ISimpleShader::SetFloat(const char* name, float data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(float));
 }
@@ -474,7 +730,7 @@ bool ISimpleShader::SetFloat(std::string name, float data)
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const float data[2])
+bool ISimpleShader::SetFloat2(const char* name, const float data[2])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 2);
 }
@@ -482,7 +738,7 @@ bool ISimpleShader::SetFloat2(std::string name, const float data[2])
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
+bool ISimpleShader::SetFloat2(const char* name, const DirectX::XMFLOAT2 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 2);
 }
@@ -490,7 +746,7 @@ bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const float data[3])
+bool ISimpleShader::SetFloat3(const char* name, const float data[3])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 3);
 }
@@ -498,7 +754,7 @@ bool ISimpleShader::SetFloat3(std::string name, const float data[3])
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
+bool ISimpleShader::SetFloat3(const char* name, const DirectX::XMFLOAT3 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 3);
 }
@@ -506,7 +762,7 @@ bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const float data[4])
+bool ISimpleShader::SetFloat4(const char* name, const float data[4])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 4);
 }
@@ -514,7 +770,7 @@ bool ISimpleShader::SetFloat4(std::string name, const float data[4])
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
+bool ISimpleShader::SetFloat4(const char* name, const DirectX::XMFLOAT4 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 4);
 }
@@ -522,7 +778,7 @@ bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
+bool ISimpleShader::SetMatrix4x4(const char* name, const float data[16])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 16);
 }
@@ -530,16 +786,183 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data)
+bool ISimpleShader::SetMatrix4x4(const char* name, const DirectX::XMFLOAT4X4 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Sets INTEGER data through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(SimpleShaderHandle handle, int data)
+{
+	return this->SetData(handle, &data, sizeof(int));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat(SimpleShaderHandle handle, float data)
+{
+	return this->SetData(handle, &data, sizeof(float));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT2 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat2(SimpleShaderHandle handle, const DirectX::XMFLOAT2& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT3 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat3(SimpleShaderHandle handle, const DirectX::XMFLOAT3& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT4 variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat4(SimpleShaderHandle handle, const DirectX::XMFLOAT4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+// --------------------------------------------------------
+// Sets a MATRIX (4x4) variable through a handle
+// --------------------------------------------------------
+bool ISimpleShader::SetMatrix4x4(SimpleShaderHandle handle, const DirectX::XMFLOAT4X4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view by name
+//
+// name - The name of the texture resource in the shader
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if a texture of the given name was found, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+{
+	// Look for the SRV and verify
+	SimpleShaderHandle handle = GetShaderResourceViewHandle(name);
+	if (!handle.IsValid())
+	{
+		if (ReportWarnings)
+		{
+			LogWarning("SimpleShader::SetShaderResourceView() - SRV named '");
+			Log(name);
+			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
+		}
+		return false;
+	}
+
+	return SetShaderResourceView(handle, srv.Get());
+}
+
+// --------------------------------------------------------
+// Sets a sampler state by name
+//
+// name - The name of the sampler state in the shader
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if a sampler of the given name was found, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+{
+	// Look for the sampler and verify
+	SimpleShaderHandle handle = GetSamplerHandle(name);
+	if (!handle.IsValid())
+	{
+		if (ReportWarnings)
+		{
+			LogWarning("SimpleShader::SetSamplerState() - Sampler named '");
+			Log(name);
+			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
+		}
+		return false;
+	}
+
+	return SetSamplerState(handle, samplerState.Get());
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view through its handle
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv)
+{
+	if (handle.Index < 0 || handle.Index >= (int)shaderResourceViews.size())
+		return false;
+
+	BindShaderResourceView(shaderResourceViews[handle.Index]->BindIndex, srv);
+	return true;
+}
+
+// --------------------------------------------------------
+// Sets a sampler state through its handle
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState)
+{
+	if (handle.Index < 0 || handle.Index >= (int)samplerStates.size())
+		return false;
+
+	BindSamplerState(samplerStates[handle.Index]->BindIndex, samplerState);
+	return true;
+}
+
+// --------------------------------------------------------
+// Resolves a constant buffer variable's name to a handle.
+// The handle is invalid if the variable doesn't exist.
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(const char* name)
+{
+	SimpleShaderHandle handle;
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var)
+		handle.Index = (int)(var - &variables[0]);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Resolves an SRV's name to a handle.
+// The handle is invalid if the SRV doesn't exist.
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetShaderResourceViewHandle(const char* name)
+{
+	SimpleShaderHandle handle;
+	const SimpleSRV* srv = GetShaderResourceViewInfo(name);
+	if (srv)
+		handle.Index = (int)srv->Index;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Resolves a sampler's name to a handle.
+// The handle is invalid if the sampler doesn't exist.
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetSamplerHandle(const char* name)
+{
+	SimpleShaderHandle handle;
+	const SimpleSampler* samp = GetSamplerInfo(name);
+	if (samp)
+		handle.Index = (int)samp->Index;
+	return handle;
+}
+
 // --------------------------------------------------------
 // Determines if the shader contains the specified
 // variable within one of its constant buffers
 // --------------------------------------------------------
-bool ISimpleShader::HasVariable(std::string name)
+bool ISimpleShader::HasVariable(const char* name)
 {
 	return FindVariable(name, -1) != 0;
 }
@@ -547,7 +970,7 @@ bool ISimpleShader::HasVariable(std::string name)
 // --------------------------------------------------------
 // Determines if the shader contains the specified SRV
 // --------------------------------------------------------
-bool ISimpleShader::HasShaderResourceView(std::string name)
+bool ISimpleShader::HasShaderResourceView(const char* name)
 {
 	return GetShaderResourceViewInfo(name) != 0;
 }
@@ -555,7 +978,7 @@ bool ISimpleShader::HasShaderResourceView(std::string name)
 // --------------------------------------------------------
 // Determines if the shader contains the specified sampler
 // --------------------------------------------------------
-bool ISimpleShader::HasSamplerState(std::string name)
+bool ISimpleShader::HasSamplerState(const char* name)
 {
 	return GetSamplerInfo(name) != 0;
 }
@@ -563,7 +986,7 @@ bool ISimpleShader::HasSamplerState(std::string name)
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
-const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
+const SimpleShaderVariable* ISimpleShader::GetVariableInfo(const char* name)
 {
 	return FindVariable(name, -1);
 }
@@ -573,7 +996,7 @@ const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 //
 // name - the name of the SRV
 // --------------------------------------------------------
-const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
+const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleSRV*>::iterator result =
@@ -608,7 +1031,7 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 // 
 // name - the name of the sampler
 // --------------------------------------------------------
-const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
+const SimpleSampler* ISimpleShader::GetSamplerInfo(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleSampler*>::iterator result =
@@ -661,7 +1084,7 @@ unsigned int ISimpleShader::GetBufferSize(unsigned int index)
 // Gets info about a particular constant buffer 
 // by name, if it exists
 // --------------------------------------------------------
-const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(std::string name)
+const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(const char* name)
 {
 	return FindConstantBuffer(name);
 }
@@ -697,6 +1120,7 @@ SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> devi
 	// Ensure we set to zero to successfully trigger
 	// the Input Layout creation during LoadShaderFile()
 	this->perInstanceCompatible = false;
+	this->customInputLayout = false;
 
 	// Load the actual compiled shader file
 	this->LoadShaderFile(shaderFile);
@@ -713,6 +1137,7 @@ SimpleVertexShader::SimpleVertexShader(Microsoft::WRL::ComPtr<ID3D11Device> devi
 {
 	// Save the custom input layout
 	this->inputLayout = inputLayout;
+	this->customInputLayout = true;
 
 	// Unable to determine from an input layout, require user to tell us
 	this->perInstanceCompatible = perInstanceCompatible;
@@ -755,7 +1180,7 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Did the creation work?
 	if (result != S_OK)
@@ -763,52 +1188,36 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 
 	// Do we already have an input layout?
 	// (This would come from one of the constructor overloads)
-	if (inputLayout)
+	if (customInputLayout)
 		return true;
 
+	// Otherwise it's rebuilt, as a reload may have changed the inputs
+	inputLayout.Reset();
+	perInstanceCompatible = false;
+
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
+	// reflected inputs to create an input layout that 
 	// matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Read input layout description from shader info
+	// Build the input layout description from the reflected inputs
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	for (unsigned int i = 0; i < reflection.Inputs.size(); i++)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
-		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
-		bool isPerInstance = 
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+		const SimpleReflectedInput& input = reflection.Inputs[i];
 
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
-		elementDesc.SemanticName = paramDesc.SemanticName;
-		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
+		elementDesc.SemanticName = input.SemanticName.c_str();
+		elementDesc.SemanticIndex = input.SemanticIndex;
+		elementDesc.Format = (DXGI_FORMAT)input.Format;
 		elementDesc.InputSlot = 0;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 		elementDesc.InstanceDataStepRate = 0;
 
 		// Replace anything affected by "per instance" data
-		if (isPerInstance)
+		if (input.PerInstance)
 		{
 			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
 			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
@@ -817,43 +1226,21 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 			perInstanceCompatible = true;
 		}
 
-		// Determine DXGI format
-		if (paramDesc.Mask == 1)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 3)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 7)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 15)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		}
-
 		// Save element desc
 		inputLayoutDesc.push_back(elementDesc);
 	}
 
+	// Shaders that read no vertex data (e.g. fullscreen triangles) need no layout
+	if (inputLayoutDesc.empty())
+		return true;
+
 	// Try to create Input Layout
 	HRESULT hr = device->CreateInputLayout(
 		&inputLayoutDesc[0], 
 		(unsigned int)inputLayoutDesc.size(), 
 		shaderBlob->GetBufferPointer(), 
 		shaderBlob->GetBufferSize(),
-		inputLayout.GetAddressOf());
+		inputLayout.ReleaseAndGetAddressOf());
 
 	// All done, clean up
 	return true;
@@ -868,9 +1255,20 @@ void SimpleVertexShader::SetShaderAndCBs()
 	// Is shader valid?
 	if (!shaderValid) return;
 
+	// Bind through the state tracker if there is one
+	SimpleStateTracker* tracker = GetStateTracker();
+
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	if (tracker)
+	{
+		tracker->SetInputLayout(inputLayout.Get());
+		tracker->SetVertexShader(shader.Get());
+	}
+	else
+	{
+		GetContext()->IASetInputLayout(inputLayout.Get());
+		GetContext()->VSSetShader(shader.Get(), 0, 0);
+	}
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -880,7 +1278,12 @@ void SimpleVertexShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
+		if (tracker)
+		{
+			tracker->SetVSConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+			continue;
+		}
+		GetContext()->VSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -888,63 +1291,27 @@ void SimpleVertexShader::SetShaderAndCBs()
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the vertex shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the vertex shader stage
 // --------------------------------------------------------
-bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimpleVertexShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleVertexShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	SimpleStateTracker* tracker = GetStateTracker();
+	if (tracker)
+		tracker->SetVSShaderResource(bindIndex, srv);
+	else
+		GetContext()->VSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the vertex shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the vertex shader stage
 // --------------------------------------------------------
-bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimpleVertexShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleVertexShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	SimpleStateTracker* tracker = GetStateTracker();
+	if (tracker)
+		tracker->SetVSSampler(bindIndex, samplerState);
+	else
+		GetContext()->VSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 
@@ -996,7 +1363,7 @@ bool SimplePixelShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1011,8 +1378,14 @@ void SimplePixelShader::SetShaderAndCBs()
 	// Is shader valid?
 	if (!shaderValid) return;
 	
+	// Bind through the state tracker if there is one
+	SimpleStateTracker* tracker = GetStateTracker();
+
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	if (tracker)
+		tracker->SetPixelShader(shader.Get());
+	else
+		GetContext()->PSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,7 +1395,12 @@ void SimplePixelShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
+		if (tracker)
+		{
+			tracker->SetPSConstantBuffer(constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+			continue;
+		}
+		GetContext()->PSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1030,63 +1408,27 @@ void SimplePixelShader::SetShaderAndCBs()
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the pixel shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the pixel shader stage
 // --------------------------------------------------------
-bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimplePixelShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimplePixelShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	SimpleStateTracker* tracker = GetStateTracker();
+	if (tracker)
+		tracker->SetPSShaderResource(bindIndex, srv);
+	else
+		GetContext()->PSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the pixel shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the pixel shader stage
 // --------------------------------------------------------
-bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimplePixelShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimplePixelShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	SimpleStateTracker* tracker = GetStateTracker();
+	if (tracker)
+		tracker->SetPSSampler(bindIndex, samplerState);
+	else
+		GetContext()->PSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 
@@ -1140,7 +1482,7 @@ bool SimpleDomainShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1156,7 +1498,7 @@ void SimpleDomainShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->DSSetShader(shader.Get(), 0, 0);
+	GetContext()->DSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1166,7 +1508,7 @@ void SimpleDomainShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
+		GetContext()->DSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1174,63 +1516,19 @@ void SimpleDomainShader::SetShaderAndCBs()
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the domain shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the domain shader stage
 // --------------------------------------------------------
-bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimpleDomainShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleDomainShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->DSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the domain shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the domain shader stage
 // --------------------------------------------------------
-bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimpleDomainShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleDomainShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->DSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 
@@ -1283,7 +1581,7 @@ bool SimpleHullShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob)
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1299,7 +1597,7 @@ void SimpleHullShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->HSSetShader(shader.Get(), 0, 0);
+	GetContext()->HSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1309,7 +1607,7 @@ void SimpleHullShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
+		GetContext()->HSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1317,63 +1615,19 @@ void SimpleHullShader::SetShaderAndCBs()
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the hull shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the hull shader stage
 // --------------------------------------------------------
-bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimpleHullShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleHullShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->HSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the hull shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the hull shader stage
 // --------------------------------------------------------
-bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimpleHullShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleHullShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->HSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 
@@ -1435,7 +1689,7 @@ bool SimpleGeometryShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderB
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Check the result
 	return (result == S_OK);
@@ -1507,7 +1761,7 @@ bool SimpleGeometryShader::CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3D
 		0,                              // No buffer strides
 		rast,                           // Index of the stream to rasterize (if any)
 		NULL,                           // Not using class linkage
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 	
 	return (result == S_OK);
 }
@@ -1573,7 +1827,7 @@ void SimpleGeometryShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->GSSetShader(shader.Get(), 0, 0);
+	GetContext()->GSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1583,7 +1837,7 @@ void SimpleGeometryShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
+		GetContext()->GSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1591,63 +1845,19 @@ void SimpleGeometryShader::SetShaderAndCBs()
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the Geometry shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the geometry shader stage
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimpleGeometryShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleGeometryShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->GSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the Geometry shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the geometry shader stage
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimpleGeometryShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleGeometryShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->GSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 // --------------------------------------------------------
@@ -1724,7 +1934,7 @@ bool SimpleComputeShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBl
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		0,
-		shader.GetAddressOf());
+		shader.ReleaseAndGetAddressOf());
 
 	// Was the shader created correctly?
 	if (result != S_OK)
@@ -1783,7 +1993,7 @@ void SimpleComputeShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->CSSetShader(shader.Get(), 0, 0);
+	GetContext()->CSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1793,7 +2003,7 @@ void SimpleComputeShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
+		GetContext()->CSSetConstantBuffers(
 			constantBuffers[i].BindIndex,
 			1,
 			constantBuffers[i].ConstantBuffer.GetAddressOf());
@@ -1822,7 +2032,7 @@ void SimpleComputeShader::SetShaderAndCBs()
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ)
 {
-	deviceContext->Dispatch(groupsX, groupsY, groupsZ);
+	GetContext()->Dispatch(groupsX, groupsY, groupsZ);
 }
 
 // --------------------------------------------------------
@@ -1847,7 +2057,7 @@ void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int gr
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ)
 {
-	deviceContext->Dispatch(
+	GetContext()->Dispatch(
 		max((unsigned int)ceil((float)threadsX / this->threadsX), 1),
 		max((unsigned int)ceil((float)threadsY / this->threadsY), 1),
 		max((unsigned int)ceil((float)threadsZ / this->threadsZ), 1));
@@ -1856,69 +2066,25 @@ void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int
 // --------------------------------------------------------
 // Determines if this shader has the specified UAV
 // --------------------------------------------------------
-bool SimpleComputeShader::HasUnorderedAccessView(std::string name)
+bool SimpleComputeShader::HasUnorderedAccessView(const char* name)
 {
 	return GetUnorderedAccessViewIndex(name) != -1;
 }
 
 // --------------------------------------------------------
-// Sets a shader resource view in the Compute shader stage
-//
-// name - The name of the texture resource in the shader
-// srv - The shader resource view of the texture in GPU memory
-//
-// Returns true if a texture of the given name was found, false otherwise
+// Binds a shader resource view to the compute shader stage
 // --------------------------------------------------------
-bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+void SimpleComputeShader::BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleComputeShader::SetShaderResourceView() - SRV named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->CSSetShaderResources(bindIndex, 1, &srv);
 }
 
 // --------------------------------------------------------
-// Sets a sampler state in the Compute shader stage
-//
-// name - The name of the sampler state in the shader
-// samplerState - The sampler state in GPU memory
-//
-// Returns true if a sampler of the given name was found, false otherwise
+// Binds a sampler state to the compute shader stage
 // --------------------------------------------------------
-bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+void SimpleComputeShader::BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
-	{
-		if (ReportWarnings)
-		{
-			LogWarning("SimpleComputeShader::SetSamplerState() - Sampler named '");
-			Log(name);
-			LogWarning("' was not found in the shader. Ensure the name is spelled correctly and that it exists in the shader.\n");
-		}
-		return false;
-	}
-
-	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
-
-	// Success
-	return true;
+	GetContext()->CSSetSamplers(bindIndex, 1, &samplerState);
 }
 
 // --------------------------------------------------------
@@ -1930,7 +2096,7 @@ bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComP
 //
 // Returns true if a UAV of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset)
+bool SimpleComputeShader::SetUnorderedAccessView(const char* name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset)
 {
 	// Look for the variable and verify
 	unsigned int bindIndex = GetUnorderedAccessViewIndex(name);
@@ -1946,7 +2112,7 @@ bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WR
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetUnorderedAccessViews(bindIndex, 1, uav.GetAddressOf(), &appendConsumeOffset);
+	GetContext()->CSSetUnorderedAccessViews(bindIndex, 1, uav.GetAddressOf(), &appendConsumeOffset);
 
 	// Success
 	return true;
@@ -1955,7 +2121,7 @@ bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WR
 // --------------------------------------------------------
 // Gets the index of the specified UAV (or -1)
 // --------------------------------------------------------
-int SimpleComputeShader::GetUnorderedAccessViewIndex(std::string name)
+int SimpleComputeShader::GetUnorderedAccessViewIndex(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, unsigned int>::iterator result =
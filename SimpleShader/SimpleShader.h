@@ -10,6 +10,10 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <atomic>
+
+#include "SimpleShaderReflection.h"
+#include "SimpleRecordingContext.h"
 
 
 // --------------------------------------------------------
@@ -26,7 +30,7 @@ struct SimpleShaderVariable
 // --------------------------------------------------------
 // Contains information about a specific
 // constant buffer in a shader, as well as
-// the local data buffer for it
+// the local data for it, one copy per recording slot
 // --------------------------------------------------------
 struct SimpleConstantBuffer
 {
@@ -35,7 +39,7 @@ struct SimpleConstantBuffer
 	unsigned int Size = 0;
 	unsigned int BindIndex = 0;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
-	unsigned char* LocalDataBuffer = 0;
+	SimpleConstantStaging Staging;
 	std::vector<SimpleShaderVariable> Variables;
 };
 
@@ -57,6 +61,16 @@ struct SimpleSampler
 	unsigned int BindIndex; // The register of the Sampler
 };
 
+// --------------------------------------------------------
+// A variable, SRV or sampler name resolved once, so it
+// can be set repeatedly without a string lookup
+// --------------------------------------------------------
+struct SimpleShaderHandle
+{
+	int Index = -1; // -1 if the name was not found
+	bool IsValid() const { return Index >= 0; }
+};
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -73,55 +87,86 @@ public:
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
-	void CopyBufferData(std::string bufferName);
+	void CopyBufferData(const char* bufferName);
 
 	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	bool SetData(const char* name, const void* data, unsigned int size);
+
+	bool SetInt(const char* name, int data);
+	bool SetFloat(const char* name, float data);
+	bool SetFloat2(const char* name, const float data[2]);
+	bool SetFloat2(const char* name, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const char* name, const float data[3]);
+	bool SetFloat3(const char* name, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const char* name, const float data[4]);
+	bool SetFloat4(const char* name, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const char* name, const float data[16]);
+	bool SetMatrix4x4(const char* name, const DirectX::XMFLOAT4X4 data);
 
 	// Setting shader resources
-	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
-	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+
+	// Resolving names to handles, done once ahead of time
+	SimpleShaderHandle GetVariableHandle(const char* name);
+	SimpleShaderHandle GetShaderResourceViewHandle(const char* name);
+	SimpleShaderHandle GetSamplerHandle(const char* name);
+
+	// Setting data and resources through handles (no lookups)
+	bool SetData(SimpleShaderHandle handle, const void* data, unsigned int size);
+	bool SetInt(SimpleShaderHandle handle, int data);
+	bool SetFloat(SimpleShaderHandle handle, float data);
+	bool SetFloat2(SimpleShaderHandle handle, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(SimpleShaderHandle handle, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(SimpleShaderHandle handle, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(SimpleShaderHandle handle, const DirectX::XMFLOAT4X4& data);
+	bool SetShaderResourceView(SimpleShaderHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(SimpleShaderHandle handle, ID3D11SamplerState* samplerState);
 
 	// Simple resource checking
-	bool HasVariable(std::string name);
-	bool HasShaderResourceView(std::string name);
-	bool HasSamplerState(std::string name);
+	bool HasVariable(const char* name);
+	bool HasShaderResourceView(const char* name);
+	bool HasSamplerState(const char* name);
 
 	// Getting data about variables and resources
-	const SimpleShaderVariable* GetVariableInfo(std::string name);
+	const SimpleShaderVariable* GetVariableInfo(const char* name);
 	
-	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
+	const SimpleSRV* GetShaderResourceViewInfo(const char* name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
 	size_t GetShaderResourceViewCount() { return textureTable.size(); }
 	
-	const SimpleSampler* GetSamplerInfo(std::string name);
+	const SimpleSampler* GetSamplerInfo(const char* name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
 	size_t GetSamplerCount() { return samplerTable.size(); }
 
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
 	unsigned int GetBufferSize(unsigned int index);
-	const SimpleConstantBuffer* GetBufferInfo(std::string name);
+	const SimpleConstantBuffer* GetBufferInfo(const char* name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
 	
 	// Misc getters
 	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
 
+	// Replaces the shader with another compiled one of the same type, keeping
+	// this object (and so every holder of it); handles must be fetched again
+	bool Reload(Microsoft::WRL::ComPtr<ID3DBlob> compiledShader);
+
 	// Error reporting
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Constant buffer upload counters across all shaders and
+	// threads, reset once per frame with ResetUploadStats()
+	// (the counters live with the staging that counts them)
+	static std::atomic<unsigned int>& BytesUploaded;
+	static std::atomic<unsigned int>& UploadsSkipped;
+	static void ResetUploadStats();
+
+	// Reflects a compiled blob, also used to build input layouts
+	// outside of SimpleShader
+	static void ReflectShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob, SimpleShaderReflection& reflection);
+
 protected:
 	
 	bool shaderValid;
@@ -136,23 +181,39 @@ protected:
 	SimpleConstantBuffer*		constantBuffers; // For index-based lookup
 	std::vector<SimpleSRV*>		shaderResourceViews;
 	std::vector<SimpleSampler*>	samplerStates;
+	std::vector<SimpleShaderVariable> variables; // For handle-based lookup
 	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
+	std::unordered_map<std::string, unsigned int> varTable; // Index into variables
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
-	// Initialization method
+	// Reflection data for the loaded blob, from the cache when possible
+	SimpleShaderReflection reflection;
+
+	// Initialization methods
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	bool LoadShaderBlob(Microsoft::WRL::ComPtr<ID3DBlob> blob);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
+	virtual void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv) = 0;
+	virtual void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState) = 0;
 
 	virtual void CleanUp();
 
 	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
-	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+	SimpleShaderVariable* FindVariable(const char* name, int size);
+	SimpleConstantBuffer* FindConstantBuffer(const char* name);
+
+	// The calling thread's context, state tracker (or null) and
+	// staging slot, from its bound SimpleRecordingContext if any
+	ID3D11DeviceContext* GetContext();
+	SimpleStateTracker* GetStateTracker();
+	unsigned int GetStagingSlot();
+
+	// Uploads a buffer's local data only if it changed since the last upload
+	void CopyBufferDataIfDirty(SimpleConstantBuffer* cb);
 
 	// Error logging
 	void Log(std::string message, WORD color);
@@ -178,15 +239,15 @@ public:
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout() { return inputLayout; }
 	bool GetPerInstanceCompatible() { return perInstanceCompatible; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
 protected:
 	bool perInstanceCompatible;
+	bool customInputLayout; // From the constructor, kept across reloads
 	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
 	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 };
 
@@ -201,13 +262,12 @@ public:
 	~SimplePixelShader();
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
 protected:
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 };
 
@@ -221,13 +281,12 @@ public:
 	~SimpleDomainShader();
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
 protected:
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 };
 
@@ -241,13 +300,12 @@ public:
 	~SimpleHullShader();
 	Microsoft::WRL::ComPtr<ID3D11HullShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
 protected:
 	Microsoft::WRL::ComPtr<ID3D11HullShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 };
 
@@ -261,9 +319,6 @@ public:
 	~SimpleGeometryShader();
 	Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-
 	bool CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount);
 
 	static void UnbindStreamOutStage(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext);
@@ -280,6 +335,8 @@ protected:
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	bool CreateShaderWithStreamOut(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 
 	// Helpers
@@ -300,13 +357,11 @@ public:
 	void DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ);
 	void DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ);
 
-	bool HasUnorderedAccessView(std::string name);
+	bool HasUnorderedAccessView(const char* name);
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-	bool SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
+	bool SetUnorderedAccessView(const char* name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
 
-	int GetUnorderedAccessViewIndex(std::string name);
+	int GetUnorderedAccessViewIndex(const char* name);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11ComputeShader> shader;
@@ -319,5 +374,7 @@ protected:
 
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
+	void BindShaderResourceView(unsigned int bindIndex, ID3D11ShaderResourceView* srv);
+	void BindSamplerState(unsigned int bindIndex, ID3D11SamplerState* samplerState);
 	void CleanUp();
 };
\ No newline at end of file
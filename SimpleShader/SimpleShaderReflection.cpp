@@ -0,0 +1,269 @@
+#include "SimpleShaderReflection.h"
+
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+
+// File header, bump the version whenever the layout changes
+#define REFLECTION_CACHE_MAGIC 0x43525353 // "SSRC"
+#define REFLECTION_CACHE_VERSION 1
+
+// Static members
+std::string SimpleShaderReflectionCache::Directory;
+unsigned int SimpleShaderReflectionCache::Hits = 0;
+unsigned int SimpleShaderReflectionCache::Misses = 0;
+std::unordered_map<unsigned long long, SimpleShaderReflection> SimpleShaderReflectionCache::entries;
+
+
+// --------------------------------------------------------
+// Helpers for writing and reading the serialized format:
+// little endian 32 bit values and length prefixed strings
+// --------------------------------------------------------
+namespace
+{
+	void WriteUInt(std::vector<unsigned char>& bytes, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+			bytes.push_back((unsigned char)(value >> (i * 8)));
+	}
+
+	void WriteString(std::vector<unsigned char>& bytes, const std::string& str)
+	{
+		WriteUInt(bytes, (unsigned int)str.size());
+		bytes.insert(bytes.end(), str.begin(), str.end());
+	}
+
+	struct Reader
+	{
+		const unsigned char* Bytes;
+		size_t Size;
+		size_t Position;
+		bool Failed;
+
+		unsigned int ReadUInt()
+		{
+			if (Failed || Size - Position < 4) { Failed = true; return 0; }
+			unsigned int value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= (unsigned int)Bytes[Position + i] << (i * 8);
+			Position += 4;
+			return value;
+		}
+
+		std::string ReadString()
+		{
+			unsigned int length = ReadUInt();
+			if (Failed || Size - Position < length) { Failed = true; return std::string(); }
+			std::string str((const char*)Bytes + Position, length);
+			Position += length;
+			return str;
+		}
+
+		// Reads an element count, rejecting counts the remaining bytes can't hold
+		unsigned int ReadCount()
+		{
+			unsigned int count = ReadUInt();
+			if (Failed || count > Size - Position) { Failed = true; return 0; }
+			return count;
+		}
+	};
+}
+
+// --------------------------------------------------------
+// Hashes a compiled shader blob (64 bit FNV-1a)
+// --------------------------------------------------------
+unsigned long long SimpleShaderReflectionCache::HashBlob(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Writes reflection data to a byte array
+// --------------------------------------------------------
+void SimpleShaderReflectionCache::Serialize(const SimpleShaderReflection& reflection, std::vector<unsigned char>& bytes)
+{
+	bytes.clear();
+	WriteUInt(bytes, REFLECTION_CACHE_MAGIC);
+	WriteUInt(bytes, REFLECTION_CACHE_VERSION);
+
+	WriteUInt(bytes, (unsigned int)reflection.ConstantBuffers.size());
+	for (const SimpleReflectedBuffer& cb : reflection.ConstantBuffers)
+	{
+		WriteString(bytes, cb.Name);
+		WriteUInt(bytes, cb.Type);
+		WriteUInt(bytes, cb.Size);
+		WriteUInt(bytes, cb.BindIndex);
+		WriteUInt(bytes, (unsigned int)cb.Variables.size());
+		for (const SimpleReflectedVariable& var : cb.Variables)
+		{
+			WriteString(bytes, var.Name);
+			WriteUInt(bytes, var.ByteOffset);
+			WriteUInt(bytes, var.Size);
+		}
+	}
+
+	WriteUInt(bytes, (unsigned int)reflection.ShaderResourceViews.size());
+	for (const SimpleReflectedResource& srv : reflection.ShaderResourceViews)
+	{
+		WriteString(bytes, srv.Name);
+		WriteUInt(bytes, srv.BindIndex);
+	}
+
+	WriteUInt(bytes, (unsigned int)reflection.Samplers.size());
+	for (const SimpleReflectedResource& samp : reflection.Samplers)
+	{
+		WriteString(bytes, samp.Name);
+		WriteUInt(bytes, samp.BindIndex);
+	}
+
+	WriteUInt(bytes, (unsigned int)reflection.Inputs.size());
+	for (const SimpleReflectedInput& input : reflection.Inputs)
+	{
+		WriteString(bytes, input.SemanticName);
+		WriteUInt(bytes, input.SemanticIndex);
+		WriteUInt(bytes, input.Format);
+		WriteUInt(bytes, input.PerInstance ? 1 : 0);
+	}
+}
+
+// --------------------------------------------------------
+// Reads reflection data from a byte array
+//
+// Returns false if the data is truncated, malformed or
+// from a different version of the format
+// --------------------------------------------------------
+bool SimpleShaderReflectionCache::Deserialize(const unsigned char* bytes, size_t size, SimpleShaderReflection& reflection)
+{
+	Reader reader = { bytes, size, 0, false };
+	if (reader.ReadUInt() != REFLECTION_CACHE_MAGIC || reader.ReadUInt() != REFLECTION_CACHE_VERSION)
+		return false;
+
+	SimpleShaderReflection result;
+
+	result.ConstantBuffers.resize(reader.ReadCount());
+	for (SimpleReflectedBuffer& cb : result.ConstantBuffers)
+	{
+		cb.Name = reader.ReadString();
+		cb.Type = reader.ReadUInt();
+		cb.Size = reader.ReadUInt();
+		cb.BindIndex = reader.ReadUInt();
+		cb.Variables.resize(reader.ReadCount());
+		for (SimpleReflectedVariable& var : cb.Variables)
+		{
+			var.Name = reader.ReadString();
+			var.ByteOffset = reader.ReadUInt();
+			var.Size = reader.ReadUInt();
+		}
+	}
+
+	result.ShaderResourceViews.resize(reader.ReadCount());
+	for (SimpleReflectedResource& srv : result.ShaderResourceViews)
+	{
+		srv.Name = reader.ReadString();
+		srv.BindIndex = reader.ReadUInt();
+	}
+
+	result.Samplers.resize(reader.ReadCount());
+	for (SimpleReflectedResource& samp : result.Samplers)
+	{
+		samp.Name = reader.ReadString();
+		samp.BindIndex = reader.ReadUInt();
+	}
+
+	result.Inputs.resize(reader.ReadCount());
+	for (SimpleReflectedInput& input : result.Inputs)
+	{
+		input.SemanticName = reader.ReadString();
+		input.SemanticIndex = reader.ReadUInt();
+		input.Format = reader.ReadUInt();
+		input.PerInstance = reader.ReadUInt() != 0;
+	}
+
+	// Everything must have been read, and nothing more
+	if (reader.Failed || reader.Position != size)
+		return false;
+
+	reflection = result;
+	return true;
+}
+
+// --------------------------------------------------------
+// Looks for cached reflection data, first in memory and
+// then on disk
+// --------------------------------------------------------
+bool SimpleShaderReflectionCache::Find(unsigned long long hash, SimpleShaderReflection& reflection)
+{
+	// Already loaded this run?
+	std::unordered_map<unsigned long long, SimpleShaderReflection>::iterator result =
+		entries.find(hash);
+	if (result != entries.end())
+	{
+		reflection = result->second;
+		Hits++;
+		return true;
+	}
+
+	// Saved by an earlier run?
+	if (!Directory.empty())
+	{
+		std::ifstream file(GetFilePath(hash), std::ios::binary);
+		if (file)
+		{
+			std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			if (!bytes.empty() && Deserialize(&bytes[0], bytes.size(), reflection))
+			{
+				entries[hash] = reflection;
+				Hits++;
+				return true;
+			}
+		}
+	}
+
+	Misses++;
+	return false;
+}
+
+// --------------------------------------------------------
+// Adds reflection data to the cache, writing it to disk
+// if a directory is set
+// --------------------------------------------------------
+void SimpleShaderReflectionCache::Store(unsigned long long hash, const SimpleShaderReflection& reflection)
+{
+	entries[hash] = reflection;
+
+	if (Directory.empty())
+		return;
+
+	std::vector<unsigned char> bytes;
+	Serialize(reflection, bytes);
+
+	std::ofstream file(GetFilePath(hash), std::ios::binary | std::ios::trunc);
+	if (file)
+		file.write((const char*)&bytes[0], bytes.size());
+}
+
+// --------------------------------------------------------
+// Empties the in-memory cache (files are left alone)
+// --------------------------------------------------------
+void SimpleShaderReflectionCache::Clear()
+{
+	entries.clear();
+}
+
+// --------------------------------------------------------
+// Gets the cache file path for a blob hash
+// --------------------------------------------------------
+std::string SimpleShaderReflectionCache::GetFilePath(unsigned long long hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.refl", hash);
+	return Directory + name;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// --------------------------------------------------------
+// Reflected data about a single constant buffer variable
+// --------------------------------------------------------
+struct SimpleReflectedVariable
+{
+	std::string Name;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;
+};
+
+// --------------------------------------------------------
+// Reflected data about a single constant buffer
+// --------------------------------------------------------
+struct SimpleReflectedBuffer
+{
+	std::string Name;
+	unsigned int Type = 0;		// D3D_CBUFFER_TYPE
+	unsigned int Size = 0;
+	unsigned int BindIndex = 0;
+	std::vector<SimpleReflectedVariable> Variables;
+};
+
+// --------------------------------------------------------
+// Reflected data about a bound resource (SRV or sampler)
+// --------------------------------------------------------
+struct SimpleReflectedResource
+{
+	std::string Name;
+	unsigned int BindIndex = 0;
+};
+
+// --------------------------------------------------------
+// Reflected data about a single shader input, enough to
+// build an input layout element from
+// --------------------------------------------------------
+struct SimpleReflectedInput
+{
+	std::string SemanticName;
+	unsigned int SemanticIndex = 0;
+	unsigned int Format = 0;	// DXGI_FORMAT
+	bool PerInstance = false;
+};
+
+// --------------------------------------------------------
+// Everything SimpleShader needs from shader reflection,
+// in a form that can be cached without Direct3D
+// --------------------------------------------------------
+struct SimpleShaderReflection
+{
+	std::vector<SimpleReflectedBuffer> ConstantBuffers;
+	std::vector<SimpleReflectedResource> ShaderResourceViews;
+	std::vector<SimpleReflectedResource> Samplers;
+	std::vector<SimpleReflectedInput> Inputs;
+};
+
+// --------------------------------------------------------
+// Cache of shader reflection data keyed by a hash of the
+// compiled shader blob. Entries are kept in memory and,
+// if a directory is set, in one file per blob so later
+// launches can skip reflection too.
+// --------------------------------------------------------
+class SimpleShaderReflectionCache
+{
+public:
+	// Where cache files are read and written, ending in a path separator.
+	// Empty keeps the cache in memory only.
+	static std::string Directory;
+
+	// Looking up and adding entries
+	static bool Find(unsigned long long hash, SimpleShaderReflection& reflection);
+	static void Store(unsigned long long hash, const SimpleShaderReflection& reflection);
+	static void Clear();
+
+	// Hit and miss counts since startup
+	static unsigned int Hits;
+	static unsigned int Misses;
+
+	// Helpers, public so they can be used on their own
+	static unsigned long long HashBlob(const void* data, size_t size);
+	static void Serialize(const SimpleShaderReflection& reflection, std::vector<unsigned char>& bytes);
+	static bool Deserialize(const unsigned char* bytes, size_t size, SimpleShaderReflection& reflection);
+
+private:
+	static std::unordered_map<unsigned long long, SimpleShaderReflection> entries;
+	static std::string GetFilePath(unsigned long long hash);
+};
@@ -0,0 +1,171 @@
+#include "SimpleStateFilter.h"
+
+#include <cstring>
+#include <cstdint>
+
+// Marks state that may be anything, since no real object has this address
+static const void* const UnknownState = reinterpret_cast<const void*>(~(uintptr_t)0);
+
+// --------------------------------------------------------
+// Constructor assumes nothing about what is bound
+// --------------------------------------------------------
+SimpleStateFilter::SimpleStateFilter()
+{
+	Invalidate();
+	ResetStats();
+}
+
+SimpleStateFilter::~SimpleStateFilter() {}
+
+void SimpleStateFilter::Invalidate()
+{
+	inputLayout = UnknownState;
+	vertexShader = UnknownState;
+	pixelShader = UnknownState;
+	for (unsigned int i = 0; i < SIMPLE_STATE_CONSTANT_BUFFER_SLOTS; i++)
+	{
+		vsConstantBuffers[i] = UnknownState;
+		psConstantBuffers[i] = UnknownState;
+	}
+	for (unsigned int i = 0; i < SIMPLE_STATE_SAMPLER_SLOTS; i++)
+	{
+		vsSamplers[i] = UnknownState;
+		psSamplers[i] = UnknownState;
+	}
+	InvalidateShaderResources();
+	rasterizerState = UnknownState;
+	depthStencilState = UnknownState;
+	stencilRef = 0;
+	renderTarget = UnknownState;
+	depthStencilView = UnknownState;
+	viewportKnown = false;
+}
+
+void SimpleStateFilter::InvalidateVSConstantBuffer(unsigned int slot)
+{
+	vsConstantBuffers[slot] = UnknownState;
+}
+
+void SimpleStateFilter::ResetStats()
+{
+	issuedCalls = 0;
+	filteredCalls = 0;
+}
+
+bool SimpleStateFilter::Track(const void*& bound, const void* value)
+{
+	if (bound == value)
+	{
+		filteredCalls++;
+		return false;
+	}
+
+	bound = value;
+	issuedCalls++;
+	return true;
+}
+
+void SimpleStateFilter::InvalidateShaderResources()
+{
+	for (unsigned int i = 0; i < SIMPLE_STATE_INPUT_RESOURCE_SLOTS; i++)
+	{
+		vsShaderResources[i] = UnknownState;
+		psShaderResources[i] = UnknownState;
+	}
+}
+
+bool SimpleStateFilter::SetInputLayout(const void* inputLayout)
+{
+	return Track(this->inputLayout, inputLayout);
+}
+
+bool SimpleStateFilter::SetVertexShader(const void* shader)
+{
+	return Track(vertexShader, shader);
+}
+
+bool SimpleStateFilter::SetPixelShader(const void* shader)
+{
+	return Track(pixelShader, shader);
+}
+
+bool SimpleStateFilter::SetVSConstantBuffer(unsigned int slot, const void* buffer)
+{
+	return Track(vsConstantBuffers[slot], buffer);
+}
+
+bool SimpleStateFilter::SetPSConstantBuffer(unsigned int slot, const void* buffer)
+{
+	return Track(psConstantBuffers[slot], buffer);
+}
+
+bool SimpleStateFilter::SetVSShaderResource(unsigned int slot, const void* srv)
+{
+	return Track(vsShaderResources[slot], srv);
+}
+
+bool SimpleStateFilter::SetPSShaderResource(unsigned int slot, const void* srv)
+{
+	return Track(psShaderResources[slot], srv);
+}
+
+bool SimpleStateFilter::SetVSSampler(unsigned int slot, const void* sampler)
+{
+	return Track(vsSamplers[slot], sampler);
+}
+
+bool SimpleStateFilter::SetPSSampler(unsigned int slot, const void* sampler)
+{
+	return Track(psSamplers[slot], sampler);
+}
+
+bool SimpleStateFilter::SetRasterizerState(const void* state)
+{
+	return Track(rasterizerState, state);
+}
+
+bool SimpleStateFilter::SetDepthStencilState(const void* state, unsigned int stencilRef)
+{
+	if (depthStencilState == state && this->stencilRef == stencilRef)
+	{
+		filteredCalls++;
+		return false;
+	}
+
+	depthStencilState = state;
+	this->stencilRef = stencilRef;
+	issuedCalls++;
+	return true;
+}
+
+bool SimpleStateFilter::SetViewport(const SimpleViewport& viewport)
+{
+	if (viewportKnown && memcmp(&this->viewport, &viewport, sizeof(SimpleViewport)) == 0)
+	{
+		filteredCalls++;
+		return false;
+	}
+
+	this->viewport = viewport;
+	viewportKnown = true;
+	issuedCalls++;
+	return true;
+}
+
+bool SimpleStateFilter::SetRenderTarget(const void* rtv, const void* dsv)
+{
+	if (renderTarget == rtv && depthStencilView == dsv)
+	{
+		filteredCalls++;
+		return false;
+	}
+
+	renderTarget = rtv;
+	depthStencilView = dsv;
+	issuedCalls++;
+
+	// Binding a resource as an output silently unbinds its SRVs, and
+	// there's no telling which slots that hit, so forget them all
+	InvalidateShaderResources();
+	return true;
+}
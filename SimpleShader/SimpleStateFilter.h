@@ -0,0 +1,88 @@
+#pragma once
+
+// Per stage slot counts, the same as D3D11's
+#define SIMPLE_STATE_CONSTANT_BUFFER_SLOTS 14
+#define SIMPLE_STATE_INPUT_RESOURCE_SLOTS 128
+#define SIMPLE_STATE_SAMPLER_SLOTS 16
+
+// A viewport laid out like D3D11_VIEWPORT
+struct SimpleViewport
+{
+	float TopLeftX;
+	float TopLeftY;
+	float Width;
+	float Height;
+	float MinDepth;
+	float MaxDepth;
+};
+
+// --------------------------------------------------------
+// The bookkeeping behind SimpleStateTracker: remembers the
+// objects bound to each piece of state and decides which
+// binds repeat what's already there. Each Set records a
+// bind and returns true if it must be issued. Objects are
+// only compared by address.
+// --------------------------------------------------------
+class SimpleStateFilter
+{
+public:
+	SimpleStateFilter();
+	~SimpleStateFilter();
+
+	// Forgets all tracked state, so every next bind is issued
+	void Invalidate();
+
+	// Forgets one constant buffer slot, after binding it directly
+	void InvalidateVSConstantBuffer(unsigned int slot);
+
+	// Shaders and input assembly
+	bool SetInputLayout(const void* inputLayout);
+	bool SetVertexShader(const void* shader);
+	bool SetPixelShader(const void* shader);
+
+	// Per stage resources
+	bool SetVSConstantBuffer(unsigned int slot, const void* buffer);
+	bool SetPSConstantBuffer(unsigned int slot, const void* buffer);
+	bool SetVSShaderResource(unsigned int slot, const void* srv);
+	bool SetPSShaderResource(unsigned int slot, const void* srv);
+	bool SetVSSampler(unsigned int slot, const void* sampler);
+	bool SetPSSampler(unsigned int slot, const void* sampler);
+
+	// Fixed function state. A new render target forgets every
+	// shader resource, since binding an output unbinds its SRVs.
+	bool SetRasterizerState(const void* state);
+	bool SetDepthStencilState(const void* state, unsigned int stencilRef);
+	bool SetViewport(const SimpleViewport& viewport);
+	bool SetRenderTarget(const void* rtv, const void* dsv);
+
+	// Binds issued and binds filtered out since the last reset
+	unsigned int GetIssuedCalls() { return issuedCalls; }
+	unsigned int GetFilteredCalls() { return filteredCalls; }
+	void ResetStats();
+
+private:
+	// Bound objects, or UnknownState after Invalidate()
+	const void* inputLayout;
+	const void* vertexShader;
+	const void* pixelShader;
+	const void* vsConstantBuffers[SIMPLE_STATE_CONSTANT_BUFFER_SLOTS];
+	const void* psConstantBuffers[SIMPLE_STATE_CONSTANT_BUFFER_SLOTS];
+	const void* vsShaderResources[SIMPLE_STATE_INPUT_RESOURCE_SLOTS];
+	const void* psShaderResources[SIMPLE_STATE_INPUT_RESOURCE_SLOTS];
+	const void* vsSamplers[SIMPLE_STATE_SAMPLER_SLOTS];
+	const void* psSamplers[SIMPLE_STATE_SAMPLER_SLOTS];
+	const void* rasterizerState;
+	const void* depthStencilState;
+	unsigned int stencilRef;
+	const void* renderTarget;
+	const void* depthStencilView;
+	SimpleViewport viewport;
+	bool viewportKnown;
+
+	unsigned int issuedCalls;
+	unsigned int filteredCalls;
+
+	// Updates a cached value, returning true if the bind must be issued
+	bool Track(const void*& bound, const void* value);
+	void InvalidateShaderResources();
+};
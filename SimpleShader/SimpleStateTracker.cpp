@@ -0,0 +1,106 @@
+#include "SimpleStateTracker.h"
+
+static_assert(SIMPLE_STATE_CONSTANT_BUFFER_SLOTS == D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, "Constant buffer slot counts differ");
+static_assert(SIMPLE_STATE_INPUT_RESOURCE_SLOTS == D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, "Input resource slot counts differ");
+static_assert(SIMPLE_STATE_SAMPLER_SLOTS == D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, "Sampler slot counts differ");
+static_assert(sizeof(SimpleViewport) == sizeof(D3D11_VIEWPORT), "SimpleViewport isn't laid out like D3D11_VIEWPORT");
+
+// --------------------------------------------------------
+// Constructor accepts the context to track, assuming
+// nothing about what is currently bound to it
+// --------------------------------------------------------
+SimpleStateTracker::SimpleStateTracker(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->context = context;
+}
+
+SimpleStateTracker::~SimpleStateTracker() {}
+
+void SimpleStateTracker::Invalidate()
+{
+	filter.Invalidate();
+}
+
+void SimpleStateTracker::InvalidateVSConstantBuffer(unsigned int slot)
+{
+	filter.InvalidateVSConstantBuffer(slot);
+}
+
+void SimpleStateTracker::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	if (filter.SetInputLayout(inputLayout))
+		context->IASetInputLayout(inputLayout);
+}
+
+void SimpleStateTracker::SetVertexShader(ID3D11VertexShader* shader)
+{
+	if (filter.SetVertexShader(shader))
+		context->VSSetShader(shader, 0, 0);
+}
+
+void SimpleStateTracker::SetPixelShader(ID3D11PixelShader* shader)
+{
+	if (filter.SetPixelShader(shader))
+		context->PSSetShader(shader, 0, 0);
+}
+
+void SimpleStateTracker::SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (filter.SetVSConstantBuffer(slot, buffer))
+		context->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void SimpleStateTracker::SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (filter.SetPSConstantBuffer(slot, buffer))
+		context->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void SimpleStateTracker::SetVSShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (filter.SetVSShaderResource(slot, srv))
+		context->VSSetShaderResources(slot, 1, &srv);
+}
+
+void SimpleStateTracker::SetPSShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (filter.SetPSShaderResource(slot, srv))
+		context->PSSetShaderResources(slot, 1, &srv);
+}
+
+void SimpleStateTracker::SetVSSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (filter.SetVSSampler(slot, sampler))
+		context->VSSetSamplers(slot, 1, &sampler);
+}
+
+void SimpleStateTracker::SetPSSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (filter.SetPSSampler(slot, sampler))
+		context->PSSetSamplers(slot, 1, &sampler);
+}
+
+void SimpleStateTracker::SetRasterizerState(ID3D11RasterizerState* state)
+{
+	if (filter.SetRasterizerState(state))
+		context->RSSetState(state);
+}
+
+void SimpleStateTracker::SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	if (filter.SetDepthStencilState(state, stencilRef))
+		context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void SimpleStateTracker::SetViewport(const D3D11_VIEWPORT& viewport)
+{
+	SimpleViewport tracked = { viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth };
+	if (filter.SetViewport(tracked))
+		context->RSSetViewports(1, &viewport);
+}
+
+void SimpleStateTracker::SetRenderTarget(ID3D11RenderTargetView* rtv, ID3D11DepthStencilView* dsv)
+{
+	if (filter.SetRenderTarget(rtv, dsv))
+		context->OMSetRenderTargets(rtv ? 1 : 0, rtv ? &rtv : 0, dsv);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include "SimpleStateFilter.h"
+
+// --------------------------------------------------------
+// Remembers what is bound to a device context and filters
+// out calls that would bind the same thing again. Only
+// correct if everything that changes tracked state goes
+// through it; call Invalidate() after code that doesn't.
+// The deciding is done by a SimpleStateFilter, this only
+// issues what it lets through.
+// --------------------------------------------------------
+class SimpleStateTracker
+{
+public:
+	SimpleStateTracker(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~SimpleStateTracker();
+
+	ID3D11DeviceContext* GetContext() { return context.Get(); }
+
+	// Forgets all tracked state, so every next call is issued
+	void Invalidate();
+
+	// Forgets one constant buffer slot, after binding it directly
+	void InvalidateVSConstantBuffer(unsigned int slot);
+
+	// Shaders and input assembly
+	void SetInputLayout(ID3D11InputLayout* inputLayout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+
+	// Per stage resources
+	void SetVSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void SetVSShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void SetPSShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void SetVSSampler(unsigned int slot, ID3D11SamplerState* sampler);
+	void SetPSSampler(unsigned int slot, ID3D11SamplerState* sampler);
+
+	// Fixed function state
+	void SetRasterizerState(ID3D11RasterizerState* state);
+	void SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+	void SetViewport(const D3D11_VIEWPORT& viewport);
+	void SetRenderTarget(ID3D11RenderTargetView* rtv, ID3D11DepthStencilView* dsv);
+
+	// Calls passed to the context and calls filtered out since the last reset
+	unsigned int GetIssuedCalls() { return filter.GetIssuedCalls(); }
+	unsigned int GetFilteredCalls() { return filter.GetFilteredCalls(); }
+	void ResetStats() { filter.ResetStats(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+
+	SimpleStateFilter filter;
+};
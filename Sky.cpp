@@ -1,9 +1,12 @@
 #include "Sky.h"
+#include "Profiler.h"
+#include "SkyProjection.h"
 
 Sky::Sky(std::shared_ptr<Mesh> cubeMesh, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, 
   Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skySRV,
 	std::shared_ptr<SimplePixelShader> skyPS,
 	std::shared_ptr<SimpleVertexShader> skyVS,
+	std::shared_ptr<SimpleVertexShader> fullscreenVS,
 	Microsoft::WRL::ComPtr<ID3D11Device> device)
 {
 	skyMesh = cubeMesh;
@@ -11,6 +14,8 @@ Sky::Sky(std::shared_ptr<Mesh> cubeMesh, Microsoft::WRL::ComPtr<ID3D11SamplerSta
 	textureSRV = skySRV;
 	skyPixelShader = skyPS;
 	skyVertexShader = skyVS;
+	fullscreenVertexShader = fullscreenVS;
+	RefreshShaderHandles();
 
 	//creating rasterizer state
 	D3D11_RASTERIZER_DESC rasterizerDesc = {};
@@ -18,34 +23,59 @@ Sky::Sky(std::shared_ptr<Mesh> cubeMesh, Microsoft::WRL::ComPtr<ID3D11SamplerSta
 	rasterizerDesc.CullMode = D3D11_CULL_FRONT;
 	device->CreateRasterizerState(&rasterizerDesc, rasterizerState.GetAddressOf());
 
-	//creating depth-stencil state
+	//creating depth-stencil state: the sky sits on the far plane and never writes depth
 	D3D11_DEPTH_STENCIL_DESC depthStencilDesc = {};
 	depthStencilDesc.DepthEnable = true;
+	depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
 	depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
 	device->CreateDepthStencilState(&depthStencilDesc, stencilState.GetAddressOf());
 }
 
 Sky::~Sky() {}
 
-void Sky::Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, std::shared_ptr<Camera> camera)
+void Sky::SetTextureSRV(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skySRV)
 {
-	context->RSSetState(rasterizerState.Get());
-	context->OMSetDepthStencilState(stencilState.Get(), 0);
+	this->textureSRV = skySRV;
+}
 
-	skyVertexShader->SetMatrix4x4("view", camera->GetViewMatrix());
-	skyVertexShader->SetMatrix4x4("projection", camera->GetProjectionMatrix());
-	skyVertexShader->CopyAllBufferData();
+void Sky::RefreshShaderHandles()
+{
+	viewHandle = skyVertexShader->GetVariableHandle("view");
+	projectionHandle = skyVertexShader->GetVariableHandle("projection");
+	inverseViewProjectionHandle = fullscreenVertexShader->GetVariableHandle("inverseViewProjection");
+	cubeMapHandle = skyPixelShader->GetShaderResourceViewHandle("CubeMap");
+	samplerHandle = skyPixelShader->GetSamplerHandle("BasicSampler");
+}
 
-	skyPixelShader->SetShaderResourceView("CubeMap", textureSRV);
-	skyPixelShader->SetSamplerState("BasicSampler", sampler);
-	skyPixelShader->CopyAllBufferData();
+void Sky::Draw(SimpleStateTracker* stateTracker, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, bool fullscreen)
+{
+	PROFILE_SCOPE("Sky");
+	stateTracker->SetDepthStencilState(stencilState.Get(), 0);
 
-	skyVertexShader->SetShader();
+	skyPixelShader->SetShaderResourceView(cubeMapHandle, textureSRV.Get());
+	skyPixelShader->SetSamplerState(samplerHandle, sampler.Get());
 	skyPixelShader->SetShader();
 
-	skyMesh->Draw();
+	if (fullscreen)
+	{
+		//the triangle is wound for the default state, and reads no vertices
+		DirectX::XMFLOAT4X4 inverseViewProjection;
+		if (!SkyProjection::GetInverseViewProjection(&view._11, &projection._11, &inverseViewProjection._11))
+			return;
+
+		stateTracker->SetRasterizerState(0);
+		fullscreenVertexShader->SetMatrix4x4(inverseViewProjectionHandle, inverseViewProjection);
+		fullscreenVertexShader->CopyAllBufferData();
+		fullscreenVertexShader->SetShader();
+		stateTracker->GetContext()->Draw(3, 0);
+		return;
+	}
+
+	stateTracker->SetRasterizerState(rasterizerState.Get());
+	skyVertexShader->SetMatrix4x4(viewHandle, view);
+	skyVertexShader->SetMatrix4x4(projectionHandle, projection);
+	skyVertexShader->CopyAllBufferData();
+	skyVertexShader->SetShader();
 
-	//reset render states
-	context->RSSetState(0);
-	context->OMSetDepthStencilState(0, 0);
+	skyMesh->Draw();
 }
@@ -13,11 +13,20 @@ public:
 	  Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skySRV,
 		std::shared_ptr<SimplePixelShader> skyPS,
 		std::shared_ptr<SimpleVertexShader> skyVS,
+		std::shared_ptr<SimpleVertexShader> fullscreenVS,
 		Microsoft::WRL::ComPtr<ID3D11Device> device);
 	
 	~Sky();
 
-	void Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, std::shared_ptr<Camera> camera);
+	//The cube map arrives after the sky is made when assets load in the background
+	void SetTextureSRV(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> skySRV);
+
+	//After one of its shaders reloaded in place
+	void RefreshShaderHandles();
+
+	//Draws after everything else, where depth already hides most of it. fullscreen draws one
+	//triangle from the vertex id, with no mesh or rasterizer state, instead of the cube.
+	void Draw(SimpleStateTracker* stateTracker, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, bool fullscreen); //leaves its states bound
 
 
 private:
@@ -29,4 +38,12 @@ private:
 	std::shared_ptr<Mesh> skyMesh;
 	std::shared_ptr<SimplePixelShader> skyPixelShader;
 	std::shared_ptr<SimpleVertexShader> skyVertexShader;
+	std::shared_ptr<SimpleVertexShader> fullscreenVertexShader;
+
+	//resolved once rather than looked up by name every frame
+	SimpleShaderHandle viewHandle;
+	SimpleShaderHandle projectionHandle;
+	SimpleShaderHandle inverseViewProjectionHandle;
+	SimpleShaderHandle cubeMapHandle;
+	SimpleShaderHandle samplerHandle;
 };
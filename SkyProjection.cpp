@@ -0,0 +1,110 @@
+#include "SkyProjection.h"
+#include <cmath>
+
+namespace
+{
+	void Multiply(const float a[16], const float b[16], float result[16])
+	{
+		for (unsigned int row = 0; row < 4; row++)
+		{
+			for (unsigned int column = 0; column < 4; column++)
+			{
+				float sum = 0.0f;
+				for (unsigned int k = 0; k < 4; k++)
+					sum += a[row * 4 + k] * b[k * 4 + column];
+				result[row * 4 + column] = sum;
+			}
+		}
+	}
+
+	// Row vector times matrix
+	void Transform(const float v[4], const float m[16], float result[4])
+	{
+		for (unsigned int column = 0; column < 4; column++)
+			result[column] = v[0] * m[column] + v[1] * m[4 + column] + v[2] * m[8 + column] + v[3] * m[12 + column];
+	}
+
+	// By cofactors, in double so the far plane survives a small near plane
+	bool Invert(const float m[16], float inverse[16])
+	{
+		double a[16];
+		for (unsigned int i = 0; i < 16; i++)
+			a[i] = m[i];
+
+		double c[16];
+		c[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		c[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		c[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		c[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		c[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		c[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		c[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		c[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		c[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		c[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		c[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		c[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		c[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		c[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		c[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		c[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		double determinant = a[0] * c[0] + a[1] * c[4] + a[2] * c[8] + a[3] * c[12];
+		if (std::fabs(determinant) < 1e-30)
+			return false;
+
+		for (unsigned int i = 0; i < 16; i++)
+			inverse[i] = (float)(c[i] / determinant);
+		return true;
+	}
+}
+
+void SkyProjection::GetViewProjection(const float view[16], const float projection[16], float viewProjection[16])
+{
+	//the last row of a row vector matrix is its translation
+	float rotation[16];
+	for (unsigned int i = 0; i < 16; i++)
+		rotation[i] = view[i];
+	rotation[12] = 0.0f;
+	rotation[13] = 0.0f;
+	rotation[14] = 0.0f;
+	Multiply(rotation, projection, viewProjection);
+}
+
+bool SkyProjection::GetInverseViewProjection(const float view[16], const float projection[16], float inverse[16])
+{
+	float viewProjection[16];
+	GetViewProjection(view, projection, viewProjection);
+	return Invert(viewProjection, inverse);
+}
+
+void SkyProjection::GetFullscreenVertex(unsigned int vertex, float ndc[2])
+{
+	//matches VertexShader_SkyFullscreen: (-1, 1), (3, 1), (-1, -3)
+	float u = (float)((vertex << 1) & 2);
+	float v = (float)(vertex & 2);
+	ndc[0] = u * 2.0f - 1.0f;
+	ndc[1] = v * -2.0f + 1.0f;
+}
+
+void SkyProjection::ReconstructDirection(const float inverseViewProjection[16], float ndcX, float ndcY, float direction[3])
+{
+	float farPoint[4] = { ndcX, ndcY, 1.0f, 1.0f };
+	float result[4];
+	Transform(farPoint, inverseViewProjection, result);
+	for (unsigned int i = 0; i < 3; i++)
+		direction[i] = result[i];
+}
+
+bool SkyProjection::ProjectDirection(const float viewProjection[16], const float direction[3], float ndc[2])
+{
+	float point[4] = { direction[0], direction[1], direction[2], 1.0f };
+	float clip[4];
+	Transform(point, viewProjection, clip);
+	if (clip[3] <= 0.0f)
+		return false;
+
+	ndc[0] = clip[0] / clip[3];
+	ndc[1] = clip[1] / clip[3];
+	return true;
+}
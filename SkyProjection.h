@@ -0,0 +1,34 @@
+#pragma once
+
+// --------------------------------------------------------
+// The math of the two ways the sky is drawn, so they can be
+// compared without a device. The cube path projects a cube
+// around the camera and samples along each interpolated
+// corner; the fullscreen path draws one triangle over the
+// screen and turns each point back into a direction through
+// the inverse view-projection. Both leave out the camera's
+// translation. Matrices are 16 floats laid out like
+// XMFLOAT4X4, for row vectors (v * M), as the Camera keeps
+// them.
+// --------------------------------------------------------
+class SkyProjection
+{
+public:
+	//The view without its translation, then the projection
+	static void GetViewProjection(const float view[16], const float projection[16], float viewProjection[16]);
+
+	//What the fullscreen vertex shader gets; false if the matrix can't be inverted
+	static bool GetInverseViewProjection(const float view[16], const float projection[16], float inverse[16]);
+
+	//Corner of the fullscreen triangle for SV_VertexID 0 to 2, in NDC. The triangle
+	//covers the screen and is wound clockwise, for the default rasterizer state.
+	static void GetFullscreenVertex(unsigned int vertex, float ndc[2]);
+
+	//What the fullscreen path samples at a point of the screen, as the vertex shader
+	//computes it: the point on the far plane times its w, which is the same all over
+	//the plane, so it's linear in the screen point. Not normalized.
+	static void ReconstructDirection(const float inverseViewProjection[16], float ndcX, float ndcY, float direction[3]);
+
+	//Where the cube path draws a direction; false if it's behind the camera
+	static bool ProjectDirection(const float viewProjection[16], const float direction[3], float ndc[2]);
+};
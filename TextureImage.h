@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// 8 bit per channel pixels in CPU memory, rows tightly
+// packed top to bottom.
+// --------------------------------------------------------
+struct TextureImage
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	unsigned int Channels = 0;
+	std::vector<unsigned char> Pixels;
+
+	void Allocate(unsigned int width, unsigned int height, unsigned int channels)
+	{
+		Width = width;
+		Height = height;
+		Channels = channels;
+		Pixels.assign((size_t)width * height * channels, 0);
+	}
+
+	unsigned char* GetPixel(unsigned int x, unsigned int y) { return &Pixels[((size_t)y * Width + x) * Channels]; }
+	const unsigned char* GetPixel(unsigned int x, unsigned int y) const { return &Pixels[((size_t)y * Width + x) * Channels]; }
+};
@@ -0,0 +1,135 @@
+#include "TextureLoader.h"
+#include "PngDecoder.h"
+#include "TexturePacker.h"
+#include "DDSTextureLoader.h"
+#include <fstream>
+
+bool TextureLoader::ReadAlbedo(const std::string& basePath, TextureData& data, JobSystem* jobs)
+{
+	if (ReadFile(basePath + TEXTURE_ALBEDO_DDS, data.DdsFile))
+		return true;
+
+	TextureImage albedo;
+	if (!PngDecoder::Load(basePath + "_albedo.png", albedo))
+		return false;
+
+	MipSettings mipSettings;
+	mipSettings.Content = MipContentSRGB;
+	MipGenerator::Generate(albedo, data.Levels, mipSettings, jobs);
+	return true;
+}
+
+bool TextureLoader::ReadSurface(const std::string& basePath, TextureData& data, JobSystem* jobs)
+{
+	if (ReadFile(basePath + TEXTURE_SURFACE_DDS, data.DdsFile))
+		return true;
+
+	TextureImage roughness;
+	TextureImage metalness;
+	TextureImage occlusion;
+	bool hasRoughness = PngDecoder::Load(basePath + "_roughness.png", roughness);
+	bool hasMetalness = PngDecoder::Load(basePath + "_metal.png", metalness);
+	bool hasOcclusion = PngDecoder::Load(basePath + "_ao.png", occlusion);
+
+	TextureImage surface;
+	if (!TexturePacker::PackSurface(hasRoughness ? &roughness : 0, hasMetalness ? &metalness : 0, hasOcclusion ? &occlusion : 0, surface))
+		return false;
+
+	MipGenerator::Generate(surface, data.Levels, MipSettings(), jobs);
+	return true;
+}
+
+bool TextureLoader::ReadNormals(const std::string& basePath, TextureData& data, JobSystem* jobs)
+{
+	if (ReadFile(basePath + TEXTURE_NORMALS_DDS, data.DdsFile))
+		return true;
+
+	TextureImage normals;
+	if (!PngDecoder::Load(basePath + "_normals.png", normals))
+		return false;
+
+	TextureImage packed;
+	TexturePacker::PackNormals(normals, packed);
+
+	MipSettings mipSettings;
+	mipSettings.Content = MipContentNormals;
+	MipGenerator::Generate(packed, data.Levels, mipSettings, jobs);
+	return true;
+}
+
+void TextureLoader::GetAlbedoFiles(const std::string& basePath, std::vector<std::string>& files)
+{
+	files.push_back(basePath + TEXTURE_ALBEDO_DDS);
+	files.push_back(basePath + "_albedo.png");
+}
+
+void TextureLoader::GetSurfaceFiles(const std::string& basePath, std::vector<std::string>& files)
+{
+	files.push_back(basePath + TEXTURE_SURFACE_DDS);
+	files.push_back(basePath + "_roughness.png");
+	files.push_back(basePath + "_metal.png");
+	files.push_back(basePath + "_ao.png");
+}
+
+void TextureLoader::GetNormalsFiles(const std::string& basePath, std::vector<std::string>& files)
+{
+	files.push_back(basePath + TEXTURE_NORMALS_DDS);
+	files.push_back(basePath + "_normals.png");
+}
+
+bool TextureLoader::ReadFile(const std::string& path, std::vector<unsigned char>& bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::streamoff size = file.tellg();
+	file.seekg(0);
+	bytes.resize((size_t)size);
+	return size > 0 && file.read((char*)bytes.data(), size).good();
+}
+
+HRESULT TextureLoader::CreateTexture(Microsoft::WRL::ComPtr<ID3D11Device> device, const TextureData& data, ID3D11ShaderResourceView** srv)
+{
+	if (!data.DdsFile.empty())
+		return DirectX::CreateDDSTextureFromMemory(device.Get(), data.DdsFile.data(), data.DdsFile.size(), 0, srv);
+
+	if (data.Levels.empty() || (data.Levels[0].Channels != 2 && data.Levels[0].Channels != 4))
+		return E_INVALIDARG;
+
+	std::vector<D3D11_SUBRESOURCE_DATA> initialData(data.Levels.size());
+	for (size_t i = 0; i < data.Levels.size(); i++)
+	{
+		initialData[i].pSysMem = data.Levels[i].Pixels.data();
+		initialData[i].SysMemPitch = data.Levels[i].Width * data.Levels[i].Channels;
+	}
+
+	const TextureImage& top = data.Levels[0];
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = top.Width;
+	desc.Height = top.Height;
+	desc.MipLevels = (UINT)data.Levels.size();
+	desc.ArraySize = 1;
+	desc.Format = top.Channels == 2 ? DXGI_FORMAT_R8G8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	HRESULT hr = device->CreateTexture2D(&desc, initialData.data(), texture.GetAddressOf());
+	if (FAILED(hr))
+		return hr;
+
+	return device->CreateShaderResourceView(texture.Get(), 0, srv);
+}
+
+HRESULT TextureLoader::CreatePlaceholder(Microsoft::WRL::ComPtr<ID3D11Device> device, unsigned int channels, const unsigned char* texel,
+	ID3D11ShaderResourceView** srv)
+{
+	TextureData data;
+	data.Levels.resize(1);
+	data.Levels[0].Allocate(1, 1, channels);
+	for (unsigned int c = 0; c < channels; c++)
+		data.Levels[0].Pixels[c] = texel[c];
+	return CreateTexture(device, data, srv);
+}
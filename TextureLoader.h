@@ -0,0 +1,61 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+#include "TextureImage.h"
+#include "MipGenerator.h"
+
+// What the asset tools name the DDS files they write next to
+// a material's PNGs, after its base path
+#define TEXTURE_ALBEDO_DDS "_albedo.dds"
+#define TEXTURE_NORMALS_DDS "_normals_xy.dds"
+#define TEXTURE_SURFACE_DDS "_surface.dds"
+
+// --------------------------------------------------------
+// What reading a texture produces, ready to upload: either a
+// whole DDS file, which carries its own mips, or the levels
+// of a texture built from source images
+// --------------------------------------------------------
+struct TextureData
+{
+	std::vector<unsigned char> DdsFile;
+	std::vector<TextureImage> Levels;
+};
+
+// --------------------------------------------------------
+// Loads material textures in the layouts the pixel shader
+// samples. Packed maps come from the DDS files written by
+// Tools/PackTextures or Tools/CompressTextures, or are
+// packed from the source PNGs at load time when those
+// haven't been built. Mips of textures built here come
+// from MipGenerator, filtered in the space their content
+// lives in. Reading is split from creating so reads can
+// run on worker threads; only the Create functions touch
+// the device.
+// --------------------------------------------------------
+class TextureLoader
+{
+public:
+	//basePath is the material's path without suffix, like Assets/PBR/bronze.
+	//False when the map has no source at all. jobs, if any, share the filtering.
+	static bool ReadAlbedo(const std::string& basePath, TextureData& data, JobSystem* jobs = 0);
+	static bool ReadSurface(const std::string& basePath, TextureData& data, JobSystem* jobs = 0);
+	static bool ReadNormals(const std::string& basePath, TextureData& data, JobSystem* jobs = 0);
+
+	//Every file the matching Read function may read, present or not, for watching
+	static void GetAlbedoFiles(const std::string& basePath, std::vector<std::string>& files);
+	static void GetSurfaceFiles(const std::string& basePath, std::vector<std::string>& files);
+	static void GetNormalsFiles(const std::string& basePath, std::vector<std::string>& files);
+
+	//Whole file into memory
+	static bool ReadFile(const std::string& path, std::vector<unsigned char>& bytes);
+
+	//Immutable texture from read data; two or four channel levels
+	static HRESULT CreateTexture(Microsoft::WRL::ComPtr<ID3D11Device> device, const TextureData& data, ID3D11ShaderResourceView** srv);
+
+	//1x1 texture of a single texel, standing in for one still loading
+	static HRESULT CreatePlaceholder(Microsoft::WRL::ComPtr<ID3D11Device> device, unsigned int channels, const unsigned char* texel,
+		ID3D11ShaderResourceView** srv);
+};
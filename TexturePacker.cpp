@@ -0,0 +1,95 @@
+#include "TexturePacker.h"
+#include <cmath>
+
+bool TexturePacker::PackSurface(const TextureImage* roughness, const TextureImage* metalness, const TextureImage* occlusion, TextureImage& packed)
+{
+	const TextureImage* inputs[3] = { roughness, metalness, occlusion };
+	const unsigned char defaults[3] = { PACK_DEFAULT_ROUGHNESS, PACK_DEFAULT_METALNESS, PACK_DEFAULT_OCCLUSION };
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	for (const TextureImage* input : inputs)
+	{
+		if (input && input->Width * input->Height > width * height)
+		{
+			width = input->Width;
+			height = input->Height;
+		}
+	}
+	if (width == 0 || height == 0)
+		return false;
+
+	//there is no three channel 8 bit format, so occlusion costs a full RGBA texel
+	unsigned int channels = occlusion ? 4 : 2;
+	packed.Allocate(width, height, channels);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned char* texel = packed.GetPixel(x, y);
+			for (unsigned int c = 0; c < channels && c < 3; c++)
+			{
+				texel[c] = inputs[c] ? SampleRed(*inputs[c], x, y, width, height) : defaults[c];
+			}
+			if (channels == 4)
+			{
+				texel[3] = 255;
+			}
+		}
+	}
+	return true;
+}
+
+void TexturePacker::PackNormals(const TextureImage& normals, TextureImage& packed)
+{
+	packed.Allocate(normals.Width, normals.Height, 2);
+	for (unsigned int y = 0; y < normals.Height; y++)
+	{
+		for (unsigned int x = 0; x < normals.Width; x++)
+		{
+			const unsigned char* source = normals.GetPixel(x, y);
+			float nx = source[0] / 127.5f - 1.0f;
+			float ny = source[1] / 127.5f - 1.0f;
+			float nz = source[2] / 127.5f - 1.0f;
+
+			//z is rebuilt as positive, so drop anything pointing into the surface
+			nz = nz > 0.0f ? nz : 0.0f;
+			float length = sqrtf(nx * nx + ny * ny + nz * nz);
+			if (length > 0.0f)
+			{
+				nx /= length;
+				ny /= length;
+			}
+
+			unsigned char* texel = packed.GetPixel(x, y);
+			texel[0] = (unsigned char)lroundf((nx * 0.5f + 0.5f) * 255.0f);
+			texel[1] = (unsigned char)lroundf((ny * 0.5f + 0.5f) * 255.0f);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Bilinear sample of the red channel at the centre of texel
+// (x, y) of a width x height grid over the same UV range
+// --------------------------------------------------------
+unsigned char TexturePacker::SampleRed(const TextureImage& image, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+	if (image.Width == width && image.Height == height)
+		return image.GetPixel(x, y)[0];
+
+	float u = (x + 0.5f) * image.Width / width - 0.5f;
+	float v = (y + 0.5f) * image.Height / height - 0.5f;
+	u = u < 0.0f ? 0.0f : u;
+	v = v < 0.0f ? 0.0f : v;
+
+	unsigned int x0 = (unsigned int)u;
+	unsigned int y0 = (unsigned int)v;
+	unsigned int x1 = x0 + 1 < image.Width ? x0 + 1 : x0;
+	unsigned int y1 = y0 + 1 < image.Height ? y0 + 1 : y0;
+	float fx = u - x0;
+	float fy = v - y0;
+
+	float top = image.GetPixel(x0, y0)[0] * (1.0f - fx) + image.GetPixel(x1, y0)[0] * fx;
+	float bottom = image.GetPixel(x0, y1)[0] * (1.0f - fx) + image.GetPixel(x1, y1)[0] * fx;
+	return (unsigned char)lroundf(top * (1.0f - fy) + bottom * fy);
+}
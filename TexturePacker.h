@@ -0,0 +1,30 @@
+#pragma once
+
+#include "TextureImage.h"
+
+// Values for maps a material doesn't have
+#define PACK_DEFAULT_ROUGHNESS 255
+#define PACK_DEFAULT_METALNESS 0
+#define PACK_DEFAULT_OCCLUSION 255
+
+// --------------------------------------------------------
+// Packs a material's single channel maps into fewer, fuller
+// textures: roughness and metalness (and ambient occlusion,
+// when there is one) share a surface map, and normal maps
+// keep only x and y, with z rebuilt in the pixel shader.
+// Inputs are RGBA8 and read from red; smaller inputs are
+// filtered up to the largest.
+// --------------------------------------------------------
+class TexturePacker
+{
+public:
+	//Roughness in r, metalness in g and, with an occlusion map, occlusion in b of an
+	//RGBA8 image; without one the result is two channels. Missing maps use the defaults.
+	static bool PackSurface(const TextureImage* roughness, const TextureImage* metalness, const TextureImage* occlusion, TextureImage& packed);
+
+	//Renormalized tangent space x and y as two channels
+	static void PackNormals(const TextureImage& normals, TextureImage& packed);
+
+private:
+	static unsigned char SampleRed(const TextureImage& image, unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+};
@@ -0,0 +1,158 @@
+#include "TextureStreamer.h"
+#include "Profiler.h"
+
+namespace
+{
+	// Width or height of a level
+	unsigned int GetLevelDimension(unsigned int size, unsigned int mip)
+	{
+		return size >> mip ? size >> mip : 1;
+	}
+}
+
+TextureStreamer::TextureStreamer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	std::shared_ptr<JobSystem> jobSystem, const MipResidencySettings& settings)
+	: device(device), context(context), jobSystem(jobSystem), residency(settings)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	//reads write into their pending loads, so those have to outlive them
+	for (auto& load : pending)
+		jobSystem->Wait(&load->Counter);
+}
+
+bool TextureStreamer::Register(const std::string& ddsPath, const StreamedTextureChanged& changed, StreamingHandle* handle)
+{
+	DdsInfo info = {};
+	if (!DdsFile::ReadInfo(ddsPath, info))
+		return false;
+
+	//cube maps stay whole, they're small and sampled from every direction
+	bool powerOfTwo = (info.Width & (info.Width - 1)) == 0 && (info.Height & (info.Height - 1)) == 0;
+	if (!powerOfTwo || info.Faces != 1)
+		return false;
+
+	std::vector<size_t> levelBytes;
+	for (unsigned int mip = 0; mip < info.MipCount; mip++)
+		levelBytes.push_back(DdsFile::GetLevelSize(info.Format, GetLevelDimension(info.Width, mip), GetLevelDimension(info.Height, mip)));
+
+	StreamedTexture texture;
+	texture.Path = ddsPath;
+	texture.Info = info;
+	texture.FirstMip = info.MipCount;
+	texture.Changed = changed;
+	textures.push_back(texture);
+
+	*handle = residency.Register(ddsPath.substr(ddsPath.find_last_of("/\\") + 1), levelBytes, info.Width, info.Height);
+	return true;
+}
+
+bool TextureStreamer::Reload(StreamingHandle handle)
+{
+	StreamedTexture& texture = textures[handle];
+	DdsInfo info = {};
+	if (!DdsFile::ReadInfo(texture.Path, info) || info.Format != texture.Info.Format || info.Width != texture.Info.Width ||
+		info.Height != texture.Info.Height || info.MipCount != texture.Info.MipCount || info.Faces != texture.Info.Faces)
+		return false;
+
+	//nothing resident, the next load reads the new file anyway
+	unsigned int firstMip = texture.FirstMip;
+	if (firstMip == info.MipCount)
+		return true;
+
+	std::vector<DdsLevel> levels;
+	if (!DdsFile::ReadLevels(texture.Path, firstMip, info.MipCount - firstMip, levels))
+		return false;
+
+	//as if nothing was resident, so every level comes from the file
+	texture.FirstMip = info.MipCount;
+	if (Rebuild(texture, firstMip, &levels))
+		return true;
+
+	texture.FirstMip = firstMip;
+	return false;
+}
+
+void TextureStreamer::Update()
+{
+	PROFILE_SCOPE("Texture streaming");
+
+	//reads that finished since the last frame
+	for (auto load = pending.begin(); load != pending.end();)
+	{
+		if (!(*load)->Counter.IsDone())
+		{
+			++load;
+			continue;
+		}
+
+		PendingLoad& read = **load;
+		jobSystem->Wait(&read.Counter);
+		bool succeeded = read.Succeeded && Rebuild(textures[read.Load.Texture], read.Load.ToMip, &read.Levels);
+		residency.CompleteLoad(read.Load, succeeded);
+		load = pending.erase(load);
+	}
+
+	residency.Update(loads, evictions);
+	for (const MipTransition& eviction : evictions)
+		Rebuild(textures[eviction.Texture], eviction.ToMip, 0);
+
+	for (const MipTransition& load : loads)
+	{
+		pending.push_back(std::make_unique<PendingLoad>());
+		PendingLoad* read = pending.back().get();
+		read->Load = load;
+		read->Succeeded = false;
+
+		std::string path = textures[load.Texture].Path;
+		jobSystem->Run([read, path]()
+		{
+			PROFILE_SCOPE("Texture stream read");
+			read->Succeeded = DdsFile::ReadLevels(path, read->Load.ToMip, read->Load.FromMip - read->Load.ToMip, read->Levels);
+		}, &read->Counter);
+	}
+}
+
+bool TextureStreamer::Rebuild(StreamedTexture& texture, unsigned int firstMip, const std::vector<DdsLevel>* loaded)
+{
+	const DdsInfo& info = texture.Info;
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = GetLevelDimension(info.Width, firstMip);
+	desc.Height = GetLevelDimension(info.Height, firstMip);
+	desc.MipLevels = info.MipCount - firstMip;
+	desc.ArraySize = 1;
+	desc.Format = (DXGI_FORMAT)info.Format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> rebuilt;
+	if (FAILED(device->CreateTexture2D(&desc, 0, rebuilt.GetAddressOf())))
+		return false;
+
+	for (unsigned int mip = firstMip; mip < info.MipCount; mip++)
+	{
+		if (loaded && mip < texture.FirstMip)
+		{
+			//a row of texels, or of blocks for compressed formats
+			const DdsLevel& level = (*loaded)[mip - firstMip];
+			UINT rowPitch = (UINT)DdsFile::GetLevelSize(info.Format, level.Width, 1);
+			context->UpdateSubresource(rebuilt.Get(), mip - firstMip, 0, level.Data.data(), rowPitch, 0);
+		}
+		else
+		{
+			context->CopySubresourceRegion(rebuilt.Get(), mip - firstMip, 0, 0, 0, texture.Texture.Get(), mip - texture.FirstMip, 0);
+		}
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (FAILED(device->CreateShaderResourceView(rebuilt.Get(), 0, srv.GetAddressOf())))
+		return false;
+
+	texture.Texture = rebuilt;
+	texture.FirstMip = firstMip;
+	texture.Changed(srv);
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DdsFile.h"
+#include "JobSystem.h"
+#include "MipResidency.h"
+
+// Called with each new view of a streamed texture, on the thread
+// running TextureStreamer::Update, so whatever samples it can swap
+typedef std::function<void(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>)> StreamedTextureChanged;
+
+// --------------------------------------------------------
+// Streams the mips of textures the asset tools wrote as
+// DDS files, keeping what MipResidency asks for resident.
+// Levels are read as jobs straight from their place in the
+// file; once read, the texture is recreated holding just
+// the resident levels, copying the ones it already had on
+// the GPU, and its new view handed out. Evicting recreates
+// it smaller the same way. Register and Update are for the
+// thread that owns the device context.
+// --------------------------------------------------------
+class TextureStreamer
+{
+public:
+	TextureStreamer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		std::shared_ptr<JobSystem> jobSystem, const MipResidencySettings& settings);
+	~TextureStreamer(); //waits for reads in flight
+
+	//Streams ddsPath, starting from nothing resident. False when the file's
+	//header can't be read or its size isn't a power of two, which is what
+	//keeps every level a texture can start from whole blocks.
+	bool Register(const std::string& ddsPath, const StreamedTextureChanged& changed, StreamingHandle* handle);
+
+	//Reads the levels resident again after the file was rewritten, right away.
+	//False if its size, format or mip count changed, which residency can't follow.
+	bool Reload(StreamingHandle handle);
+
+	//Feedback goes here, as do budget changes and stats
+	MipResidency& GetResidency() { return residency; }
+
+	//Applies finished reads, then the evictions and loads the policy
+	//decides on from this frame's feedback
+	void Update();
+
+private:
+	struct StreamedTexture
+	{
+		std::string Path;
+		DdsInfo Info;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> Texture; //null while nothing is resident
+		unsigned int FirstMip;
+		StreamedTextureChanged Changed;
+	};
+
+	struct PendingLoad
+	{
+		MipTransition Load;
+		std::vector<DdsLevel> Levels; //ToMip up to FromMip
+		bool Succeeded;
+		JobCounter Counter;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::shared_ptr<JobSystem> jobSystem;
+	MipResidency residency;
+
+	std::vector<StreamedTexture> textures;
+	std::vector<std::unique_ptr<PendingLoad>> pending;
+	std::vector<MipTransition> loads;
+	std::vector<MipTransition> evictions;
+
+	//Recreates the texture from firstMip down, filling levels above what
+	//it had from loaded and copying the rest from the old texture
+	bool Rebuild(StreamedTexture& texture, unsigned int firstMip, const std::vector<DdsLevel>* loaded);
+};
@@ -0,0 +1,76 @@
+#include "TimingStats.h"
+#include "FrameStatsRecorder.h"
+#include <algorithm>
+
+TimingStats::TimingStats() {}
+
+TimingStats::~TimingStats() {}
+
+void TimingStats::AddSample(const std::string& name, float milliseconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Series& s = series[name];
+
+	if (s.Samples.size() < TIMING_STATS_WINDOW)
+	{
+		s.Samples.push_back(milliseconds);
+	}
+	else
+	{
+		s.Samples[s.Next] = milliseconds;
+	}
+	s.Next = (s.Next + 1) % TIMING_STATS_WINDOW;
+
+	if (recorder)
+	{
+		recorder->AddSample(name, milliseconds);
+	}
+}
+
+bool TimingStats::GetSummary(const std::string& name, TimingSummary* summary)
+{
+	std::vector<float> sorted;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = series.find(name);
+		if (found == series.end() || found->second.Samples.empty())
+			return false;
+		sorted = found->second.Samples;
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (float sample : sorted) { total += sample; }
+
+	//nearest rank percentiles
+	unsigned int count = (unsigned int)sorted.size();
+	auto percentile = [&](float p) { return sorted[std::min(count - 1, (unsigned int)(p * count))]; };
+
+	summary->Count = count;
+	summary->Min = sorted.front();
+	summary->Average = (float)(total / count);
+	summary->Max = sorted.back();
+	summary->P50 = percentile(0.50f);
+	summary->P95 = percentile(0.95f);
+	summary->P99 = percentile(0.99f);
+	return true;
+}
+
+void TimingStats::GetSeriesNames(std::vector<std::string>& names)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	names.clear();
+	for (auto& s : series) { names.push_back(s.first); }
+}
+
+void TimingStats::SetRecorder(std::shared_ptr<FrameStatsRecorder> recorder)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->recorder = recorder;
+}
+
+void TimingStats::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	series.clear();
+}
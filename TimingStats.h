@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Most recent samples kept per series
+#define TIMING_STATS_WINDOW 256
+
+// --------------------------------------------------------
+// Summary of a series' samples in the window, milliseconds
+// --------------------------------------------------------
+struct TimingSummary
+{
+	unsigned int Count;
+	float Min;
+	float Average;
+	float Max;
+	float P50;
+	float P95;
+	float P99;
+};
+
+class FrameStatsRecorder;
+
+// --------------------------------------------------------
+// Named series of timings, CPU and GPU alike, each keeping
+// a rolling window of samples. Safe to add to from several
+// threads, which also serializes the recorder.
+// --------------------------------------------------------
+class TimingStats
+{
+public:
+	TimingStats();
+	~TimingStats();
+
+	void AddSample(const std::string& name, float milliseconds);
+
+	//False if the series has no samples yet
+	bool GetSummary(const std::string& name, TimingSummary* summary);
+	void GetSeriesNames(std::vector<std::string>& names); //sorted by name
+
+	void Clear();
+
+	//Also passes every sample to recorder while set, null stops
+	void SetRecorder(std::shared_ptr<FrameStatsRecorder> recorder);
+
+private:
+	struct Series
+	{
+		std::vector<float> Samples; //ring of up to TIMING_STATS_WINDOW
+		unsigned int Next;
+	};
+
+	std::mutex mutex;
+	std::map<std::string, Series> series;
+	std::shared_ptr<FrameStatsRecorder> recorder;
+};
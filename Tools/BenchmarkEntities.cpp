@@ -0,0 +1,208 @@
+// --------------------------------------------------------
+// Times iterating EntityRegistry against the list of
+// shared_ptr entities it replaced, at 10k, 100k and 1M
+// entities. The draw walk reads each visible entity's world
+// matrix, mesh and material as the draw loops do (the old
+// loop copied each entity's shared_ptr, and its mesh and
+// material getters returned shared_ptrs by value). The
+// update walk moves every entity and rebuilds its world
+// matrix. Both layouts get the same entities, and the walks
+// must agree on what they read. First checks that a stale
+// handle can't reach the entity now in its slot. Needs
+// DirectXMath, e.g.
+//   g++ -O2 -std=c++17 -I.. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs
+//     BenchmarkEntities.cpp ../EntityRegistry.cpp ../Transform.cpp -o BenchmarkEntities
+//   ./BenchmarkEntities -max 1000000
+// --------------------------------------------------------
+
+#include "../EntityRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Stand-ins for the mesh and material the old entity pointed at
+	struct Mesh { unsigned int Id; };
+	struct Material { unsigned int Id; };
+
+	// --------------------------------------------------------
+	// Entity as it was before the registry
+	// --------------------------------------------------------
+	class Entity
+	{
+	public:
+		Entity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material) : mesh(mesh), material(material) {}
+		std::shared_ptr<Mesh> GetMesh() { return mesh; }
+		Transform* GetTransform() { return &transform; }
+		std::shared_ptr<Material> GetMaterial() { return material; }
+	private:
+		Transform transform;
+		std::shared_ptr<Mesh> mesh;
+		std::shared_ptr<Material> material;
+	};
+
+	const unsigned int meshCount = 6;
+	const unsigned int materialCount = 4;
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Entities repeat the scene's six meshes, a few hidden
+	unsigned int FlagsOf(unsigned int i)
+	{
+		return i % 16 == 15 ? ENTITY_FLAG_CASTS_SHADOW : ENTITY_FLAG_VISIBLE | ENTITY_FLAG_CASTS_SHADOW;
+	}
+
+	struct Result
+	{
+		double DrawSeconds = 0.0;
+		double UpdateSeconds = 0.0;
+		double Sum = 0.0;
+	};
+
+	Result RunShared(unsigned int count, unsigned int frames)
+	{
+		std::vector<std::shared_ptr<Mesh>> meshes;
+		std::vector<std::shared_ptr<Material>> materials;
+		for (unsigned int i = 0; i < meshCount; i++)
+			meshes.push_back(std::make_shared<Mesh>(Mesh{ i }));
+		for (unsigned int i = 0; i < materialCount; i++)
+			materials.push_back(std::make_shared<Material>(Material{ i }));
+
+		std::vector<std::shared_ptr<Entity>> entities;
+		std::vector<unsigned int> flags;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			entities.push_back(std::make_shared<Entity>(meshes[i % meshCount], materials[i % materialCount]));
+			entities.back()->GetTransform()->SetPosition((float)(i % 1000), 0.0f, (float)(i / 1000));
+			flags.push_back(FlagsOf(i));
+		}
+
+		Result result;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			unsigned int i = 0;
+			for (std::shared_ptr<Entity> entity : entities)
+			{
+				if (flags[i++] & ENTITY_FLAG_VISIBLE)
+				{
+					XMFLOAT4X4 world = entity->GetTransform()->GetWorldMatrix();
+					result.Sum += world._41 + entity->GetMesh()->Id + entity->GetMaterial()->Id;
+				}
+			}
+		}
+		result.DrawSeconds = Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			for (std::shared_ptr<Entity> entity : entities)
+			{
+				Transform* transform = entity->GetTransform();
+				transform->MoveAbsolute(0.0f, 0.01f, 0.0f);
+				result.Sum += transform->GetWorldMatrix()._42;
+			}
+		}
+		result.UpdateSeconds = Seconds(start);
+		return result;
+	}
+
+	Result RunRegistry(unsigned int count, unsigned int frames)
+	{
+		EntityRegistry registry;
+		BoundingBox bounds(XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+		for (unsigned int i = 0; i < count; i++)
+		{
+			EntityHandle handle = registry.Create(i % meshCount, i % materialCount, bounds, FlagsOf(i));
+			registry.GetTransform(handle)->SetPosition((float)(i % 1000), 0.0f, (float)(i / 1000));
+		}
+
+		Result result;
+		Transform* transforms = registry.GetTransforms();
+		const unsigned int* meshIds = registry.GetMeshes();
+		const unsigned int* materialIds = registry.GetMaterials();
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			for (unsigned int i : registry.View(ENTITY_FLAG_VISIBLE))
+			{
+				XMFLOAT4X4 world = transforms[i].GetWorldMatrix();
+				result.Sum += world._41 + meshIds[i] + materialIds[i];
+			}
+		}
+		result.DrawSeconds = Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			for (unsigned int i = 0; i < registry.GetCount(); i++)
+			{
+				transforms[i].MoveAbsolute(0.0f, 0.01f, 0.0f);
+				result.Sum += transforms[i].GetWorldMatrix()._42;
+			}
+		}
+		result.UpdateSeconds = Seconds(start);
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int largest = 1000000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-max") && i + 1 < argc)
+			largest = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: BenchmarkEntities [-max N]\n");
+			return 1;
+		}
+	}
+
+	//a destroyed entity's handle reads 0 and writes nothing, even once its slot is reused
+	{
+		EntityRegistry registry;
+		EntityHandle stale = registry.Create(1, 2, BoundingBox(), ENTITY_FLAG_VISIBLE);
+		registry.Destroy(stale);
+		EntityHandle reused = registry.Create(3, 3, BoundingBox(), ENTITY_FLAG_CASTS_SHADOW);
+		registry.SetMaterial(stale, 5);
+		registry.SetFlags(stale, ENTITY_FLAG_VISIBLE);
+		if (registry.GetTransform(stale) || registry.GetMesh(stale) || registry.GetMaterial(stale) || registry.GetFlags(stale) ||
+			registry.GetMaterial(reused) != 3 || registry.GetFlags(reused) != ENTITY_FLAG_CASTS_SHADOW)
+		{
+			fprintf(stderr, "A stale handle reached a live entity\n");
+			return 1;
+		}
+	}
+
+	printf("  %-9s %-8s %14s %14s %9s\n", "Entities", "Walk", "shared_ptr ns", "Registry ns", "Speedup");
+	bool agree = true;
+	for (unsigned int count = 10000; count <= largest; count *= 10)
+	{
+		//roughly the same total work at every size
+		unsigned int frames = 10000000 / count;
+		frames = frames < 2 ? 2 : frames;
+
+		Result before = RunShared(count, frames);
+		Result after = RunRegistry(count, frames);
+		double visits = (double)count * frames;
+		printf("  %-9u %-8s %14.2f %14.2f %8.2fx\n", count, "Draw", before.DrawSeconds * 1e9 / visits, after.DrawSeconds * 1e9 / visits, before.DrawSeconds / after.DrawSeconds);
+		printf("  %-9u %-8s %14.2f %14.2f %8.2fx\n", count, "Update", before.UpdateSeconds * 1e9 / visits, after.UpdateSeconds * 1e9 / visits, before.UpdateSeconds / after.UpdateSeconds);
+		if (before.Sum != after.Sum)
+		{
+			fprintf(stderr, "%u entities: the layouts read different values (%f vs %f)\n", count, before.Sum, after.Sum);
+			agree = false;
+		}
+	}
+	return agree ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// --------------------------------------------------------
+// Times the JobSystem at every pool size from one thread up
+// to one per core: how many empty jobs a second it can run
+// (its overhead), and how long a fixed batch of small
+// compute tasks takes, giving the speedup and efficiency
+// over one thread. Then checks threads outside the pool:
+// several register and wait on their own batches at once
+// with one unregistered thread alongside, every job must
+// run exactly once, and registering fails once every
+// external slot is taken. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. BenchmarkJobs.cpp ../JobSystem.cpp ../Profiler.cpp -o BenchmarkJobs
+//   ./BenchmarkJobs -threads 8 -tasks 4096 -work 2000
+// --------------------------------------------------------
+
+#include "../JobSystem.h"
+#include "Check.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		unsigned int Threads = 0;
+		unsigned int Tasks = 4096;
+		unsigned int Work = 2000;
+		unsigned int EmptyJobs = 200000;
+	};
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Some arithmetic the compiler can't skip
+	float Compute(unsigned int seed, unsigned int work)
+	{
+		float x = (float)seed;
+		for (unsigned int i = 0; i < work; i++)
+			x = std::sqrt(x * 1.0001f + (float)i);
+		return x;
+	}
+
+	// Empty jobs run one at a time through Run, per second
+	double EmptyJobRate(JobSystem& jobs, unsigned int count)
+	{
+		std::atomic<unsigned int> ran(0);
+		auto start = std::chrono::steady_clock::now();
+		JobCounter counter;
+		for (unsigned int i = 0; i < count; i++)
+			jobs.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		jobs.Wait(&counter);
+		double seconds = Seconds(start);
+		Expect(ran == count, "Not every empty job ran");
+		return count / seconds;
+	}
+
+	// Seconds for a batch of compute tasks, one job each
+	double TaskSeconds(JobSystem& jobs, unsigned int tasks, unsigned int work, std::vector<float>& results)
+	{
+		results.assign(tasks, 0.0f);
+		auto start = std::chrono::steady_clock::now();
+		JobCounter counter;
+		jobs.ParallelFor(tasks, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				results[i] = Compute(i, work);
+		}, &counter);
+		jobs.Wait(&counter);
+		return Seconds(start);
+	}
+
+	void CheckExternalThreads(unsigned int threadCount)
+	{
+		JobSystem jobs(threadCount);
+
+		//registered threads and one that isn't, all submitting and waiting at once
+		const unsigned int submitters = 5;
+		const unsigned int perSubmitter = 20000;
+		std::vector<std::atomic<unsigned int>> ran(submitters * perSubmitter);
+		for (std::atomic<unsigned int>& count : ran)
+			count = 0;
+		std::atomic<unsigned int> registered(0);
+		std::vector<std::thread> threads;
+		for (unsigned int s = 0; s < submitters; s++)
+		{
+			threads.emplace_back([&, s]()
+			{
+				bool registers = s + 1 < submitters;
+				if (registers && jobs.RegisterThread())
+					registered++;
+
+				JobCounter counter;
+				jobs.ParallelFor(perSubmitter, 16, [&, s](unsigned int begin, unsigned int end)
+				{
+					for (unsigned int i = begin; i < end; i++)
+						ran[s * perSubmitter + i]++;
+				}, &counter);
+				jobs.Wait(&counter);
+
+				if (registers)
+					jobs.UnregisterThread();
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		Expect(registered == submitters - 1, "An external thread couldn't register");
+		bool once = true;
+		for (std::atomic<unsigned int>& count : ran)
+			once = once && count == 1;
+		Expect(once, "A job from an external thread didn't run exactly once");
+
+		//every slot taken, then one more
+		std::atomic<unsigned int> succeeded(0);
+		std::atomic<unsigned int> arrived(0);
+		threads.clear();
+		for (unsigned int t = 0; t < JOB_SYSTEM_MAX_EXTERNAL_THREADS + 1; t++)
+		{
+			threads.emplace_back([&]()
+			{
+				bool ok = jobs.RegisterThread();
+				if (ok)
+					succeeded++;
+
+				//hold the slot until everyone has tried
+				arrived++;
+				while (arrived < JOB_SYSTEM_MAX_EXTERNAL_THREADS + 1)
+					std::this_thread::yield();
+				if (ok)
+					jobs.UnregisterThread();
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		Expect(succeeded == JOB_SYSTEM_MAX_EXTERNAL_THREADS, "Registering didn't fill exactly the external slots");
+
+		//a job waited on with nothing else to run leaves the waiter asleep,
+		//and it must still wake when the job finishes
+		JobCounter slow;
+		jobs.Run([]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }, &slow);
+		std::thread waiter([&]() { jobs.Wait(&slow); });
+		waiter.join();
+		Expect(slow.IsDone(), "Wait returned before its job finished");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseCheckOptions(argc, argv, "BenchmarkJobs", { { "-threads", &options.Threads }, { "-tasks", &options.Tasks }, { "-work", &options.Work } }))
+		return 1;
+	if (options.Threads == 0)
+		options.Threads = std::thread::hardware_concurrency();
+	if (options.Threads == 0)
+		options.Threads = 1;
+
+	printf("%u tasks of %u steps\n  %7s %14s %10s %8s %10s\n", options.Tasks, options.Work, "Threads", "Empty jobs/s", "Tasks ms", "Speedup", "Efficiency");
+	std::vector<float> expected;
+	std::vector<float> results;
+	double oneThread = 0.0;
+	for (unsigned int threads = 1; threads <= options.Threads; threads++)
+	{
+		JobSystem jobs(threads);
+		double rate = EmptyJobRate(jobs, options.EmptyJobs);
+
+		//best of a few, after a warmup
+		TaskSeconds(jobs, options.Tasks, options.Work, results);
+		double seconds = 1e30;
+		for (unsigned int r = 0; r < 3; r++)
+		{
+			double s = TaskSeconds(jobs, options.Tasks, options.Work, results);
+			seconds = s < seconds ? s : seconds;
+		}
+
+		if (threads == 1)
+		{
+			oneThread = seconds;
+			expected = results;
+		}
+		Expect(results == expected, "Tasks gave different results on more threads");
+
+		double speedup = oneThread / seconds;
+		printf("  %7u %14.0f %10.2f %7.2fx %9.0f%%\n", threads, rate, seconds * 1e3, speedup, speedup / threads * 100.0);
+	}
+
+	CheckExternalThreads(options.Threads);
+	return FinishCheck();
+}
@@ -0,0 +1,237 @@
+// --------------------------------------------------------
+// Times setting shader variables by name against setting
+// them through SimpleShaderHandles, over the per object
+// variables a draw sets: once each on their own, and once
+// with CopyAllBufferData after each draw's sets. Checks
+// both paths stage the same bytes. SimpleShader is built
+// on D3D11 reflection and device objects, so this needs
+// Windows, but it makes a WARP (software) device and so
+// runs without a GPU, as on a build machine. From a
+// Developer Command Prompt, e.g.
+//   cl /O2 /EHsc /std:c++17 /I.. BenchmarkShaderSetters.cpp ..\SimpleShader\SimpleShader.cpp
+//     ..\SimpleShader\SimpleShaderReflection.cpp ..\SimpleShader\SimpleRecordingContext.cpp
+//     ..\SimpleShader\SimpleStateTracker.cpp ..\SimpleShader\SimpleStateFilter.cpp
+//     ..\SimpleShader\SimpleConstantStaging.cpp
+//   BenchmarkShaderSetters -draws 100000
+// --------------------------------------------------------
+
+#include "../SimpleShader/SimpleShader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#pragma comment(lib, "d3d11.lib")
+
+using namespace DirectX;
+
+namespace
+{
+	// Per frame and per object buffers laid out like the game's,
+	// every variable used so none is compiled away
+	const char* shaderSource =
+		"cbuffer perFrame : register(b0)\n"
+		"{\n"
+		"	matrix view;\n"
+		"	matrix projection;\n"
+		"	float3 cameraPosition;\n"
+		"	float time;\n"
+		"	float4 lightColor[3];\n"
+		"	float4 lightDirection[3];\n"
+		"};\n"
+		"cbuffer perObject : register(b1)\n"
+		"{\n"
+		"	matrix world;\n"
+		"	matrix worldInvTranspose;\n"
+		"	float4 tint;\n"
+		"	float roughness;\n"
+		"	float metalness;\n"
+		"	float2 uvScale;\n"
+		"	uint materialIndex;\n"
+		"};\n"
+		"float4 main(float4 position : SV_POSITION) : SV_TARGET\n"
+		"{\n"
+		"	float4 p = mul(mul(mul(position, world), view), projection) + mul(position, worldInvTranspose);\n"
+		"	float4 light = lightColor[0] * dot(lightDirection[0].xyz, cameraPosition) + lightColor[1] * lightDirection[1] + lightColor[2] * lightDirection[2];\n"
+		"	return p * tint * light + float4(roughness, metalness, uvScale) * time + materialIndex;\n"
+		"}\n";
+
+	struct Options
+	{
+		unsigned int Draws = 100000;
+	};
+
+	// What a draw sets, different for every draw so uploads happen
+	struct ObjectData
+	{
+		XMFLOAT4X4 World;
+		XMFLOAT4X4 WorldInvTranspose;
+		XMFLOAT4 Tint;
+		float Roughness;
+		float Metalness;
+		XMFLOAT2 UVScale;
+		int MaterialIndex;
+	};
+
+	struct Handles
+	{
+		SimpleShaderHandle World;
+		SimpleShaderHandle WorldInvTranspose;
+		SimpleShaderHandle Tint;
+		SimpleShaderHandle Roughness;
+		SimpleShaderHandle Metalness;
+		SimpleShaderHandle UVScale;
+		SimpleShaderHandle MaterialIndex;
+	};
+
+	const unsigned int setsPerDraw = 7;
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	ObjectData MakeObject(unsigned int draw)
+	{
+		float f = (float)(draw % 1024);
+		ObjectData object;
+		XMStoreFloat4x4(&object.World, XMMatrixTranslation(f, 0.0f, -f));
+		XMStoreFloat4x4(&object.WorldInvTranspose, XMMatrixTranslation(0.0f, f, 0.0f));
+		object.Tint = XMFLOAT4(1.0f, f, 1.0f, 1.0f);
+		object.Roughness = f / 1024.0f;
+		object.Metalness = 1.0f - f / 1024.0f;
+		object.UVScale = XMFLOAT2(1.0f, 2.0f);
+		object.MaterialIndex = (int)(draw % 7);
+		return object;
+	}
+
+	// The per object sets as Game made them before handles
+	bool SetByName(SimplePixelShader& shader, const ObjectData& object)
+	{
+		bool set = shader.SetMatrix4x4("world", object.World);
+		set &= shader.SetMatrix4x4("worldInvTranspose", object.WorldInvTranspose);
+		set &= shader.SetFloat4("tint", object.Tint);
+		set &= shader.SetFloat("roughness", object.Roughness);
+		set &= shader.SetFloat("metalness", object.Metalness);
+		set &= shader.SetFloat2("uvScale", object.UVScale);
+		set &= shader.SetInt("materialIndex", object.MaterialIndex);
+		return set;
+	}
+
+	bool SetByHandle(SimplePixelShader& shader, const Handles& handles, const ObjectData& object)
+	{
+		bool set = shader.SetMatrix4x4(handles.World, object.World);
+		set &= shader.SetMatrix4x4(handles.WorldInvTranspose, object.WorldInvTranspose);
+		set &= shader.SetFloat4(handles.Tint, object.Tint);
+		set &= shader.SetFloat(handles.Roughness, object.Roughness);
+		set &= shader.SetFloat(handles.Metalness, object.Metalness);
+		set &= shader.SetFloat2(handles.UVScale, object.UVScale);
+		set &= shader.SetInt(handles.MaterialIndex, object.MaterialIndex);
+		return set;
+	}
+
+	// The per object buffer's staged bytes, as the main thread sees them
+	std::vector<unsigned char> Staged(SimplePixelShader& shader)
+	{
+		SimpleConstantBuffer* buffer = const_cast<SimpleConstantBuffer*>(shader.GetBufferInfo("perObject"));
+		return std::vector<unsigned char>(buffer->Staging.GetData(0), buffer->Staging.GetData(0) + buffer->Size);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-draws") && i + 1 < argc)
+			options.Draws = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: BenchmarkShaderSetters [-draws N]\n");
+			return 1;
+		}
+	}
+	if (options.Draws == 0)
+		return 1;
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	if (FAILED(D3D11CreateDevice(0, D3D_DRIVER_TYPE_WARP, 0, 0, 0, 0, D3D11_SDK_VERSION, device.GetAddressOf(), 0, context.GetAddressOf())))
+	{
+		fprintf(stderr, "Couldn't create a WARP device\n");
+		return 1;
+	}
+
+	Microsoft::WRL::ComPtr<ID3DBlob> compiled;
+	Microsoft::WRL::ComPtr<ID3DBlob> errors;
+	if (FAILED(D3DCompile(shaderSource, strlen(shaderSource), "BenchmarkShaderSetters", 0, 0, "main", "ps_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, compiled.GetAddressOf(), errors.GetAddressOf())))
+	{
+		fprintf(stderr, "%s\n", errors ? (const char*)errors->GetBufferPointer() : "Couldn't compile the shader");
+		return 1;
+	}
+
+	//no file to load from, the compiled blob goes in through Reload
+	SimplePixelShader shader(device, context, L"");
+	if (!shader.Reload(compiled))
+	{
+		fprintf(stderr, "Couldn't create the shader\n");
+		return 1;
+	}
+
+	Handles handles;
+	handles.World = shader.GetVariableHandle("world");
+	handles.WorldInvTranspose = shader.GetVariableHandle("worldInvTranspose");
+	handles.Tint = shader.GetVariableHandle("tint");
+	handles.Roughness = shader.GetVariableHandle("roughness");
+	handles.Metalness = shader.GetVariableHandle("metalness");
+	handles.UVScale = shader.GetVariableHandle("uvScale");
+	handles.MaterialIndex = shader.GetVariableHandle("materialIndex");
+
+	std::vector<ObjectData> objects(1024);
+	for (unsigned int i = 0; i < objects.size(); i++)
+		objects[i] = MakeObject(i);
+
+	//both paths must stage the same bytes
+	if (!SetByName(shader, objects[3]))
+	{
+		fprintf(stderr, "A variable wasn't found by name\n");
+		return 1;
+	}
+	std::vector<unsigned char> byName = Staged(shader);
+	SetByName(shader, objects[0]);
+	if (!SetByHandle(shader, handles, objects[3]) || Staged(shader) != byName)
+	{
+		fprintf(stderr, "Handles set different bytes than names\n");
+		return 1;
+	}
+
+	double seconds[4];
+	bool set = true;
+	for (unsigned int copy = 0; copy < 2; copy++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int d = 0; d < options.Draws; d++)
+		{
+			set &= SetByName(shader, objects[d % objects.size()]);
+			if (copy)
+				shader.CopyAllBufferData();
+		}
+		seconds[copy * 2] = Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int d = 0; d < options.Draws; d++)
+		{
+			set &= SetByHandle(shader, handles, objects[d % objects.size()]);
+			if (copy)
+				shader.CopyAllBufferData();
+		}
+		seconds[copy * 2 + 1] = Seconds(start);
+	}
+
+	double sets = (double)options.Draws * setsPerDraw;
+	printf("%u draws, %u sets each\n  %-28s %10s %10s %8s\n", options.Draws, setsPerDraw, "", "Name ns", "Handle ns", "Speedup");
+	printf("  %-28s %10.2f %10.2f %7.2fx\n", "Per set", seconds[0] * 1e9 / sets, seconds[1] * 1e9 / sets, seconds[0] / seconds[1]);
+	printf("  %-28s %10.2f %10.2f %7.2fx\n", "Per draw, with CopyAllBufferData", seconds[2] * 1e9 / options.Draws, seconds[3] * 1e9 / options.Draws, seconds[2] / seconds[3]);
+	return set ? 0 : 1;
+}
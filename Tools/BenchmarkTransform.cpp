@@ -0,0 +1,246 @@
+// --------------------------------------------------------
+// Times Transform's hot calls against the euler angle
+// Transform it replaced: Rotate then GetForward (mouse look,
+// which rebuilt the quaternion from the angles on every
+// read), MoveRelative (which also rebuilt it on every call),
+// GetForward with nothing changed, and GetWorldMatrix after
+// a rotation. Also checks that both agree on direction and
+// position while there is no roll, which is how the camera
+// uses them. Needs DirectXMath, which builds on Linux with
+// the DirectX-Headers stubs for its SAL annotations, e.g.
+//   g++ -O2 -std=c++17 -I.. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs
+//     BenchmarkTransform.cpp ../Transform.cpp -o BenchmarkTransform
+//   ./BenchmarkTransform -transforms 10000 -frames 200
+// --------------------------------------------------------
+
+#include "../Transform.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Transform as it was before orientations were stored as
+	// quaternions, cut down to the calls timed here
+	// --------------------------------------------------------
+	class EulerTransform
+	{
+	public:
+		void SetPosition(float x, float y, float z) { position = XMFLOAT3(x, y, z); isWorldMatrixDirty = true; }
+		void SetRotation(float pitch, float yaw, float roll) { rotation = XMFLOAT3(pitch, yaw, roll); isRotated = true; isWorldMatrixDirty = true; }
+		XMFLOAT3 GetPosition() { return position; }
+
+		XMFLOAT4X4 GetWorldMatrix()
+		{
+			if (isWorldMatrixDirty)
+			{
+				XMMATRIX transMat = XMMatrixTranslationFromVector(XMLoadFloat3(&position));
+				XMMATRIX rotMat = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+				XMMATRIX scaleMat = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
+				XMMATRIX world = scaleMat * rotMat * transMat;
+				XMStoreFloat4x4(&worldMatrix, world);
+				XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
+				isWorldMatrixDirty = false;
+			}
+			return worldMatrix;
+		}
+
+		XMFLOAT3 GetForward()
+		{
+			if (isRotated)
+			{
+				XMVECTOR rot = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+				XMStoreFloat3(&right, XMVector3Rotate(XMVectorSet(1, 0, 0, 0), rot));
+				XMStoreFloat3(&up, XMVector3Rotate(XMVectorSet(0, 1, 0, 0), rot));
+				XMStoreFloat3(&forward, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rot));
+				isRotated = false;
+			}
+			return forward;
+		}
+
+		void MoveRelative(float x, float y, float z)
+		{
+			XMVECTOR rot = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+			XMVECTOR relVec = XMVector3Rotate(XMVectorSet(x, y, z, 1), rot);
+			XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&position), relVec));
+			isWorldMatrixDirty = true;
+		}
+
+		void Rotate(float pitch, float yaw, float roll)
+		{
+			isRotated = true;
+			isWorldMatrixDirty = true;
+			XMStoreFloat3(&rotation, XMVectorAdd(XMLoadFloat3(&rotation), XMVectorSet(pitch, yaw, roll, 0.0f)));
+		}
+
+	private:
+		XMFLOAT4X4 worldMatrix;
+		XMFLOAT4X4 worldInverseTransposeMatrix;
+		XMFLOAT3 position = XMFLOAT3(0, 0, 0);
+		XMFLOAT3 rotation = XMFLOAT3(0, 0, 0);
+		XMFLOAT3 scale = XMFLOAT3(1, 1, 1);
+		XMFLOAT3 right = XMFLOAT3(1, 0, 0);
+		XMFLOAT3 up = XMFLOAT3(0, 1, 0);
+		XMFLOAT3 forward = XMFLOAT3(0, 0, 1);
+		bool isWorldMatrixDirty = true;
+		bool isRotated = true;
+	};
+
+	struct Options
+	{
+		unsigned int Transforms = 10000;
+		unsigned int Frames = 200;
+	};
+
+	// Small per frame steps like mouse look, no roll
+	struct Step
+	{
+		float Pitch;
+		float Yaw;
+		XMFLOAT3 Move;
+	};
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	float Sum(const XMFLOAT3& v)
+	{
+		return v.x + v.y + v.z;
+	}
+
+	// Runs each timed pattern over every transform for every
+	// frame, returning seconds per pattern; sink keeps results alive
+	template<typename T>
+	void Run(std::vector<T>& transforms, const std::vector<Step>& steps, const Options& options, double seconds[4], float& sink)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < options.Frames; f++)
+		{
+			const Step& step = steps[f % steps.size()];
+			for (T& t : transforms)
+			{
+				t.Rotate(step.Pitch, step.Yaw, 0.0f);
+				sink += Sum(t.GetForward());
+			}
+		}
+		seconds[0] = Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < options.Frames; f++)
+		{
+			const Step& step = steps[f % steps.size()];
+			for (T& t : transforms)
+				t.MoveRelative(step.Move.x, step.Move.y, step.Move.z);
+		}
+		seconds[1] = Seconds(start);
+		for (T& t : transforms)
+			sink += Sum(t.GetPosition());
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < options.Frames; f++)
+		{
+			for (T& t : transforms)
+				sink += Sum(t.GetForward());
+		}
+		seconds[2] = Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (unsigned int f = 0; f < options.Frames; f++)
+		{
+			const Step& step = steps[f % steps.size()];
+			for (T& t : transforms)
+			{
+				t.Rotate(step.Pitch, step.Yaw, 0.0f);
+				sink += t.GetWorldMatrix()._41;
+			}
+		}
+		seconds[3] = Seconds(start);
+	}
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		float dx = a.x - b.x;
+		float dy = a.y - b.y;
+		float dz = a.z - b.z;
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-transforms") && i + 1 < argc)
+			options.Transforms = (unsigned int)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-frames") && i + 1 < argc)
+			options.Frames = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: BenchmarkTransform [-transforms N] [-frames N]\n");
+			return 1;
+		}
+	}
+	if (options.Transforms == 0 || options.Frames == 0)
+		return 1;
+
+	//pitch stays well inside +-90 degrees so the euler angles can't wrap
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> turn(-0.002f, 0.002f);
+	std::uniform_real_distribution<float> move(-0.1f, 0.1f);
+	std::vector<Step> steps(256);
+	for (Step& step : steps)
+		step = { turn(random), turn(random) * 4.0f, XMFLOAT3(move(random), move(random), move(random)) };
+
+	std::vector<EulerTransform> before(options.Transforms);
+	std::vector<Transform> after(options.Transforms);
+	std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+	for (unsigned int i = 0; i < options.Transforms; i++)
+	{
+		float pitch = angle(random);
+		float yaw = angle(random) * 6.0f;
+		before[i].SetRotation(pitch, yaw, 0.0f);
+		after[i].SetRotation(pitch, yaw, 0.0f);
+		before[i].SetPosition((float)(i % 100), 0.0f, 0.0f);
+		after[i].SetPosition((float)(i % 100), 0.0f, 0.0f);
+	}
+
+	float sink = 0.0f;
+	double beforeSeconds[4];
+	double afterSeconds[4];
+	Run(before, steps, options, beforeSeconds, sink);
+	Run(after, steps, options, afterSeconds, sink);
+
+	double calls = (double)options.Transforms * options.Frames;
+	const char* names[4] = { "Rotate + GetForward", "MoveRelative", "GetForward (clean)", "Rotate + GetWorldMatrix" };
+	printf("%u transforms, %u frames\n  %-24s %12s %12s %8s\n", options.Transforms, options.Frames, "Call", "Euler ns", "Quat ns", "Speedup");
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		printf("  %-24s %12.2f %12.2f %7.2fx\n", names[i], beforeSeconds[i] * 1e9 / calls, afterSeconds[i] * 1e9 / calls, beforeSeconds[i] / afterSeconds[i]);
+	}
+
+	//both took the same steps, so with no roll they should still agree
+	float largestDirection = 0.0f;
+	float largestPosition = 0.0f;
+	for (unsigned int i = 0; i < options.Transforms; i++)
+	{
+		largestDirection = std::fmax(largestDirection, Distance(before[i].GetForward(), after[i].GetForward()));
+		largestPosition = std::fmax(largestPosition, Distance(before[i].GetPosition(), after[i].GetPosition()));
+	}
+	printf("Largest difference: forward %g, position %g (sink %g)\n", largestDirection, largestPosition, sink);
+	if (largestDirection > 1e-3f || largestPosition > 1e-3f + 1e-6f * options.Frames)
+	{
+		fprintf(stderr, "Euler and quaternion transforms disagree\n");
+		return 1;
+	}
+	return 0;
+}
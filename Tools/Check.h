@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+// --------------------------------------------------------
+// What every check program shares: the failure count, of
+// which only the first few are printed, "-name N" options,
+// and the summary and exit code a check ends with. Header
+// only, so each check still builds from one command line.
+// --------------------------------------------------------
+
+// Failures so far, over the whole run
+inline unsigned int checkFailures = 0;
+
+// Counts a failure, returning true for the first few, which are worth printing
+inline bool CountFailure()
+{
+	return checkFailures++ < 10;
+}
+
+// Counts and prints a failure if the condition doesn't hold
+inline void Expect(bool condition, const char* message)
+{
+	if (!condition && CountFailure())
+		fprintf(stderr, "%s\n", message);
+}
+
+// The same, for a failure at a numbered step, e.g. "Frame 12: ..."
+inline void Expect(bool condition, const char* message, const char* at, unsigned int index)
+{
+	if (!condition && CountFailure())
+		fprintf(stderr, "%s %u: %s\n", at, index, message);
+}
+
+// A "-name N" option and the value it sets, which keeps its default if not given
+struct CheckOption
+{
+	const char* Name;
+	unsigned int* Value;
+};
+
+// Reads the options. Anything else prints the usage and returns false.
+inline bool ParseCheckOptions(int argc, char* argv[], const char* check, std::initializer_list<CheckOption> options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const CheckOption* found = 0;
+		for (const CheckOption& option : options)
+		{
+			if (!strcmp(argv[i], option.Name))
+				found = &option;
+		}
+
+		if (!found || i + 1 >= argc)
+		{
+			fprintf(stderr, "Usage: %s", check);
+			for (const CheckOption& option : options)
+				fprintf(stderr, " [%s N]", option.Name);
+			fprintf(stderr, "\n");
+			return false;
+		}
+		*found->Value = (unsigned int)atoi(argv[++i]);
+	}
+	return true;
+}
+
+// Prints how many failures there were, and returns the exit code: nonzero after any
+inline int FinishCheck()
+{
+	printf("%u failures\n", checkFailures);
+	return checkFailures ? 1 : 0;
+}
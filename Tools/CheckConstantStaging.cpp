@@ -0,0 +1,162 @@
+// --------------------------------------------------------
+// Checks SimpleConstantStaging with no device, through a
+// recording uploader standing in for the device context.
+// Replays what SimpleShader does: SetData writes into a
+// slot, and CopyBufferData uploads it unless the GPU copy
+// is current. Setting unchanged data must skip the upload,
+// changed data must upload exactly the staged bytes, a new
+// generation must upload again, and slots must not dirty
+// each other. Then runs random writes and uploads against
+// a model, and checks BytesUploaded and UploadsSkipped
+// match what the uploader actually saw. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckConstantStaging.cpp ../SimpleShader/SimpleConstantStaging.cpp -o CheckConstantStaging
+//   ./CheckConstantStaging -steps 100000
+// --------------------------------------------------------
+
+#include "../SimpleShader/SimpleConstantStaging.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Records every upload instead of sending it anywhere
+	// --------------------------------------------------------
+	class RecordingUploader : public ISimpleConstantUploader
+	{
+	public:
+		void Upload(const void* data, unsigned int size)
+		{
+			Last.assign((const unsigned char*)data, (const unsigned char*)data + size);
+			Uploads++;
+			Bytes += size;
+		}
+
+		std::vector<unsigned char> Last;
+		unsigned int Uploads = 0;
+		unsigned int Bytes = 0;
+	};
+
+	// What SetData then CopyBufferData do with the staging
+	bool SetAndCopy(SimpleConstantStaging& staging, unsigned int slot, unsigned int generation, unsigned int offset, float value, RecordingUploader& uploader)
+	{
+		staging.Write(slot, offset, &value, sizeof(value));
+		return staging.Upload(slot, generation, &uploader);
+	}
+
+	bool Staged(SimpleConstantStaging& staging, unsigned int slot, const RecordingUploader& uploader)
+	{
+		return uploader.Last.size() == staging.GetSize() && memcmp(uploader.Last.data(), staging.GetData(slot), staging.GetSize()) == 0;
+	}
+
+	void CheckBasics()
+	{
+		SimpleConstantStaging::ResetStats();
+		SimpleConstantStaging staging;
+		staging.Resize(64, SIMPLE_SHADER_MAX_RECORDING_SLOTS);
+		RecordingUploader uploader;
+
+		Expect(SetAndCopy(staging, 0, 1, 0, 1.0f, uploader), "A new buffer's first copy didn't upload");
+		Expect(Staged(staging, 0, uploader), "The upload doesn't hold the staged bytes");
+		Expect(!SetAndCopy(staging, 0, 1, 0, 1.0f, uploader), "Setting unchanged data uploaded again");
+		Expect(SetAndCopy(staging, 0, 1, 0, 2.0f, uploader), "Setting changed data didn't upload");
+		Expect(Staged(staging, 0, uploader), "The upload doesn't hold the changed bytes");
+		Expect(!staging.Upload(0, 1, &uploader), "Copying twice uploaded twice");
+		Expect(staging.Upload(0, 2, &uploader), "A new generation didn't upload");
+
+		//a write to one slot leaves the others current
+		Expect(staging.Upload(1, 2, &uploader), "A new slot's first copy didn't upload");
+		Expect(SetAndCopy(staging, 2, 2, 16, 3.0f, uploader), "Another slot's changed data didn't upload");
+		Expect(!staging.Upload(1, 2, &uploader), "A write to one slot dirtied another");
+		Expect(!staging.Upload(0, 2, &uploader), "A write to one slot dirtied slot 0");
+
+		//a change that's undone still uploads, the dirty flag doesn't compare with the GPU copy
+		staging.Write(0, 0, "\x00\x00\x80\x40", 4);
+		float two = 2.0f;
+		staging.Write(0, 0, &two, 4);
+		Expect(staging.Upload(0, 2, &uploader), "A change that was undone skipped the upload");
+
+		Expect(uploader.Uploads == 6, "The uploader didn't see the expected six uploads");
+		Expect(SimpleConstantStaging::BytesUploaded == uploader.Bytes, "BytesUploaded doesn't match the uploader");
+		Expect(SimpleConstantStaging::UploadsSkipped == 4, "UploadsSkipped doesn't match the skipped copies");
+	}
+
+	// Random writes and copies across slots and generations against a model
+	void CheckRandom(unsigned int steps)
+	{
+		const unsigned int size = 256;
+		const unsigned int slotCount = SIMPLE_SHADER_MAX_RECORDING_SLOTS;
+
+		SimpleConstantStaging::ResetStats();
+		SimpleConstantStaging staging;
+		staging.Resize(size, slotCount);
+		RecordingUploader uploader;
+
+		//per slot: changed since the last upload, and the generation it went up in
+		std::vector<bool> dirty(slotCount, true);
+		std::vector<unsigned int> uploadedGeneration(slotCount, 0);
+		std::vector<unsigned int> generations(slotCount, 1);
+		unsigned int skipped = 0;
+
+		std::mt19937 random(5);
+		std::uniform_int_distribution<unsigned int> slotOf(0, slotCount - 1);
+		std::uniform_int_distribution<unsigned int> action(0, 9);
+		std::uniform_int_distribution<unsigned int> offsetOf(0, size / 4 - 1);
+		std::uniform_int_distribution<unsigned int> valueOf(0, 3);
+		for (unsigned int step = 0; step < steps; step++)
+		{
+			unsigned int slot = slotOf(random);
+			unsigned int choice = action(random);
+			if (choice < 5)
+			{
+				//few values, so many writes repeat what's there
+				unsigned int offset = offsetOf(random) * 4;
+				float value = (float)valueOf(random);
+				bool changes = memcmp(staging.GetData(slot) + offset, &value, 4) != 0;
+				Expect(staging.Write(slot, offset, &value, 4) == changes, "Write misreported whether the bytes changed");
+				dirty[slot] = dirty[slot] || changes;
+			}
+			else if (choice < 9)
+			{
+				bool expected = dirty[slot] || uploadedGeneration[slot] != generations[slot];
+				unsigned int before = uploader.Uploads;
+				bool uploaded = staging.Upload(slot, generations[slot], &uploader);
+				Expect(uploaded == expected, "Upload disagreed with the model");
+				Expect(uploader.Uploads == before + (uploaded ? 1 : 0), "Upload's result doesn't match the uploader");
+				if (uploaded)
+				{
+					Expect(Staged(staging, slot, uploader), "An upload doesn't hold the slot's staged bytes");
+					dirty[slot] = false;
+					uploadedGeneration[slot] = generations[slot];
+				}
+				else
+				{
+					skipped++;
+				}
+			}
+			else
+			{
+				//the slot's context began a new command list
+				generations[slot]++;
+			}
+		}
+
+		Expect(SimpleConstantStaging::BytesUploaded == uploader.Bytes, "BytesUploaded doesn't match the random run's uploader");
+		Expect(SimpleConstantStaging::UploadsSkipped == skipped, "UploadsSkipped doesn't match the random run's skips");
+		printf("%u steps: %u uploads, %u skipped\n", steps, uploader.Uploads, skipped);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int steps = 100000;
+	if (!ParseCheckOptions(argc, argv, "CheckConstantStaging", { { "-steps", &steps } }))
+		return 1;
+
+	CheckBasics();
+	CheckRandom(steps);
+	return FinishCheck();
+}
@@ -0,0 +1,244 @@
+// --------------------------------------------------------
+// Checks GpuTimer with no device, through a query backend
+// standing in for a GPU that finishes each frame a random
+// number of frames after it was begun, and sometimes
+// reports a frame disjoint. The timer must read frames in
+// the order they were begun, never reuse a slot without
+// counting the frame in it as dropped, and never wait:
+// every frame ends up resolved, dropped or still in
+// flight. A GPU that keeps up within the latency must lose
+// no frames, one that falls further behind must lose them
+// all, and the times reaching TimingStats must match what
+// the GPU measured. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckGpuTimer.cpp ../GpuTimer.cpp ../TimingStats.cpp
+//     ../FrameStatsRecorder.cpp -o CheckGpuTimer
+//   ./CheckGpuTimer -frames 100000
+// --------------------------------------------------------
+
+#include "../GpuTimer.h"
+#include "Check.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const unsigned long long frequency = 1000000; //ticks per second
+
+	// Ticks a scope took in a frame, different every frame
+	unsigned long long ScopeTicks(unsigned long long frame, unsigned int scope)
+	{
+		return (frame * 7 + scope * 13) % 5000 + 1;
+	}
+
+	// --------------------------------------------------------
+	// A GPU the test steps a frame at a time. A frame begun in
+	// a slot is ready some frames later, and the slot only
+	// holds the last frame begun in it.
+	// --------------------------------------------------------
+	class SimulatedQueries : public IGpuQueryBackend
+	{
+	public:
+		struct Slot
+		{
+			unsigned long long Frame;
+			unsigned long long ReadyAt; //in frames begun
+			bool Disjoint;
+			bool Open;
+			bool Read;
+		};
+
+		Slot Slots[GPU_TIMER_FRAME_LATENCY] = {};
+		unsigned long long FramesBegun = 0;
+		unsigned long long FramesOverwritten = 0; //begun over a frame never read
+		unsigned long long FramesReadDisjoint = 0;
+		std::vector<unsigned long long> FramesRead; //in the order the timer read them
+		std::vector<unsigned long long> FramesReadTimed; //of those, the ones that weren't disjoint
+		unsigned int Delay = 0; //frames, for the next frame begun
+		bool NextDisjoint = false;
+
+		void BeginFrame(unsigned int slot)
+		{
+			Expect(slot < GPU_TIMER_FRAME_LATENCY, "BeginFrame on a slot that doesn't exist");
+			Slot& s = Slots[slot % GPU_TIMER_FRAME_LATENCY];
+			Expect(!s.Open, "BeginFrame on a slot already open");
+			if (FramesBegun >= GPU_TIMER_FRAME_LATENCY && !s.Read)
+				FramesOverwritten++;
+
+			s.Frame = FramesBegun;
+			s.ReadyAt = FramesBegun + 1 + Delay;
+			s.Disjoint = NextDisjoint;
+			s.Open = true;
+			s.Read = false;
+			FramesBegun++;
+		}
+
+		void EndFrame(unsigned int slot)
+		{
+			Expect(slot < GPU_TIMER_FRAME_LATENCY && Slots[slot].Open, "EndFrame on a slot that isn't open");
+			Slots[slot % GPU_TIMER_FRAME_LATENCY].Open = false;
+		}
+
+		bool ReadFrame(unsigned int slot, unsigned int timestampCount, unsigned long long* timestamps,
+			unsigned long long* frequency, bool* disjoint)
+		{
+			Slot& s = Slots[slot % GPU_TIMER_FRAME_LATENCY];
+			Expect(!s.Open, "ReadFrame on a frame that hasn't ended");
+			Expect(!s.Read, "ReadFrame on a frame already read");
+			if (s.Open || s.Read || FramesBegun < s.ReadyAt)
+				return false;
+
+			//scopes run back to back from an arbitrary start
+			unsigned long long time = 1ull << 40;
+			for (unsigned int i = 0; i + 1 < timestampCount; i += 2)
+			{
+				timestamps[i] = time;
+				time += ScopeTicks(s.Frame, i / 2);
+				timestamps[i + 1] = time;
+			}
+			*frequency = ::frequency;
+			*disjoint = s.Disjoint;
+
+			s.Read = true;
+			FramesRead.push_back(s.Frame);
+			if (s.Disjoint)
+				FramesReadDisjoint++;
+			else
+				FramesReadTimed.push_back(s.Frame);
+			return true;
+		}
+	};
+
+	// Frames still in the backend that nobody has read or overwritten
+	unsigned long long Unread(const SimulatedQueries& queries)
+	{
+		unsigned long long unread = 0;
+		for (const SimulatedQueries::Slot& slot : queries.Slots)
+		{
+			if (slot.ReadyAt > 0 && !slot.Read)
+				unread++;
+		}
+		return unread;
+	}
+
+	// Steady GPU delays: within the latency nothing is lost, beyond it everything is
+	void CheckSteady()
+	{
+		for (unsigned int delay = 0; delay <= GPU_TIMER_FRAME_LATENCY + 1; delay++)
+		{
+			std::shared_ptr<SimulatedQueries> queries = std::make_shared<SimulatedQueries>();
+			std::shared_ptr<TimingStats> stats = std::make_shared<TimingStats>();
+			GpuTimer timer(queries, stats);
+			timer.RegisterScope("Shadows");
+			timer.RegisterScope("Opaque");
+			queries->Delay = delay;
+
+			const unsigned int frames = 100;
+			for (unsigned int f = 0; f < frames; f++)
+			{
+				timer.BeginFrame();
+				Expect(timer.GetFrameSlot() == f % GPU_TIMER_FRAME_LATENCY, "Frames don't take the slots in turn");
+				timer.EndFrame();
+			}
+
+			if (delay < GPU_TIMER_FRAME_LATENCY)
+			{
+				Expect(timer.GetFramesDropped() == 0, "A GPU within the latency lost frames");
+				//the last frames begun are still in flight
+				Expect(timer.GetFramesResolved() == frames - 1 - delay, "A GPU within the latency didn't resolve every finished frame");
+			}
+			else
+			{
+				Expect(timer.GetFramesResolved() == 0, "A GPU behind the latency resolved a frame it should have given up on");
+				Expect(timer.GetFramesDropped() == frames - GPU_TIMER_FRAME_LATENCY, "A GPU behind the latency didn't drop every frame");
+			}
+		}
+
+		//a frame that isn't open can't be ended, and ending it twice does nothing
+		std::shared_ptr<SimulatedQueries> queries = std::make_shared<SimulatedQueries>();
+		GpuTimer timer(queries, std::make_shared<TimingStats>());
+		timer.EndFrame();
+		timer.BeginFrame();
+		timer.EndFrame();
+		timer.EndFrame();
+	}
+
+	void CheckRandom(unsigned int frames)
+	{
+		std::shared_ptr<SimulatedQueries> queries = std::make_shared<SimulatedQueries>();
+		std::shared_ptr<TimingStats> stats = std::make_shared<TimingStats>();
+		GpuTimer timer(queries, stats);
+		const char* names[] = { "Shadows", "Opaque", "Sky", "Post" };
+		const unsigned int scopeCount = 4;
+		for (unsigned int i = 0; i < scopeCount; i++)
+			Expect(timer.RegisterScope(names[i]) == i, "Scopes aren't numbered from 0");
+		Expect(timer.GetTimestampCount() == scopeCount * 2, "Not two timestamps per scope");
+
+		//mostly a frame or two behind, sometimes a long stall
+		std::mt19937 random(3);
+		std::uniform_int_distribution<unsigned int> delayOf(0, 99);
+		for (unsigned int f = 0; f < frames; f++)
+		{
+			unsigned int roll = delayOf(random);
+			queries->Delay = roll < 80 ? roll % 3 : roll < 97 ? roll % (GPU_TIMER_FRAME_LATENCY + 1) : 8;
+			queries->NextDisjoint = delayOf(random) < 2;
+			timer.BeginFrame();
+			timer.EndFrame();
+
+			unsigned long long accounted = timer.GetFramesResolved() + timer.GetFramesDropped();
+			Expect(accounted <= queries->FramesBegun && queries->FramesBegun - accounted <= GPU_TIMER_FRAME_LATENCY, "More frames in flight than there are slots");
+		}
+
+		//in order, and each exactly once
+		bool ordered = true;
+		for (size_t i = 1; i < queries->FramesRead.size(); i++)
+			ordered = ordered && queries->FramesRead[i] > queries->FramesRead[i - 1];
+		Expect(ordered, "Frames weren't read in the order they were begun");
+
+		Expect(timer.GetFramesResolved() == queries->FramesReadTimed.size(), "Resolved frames don't match the frames read that weren't disjoint");
+		Expect(timer.GetFramesDropped() == queries->FramesReadDisjoint + queries->FramesOverwritten, "Dropped frames don't match the disjoint and overwritten ones");
+		Expect(timer.GetFramesResolved() + timer.GetFramesDropped() + Unread(*queries) == queries->FramesBegun, "A frame was lost without being counted");
+
+		//each scope's window holds the last resolved frames' times
+		for (unsigned int i = 0; i < scopeCount; i++)
+		{
+			std::vector<float> expected;
+			for (unsigned long long frame : queries->FramesReadTimed)
+				expected.push_back((float)(ScopeTicks(frame, i) * 1000.0 / frequency));
+			if (expected.size() > TIMING_STATS_WINDOW)
+				expected.erase(expected.begin(), expected.end() - TIMING_STATS_WINDOW);
+
+			TimingSummary summary = {};
+			bool found = stats->GetSummary(names[i], &summary);
+			Expect(found && summary.Count == expected.size(), "A scope's series doesn't hold the resolved frames");
+			if (!found || expected.empty())
+				continue;
+
+			float minimum = expected[0];
+			float maximum = expected[0];
+			double total = 0.0;
+			for (float ms : expected)
+			{
+				minimum = ms < minimum ? ms : minimum;
+				maximum = ms > maximum ? ms : maximum;
+				total += ms;
+			}
+			Expect(summary.Min == minimum && summary.Max == maximum, "A scope's times don't match what the GPU measured");
+			Expect(std::fabs(summary.Average - total / expected.size()) < 1e-4, "A scope's average doesn't match what the GPU measured");
+		}
+
+		printf("%u frames: %llu resolved, %llu dropped (%llu disjoint)\n", frames, timer.GetFramesResolved(), timer.GetFramesDropped(), queries->FramesReadDisjoint);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int frames = 100000;
+	if (!ParseCheckOptions(argc, argv, "CheckGpuTimer", { { "-frames", &frames } }))
+		return 1;
+
+	CheckSteady();
+	CheckRandom(frames);
+	return FinishCheck();
+}
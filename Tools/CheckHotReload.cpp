@@ -0,0 +1,167 @@
+// --------------------------------------------------------
+// Checks hot reload's change detection against the real
+// file system notifications (inotify on Linux), with no
+// device. In a scratch directory it sets up what the game
+// registers: shaders sharing an include, one OBJ behind two
+// meshes and a packed map built from several PNGs. It then
+// edits files the ways editors and tools do and checks
+// which assets come back: only the ones using a changed
+// file, once however many writes a save takes, nothing for
+// a save that changes nothing, and new includes once the
+// shader's files are scanned again. Exits nonzero after
+// any mismatch. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckHotReload.cpp ../FileWatcher.cpp ../AssetDependencies.cpp -o CheckHotReload
+//   ./CheckHotReload
+// --------------------------------------------------------
+
+#include "../AssetDependencies.h"
+#include "../FileWatcher.h"
+#include "Check.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const unsigned int settleMilliseconds = 50;
+
+	std::string root;
+
+	std::string PathOf(const std::string& name)
+	{
+		return root + "/" + name;
+	}
+
+	void Write(const std::string& name, const std::string& contents)
+	{
+		std::ofstream file(PathOf(name), std::ios::binary | std::ios::trunc);
+		file << contents;
+	}
+
+	// Written beside the file, then renamed over it, as many editors save
+	void WriteByRename(const std::string& name, const std::string& contents)
+	{
+		Write(name + ".tmp", contents);
+		std::filesystem::rename(PathOf(name + ".tmp"), PathOf(name));
+	}
+
+	// Polls until the watcher has been quiet for a few settle times, like frames do
+	std::vector<AssetId> Collect(FileWatcher& watcher, AssetDependencies& dependencies)
+	{
+		std::vector<AssetId> changed;
+		auto quietSince = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - quietSince < std::chrono::milliseconds(settleMilliseconds * 4))
+		{
+			std::vector<std::string> files;
+			watcher.Poll(files);
+			if (!files.empty())
+			{
+				dependencies.GetChanged(files, changed);
+				quietSince = std::chrono::steady_clock::now();
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		return changed;
+	}
+
+	void Check(const char* step, FileWatcher& watcher, AssetDependencies& dependencies, const std::vector<AssetId>& expected)
+	{
+		std::vector<AssetId> changed = Collect(watcher, dependencies);
+		bool same = changed == expected;
+		printf("%-44s", step);
+		for (AssetId asset : changed)
+			printf(" %s", dependencies.GetName(asset).c_str());
+		printf("%s%s\n", changed.empty() ? " (nothing)" : "", same ? "" : "  MISMATCH");
+		if (!same)
+			CountFailure();
+	}
+}
+
+int main()
+{
+	std::filesystem::path scratch = std::filesystem::temp_directory_path() / "CheckHotReload";
+	std::filesystem::remove_all(scratch);
+	std::filesystem::create_directories(scratch / "Models");
+	root = scratch.generic_string();
+
+	Write("Lighting.hlsli", "float3 Light() { return 1; }\n");
+	Write("Includes.hlsli", "#include \"Lighting.hlsli\"\n");
+	Write("VertexShader.hlsl", "#include \"Includes.hlsli\"\nfloat4 main() : SV_POSITION { return 0; }\n");
+	Write("PixelShader.hlsl", "  #include \"Lighting.hlsli\"\nfloat4 main() : SV_TARGET { return 1; }\n");
+	Write("PixelShader_Sky.hlsl", "float4 main() : SV_TARGET { return 0; }\n");
+	Write("Models/cube.obj", "v 0 0 0\n");
+	Write("Models/sphere.obj", "v 1 1 1\n");
+	Write("bronze_roughness.png", "roughness");
+	Write("bronze_metal.png", "metal");
+	Write("unrelated.txt", "nothing uses this");
+
+	//registered as the game does; the ids are the order added
+	AssetDependencies dependencies;
+	const char* shaders[] = { "VertexShader.hlsl", "PixelShader.hlsl", "PixelShader_Sky.hlsl" };
+	for (const char* shader : shaders)
+	{
+		std::vector<std::string> files;
+		AssetDependencies::GetShaderFiles(PathOf(shader), files);
+		dependencies.Add(shader, files);
+	}
+	dependencies.Add("cube.obj (meshes 0, 5)", { PathOf("Models/cube.obj") });
+	dependencies.Add("sphere.obj", { PathOf("Models/sphere.obj") });
+	dependencies.Add("bronze surface", { PathOf("bronze_surface.dds"), PathOf("bronze_roughness.png"), PathOf("bronze_metal.png"), PathOf("bronze_ao.png") });
+	const AssetId vertexShader = 0, pixelShader = 1, skyShader = 2, cube = 3, sphere = 4, surface = 5;
+
+	FileWatcher watcher(settleMilliseconds);
+	std::vector<std::string> directories;
+	dependencies.GetDirectories(directories);
+	for (const std::string& directory : directories)
+	{
+		if (!watcher.Watch(directory))
+		{
+			printf("Can't watch %s on this platform\n", directory.c_str());
+			return 1;
+		}
+	}
+
+	Write("Lighting.hlsli", "float3 Light() { return 2; }\n");
+	Check("Shared include edited:", watcher, dependencies, { vertexShader, pixelShader });
+
+	Write("Includes.hlsli", "#include \"Lighting.hlsli\"\n// comment\n");
+	Check("Nested include edited:", watcher, dependencies, { vertexShader });
+
+	Write("PixelShader_Sky.hlsl", "float4 main() : SV_TARGET { return 0; }\n");
+	Check("Saved without changes:", watcher, dependencies, {});
+
+	for (unsigned int i = 0; i < 10; i++)
+		Write("Models/cube.obj", "v 0 0 " + std::to_string(i) + "\n");
+	Check("Written ten times in a row:", watcher, dependencies, { cube });
+
+	WriteByRename("Models/sphere.obj", "v 2 2 2\n");
+	Check("Renamed over:", watcher, dependencies, { sphere });
+
+	Write("bronze_ao.png", "occlusion");
+	Check("Missing source created:", watcher, dependencies, { surface });
+
+	Write("unrelated.txt", "still nothing uses this");
+	Check("File no asset uses:", watcher, dependencies, {});
+
+	//a new include only counts once the shader is scanned again, as a reload does
+	Write("Shadows.hlsli", "float Shadow() { return 1; }\n");
+	WriteByRename("PixelShader_Sky.hlsl", "#include \"Shadows.hlsli\"\nfloat4 main() : SV_TARGET { return Shadow(); }\n");
+	Check("Include added:", watcher, dependencies, { skyShader });
+	std::vector<std::string> skyFiles;
+	AssetDependencies::GetShaderFiles(PathOf("PixelShader_Sky.hlsl"), skyFiles);
+	dependencies.SetFiles(skyShader, skyFiles);
+	Write("Shadows.hlsli", "float Shadow() { return 0.5; }\n");
+	Check("New include edited:", watcher, dependencies, { skyShader });
+
+	Write("Lighting.hlsli", "float3 Light() { return 3; }\n");
+	Write("Models/cube.obj", "v 9 9 9\n");
+	Write("bronze_metal.png", "metal 2");
+	Check("Several at once:", watcher, dependencies, { vertexShader, pixelShader, cube, surface });
+
+	std::filesystem::remove_all(scratch);
+	return FinishCheck();
+}
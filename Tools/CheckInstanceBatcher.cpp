@@ -0,0 +1,159 @@
+// --------------------------------------------------------
+// Checks InstanceBatcher with no device. Random entities
+// go through a sorted RenderQueue, then for every pass:
+// BuildBatches must cover the pass's items in order, each
+// batch one shader, material and mesh, with no two batches
+// in a row that could have merged. PackInstances must write
+// exactly one instance per item, in item order, holding its
+// entity's world matrix, an inverse transpose that undoes
+// it, and the material from the entity array or, without
+// one, from the key. Needs DirectXMath, e.g.
+//   g++ -O2 -std=c++17 -I.. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs
+//     CheckInstanceBatcher.cpp ../InstanceBatcher.cpp ../RenderQueue.cpp ../Transform.cpp -o CheckInstanceBatcher
+//   ./CheckInstanceBatcher -entities 5000
+// --------------------------------------------------------
+
+#include "../InstanceBatcher.h"
+#include "Check.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	void Fail(const char* message, unsigned int pass, unsigned int index)
+	{
+		if (CountFailure())
+			fprintf(stderr, "Pass %u, item %u: %s\n", pass, index, message);
+	}
+
+	bool SameMatrix(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		return memcmp(&a, &b, sizeof(XMFLOAT4X4)) == 0;
+	}
+
+	// World times the transpose of its inverse transpose is the identity
+	bool Undoes(const XMFLOAT4X4& world, const XMFLOAT4X4& inverseTranspose)
+	{
+		XMFLOAT4X4 product;
+		XMStoreFloat4x4(&product, XMMatrixMultiply(XMLoadFloat4x4(&world), XMMatrixTranspose(XMLoadFloat4x4(&inverseTranspose))));
+		for (unsigned int r = 0; r < 4; r++)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				if (std::fabs(product.m[r][c] - (r == c ? 1.0f : 0.0f)) > 1e-3f)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void CheckBatches(unsigned int pass, const RenderItem* items, unsigned int count, unsigned int firstInstance, const std::vector<InstanceBatch>& batches)
+	{
+		unsigned int next = firstInstance;
+		for (unsigned int b = 0; b < batches.size(); b++)
+		{
+			const InstanceBatch& batch = batches[b];
+			if (batch.FirstInstance != next || batch.InstanceCount == 0)
+				Fail("batches leave a gap, overlap or are empty", pass, next - firstInstance);
+			for (unsigned int i = batch.FirstInstance - firstInstance; i < batch.FirstInstance - firstInstance + batch.InstanceCount && i < count; i++)
+			{
+				unsigned long long key = items[i].Key;
+				if (RenderQueue::GetShader(key) != batch.Shader || RenderQueue::GetMaterial(key) != batch.Material || RenderQueue::GetMesh(key) != batch.Mesh)
+					Fail("item doesn't match its batch's state", pass, i);
+			}
+			if (b > 0 && batches[b - 1].Shader == batch.Shader && batches[b - 1].Material == batch.Material && batches[b - 1].Mesh == batch.Mesh)
+				Fail("two batches in a row could have merged", pass, batch.FirstInstance - firstInstance);
+			next = batch.FirstInstance + batch.InstanceCount;
+		}
+		if (next != firstInstance + count)
+			Fail("batches don't cover every item", pass, next - firstInstance);
+	}
+
+	void CheckInstances(unsigned int pass, const RenderItem* items, unsigned int count, Transform* transforms, const unsigned int* materials, const std::vector<InstanceData>& instances)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const InstanceData& instance = instances[i];
+			Transform& transform = transforms[items[i].EntityIndex];
+			if (!SameMatrix(instance.World, transform.GetWorldMatrix()))
+				Fail("instance holds another entity's world matrix", pass, i);
+			if (!Undoes(instance.World, instance.WorldInvTranspose))
+				Fail("inverse transpose doesn't undo the world matrix", pass, i);
+			unsigned int material = materials ? materials[items[i].EntityIndex] : RenderQueue::GetMaterial(items[i].Key);
+			if (instance.MaterialIndex != material)
+				Fail("instance holds the wrong material", pass, i);
+		}
+
+		//nothing written past the last item
+		const unsigned char* past = (const unsigned char*)&instances[count];
+		for (unsigned int b = 0; b < sizeof(InstanceData); b++)
+		{
+			if (past[b] != 0xCD)
+			{
+				Fail("wrote past the last instance", pass, count);
+				break;
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int entityCount = 5000;
+	if (!ParseCheckOptions(argc, argv, "CheckInstanceBatcher", { { "-entities", &entityCount } }))
+		return 1;
+
+	//few meshes and materials, so long runs share state and batch
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+	std::uniform_int_distribution<unsigned int> material(0, 5);
+	std::uniform_int_distribution<unsigned int> mesh(0, 3);
+	std::uniform_int_distribution<unsigned int> shader(1, 2);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+	std::vector<Transform> transforms(entityCount);
+	std::vector<unsigned int> materials(entityCount);
+	RenderQueue queue;
+	for (unsigned int e = 0; e < entityCount; e++)
+	{
+		transforms[e].SetPosition(position(random), position(random), position(random));
+		transforms[e].SetRotation(angle(random), angle(random), angle(random));
+		transforms[e].SetScale(scale(random), scale(random), scale(random));
+		materials[e] = material(random);
+		queue.Add(RENDER_PASS_SHADOW_0, 0, 0, mesh(random), 0.0f, e);
+		queue.Add(RENDER_PASS_OPAQUE, shader(random), materials[e], mesh(random), depth(random), e);
+	}
+	queue.Sort();
+
+	//each pass batches from its own offset, as the frame's instance buffer does
+	unsigned int totalBatches = 0;
+	for (unsigned int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+	{
+		unsigned int count;
+		const RenderItem* items = queue.GetPassItems(pass, &count);
+		unsigned int firstInstance = queue.GetPassStart(pass);
+
+		std::vector<InstanceBatch> batches;
+		InstanceBatcher::BuildBatches(items, count, firstInstance, batches);
+		CheckBatches(pass, items, count, firstInstance, batches);
+		totalBatches += (unsigned int)batches.size();
+
+		std::vector<InstanceData> instances(count + 1);
+		for (const unsigned int* entityMaterials : { (const unsigned int*)materials.data(), (const unsigned int*)0 })
+		{
+			memset(instances.data(), 0xCD, instances.size() * sizeof(InstanceData));
+			InstanceBatcher::PackInstances(items, count, transforms.data(), entityMaterials, instances.data());
+			CheckInstances(pass, items, count, transforms.data(), entityMaterials, instances);
+		}
+	}
+
+	printf("%u items in %u batches\n", queue.GetCount(), totalBatches);
+	return FinishCheck();
+}
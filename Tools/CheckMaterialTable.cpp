@@ -0,0 +1,366 @@
+// --------------------------------------------------------
+// Checks MaterialTable with no device. GetFullMipCount and
+// Fits are checked on known sizes, then random material
+// sets are compiled one after another, each against the
+// last compile's arrays as when textures stream. Every
+// compile must match a model: each array in the format
+// most eligible materials use, sized by its largest texture
+// unless the last array still holds that on its top two
+// levels; a material in the table exactly when it's
+// eligible, within MATERIAL_TABLE_MAX_SLICES and every map
+// it has lands on some level of its array with the levels
+// below; records pointing at distinct slices handed out in
+// material order, with the level the map starts on as the
+// minimum LOD; and one copy filling each slice down to the
+// array's last level. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckMaterialTable.cpp ../MaterialTable.cpp -o CheckMaterialTable
+//   ./CheckMaterialTable -compiles 2000
+// --------------------------------------------------------
+
+#include "../MaterialTable.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// DXGI_FORMAT values of BC1, BC3 and BC5 UNORM
+	const unsigned int formats[] = { 71, 77, 83 };
+
+	unsigned int Log2(unsigned int size)
+	{
+		unsigned int log = 0;
+		while (size > 1)
+		{
+			size >>= 1;
+			log++;
+		}
+		return log;
+	}
+
+	bool SameArray(const MaterialArrayLayout& a, const MaterialArrayLayout& b)
+	{
+		return a.Format == b.Format && a.Width == b.Width && a.Height == b.Height && a.MipCount == b.MipCount;
+	}
+
+	// The level of the array a map's top lands on, or -1 if it lands on none
+	// with all the levels below; sizes here are powers of two
+	int LandsOn(const MaterialMapDesc& map, const MaterialArrayLayout& array)
+	{
+		if (map.Width == 0 || array.Width == 0 || map.Format != array.Format)
+			return -1;
+		for (unsigned int level = 0; level < array.MipCount; level++)
+		{
+			unsigned int width = array.Width >> level ? array.Width >> level : 1;
+			unsigned int height = array.Height >> level ? array.Height >> level : 1;
+			if (width == map.Width && height == map.Height)
+				return map.MipCount >= array.MipCount - level ? (int)level : -1;
+		}
+		return -1;
+	}
+
+	void CheckSizes()
+	{
+		Expect(MaterialTable::GetFullMipCount(0, 0) == 0, "A texture with no size has mips");
+		Expect(MaterialTable::GetFullMipCount(1, 1) == 1, "A 1x1 texture isn't one mip");
+		Expect(MaterialTable::GetFullMipCount(256, 256) == 9, "A 256x256 texture isn't nine mips");
+		Expect(MaterialTable::GetFullMipCount(256, 1) == 9 && MaterialTable::GetFullMipCount(1, 256) == 9, "A strip isn't counted by its long side");
+		Expect(MaterialTable::GetFullMipCount(300, 20) == 9, "A size that isn't a power of two isn't rounded down");
+
+		MaterialArrayLayout array = { 71, 512, 256, 10, 0 };
+		unsigned int level = 99;
+		Expect(MaterialTable::Fits({ 71, 512, 256, 10 }, array, &level) && level == 0, "A texture the array's size didn't land on level 0");
+		Expect(MaterialTable::Fits({ 71, 128, 64, 8 }, array, &level) && level == 2, "A quarter size texture didn't land on level 2");
+		Expect(MaterialTable::Fits({ 71, 128, 64, 12 }, array, &level) && level == 2, "A texture with more levels than needed didn't fit");
+		level = 99;
+		Expect(!MaterialTable::Fits({ 71, 128, 64, 7 }, array, &level) && level == 99, "A texture missing its last level fit");
+		Expect(!MaterialTable::Fits({ 77, 512, 256, 10 }, array, &level), "A texture in another format fit");
+		Expect(!MaterialTable::Fits({ 71, 256, 256, 9 }, array, &level), "A texture of another aspect fit");
+		Expect(!MaterialTable::Fits({ 71, 1024, 512, 11 }, array, &level), "A texture larger than the array fit");
+		Expect(!MaterialTable::Fits({ 71, 0, 0, 0 }, array, &level), "A missing texture fit");
+		Expect(!MaterialTable::Fits({ 71, 512, 256, 10 }, MaterialArrayLayout(), &level), "A texture fit an empty array");
+
+		//a tie of formats goes to the one used first, ineligible materials don't count
+		std::vector<MaterialDesc> materials(4);
+		for (MaterialDesc& material : materials)
+			material = {};
+		materials[0].Maps[MATERIAL_TABLE_SURFACE] = { 83, 64, 64, 7 };
+		materials[1].Eligible = true;
+		materials[1].Maps[MATERIAL_TABLE_SURFACE] = { 77, 64, 64, 7 };
+		materials[2].Eligible = true;
+		materials[2].Maps[MATERIAL_TABLE_SURFACE] = { 71, 256, 256, 9 };
+		materials[3].Eligible = true;
+		MaterialTableLayout layout;
+		MaterialTable::Compile(materials, 0, layout);
+		Expect(layout.Arrays[MATERIAL_TABLE_SURFACE].Format == 77 && layout.InTable[1] && !layout.InTable[2], "A tie of formats didn't go to the one used first");
+		Expect(!layout.InTable[0] && layout.InTable[3] && layout.Records[3].Slices[MATERIAL_TABLE_SURFACE] == MATERIAL_TABLE_NO_SLICE, "Eligibility or a material with no maps was handled wrong");
+		Expect(layout.Arrays[MATERIAL_TABLE_ALBEDO].SliceCount == 0 && layout.Arrays[MATERIAL_TABLE_ALBEDO].Width == 0, "An array no material uses has a size");
+	}
+
+	// --------------------------------------------------------
+	// Streaming: the largest textures losing their top level
+	// keep the array, losing two shrinks it, and a compile
+	// with no previous arrays always sizes to the largest
+	// --------------------------------------------------------
+	void CheckKeptArrays()
+	{
+		std::vector<MaterialDesc> materials(3);
+		for (unsigned int m = 0; m < 3; m++)
+		{
+			materials[m] = {};
+			materials[m].Eligible = true;
+			unsigned int size = 512 >> m;
+			materials[m].Maps[MATERIAL_TABLE_ALBEDO] = { 71, size, size, MaterialTable::GetFullMipCount(size, size) };
+		}
+		MaterialTableLayout first;
+		MaterialTable::Compile(materials, 0, first);
+		Expect(first.Arrays[MATERIAL_TABLE_ALBEDO].Width == 512 && first.Records[2].MinLods[MATERIAL_TABLE_ALBEDO] == 2.0f, "The array isn't sized by the largest texture");
+
+		//one level out: the array stays, the material drops a level
+		materials[0].Maps[MATERIAL_TABLE_ALBEDO] = { 71, 256, 256, 9 };
+		MaterialTableLayout kept;
+		MaterialTable::Compile(materials, first.Arrays, kept);
+		Expect(SameArray(kept.Arrays[MATERIAL_TABLE_ALBEDO], first.Arrays[MATERIAL_TABLE_ALBEDO]), "Streaming a level out recreated the array");
+		Expect(kept.InTable[0] && kept.Records[0].MinLods[MATERIAL_TABLE_ALBEDO] == 1.0f, "A texture a level down didn't move down a level");
+		MaterialTableLayout fresh;
+		MaterialTable::Compile(materials, 0, fresh);
+		Expect(fresh.Arrays[MATERIAL_TABLE_ALBEDO].Width == 256, "With no previous arrays the array wasn't sized to the largest texture");
+
+		//two levels out from the kept array: it shrinks
+		materials[0].Maps[MATERIAL_TABLE_ALBEDO] = { 71, 128, 128, 8 };
+		materials[1].Maps[MATERIAL_TABLE_ALBEDO] = { 71, 128, 128, 8 };
+		MaterialTableLayout shrunk;
+		MaterialTable::Compile(materials, kept.Arrays, shrunk);
+		Expect(shrunk.Arrays[MATERIAL_TABLE_ALBEDO].Width == 128 && shrunk.Records[0].MinLods[MATERIAL_TABLE_ALBEDO] == 0.0f, "An array two levels too large was kept");
+
+		//a larger texture grows it, and another format replaces it
+		materials[2].Maps[MATERIAL_TABLE_ALBEDO] = { 71, 1024, 1024, 11 };
+		MaterialTableLayout grown;
+		MaterialTable::Compile(materials, shrunk.Arrays, grown);
+		Expect(grown.Arrays[MATERIAL_TABLE_ALBEDO].Width == 1024, "An array was kept when a larger texture needed it");
+		for (MaterialDesc& material : materials)
+			material.Maps[MATERIAL_TABLE_ALBEDO].Format = 77;
+		MaterialTableLayout reformatted;
+		MaterialTable::Compile(materials, grown.Arrays, reformatted);
+		Expect(reformatted.Arrays[MATERIAL_TABLE_ALBEDO].Format == 77 && reformatted.InTable[0] && reformatted.InTable[2], "An array in the old format was kept");
+	}
+
+	void CheckSliceLimit()
+	{
+		std::vector<MaterialDesc> materials(MATERIAL_TABLE_MAX_SLICES + 50);
+		for (MaterialDesc& material : materials)
+		{
+			material = {};
+			material.Eligible = true;
+			material.Maps[MATERIAL_TABLE_NORMALS] = { 83, 64, 64, 7 };
+		}
+		MaterialTableLayout layout;
+		MaterialTable::Compile(materials, 0, layout);
+		unsigned int tabled = 0;
+		for (unsigned char in : layout.InTable)
+			tabled += in;
+		Expect(tabled == MATERIAL_TABLE_MAX_SLICES && layout.Arrays[MATERIAL_TABLE_NORMALS].SliceCount == MATERIAL_TABLE_MAX_SLICES, "The table took more materials than an array has slices");
+		Expect(layout.InTable[MATERIAL_TABLE_MAX_SLICES - 1] && !layout.InTable[MATERIAL_TABLE_MAX_SLICES], "The table didn't take the first materials");
+	}
+
+	MaterialMapDesc RandomMap(std::mt19937& random, unsigned int map)
+	{
+		MaterialMapDesc desc = {};
+		if (random() % 5 == 0)
+			return desc;
+
+		//mostly one format per kind, so the choice of format matters
+		desc.Format = random() % 4 ? formats[map] : formats[random() % 3];
+		desc.Width = 16u << (random() % 6);
+		desc.Height = random() % 4 ? desc.Width : desc.Width / 2;
+		unsigned int full = MaterialTable::GetFullMipCount(desc.Width, desc.Height);
+		desc.MipCount = random() % 4 ? full : full - random() % 3;
+		return desc;
+	}
+
+	// The array a compile should make of one map kind
+	MaterialArrayLayout ModelArray(const std::vector<MaterialDesc>& materials, unsigned int map, const MaterialArrayLayout* previous)
+	{
+		//most used format, ties to the one used first
+		unsigned int counts[3] = {};
+		int firstUse[3] = { -1, -1, -1 };
+		for (unsigned int m = 0; m < materials.size(); m++)
+		{
+			const MaterialMapDesc& desc = materials[m].Maps[map];
+			if (!materials[m].Eligible || desc.Width == 0)
+				continue;
+			for (unsigned int f = 0; f < 3; f++)
+			{
+				if (desc.Format == formats[f])
+				{
+					counts[f]++;
+					firstUse[f] = firstUse[f] < 0 ? (int)m : firstUse[f];
+				}
+			}
+		}
+		int best = -1;
+		for (int f = 0; f < 3; f++)
+		{
+			if (counts[f] && (best < 0 || counts[f] > counts[best] || (counts[f] == counts[best] && firstUse[f] < firstUse[best])))
+				best = f;
+		}
+
+		MaterialArrayLayout array = {};
+		if (best < 0)
+			return array;
+		array.Format = formats[best];
+		for (const MaterialDesc& material : materials)
+		{
+			const MaterialMapDesc& desc = material.Maps[map];
+			if (material.Eligible && desc.Width && desc.Format == array.Format && desc.Width * desc.Height > array.Width * array.Height)
+			{
+				array.Width = desc.Width;
+				array.Height = desc.Height;
+			}
+		}
+		array.MipCount = Log2(array.Width > array.Height ? array.Width : array.Height) + 1;
+
+		//the last array, if the largest texture is on its top two levels
+		if (previous && previous[map].SliceCount && previous[map].Format == array.Format)
+		{
+			MaterialMapDesc largest = { array.Format, array.Width, array.Height, array.MipCount };
+			int level = LandsOn(largest, previous[map]);
+			if (level == 0 || level == 1)
+				array = previous[map];
+		}
+		array.SliceCount = 0;
+		return array;
+	}
+
+	void CheckCompile(const std::vector<MaterialDesc>& materials, const MaterialArrayLayout* previous, const MaterialTableLayout& layout, unsigned int& tabledTotal)
+	{
+		unsigned int count = (unsigned int)materials.size();
+		Expect(layout.Records.size() == count && layout.InTable.size() == count, "Not one record per material");
+		if (layout.Records.size() != count || layout.InTable.size() != count)
+			return;
+
+		MaterialArrayLayout arrays[MATERIAL_TABLE_MAPS];
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+		{
+			arrays[map] = ModelArray(materials, map, previous);
+			Expect(SameArray(layout.Arrays[map], arrays[map]), "An array doesn't match the model's format and size");
+		}
+
+		//in the table, slices in material order
+		unsigned int tabled = 0;
+		unsigned int nextSlice[MATERIAL_TABLE_MAPS] = {};
+		std::vector<const MaterialSliceCopy*> copyOf[MATERIAL_TABLE_MAPS];
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+			copyOf[map].assign(count, 0);
+		for (const MaterialSliceCopy& copy : layout.Copies)
+		{
+			bool valid = copy.Material < count && copy.Map < MATERIAL_TABLE_MAPS;
+			Expect(valid && !copyOf[copy.Map][copy.Material], "A copy is out of range or repeated");
+			if (valid)
+				copyOf[copy.Map][copy.Material] = &copy;
+		}
+
+		for (unsigned int m = 0; m < count; m++)
+		{
+			const MaterialDesc& material = materials[m];
+			const MaterialRecord& record = layout.Records[m];
+			int levels[MATERIAL_TABLE_MAPS];
+			bool fits = material.Eligible && tabled < MATERIAL_TABLE_MAX_SLICES;
+			for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+			{
+				levels[map] = LandsOn(material.Maps[map], arrays[map]);
+				if (material.Maps[map].Width && levels[map] < 0)
+					fits = false;
+			}
+			Expect((layout.InTable[m] != 0) == fits, fits ? "A material that fits was left out of the table" : "A material that doesn't fit was put in the table");
+			Expect(!memcmp(record.ColorTint, material.ColorTint, sizeof(record.ColorTint)), "A record's tint isn't the material's");
+			tabled += fits ? 1 : 0;
+
+			for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+			{
+				const MaterialSliceCopy* copy = copyOf[map][m];
+				if (!fits || material.Maps[map].Width == 0)
+				{
+					Expect(record.Slices[map] == MATERIAL_TABLE_NO_SLICE && record.MinLods[map] == 0.0f && !copy, "A map outside the table has a slice");
+					continue;
+				}
+
+				Expect(record.Slices[map] == (int)nextSlice[map], "Slices aren't handed out in material order");
+				Expect(record.MinLods[map] == (float)levels[map], "A record's minimum LOD isn't the level its map lands on");
+				Expect(copy && copy->Slice == nextSlice[map] && copy->FirstLevel == (unsigned int)levels[map], "A map in the table isn't copied to its slice and level");
+				if (copy)
+				{
+					Expect(copy->FirstLevel + copy->LevelCount == arrays[map].MipCount, "A copy doesn't fill its slice to the last level");
+					Expect(copy->LevelCount <= material.Maps[map].MipCount, "A copy reads levels the texture doesn't have");
+				}
+				nextSlice[map]++;
+			}
+		}
+
+		for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+			Expect(layout.Arrays[map].SliceCount == nextSlice[map], "An array's slice count isn't the slices handed out");
+		tabledTotal += tabled;
+	}
+
+	void CheckRandom(unsigned int compiles)
+	{
+		std::mt19937 random(29);
+		std::vector<MaterialDesc> materials;
+		MaterialTableLayout layouts[2];
+		unsigned int tabled = 0;
+		unsigned int kept = 0;
+		for (unsigned int c = 0; c < compiles; c++)
+		{
+			//now and then a new set, otherwise some textures stream a level in or out
+			if (c % 50 == 0)
+			{
+				materials.resize(random() % 64);
+				for (MaterialDesc& material : materials)
+				{
+					material.Eligible = random() % 7 != 0;
+					for (unsigned int i = 0; i < 3; i++)
+						material.ColorTint[i] = (random() % 256) / 255.0f;
+					for (unsigned int map = 0; map < MATERIAL_TABLE_MAPS; map++)
+						material.Maps[map] = RandomMap(random, map);
+				}
+			}
+			else
+			{
+				for (MaterialDesc& material : materials)
+				{
+					MaterialMapDesc& desc = material.Maps[random() % MATERIAL_TABLE_MAPS];
+					if (desc.Width == 0 || random() % 4)
+						continue;
+					bool down = desc.Width > 16 && desc.Height > 8 && (random() % 2 || desc.Width >= 512);
+					desc.Width = down ? desc.Width / 2 : desc.Width * 2;
+					desc.Height = down ? desc.Height / 2 : desc.Height * 2;
+					desc.MipCount = down ? desc.MipCount - 1 : desc.MipCount + 1;
+				}
+			}
+
+			const MaterialTableLayout& last = layouts[(c + 1) % 2];
+			MaterialTableLayout& layout = layouts[c % 2];
+			const MaterialArrayLayout* previous = c % 50 == 0 ? 0 : last.Arrays;
+			MaterialTable::Compile(materials, previous, layout);
+			CheckCompile(materials, previous, layout, tabled);
+			if (previous && SameArray(layout.Arrays[MATERIAL_TABLE_ALBEDO], last.Arrays[MATERIAL_TABLE_ALBEDO]))
+				kept++;
+		}
+		printf("%u compiles: %u materials in tables, albedo array kept %u times\n", compiles, tabled, kept);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int compiles = 2000;
+	if (!ParseCheckOptions(argc, argv, "CheckMaterialTable", { { "-compiles", &compiles } }))
+		return 1;
+
+	CheckSizes();
+	CheckKeptArrays();
+	CheckSliceLimit();
+	CheckRandom(compiles);
+	return FinishCheck();
+}
@@ -0,0 +1,414 @@
+// --------------------------------------------------------
+// Checks MipGenerator's levels against reference chains
+// built here in double. Random power of two images of each
+// content and channel count go through the box filter, and
+// every byte of every level must be within one of the
+// reference: sRGB colour averaged in linear light with
+// alpha left linear, data averaged as stored, and normals
+// averaged then renormalized, with two channel normals
+// getting z rebuilt. Known cases pin the spaces down: a
+// black and white checker must become sRGB 188 as colour
+// but 128 as data, and tilted normals that average out
+// must come back flat. Every normal any kernel makes must
+// be unit length, a flat image must stay flat under every
+// kernel, wrapping must reach across the edges and
+// clamping mustn't, and the levels must be the same with
+// jobs as without. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. CheckMipGenerator.cpp ../MipGenerator.cpp ../JobSystem.cpp
+//     ../Profiler.cpp -o CheckMipGenerator
+//   ./CheckMipGenerator -images 200
+// --------------------------------------------------------
+
+#include "../MipGenerator.h"
+#include "../JobSystem.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const char* contentNames[] = { "Linear", "sRGB", "Normals" };
+
+	// Four doubles per texel, in the space the content is filtered in
+	struct Reference
+	{
+		unsigned int Width;
+		unsigned int Height;
+		std::vector<double> Texels;
+
+		double* GetTexel(unsigned int x, unsigned int y) { return &Texels[((size_t)y * Width + x) * 4]; }
+	};
+
+	bool IsColor(MipContent content, unsigned int channel)
+	{
+		return content != MipContentLinear && channel < 3;
+	}
+
+	double Decode(MipContent content, unsigned int channel, unsigned char value)
+	{
+		double v = value / 255.0;
+		if (!IsColor(content, channel))
+			return v;
+		if (content == MipContentSRGB)
+			return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+		return v * 2.0 - 1.0;
+	}
+
+	unsigned char Encode(MipContent content, unsigned int channel, double value)
+	{
+		if (IsColor(content, channel))
+		{
+			if (content == MipContentSRGB)
+			{
+				value = std::min(std::max(value, 0.0), 1.0);
+				value = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+			}
+			else
+			{
+				value = value * 0.5 + 0.5;
+			}
+		}
+		value = std::min(std::max(value, 0.0), 1.0);
+		return (unsigned char)(value * 255.0 + 0.5);
+	}
+
+	void Renormalize(double* normal)
+	{
+		double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length > 1e-6)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+				normal[c] /= length;
+		}
+		else
+		{
+			normal[0] = 0.0;
+			normal[1] = 0.0;
+			normal[2] = 1.0;
+		}
+	}
+
+	void ToBytes(Reference& reference, unsigned int channels, MipContent content, TextureImage& image)
+	{
+		image.Allocate(reference.Width, reference.Height, channels);
+		for (unsigned int y = 0; y < image.Height; y++)
+		{
+			for (unsigned int x = 0; x < image.Width; x++)
+			{
+				for (unsigned int c = 0; c < channels; c++)
+					image.GetPixel(x, y)[c] = Encode(content, c, reference.GetTexel(x, y)[c]);
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// The whole box filtered chain, each level the plain 2x2
+	// (or 2x1) average of the one above in filtering space
+	// --------------------------------------------------------
+	void BuildReference(const TextureImage& image, MipContent content, std::vector<TextureImage>& levels)
+	{
+		Reference current = { image.Width, image.Height, std::vector<double>((size_t)image.Width * image.Height * 4, 0.0) };
+		for (unsigned int y = 0; y < image.Height; y++)
+		{
+			for (unsigned int x = 0; x < image.Width; x++)
+			{
+				double* texel = current.GetTexel(x, y);
+				for (unsigned int c = 0; c < image.Channels; c++)
+					texel[c] = Decode(content, c, image.GetPixel(x, y)[c]);
+				if (content == MipContentNormals && image.Channels < 3)
+					texel[2] = std::sqrt(std::max(0.0, 1.0 - texel[0] * texel[0] - texel[1] * texel[1]));
+			}
+		}
+
+		levels.clear();
+		levels.push_back(image);
+		while (current.Width > 1 || current.Height > 1)
+		{
+			unsigned int stepX = current.Width > 1 ? 2 : 1;
+			unsigned int stepY = current.Height > 1 ? 2 : 1;
+			Reference next = { current.Width / stepX, current.Height / stepY, {} };
+			next.Texels.assign((size_t)next.Width * next.Height * 4, 0.0);
+			for (unsigned int y = 0; y < next.Height; y++)
+			{
+				for (unsigned int x = 0; x < next.Width; x++)
+				{
+					double* texel = next.GetTexel(x, y);
+					for (unsigned int sy = 0; sy < stepY; sy++)
+					{
+						for (unsigned int sx = 0; sx < stepX; sx++)
+						{
+							const double* source = current.GetTexel(x * stepX + sx, y * stepY + sy);
+							for (unsigned int c = 0; c < 4; c++)
+								texel[c] += source[c] / (stepX * stepY);
+						}
+					}
+					if (content == MipContentNormals)
+						Renormalize(texel);
+				}
+			}
+
+			TextureImage level;
+			ToBytes(next, image.Channels, content, level);
+			levels.push_back(level);
+			current = next;
+		}
+	}
+
+	// Largest difference of any byte, or 256 if the shapes differ
+	unsigned int Difference(const TextureImage& a, const TextureImage& b)
+	{
+		if (a.Width != b.Width || a.Height != b.Height || a.Channels != b.Channels)
+			return 256;
+
+		unsigned int largest = 0;
+		for (size_t i = 0; i < a.Pixels.size(); i++)
+			largest = std::max(largest, (unsigned int)std::abs((int)a.Pixels[i] - (int)b.Pixels[i]));
+		return largest;
+	}
+
+	// Unit length to within what 8 bits can hold
+	bool IsUnit(const TextureImage& level)
+	{
+		for (unsigned int y = 0; y < level.Height; y++)
+		{
+			for (unsigned int x = 0; x < level.Width; x++)
+			{
+				const unsigned char* texel = level.GetPixel(x, y);
+				double n[3] = {};
+				for (unsigned int c = 0; c < 3 && c < level.Channels; c++)
+					n[c] = texel[c] / 255.0 * 2.0 - 1.0;
+				if (level.Channels < 3)
+					n[2] = std::sqrt(std::max(0.0, 1.0 - n[0] * n[0] - n[1] * n[1]));
+				if (std::fabs(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) - 1.0) > 0.015)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void RandomImage(std::mt19937& random, MipContent content, TextureImage& image)
+	{
+		unsigned int width = 1u << (random() % 7);
+		unsigned int height = 1u << (random() % 7);
+		unsigned int channels = content == MipContentNormals ? 2 + random() % 3 : 1 + random() % 4;
+		image.Allocate(width, height, channels);
+
+		//smooth, then noisy, so levels have something to average
+		std::uniform_real_distribution<double> angle(0.0, 6.2831853);
+		double phase = angle(random);
+		for (unsigned int y = 0; y < height; y++)
+		{
+			for (unsigned int x = 0; x < width; x++)
+			{
+				unsigned char* texel = image.GetPixel(x, y);
+				if (content == MipContentNormals)
+				{
+					//within 60 degrees of straight up
+					double theta = angle(random) / 6.0;
+					double around = phase + x * 0.3 + angle(random) * 0.2;
+					double n[3] = { std::sin(theta) * std::cos(around), std::sin(theta) * std::sin(around), std::cos(theta) };
+					for (unsigned int c = 0; c < 3 && c < channels; c++)
+						texel[c] = (unsigned char)((n[c] * 0.5 + 0.5) * 255.0 + 0.5);
+					if (channels == 4)
+						texel[3] = (unsigned char)(random() % 256);
+					continue;
+				}
+				for (unsigned int c = 0; c < channels; c++)
+				{
+					double smooth = 0.5 + 0.4 * std::sin(phase + c + x * 0.2 + y * 0.13);
+					texel[c] = (unsigned char)std::min(255.0, std::max(0.0, smooth * 255.0 + (double)(random() % 41) - 20.0));
+				}
+			}
+		}
+	}
+
+	void CheckAgainstReference(std::mt19937& random, unsigned int images)
+	{
+		unsigned int levelsChecked = 0;
+		unsigned int worst[3] = {};
+		for (unsigned int i = 0; i < images; i++)
+		{
+			MipContent content = (MipContent)(i % 3);
+			TextureImage image;
+			RandomImage(random, content, image);
+
+			MipSettings settings;
+			settings.Filter = MipFilterBox;
+			settings.Content = content;
+			settings.Wrap = random() % 2 == 0;
+			std::vector<TextureImage> levels;
+			MipGenerator::Generate(image, levels, settings);
+			std::vector<TextureImage> expected;
+			BuildReference(image, content, expected);
+
+			Expect(levels.size() == expected.size(), "The chain doesn't run down to 1x1");
+			for (size_t l = 0; l < levels.size() && l < expected.size(); l++)
+			{
+				unsigned int difference = Difference(levels[l], expected[l]);
+				worst[content] = std::max(worst[content], difference);
+				if (difference > 1)
+				{
+					fprintf(stderr, "%s %ux%ux%u level %u is %u off the reference\n", contentNames[content], image.Width, image.Height, image.Channels, (unsigned int)l, difference);
+					Expect(false, "A box filtered level isn't within one of the reference");
+				}
+				levelsChecked++;
+			}
+		}
+		printf("%u images, %u levels against the reference: worst %u linear, %u sRGB, %u normals\n", images, levelsChecked, worst[0], worst[1], worst[2]);
+	}
+
+	// Opposite corners of each 2x2 block the same, the other two different
+	TextureImage Checker(unsigned int size, unsigned int channels, const unsigned char* even, const unsigned char* odd)
+	{
+		TextureImage image;
+		image.Allocate(size, size, channels);
+		for (unsigned int y = 0; y < size; y++)
+		{
+			for (unsigned int x = 0; x < size; x++)
+				memcpy(image.GetPixel(x, y), (x + y) % 2 ? odd : even, channels);
+		}
+		return image;
+	}
+
+	bool AllTexels(const TextureImage& level, const unsigned char* value)
+	{
+		for (unsigned int y = 0; y < level.Height; y++)
+		{
+			for (unsigned int x = 0; x < level.Width; x++)
+			{
+				for (unsigned int c = 0; c < level.Channels; c++)
+				{
+					if (std::abs((int)level.GetPixel(x, y)[c] - (int)value[c]) > 1)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void CheckKnownCases()
+	{
+		std::vector<TextureImage> levels;
+		MipSettings settings;
+		settings.Filter = MipFilterBox;
+
+		//half black, half white is half the light, which sRGB stores as 188
+		const unsigned char black[4] = { 0, 0, 0, 0 };
+		const unsigned char white[4] = { 255, 255, 255, 255 };
+		settings.Content = MipContentSRGB;
+		MipGenerator::Generate(Checker(8, 4, black, white), levels, settings);
+		const unsigned char grey[4] = { 188, 188, 188, 128 };
+		for (size_t l = 1; l < levels.size(); l++)
+			Expect(AllTexels(levels[l], grey), "An sRGB checker wasn't averaged in linear light with alpha left linear");
+
+		settings.Content = MipContentLinear;
+		MipGenerator::Generate(Checker(8, 4, black, white), levels, settings);
+		const unsigned char half[4] = { 128, 128, 128, 128 };
+		for (size_t l = 1; l < levels.size(); l++)
+			Expect(AllTexels(levels[l], half), "A data checker wasn't averaged as stored");
+
+		//45 degrees either way about y average to straight up, not to a short vector
+		const unsigned char left[3] = { 37, 128, 218 };
+		const unsigned char right[3] = { 218, 128, 218 };
+		const unsigned char up[3] = { 128, 128, 255 };
+		settings.Content = MipContentNormals;
+		MipGenerator::Generate(Checker(8, 3, left, right), levels, settings);
+		for (size_t l = 1; l < levels.size(); l++)
+			Expect(AllTexels(levels[l], up), "Tilted normals weren't renormalized after averaging");
+		MipGenerator::Generate(Checker(8, 2, left, right), levels, settings);
+		for (size_t l = 1; l < levels.size(); l++)
+			Expect(AllTexels(levels[l], up), "Two channel normals weren't rebuilt and renormalized");
+
+		//normals that cancel out fall back to flat; b and 255 - b decode to opposites
+		const unsigned char sideways[3] = { 255, 127, 128 };
+		const unsigned char opposite[3] = { 0, 128, 127 };
+		MipGenerator::Generate(Checker(4, 3, sideways, opposite), levels, settings);
+		Expect(AllTexels(levels[1], up), "Normals that cancelled out didn't fall back to flat");
+	}
+
+	void CheckEveryKernel(std::mt19937& random, JobSystem& jobs)
+	{
+		const MipFilter filters[] = { MipFilterBox, MipFilterKaiser, MipFilterLanczos };
+		for (MipFilter filter : filters)
+		{
+			for (unsigned int content = 0; content < 3; content++)
+			{
+				for (unsigned int wrap = 0; wrap < 2; wrap++)
+				{
+					MipSettings settings;
+					settings.Filter = filter;
+					settings.Content = (MipContent)content;
+					settings.Wrap = wrap != 0;
+
+					//a flat image stays flat, odd sizes included
+					TextureImage image;
+					image.Allocate(37, 12, 4);
+					unsigned char value[4] = { 200, 90, 230, 77 };
+					for (unsigned int y = 0; y < image.Height; y++)
+					{
+						for (unsigned int x = 0; x < image.Width; x++)
+							memcpy(image.GetPixel(x, y), value, 4);
+					}
+					std::vector<TextureImage> levels;
+					MipGenerator::Generate(image, levels, settings);
+					bool flat = levels.size() == 6 && levels.back().Width == 1 && levels.back().Height == 1;
+					for (const TextureImage& level : levels)
+						flat = flat && AllTexels(level, value);
+					if (content != MipContentNormals)
+						Expect(flat, "A flat image didn't stay flat");
+
+					//every normal a kernel makes is unit length
+					if (content == MipContentNormals)
+					{
+						RandomImage(random, MipContentNormals, image);
+						MipGenerator::Generate(image, levels, settings);
+						bool unit = true;
+						for (const TextureImage& level : levels)
+							unit = unit && IsUnit(level);
+						Expect(unit, "A kernel made normals that aren't unit length");
+					}
+
+					//the same levels when spread over jobs
+					RandomImage(random, (MipContent)content, image);
+					std::vector<TextureImage> jobLevels;
+					MipGenerator::Generate(image, levels, settings);
+					MipGenerator::Generate(image, jobLevels, settings, &jobs);
+					bool same = levels.size() == jobLevels.size();
+					for (size_t l = 0; same && l < levels.size(); l++)
+						same = levels[l].Pixels == jobLevels[l].Pixels;
+					Expect(same, "Jobs gave different levels");
+
+					//one bright column on the left edge reaches the right edge only when wrapping
+					if (filter != MipFilterBox && content == MipContentLinear)
+					{
+						image.Allocate(64, 4, 1);
+						for (unsigned int y = 0; y < image.Height; y++)
+							image.GetPixel(0, y)[0] = 255;
+						MipGenerator::Generate(image, levels, settings);
+						unsigned char across = levels[1].GetPixel(levels[1].Width - 1, 0)[0];
+						Expect(settings.Wrap ? across > 0 : across == 0, settings.Wrap ? "Wrapping didn't filter across the edge" : "Clamping filtered across the edge");
+					}
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int images = 200;
+	if (!ParseCheckOptions(argc, argv, "CheckMipGenerator", { { "-images", &images } }))
+		return 1;
+
+	std::mt19937 random(5);
+	JobSystem jobs(4);
+	CheckAgainstReference(random, images);
+	CheckKnownCases();
+	CheckEveryKernel(random, jobs);
+	return FinishCheck();
+}
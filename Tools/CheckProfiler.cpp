@@ -0,0 +1,116 @@
+// --------------------------------------------------------
+// Checks that Profiler::Capture never returns an event the
+// owning thread overwrote while it was being copied. A
+// thread ends flat scopes as fast as it can, each named for
+// its index, and laps its ring many times a capture, while
+// this thread captures over and over. Every event captured
+// must be whole: the scopes named in turn with no gaps,
+// each beginning after the last ended, inside the window
+// asked for. Then, with the thread stopped, a capture must
+// hold exactly the newest events the ring keeps. Portable
+// C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. CheckProfiler.cpp ../Profiler.cpp -o CheckProfiler
+//   ./CheckProfiler -captures 2000
+// --------------------------------------------------------
+
+#include "../Profiler.h"
+#include "Check.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// A prime count, so names don't repeat with the ring's power of two size
+	const unsigned int nameCount = 61;
+	char nameStorage[nameCount][8];
+	const char* names[nameCount];
+
+	// Index of a scope's name, or nameCount if it isn't one of ours
+	unsigned int NameIndex(const char* name)
+	{
+		return name >= nameStorage[0] && name < nameStorage[0] + sizeof(nameStorage) ? (unsigned int)((name - nameStorage[0]) / 8) : nameCount;
+	}
+
+	// Returns how many events were whole, checking they follow on
+	unsigned int CheckEvents(const std::vector<ProfileEvent>& events, long long since)
+	{
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			const ProfileEvent& event = events[i];
+			Expect(NameIndex(event.Name) < nameCount && event.Depth == 0, "A captured event has a name or depth the thread never wrote");
+			Expect(event.Begin <= event.End && event.End >= since, "A captured event is torn or outside the window");
+			if (i == 0)
+				continue;
+
+			const ProfileEvent& last = events[i - 1];
+			Expect(NameIndex(event.Name) == (NameIndex(last.Name) + 1) % nameCount, "Captured events skip or repeat, so one was overwritten");
+			Expect(event.Begin >= last.End, "A captured event began before the one before it ended");
+		}
+		return (unsigned int)events.size();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int captures = 2000;
+	if (!ParseCheckOptions(argc, argv, "CheckProfiler", { { "-captures", &captures } }))
+		return 1;
+
+	for (unsigned int n = 0; n < nameCount; n++)
+	{
+		snprintf(nameStorage[n], sizeof(nameStorage[n]), "S%u", n);
+		names[n] = nameStorage[n];
+	}
+
+	Profiler& profiler = Profiler::GetInstance();
+	std::atomic<bool> stop(false);
+	std::atomic<bool> started(false);
+	std::atomic<unsigned long long> ended(0);
+	std::thread writer([&]()
+	{
+		profiler.SetThreadName("Writer");
+		started = true;
+		unsigned long long count = 0;
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			ProfileScope scope(names[count % nameCount]);
+			count++;
+		}
+		ended = count;
+	});
+
+	while (!started)
+		std::this_thread::yield();
+
+	//whole windows and recent ones, while the writer laps the ring
+	std::vector<ProfileThreadCapture> threads;
+	unsigned long long events = 0;
+	for (unsigned int c = 0; c < captures; c++)
+	{
+		long long since = c % 2 ? profiler.Now() - 20000 : 0;
+		profiler.Capture(since, threads);
+		Expect(threads.size() == 1, "A capture didn't hold the one thread that opened scopes");
+		for (ProfileThreadCapture& thread : threads)
+			events += CheckEvents(thread.Events, since);
+	}
+	stop = true;
+	writer.join();
+
+	//at rest, the newest events the ring keeps, one slot short of full
+	profiler.Capture(0, threads);
+	bool whole = threads.size() == 1 && threads[0].Name == "Writer";
+	if (whole)
+	{
+		const std::vector<ProfileEvent>& kept = threads[0].Events;
+		unsigned long long total = ended;
+		unsigned long long expected = total < PROFILER_EVENTS_PER_THREAD ? total : PROFILER_EVENTS_PER_THREAD - 1;
+		whole = kept.size() == expected && (kept.empty() || NameIndex(kept.back().Name) == (total - 1) % nameCount);
+		CheckEvents(kept, 0);
+	}
+	Expect(whole, "A capture at rest didn't hold the newest events");
+
+	printf("%u captures: %llu events checked, %llu written\n", captures, events, (unsigned long long)ended);
+	return FinishCheck();
+}
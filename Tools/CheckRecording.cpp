@@ -0,0 +1,227 @@
+// --------------------------------------------------------
+// Checks the device-free halves of multithreaded recording.
+// RecordingPlan::AddPassJobs must cover each pass of a
+// random sorted queue in order, in at most maxJobs jobs of
+// at least minItemsPerJob (bar the last), never splitting
+// a run of one draw state. Then replays frames the way
+// CommandRecorder and SimpleShader drive the constant
+// staging: the immediate context and threads with no
+// recording context draw on slot 0, workers record command
+// lists on their own slots, and the lists execute in order
+// against one shared GPU buffer. Every draw must see the
+// bytes its thread staged, however uploads were skipped.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckRecording.cpp ../RecordingPlan.cpp ../RenderQueue.cpp
+//     ../SimpleShader/SimpleConstantStaging.cpp -o CheckRecording
+//   ./CheckRecording -frames 2000
+// --------------------------------------------------------
+
+#include "../RecordingPlan.h"
+#include "../SimpleShader/SimpleConstantStaging.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const unsigned long long stateMask = ~0xFFFFull;
+
+	void CheckPlan(std::mt19937& random, unsigned int queues)
+	{
+		std::uniform_int_distribution<unsigned int> countOf(0, 3000);
+		std::uniform_int_distribution<unsigned int> stateOf(0, 40);
+		std::uniform_int_distribution<unsigned int> maxJobsOf(0, 12);
+		std::uniform_int_distribution<unsigned int> minItemsOf(0, 200);
+		std::uniform_real_distribution<float> depthOf(0.0f, 1.0f);
+		unsigned int jobTotal = 0;
+		for (unsigned int q = 0; q < queues; q++)
+		{
+			//few states, so long runs that a split mustn't cut
+			RenderQueue queue;
+			unsigned int count = countOf(random);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				unsigned int state = stateOf(random);
+				queue.Add(random() % RENDER_PASS_COUNT, state % 3, state, state % 5, depthOf(random), i);
+			}
+			queue.Sort();
+
+			unsigned int maxJobs = maxJobsOf(random);
+			unsigned int minItems = minItemsOf(random);
+			std::vector<RecordingJob> jobs;
+			jobs.push_back({ 99, 0, 0 });
+			for (unsigned int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+			{
+				unsigned int passCount;
+				queue.GetPassItems(pass, &passCount);
+				unsigned int firstItem = queue.GetPassStart(pass);
+				size_t firstJob = jobs.size();
+				RecordingPlan::AddPassJobs(pass, queue.GetItems(), firstItem, passCount, maxJobs, minItems, jobs);
+
+				unsigned int added = (unsigned int)(jobs.size() - firstJob);
+				Expect(added >= 1, "A pass got no jobs");
+				Expect(added <= (maxJobs > 0 ? maxJobs : 1), "A pass got more than maxJobs jobs");
+				Expect(passCount > 0 || (added == 1 && jobs[firstJob].ItemCount == 0), "An empty pass didn't get one empty job");
+
+				unsigned int next = firstItem;
+				for (size_t j = firstJob; j < jobs.size(); j++)
+				{
+					const RecordingJob& job = jobs[j];
+					Expect(job.Pass == pass, "A job has the wrong pass");
+					Expect(job.FirstItem == next, "Jobs don't follow on from each other");
+					Expect(job.ItemCount > 0 || passCount == 0, "A pass with items got an empty job");
+					Expect(j + 1 == jobs.size() || job.ItemCount >= minItems, "A job other than the last is under minItemsPerJob");
+
+					//a split between jobs falls on a change of state
+					unsigned int end = job.FirstItem + job.ItemCount;
+					if (j + 1 < jobs.size())
+						Expect((queue.GetItems()[end].Key & stateMask) != (queue.GetItems()[end - 1].Key & stateMask), "A job split a run of one draw state");
+					next = end;
+				}
+				Expect(next == firstItem + passCount, "Jobs don't cover the pass");
+				jobTotal += added;
+			}
+			Expect(jobs[0].Pass == 99, "AddPassJobs changed jobs already in the list");
+		}
+		printf("%u queues: %u jobs\n", queues, jobTotal);
+	}
+
+	// --------------------------------------------------------
+	// One constant buffer on the GPU, and the uploads and draws
+	// in a command list that hasn't run yet
+	// --------------------------------------------------------
+	struct CommandList
+	{
+		struct Command
+		{
+			bool Draw;
+			std::vector<unsigned char> Bytes; //uploaded, or what the draw must see
+		};
+		std::vector<Command> Commands;
+	};
+
+	class ImmediateUploader : public ISimpleConstantUploader
+	{
+	public:
+		ImmediateUploader(std::vector<unsigned char>& gpu) : gpu(gpu) {}
+		void Upload(const void* data, unsigned int size) { gpu.assign((const unsigned char*)data, (const unsigned char*)data + size); }
+
+	private:
+		std::vector<unsigned char>& gpu;
+	};
+
+	class DeferredUploader : public ISimpleConstantUploader
+	{
+	public:
+		DeferredUploader(CommandList& list) : list(list) {}
+		void Upload(const void* data, unsigned int size) { list.Commands.push_back({ false, std::vector<unsigned char>((const unsigned char*)data, (const unsigned char*)data + size) }); }
+
+	private:
+		CommandList& list;
+	};
+
+	// SetData then CopyBufferData, as a draw makes them; few values
+	// so data often repeats and uploads are skipped
+	void Stage(SimpleConstantStaging& staging, unsigned int slot, unsigned int generation, ISimpleConstantUploader& uploader, std::mt19937& random)
+	{
+		unsigned int value = random() % 3;
+		staging.Write(slot, (random() % (staging.GetSize() / 4)) * 4, &value, 4);
+		staging.Upload(slot, generation, &uploader);
+	}
+
+	bool Sees(const std::vector<unsigned char>& gpu, SimpleConstantStaging& staging, unsigned int slot)
+	{
+		return gpu.size() == staging.GetSize() && memcmp(gpu.data(), staging.GetData(slot), gpu.size()) == 0;
+	}
+
+	void CheckFrames(std::mt19937& random, unsigned int frames)
+	{
+		const unsigned int workerCount = SIMPLE_SHADER_MAX_RECORDING_SLOTS - 1;
+		SimpleConstantStaging::ResetStats();
+		SimpleConstantStaging staging;
+		staging.Resize(16, SIMPLE_SHADER_MAX_RECORDING_SLOTS);
+		std::vector<unsigned char> gpu;
+		ImmediateUploader immediateUploader(gpu);
+
+		//as SimpleRecordingContext's constructor and Begin take them
+		unsigned int immediateGeneration = SimpleConstantStaging::NextGeneration();
+		std::vector<unsigned int> workerGenerations(workerCount);
+
+		unsigned int draws = 0;
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			//draws on the immediate context, bound or not, in any mix
+			unsigned int immediateDraws = random() % 8;
+			for (unsigned int d = 0; d < immediateDraws; d++)
+			{
+				bool bound = random() % 2 == 0;
+				Stage(staging, 0, bound ? immediateGeneration : SimpleConstantStaging::GetLatestGeneration(), immediateUploader, random);
+				Expect(Sees(gpu, staging, 0), bound ? "A draw on the immediate context saw stale data" : "A draw with no recording context saw stale data");
+				draws++;
+			}
+
+			//workers record jobs w, w + workerCount, ... each into its own list
+			unsigned int jobCount = random() % 12;
+			std::vector<CommandList> lists(jobCount);
+			std::vector<std::vector<unsigned char>> expected;
+			for (unsigned int w = 0; w < workerCount && w < jobCount; w++)
+			{
+				for (unsigned int j = w; j < jobCount; j += workerCount)
+				{
+					workerGenerations[w] = SimpleConstantStaging::NextGeneration();
+					DeferredUploader uploader(lists[j]);
+					unsigned int jobDraws = random() % 6;
+					for (unsigned int d = 0; d < jobDraws; d++)
+					{
+						Stage(staging, w + 1, workerGenerations[w], uploader, random);
+						lists[j].Commands.push_back({ true, std::vector<unsigned char>(staging.GetData(w + 1), staging.GetData(w + 1) + staging.GetSize()) });
+					}
+				}
+			}
+
+			//the main thread may draw with no recording context in between
+			if (random() % 2 == 0)
+			{
+				Stage(staging, 0, SimpleConstantStaging::GetLatestGeneration(), immediateUploader, random);
+				Expect(Sees(gpu, staging, 0), "A draw with no recording context during recording saw stale data");
+				draws++;
+			}
+
+			//Execute runs the lists in job order, then begins the immediate context again
+			if (jobCount > 0)
+			{
+				for (const CommandList& list : lists)
+				{
+					for (const CommandList::Command& command : list.Commands)
+					{
+						if (command.Draw)
+						{
+							Expect(gpu == command.Bytes, "A draw in a command list saw stale data");
+							draws++;
+						}
+						else
+						{
+							gpu = command.Bytes;
+						}
+					}
+				}
+				immediateGeneration = SimpleConstantStaging::NextGeneration();
+			}
+		}
+		printf("%u frames: %u draws, %u uploads skipped\n", frames, draws, (unsigned int)SimpleConstantStaging::UploadsSkipped);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int frames = 2000;
+	if (!ParseCheckOptions(argc, argv, "CheckRecording", { { "-frames", &frames } }))
+		return 1;
+
+	std::mt19937 random(17);
+	CheckPlan(random, frames / 10 + 1);
+	CheckFrames(random, frames);
+	return FinishCheck();
+}
@@ -0,0 +1,240 @@
+// --------------------------------------------------------
+// Checks SimpleShaderReflectionCache with no device. Random
+// reflection data must come back unchanged from Serialize
+// then Deserialize, and every truncated, padded, corrupted
+// or wrong version copy must be rejected or read without
+// running past its bytes. HashBlob must be 64 bit FNV-1a.
+// Find and Store must count hits and misses, keep entries
+// in memory until Clear, and with a directory set, find
+// entries a "later launch" stored and skip broken files.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckReflectionCache.cpp ../SimpleShader/SimpleShaderReflection.cpp -o CheckReflectionCache
+//   ./CheckReflectionCache -shaders 200
+// --------------------------------------------------------
+
+#include "../SimpleShader/SimpleShaderReflection.h"
+#include "Check.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	std::string RandomName(std::mt19937& random)
+	{
+		std::uniform_int_distribution<unsigned int> length(0, 24);
+		std::uniform_int_distribution<unsigned int> letter('a', 'z');
+		std::string name(length(random), ' ');
+		for (char& c : name)
+			c = (char)letter(random);
+		return name;
+	}
+
+	SimpleShaderReflection RandomReflection(std::mt19937& random)
+	{
+		std::uniform_int_distribution<unsigned int> count(0, 6);
+		std::uniform_int_distribution<unsigned int> value(0, 0xFFFFFFFFu);
+
+		SimpleShaderReflection reflection;
+		reflection.ConstantBuffers.resize(count(random));
+		for (SimpleReflectedBuffer& cb : reflection.ConstantBuffers)
+		{
+			cb.Name = RandomName(random);
+			cb.Type = value(random) % 4;
+			cb.Size = value(random);
+			cb.BindIndex = value(random) % 14;
+			cb.Variables.resize(count(random) * 3);
+			for (SimpleReflectedVariable& var : cb.Variables)
+			{
+				var.Name = RandomName(random);
+				var.ByteOffset = value(random);
+				var.Size = value(random);
+			}
+		}
+		reflection.ShaderResourceViews.resize(count(random));
+		for (SimpleReflectedResource& srv : reflection.ShaderResourceViews)
+			srv = { RandomName(random), value(random) % 128 };
+		reflection.Samplers.resize(count(random));
+		for (SimpleReflectedResource& samp : reflection.Samplers)
+			samp = { RandomName(random), value(random) % 16 };
+		reflection.Inputs.resize(count(random));
+		for (SimpleReflectedInput& input : reflection.Inputs)
+		{
+			input.SemanticName = RandomName(random);
+			input.SemanticIndex = value(random) % 8;
+			input.Format = value(random) % 120;
+			input.PerInstance = value(random) % 2 == 1;
+		}
+		return reflection;
+	}
+
+	bool SameResources(const std::vector<SimpleReflectedResource>& a, const std::vector<SimpleReflectedResource>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (a[i].Name != b[i].Name || a[i].BindIndex != b[i].BindIndex)
+				return false;
+		}
+		return true;
+	}
+
+	bool Same(const SimpleShaderReflection& a, const SimpleShaderReflection& b)
+	{
+		if (a.ConstantBuffers.size() != b.ConstantBuffers.size() || a.Inputs.size() != b.Inputs.size())
+			return false;
+		for (size_t i = 0; i < a.ConstantBuffers.size(); i++)
+		{
+			const SimpleReflectedBuffer& x = a.ConstantBuffers[i];
+			const SimpleReflectedBuffer& y = b.ConstantBuffers[i];
+			if (x.Name != y.Name || x.Type != y.Type || x.Size != y.Size || x.BindIndex != y.BindIndex || x.Variables.size() != y.Variables.size())
+				return false;
+			for (size_t v = 0; v < x.Variables.size(); v++)
+			{
+				if (x.Variables[v].Name != y.Variables[v].Name || x.Variables[v].ByteOffset != y.Variables[v].ByteOffset || x.Variables[v].Size != y.Variables[v].Size)
+					return false;
+			}
+		}
+		for (size_t i = 0; i < a.Inputs.size(); i++)
+		{
+			const SimpleReflectedInput& x = a.Inputs[i];
+			const SimpleReflectedInput& y = b.Inputs[i];
+			if (x.SemanticName != y.SemanticName || x.SemanticIndex != y.SemanticIndex || x.Format != y.Format || x.PerInstance != y.PerInstance)
+				return false;
+		}
+		return SameResources(a.ShaderResourceViews, b.ShaderResourceViews) && SameResources(a.Samplers, b.Samplers);
+	}
+
+	// A copy in its own allocation, so reading past it shows up under a sanitizer
+	bool DeserializeCopy(const std::vector<unsigned char>& bytes, size_t size, SimpleShaderReflection& reflection)
+	{
+		std::vector<unsigned char> copy(bytes.begin(), bytes.begin() + size);
+		return SimpleShaderReflectionCache::Deserialize(copy.data(), copy.size(), reflection);
+	}
+
+	void CheckSerializer(std::mt19937& random, unsigned int shaders)
+	{
+		std::uniform_int_distribution<unsigned int> byteOf(0, 255);
+		for (unsigned int s = 0; s < shaders; s++)
+		{
+			SimpleShaderReflection original = RandomReflection(random);
+			std::vector<unsigned char> bytes;
+			SimpleShaderReflectionCache::Serialize(original, bytes);
+
+			SimpleShaderReflection read;
+			Expect(DeserializeCopy(bytes, bytes.size(), read) && Same(original, read), "Serialized reflection didn't read back the same");
+
+			//every truncation fails and leaves the output alone
+			SimpleShaderReflection untouched = RandomReflection(random);
+			SimpleShaderReflection output = untouched;
+			for (size_t size = 0; size < bytes.size(); size++)
+			{
+				if (DeserializeCopy(bytes, size, output))
+				{
+					Expect(false, "Truncated data was accepted");
+					break;
+				}
+			}
+			Expect(Same(output, untouched), "A rejected read changed its output");
+
+			std::vector<unsigned char> padded = bytes;
+			padded.push_back(0);
+			Expect(!DeserializeCopy(padded, padded.size(), output), "Data with trailing bytes was accepted");
+
+			std::vector<unsigned char> versioned = bytes;
+			versioned[4]++;
+			Expect(!DeserializeCopy(versioned, versioned.size(), output), "Data of another version was accepted");
+
+			std::vector<unsigned char> magic = bytes;
+			magic[0]++;
+			Expect(!DeserializeCopy(magic, magic.size(), output), "Data with the wrong magic was accepted");
+
+			//a huge count must be rejected before anything is allocated for it
+			std::vector<unsigned char> counted = bytes;
+			counted[8] = counted[9] = counted[10] = counted[11] = 0xFF;
+			Expect(!DeserializeCopy(counted, counted.size(), output), "A count larger than the data was accepted");
+
+			//corruption may still read, but must stay within the bytes
+			for (unsigned int c = 0; c < 64 && bytes.size() > 8; c++)
+			{
+				std::vector<unsigned char> corrupt = bytes;
+				corrupt[8 + byteOf(random) % (corrupt.size() - 8)] = (unsigned char)byteOf(random);
+				DeserializeCopy(corrupt, corrupt.size(), output);
+			}
+		}
+	}
+
+	void CheckHash()
+	{
+		//published FNV-1a 64 test vectors
+		Expect(SimpleShaderReflectionCache::HashBlob("", 0) == 0xcbf29ce484222325ull, "HashBlob of nothing isn't the FNV-1a offset basis");
+		Expect(SimpleShaderReflectionCache::HashBlob("a", 1) == 0xaf63dc4c8601ec8cull, "HashBlob(\"a\") isn't FNV-1a");
+		Expect(SimpleShaderReflectionCache::HashBlob("foobar", 6) == 0x85944171f73967e8ull, "HashBlob(\"foobar\") isn't FNV-1a");
+
+		unsigned char blob[256];
+		for (unsigned int i = 0; i < sizeof(blob); i++)
+			blob[i] = (unsigned char)i;
+		unsigned long long hash = SimpleShaderReflectionCache::HashBlob(blob, sizeof(blob));
+		blob[100] ^= 1;
+		Expect(SimpleShaderReflectionCache::HashBlob(blob, sizeof(blob)) != hash, "A one bit change kept the hash");
+	}
+
+	void CheckCache(std::mt19937& random)
+	{
+		SimpleShaderReflection stored = RandomReflection(random);
+		SimpleShaderReflection found;
+		unsigned int hits = SimpleShaderReflectionCache::Hits;
+		unsigned int misses = SimpleShaderReflectionCache::Misses;
+
+		//in memory only
+		SimpleShaderReflectionCache::Directory.clear();
+		SimpleShaderReflectionCache::Clear();
+		Expect(!SimpleShaderReflectionCache::Find(1, found), "Found an entry in an empty cache");
+		SimpleShaderReflectionCache::Store(1, stored);
+		Expect(SimpleShaderReflectionCache::Find(1, found) && Same(stored, found), "Didn't find what was stored");
+		Expect(!SimpleShaderReflectionCache::Find(2, found), "Found an entry under another hash");
+		SimpleShaderReflectionCache::Clear();
+		Expect(!SimpleShaderReflectionCache::Find(1, found), "Found an entry after Clear with no directory");
+		Expect(SimpleShaderReflectionCache::Hits == hits + 1 && SimpleShaderReflectionCache::Misses == misses + 3, "Hits and misses weren't counted");
+
+		//on disk, Clear stands in for the next launch
+		std::filesystem::path scratch = std::filesystem::temp_directory_path() / "CheckReflectionCache";
+		std::filesystem::remove_all(scratch);
+		std::filesystem::create_directories(scratch);
+		SimpleShaderReflectionCache::Directory = scratch.generic_string() + "/";
+
+		SimpleShaderReflectionCache::Store(0x1234, stored);
+		SimpleShaderReflectionCache::Clear();
+		Expect(SimpleShaderReflectionCache::Find(0x1234, found) && Same(stored, found), "Didn't find an entry a later launch stored");
+
+		//a broken file is a miss, not a crash or bad data
+		std::string path = SimpleShaderReflectionCache::Directory + "0000000000005678.refl";
+		SimpleShaderReflectionCache::Store(0x5678, stored);
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+		SimpleShaderReflectionCache::Clear();
+		Expect(!SimpleShaderReflectionCache::Find(0x5678, found), "Found an entry in a truncated file");
+		std::ofstream(path, std::ios::binary | std::ios::trunc);
+		Expect(!SimpleShaderReflectionCache::Find(0x5678, found), "Found an entry in an empty file");
+
+		SimpleShaderReflectionCache::Directory.clear();
+		SimpleShaderReflectionCache::Clear();
+		std::filesystem::remove_all(scratch);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int shaders = 200;
+	if (!ParseCheckOptions(argc, argv, "CheckReflectionCache", { { "-shaders", &shaders } }))
+		return 1;
+
+	std::mt19937 random(13);
+	CheckSerializer(random, shaders);
+	CheckHash();
+	CheckCache(random);
+	printf("%u shaders\n", shaders);
+	return FinishCheck();
+}
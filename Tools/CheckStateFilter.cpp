@@ -0,0 +1,247 @@
+// --------------------------------------------------------
+// Checks SimpleStateFilter, the part of SimpleStateTracker
+// that decides which binds to issue, with no device. A
+// model device context applies whatever the filter lets
+// through. After every bind the device must hold what was
+// asked for, and a bind must be filtered exactly when the
+// device is known to hold it already. Binding a render
+// target unbinds that resource's views from the model, as
+// D3D11 does, and code outside the tracker sometimes
+// changes the device then calls Invalidate. Issued and
+// filtered counts must match the model's. Portable C++17,
+// e.g.
+//   g++ -O2 -std=c++17 -I.. CheckStateFilter.cpp ../SimpleShader/SimpleStateFilter.cpp -o CheckStateFilter
+//   ./CheckStateFilter -steps 1000000
+// --------------------------------------------------------
+
+#include "../SimpleShader/SimpleStateFilter.h"
+#include "Check.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Stand-ins for device objects; a view and a target with
+	// the same index are views of the same resource
+	const unsigned int objectCount = 6;
+	char objects[objectCount];
+
+	enum Kind
+	{
+		InputLayout, VertexShader, PixelShader, Rasterizer,
+		VSConstantBuffer, PSConstantBuffer, VSShaderResource, PSShaderResource, VSSampler, PSSampler,
+		DepthStencil, Viewport, RenderTarget, KindCount
+	};
+
+	const unsigned int slotCounts[KindCount] = {
+		1, 1, 1, 1,
+		SIMPLE_STATE_CONSTANT_BUFFER_SLOTS, SIMPLE_STATE_CONSTANT_BUFFER_SLOTS,
+		SIMPLE_STATE_INPUT_RESOURCE_SLOTS, SIMPLE_STATE_INPUT_RESOURCE_SLOTS,
+		SIMPLE_STATE_SAMPLER_SLOTS, SIMPLE_STATE_SAMPLER_SLOTS,
+		1, 1, 1
+	};
+
+	// One piece of device state: an object and a second value
+	// (stencil ref, depth view, or a viewport's index)
+	struct State
+	{
+		const void* Object;
+		unsigned int Extra;
+
+		bool operator==(const State& other) const { return Object == other.Object && Extra == other.Extra; }
+	};
+
+	// --------------------------------------------------------
+	// What a device context holds, and what the filter has
+	// been told since it last forgot, which is when it may
+	// filter a bind
+	// --------------------------------------------------------
+	struct ModelDevice
+	{
+		std::vector<State> bound[KindCount];
+		std::vector<bool> known[KindCount];
+		unsigned int issued = 0;
+		unsigned int filtered = 0;
+
+		ModelDevice()
+		{
+			for (unsigned int k = 0; k < KindCount; k++)
+			{
+				bound[k].assign(slotCounts[k], State{ 0, 0 });
+				known[k].assign(slotCounts[k], false);
+			}
+		}
+
+		void Forget()
+		{
+			for (unsigned int k = 0; k < KindCount; k++)
+				known[k].assign(slotCounts[k], false);
+		}
+
+		// Binding a target as an output unbinds its views
+		void UnbindViewsOf(const void* target)
+		{
+			for (unsigned int k = VSShaderResource; k <= PSShaderResource; k++)
+			{
+				for (State& view : bound[k])
+				{
+					if (target && view.Object == target)
+						view.Object = 0;
+				}
+				known[k].assign(slotCounts[k], false);
+			}
+		}
+	};
+
+	// A few distinct viewports, and copies of them at other addresses
+	SimpleViewport viewports[3] = {
+		{ 0, 0, 1280, 720, 0, 1 },
+		{ 0, 0, 2048, 2048, 0, 1 },
+		{ 0, 0, 1280, 720, 0, 0.5f },
+	};
+
+	bool Bind(SimpleStateFilter& filter, Kind kind, unsigned int slot, State state)
+	{
+		switch (kind)
+		{
+		case InputLayout: return filter.SetInputLayout(state.Object);
+		case VertexShader: return filter.SetVertexShader(state.Object);
+		case PixelShader: return filter.SetPixelShader(state.Object);
+		case Rasterizer: return filter.SetRasterizerState(state.Object);
+		case VSConstantBuffer: return filter.SetVSConstantBuffer(slot, state.Object);
+		case PSConstantBuffer: return filter.SetPSConstantBuffer(slot, state.Object);
+		case VSShaderResource: return filter.SetVSShaderResource(slot, state.Object);
+		case PSShaderResource: return filter.SetPSShaderResource(slot, state.Object);
+		case VSSampler: return filter.SetVSSampler(slot, state.Object);
+		case PSSampler: return filter.SetPSSampler(slot, state.Object);
+		case DepthStencil: return filter.SetDepthStencilState(state.Object, state.Extra);
+		case Viewport:
+		{
+			//a copy, so only the contents can match
+			SimpleViewport viewport = viewports[state.Extra];
+			return filter.SetViewport(viewport);
+		}
+		case RenderTarget: return filter.SetRenderTarget(state.Object, &objects[state.Extra]);
+		default: return false;
+		}
+	}
+
+	// Binds through the filter, applying what it issues to the device
+	void BindAndCheck(SimpleStateFilter& filter, ModelDevice& device, Kind kind, unsigned int slot, State state)
+	{
+		bool expected = !device.known[kind][slot] || !(device.bound[kind][slot] == state);
+		bool issued = Bind(filter, kind, slot, state);
+		Expect(issued == expected, issued ? "Issued a bind the device already held" : "Filtered a bind the device didn't hold");
+
+		if (issued)
+		{
+			device.bound[kind][slot] = state;
+			device.issued++;
+			if (kind == RenderTarget)
+				device.UnbindViewsOf(state.Object);
+		}
+		else
+		{
+			device.filtered++;
+		}
+		device.known[kind][slot] = true;
+		Expect(device.bound[kind][slot] == state, "The device doesn't hold what was bound");
+	}
+
+	void CheckBasics()
+	{
+		SimpleStateFilter filter;
+		Expect(filter.SetPixelShader(0), "The first bind of null after construction was filtered");
+		Expect(!filter.SetPixelShader(0), "Binding null twice issued twice");
+		Expect(filter.SetPixelShader(&objects[0]) && !filter.SetPixelShader(&objects[0]), "A shader wasn't filtered the second time");
+
+		Expect(filter.SetDepthStencilState(&objects[1], 0), "The first depth stencil bind was filtered");
+		Expect(filter.SetDepthStencilState(&objects[1], 1), "A new stencil ref was filtered");
+		Expect(!filter.SetDepthStencilState(&objects[1], 1), "The same state and stencil ref issued twice");
+
+		//viewports compare by contents
+		SimpleViewport a = viewports[0];
+		SimpleViewport b = viewports[0];
+		Expect(filter.SetViewport(a) && !filter.SetViewport(b), "An equal viewport at another address was issued");
+		b.Width = 1281;
+		Expect(filter.SetViewport(b), "A different viewport was filtered");
+
+		//a new target forgets the views, the same target doesn't
+		Expect(filter.SetPSShaderResource(3, &objects[2]) && !filter.SetPSShaderResource(3, &objects[2]), "A view wasn't filtered the second time");
+		Expect(filter.SetRenderTarget(&objects[2], 0), "The first render target bind was filtered");
+		Expect(filter.SetPSShaderResource(3, &objects[2]), "A view was filtered after its resource was bound as a target");
+		Expect(!filter.SetRenderTarget(&objects[2], 0) && !filter.SetPSShaderResource(3, &objects[2]), "Binding the same target again forgot the views");
+
+		//one slot, or everything
+		Expect(filter.SetVSConstantBuffer(1, &objects[3]) && filter.SetVSConstantBuffer(2, &objects[3]), "New constant buffers were filtered");
+		filter.InvalidateVSConstantBuffer(1);
+		Expect(filter.SetVSConstantBuffer(1, &objects[3]) && !filter.SetVSConstantBuffer(2, &objects[3]), "InvalidateVSConstantBuffer forgot the wrong slot");
+		filter.Invalidate();
+		Expect(filter.SetVSConstantBuffer(2, &objects[3]) && filter.SetPixelShader(&objects[0]), "Invalidate didn't forget everything");
+
+		filter.ResetStats();
+		filter.SetPixelShader(&objects[0]);
+		filter.SetPixelShader(&objects[1]);
+		Expect(filter.GetIssuedCalls() == 1 && filter.GetFilteredCalls() == 1, "ResetStats didn't restart the counts");
+	}
+
+	void CheckRandom(unsigned int steps)
+	{
+		SimpleStateFilter filter;
+		ModelDevice device;
+
+		std::mt19937 random(21);
+		std::uniform_int_distribution<unsigned int> kindOf(0, KindCount - 1);
+		std::uniform_int_distribution<unsigned int> objectOf(0, objectCount);
+		std::uniform_int_distribution<unsigned int> extraOf(0, 2);
+		std::uniform_int_distribution<unsigned int> action(0, 999);
+		for (unsigned int step = 0; step < steps; step++)
+		{
+			unsigned int choice = action(random);
+			if (choice == 0)
+			{
+				//other code binds something directly, then says so
+				Kind kind = (Kind)kindOf(random);
+				unsigned int slot = std::uniform_int_distribution<unsigned int>(0, slotCounts[kind] - 1)(random);
+				device.bound[kind][slot] = State{ &objects[objectOf(random) % objectCount], extraOf(random) };
+				filter.Invalidate();
+				device.Forget();
+				continue;
+			}
+			if (choice == 1)
+			{
+				unsigned int slot = std::uniform_int_distribution<unsigned int>(0, SIMPLE_STATE_CONSTANT_BUFFER_SLOTS - 1)(random);
+				device.bound[VSConstantBuffer][slot] = State{ 0, 0 };
+				filter.InvalidateVSConstantBuffer(slot);
+				device.known[VSConstantBuffer][slot] = false;
+				continue;
+			}
+
+			//few slots and objects, so binds often repeat
+			Kind kind = (Kind)kindOf(random);
+			unsigned int slot = std::uniform_int_distribution<unsigned int>(0, slotCounts[kind] > 4 ? 3 : slotCounts[kind] - 1)(random);
+			unsigned int object = objectOf(random);
+			State state = { object < objectCount ? &objects[object] : 0, 0 };
+			if (kind == DepthStencil || kind == Viewport || kind == RenderTarget)
+				state.Extra = extraOf(random);
+			if (kind == Viewport)
+				state.Object = 0;
+			BindAndCheck(filter, device, kind, slot, state);
+		}
+
+		Expect(filter.GetIssuedCalls() == device.issued && filter.GetFilteredCalls() == device.filtered, "Issued and filtered counts don't match the model's");
+		printf("%u steps: %u issued, %u filtered\n", steps, device.issued, device.filtered);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int steps = 1000000;
+	if (!ParseCheckOptions(argc, argv, "CheckStateFilter", { { "-steps", &steps } }))
+		return 1;
+
+	CheckBasics();
+	CheckRandom(steps);
+	return FinishCheck();
+}
@@ -0,0 +1,121 @@
+// --------------------------------------------------------
+// Checks UploadRing with no device. Random sizes, alignments
+// and capacities go through Allocate and Reset, and every
+// reservation must start aligned, end within the capacity
+// and not overlap any reservation made since the last wrap
+// (those may still be in flight, the ring only tells its
+// owner to discard on a wrap). The ring must wrap on its
+// first reservation and after a Reset, and otherwise only
+// when the next aligned start leaves no room. Portable
+// C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CheckUploadRing.cpp ../UploadRing.cpp -o CheckUploadRing
+//   ./CheckUploadRing -steps 1000000
+// --------------------------------------------------------
+
+#include "../UploadRing.h"
+#include "Check.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Range
+	{
+		unsigned int Start;
+		unsigned int End;
+	};
+
+	void CheckBasics()
+	{
+		//256 byte blocks, as constant buffer offsets need
+		UploadRing ring(1024, 256);
+		bool wrapped = false;
+		Expect(ring.Allocate(100, &wrapped) == 0 && wrapped, "The first reservation didn't start a wrap at 0", "Step", 0);
+		Expect(ring.Allocate(100, &wrapped) == 256 && !wrapped, "The second reservation isn't at the next block", "Step", 1);
+		Expect(ring.Allocate(512, &wrapped) == 512 && !wrapped, "A reservation that just fits didn't fit", "Step", 2);
+		Expect(ring.Allocate(1, &wrapped) == 0 && wrapped, "A full ring didn't wrap", "Step", 3);
+		Expect(ring.Allocate(1024, &wrapped) == 0 && wrapped, "A reservation of the whole capacity didn't wrap", "Step", 4);
+
+		ring.Reset(2048);
+		Expect(ring.GetCapacity() == 2048 && ring.GetHead() == 0, "Reset didn't take the new capacity", "Step", 5);
+		Expect(ring.Allocate(16, &wrapped) == 0 && wrapped, "The first reservation after Reset didn't wrap", "Step", 6);
+
+		//no alignment is the same as byte alignment
+		UploadRing unaligned(10, 0);
+		Expect(unaligned.GetAlignment() == 1, "An alignment of 0 wasn't taken as 1", "Step", 7);
+		unaligned.Allocate(3, &wrapped);
+		Expect(unaligned.Allocate(3, &wrapped) == 3 && !wrapped, "Byte aligned reservations aren't packed", "Step", 8);
+	}
+
+	void CheckRandom(unsigned int steps)
+	{
+		std::mt19937 random(9);
+		const unsigned int alignments[] = { 0, 1, 4, 16, 64, 256 };
+		std::uniform_int_distribution<unsigned int> alignmentOf(0, 5);
+		std::uniform_int_distribution<unsigned int> capacityOf(1, 1 << 16);
+		std::uniform_int_distribution<unsigned int> action(0, 999);
+
+		UploadRing ring(capacityOf(random), alignments[alignmentOf(random)]);
+		std::vector<Range> live;
+		bool mustWrap = true;
+		unsigned int wraps = 0;
+		unsigned long long reserved = 0;
+		for (unsigned int step = 0; step < steps; step++)
+		{
+			if (action(random) == 0)
+			{
+				ring.Reset(capacityOf(random));
+				live.clear();
+				mustWrap = true;
+				continue;
+			}
+
+			//mostly small, sometimes up to the whole ring
+			unsigned int capacity = ring.GetCapacity();
+			unsigned int size = action(random) < 990 ? std::uniform_int_distribution<unsigned int>(0, capacity / 8)(random) : std::uniform_int_distribution<unsigned int>(0, capacity)(random);
+
+			unsigned int alignment = ring.GetAlignment();
+			unsigned int alignedHead = (ring.GetHead() + alignment - 1) / alignment * alignment;
+			bool fits = !mustWrap && alignedHead != 0 && alignedHead <= capacity && size <= capacity - alignedHead;
+
+			bool wrapped = false;
+			unsigned int start = ring.Allocate(size, &wrapped);
+			Expect(start % alignment == 0, "Reservation isn't aligned", "Step", step);
+			Expect(start + size <= capacity, "Reservation runs past the capacity", "Step", step);
+			Expect(wrapped == !fits, fits ? "Wrapped though the reservation fit" : "Didn't wrap though the reservation didn't fit", "Step", step);
+			Expect(!wrapped || start == 0, "A wrap didn't start at 0", "Step", step);
+			Expect(ring.GetHead() == start + size, "Head isn't past the reservation", "Step", step);
+
+			if (wrapped)
+			{
+				live.clear();
+				wraps++;
+			}
+			for (const Range& range : live)
+			{
+				if (size > 0 && start < range.End && range.Start < start + size)
+				{
+					Expect(false, "Reservation overlaps one still in flight", "Step", step);
+					break;
+				}
+			}
+			if (size > 0)
+				live.push_back({ start, start + size });
+			mustWrap = false;
+			reserved += size;
+		}
+		printf("%u steps: %llu bytes reserved over %u wraps\n", steps, reserved, wraps);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int steps = 1000000;
+	if (!ParseCheckOptions(argc, argv, "CheckUploadRing", { { "-steps", &steps } }))
+		return 1;
+
+	CheckBasics();
+	CheckRandom(steps);
+	return FinishCheck();
+}
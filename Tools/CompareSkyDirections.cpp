@@ -0,0 +1,207 @@
+// --------------------------------------------------------
+// Checks that the fullscreen sky samples the same direction
+// as the cube sky at every point of the screen, with no
+// device. For random cameras (position, orientation, field
+// of view, aspect and clip planes) it takes directions in
+// view, projects them as the cube's vertex shader does, then
+// rebuilds each from its screen point as the fullscreen
+// triangle does: the far point at each corner, interpolated
+// linearly like the rasterizer. Prints the largest angle
+// between the two and fails if that's over half a texel
+// of a 2048 cube map. Also checks the triangle covers the
+// screen. Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. CompareSkyDirections.cpp ../SkyProjection.cpp -o CompareSkyDirections
+//   ./CompareSkyDirections -cameras 1000
+// --------------------------------------------------------
+
+#include "../SkyProjection.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	const double pi = 3.14159265358979;
+
+	// Half a texel of a 2048 cube face seen from its centre, in degrees
+	const double toleranceDegrees = 0.5 * 2.0 * std::atan(1.0 / 2048.0) * 180.0 / pi;
+
+	void Normalize(float v[3])
+	{
+		float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		for (unsigned int i = 0; i < 3; i++)
+			v[i] /= length;
+	}
+
+	// XMMatrixLookToLH
+	void LookTo(const float eye[3], const float direction[3], float view[16])
+	{
+		const float up[3] = { 0.0f, 1.0f, 0.0f };
+		float z[3] = { direction[0], direction[1], direction[2] };
+		Normalize(z);
+		float x[3] = { up[1] * z[2] - up[2] * z[1], up[2] * z[0] - up[0] * z[2], up[0] * z[1] - up[1] * z[0] };
+		Normalize(x);
+		float y[3] = { z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2], z[0] * x[1] - z[1] * x[0] };
+
+		float matrix[16] =
+		{
+			x[0], y[0], z[0], 0.0f,
+			x[1], y[1], z[1], 0.0f,
+			x[2], y[2], z[2], 0.0f,
+			-(x[0] * eye[0] + x[1] * eye[1] + x[2] * eye[2]), -(y[0] * eye[0] + y[1] * eye[1] + y[2] * eye[2]), -(z[0] * eye[0] + z[1] * eye[1] + z[2] * eye[2]), 1.0f
+		};
+		memcpy(view, matrix, sizeof(matrix));
+	}
+
+	// XMMatrixPerspectiveFovLH
+	void Perspective(float fovY, float aspect, float nearZ, float farZ, float projection[16])
+	{
+		float height = 1.0f / std::tan(fovY * 0.5f);
+		float range = farZ / (farZ - nearZ);
+		float matrix[16] =
+		{
+			height / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, height, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 1.0f,
+			0.0f, 0.0f, -range * nearZ, 0.0f
+		};
+		memcpy(projection, matrix, sizeof(matrix));
+	}
+
+	// Weights of the triangle's corners at a point, as the rasterizer interpolates with them
+	void GetBarycentrics(const float corners[3][2], const float p[2], float weights[3])
+	{
+		float area = (corners[1][0] - corners[0][0]) * (corners[2][1] - corners[0][1]) - (corners[2][0] - corners[0][0]) * (corners[1][1] - corners[0][1]);
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			const float* a = corners[(i + 1) % 3];
+			const float* b = corners[(i + 2) % 3];
+			weights[i] = ((b[0] - a[0]) * (p[1] - a[1]) - (p[0] - a[0]) * (b[1] - a[1])) / area;
+		}
+	}
+
+	double GetAngleDegrees(const float a[3], const float b[3])
+	{
+		double dot = 0.0, aa = 0.0, bb = 0.0;
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			dot += (double)a[i] * b[i];
+			aa += (double)a[i] * a[i];
+			bb += (double)b[i] * b[i];
+		}
+		double cosine = dot / std::sqrt(aa * bb);
+		cosine = cosine > 1.0 ? 1.0 : (cosine < -1.0 ? -1.0 : cosine);
+		return std::acos(cosine) * 180.0 / pi;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int cameras = 1000;
+	unsigned int directions = 1000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-cameras") == 0 && i + 1 < argc)
+			cameras = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-directions") == 0 && i + 1 < argc)
+			directions = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: CompareSkyDirections [-cameras N] [-directions N]\n");
+			return 1;
+		}
+	}
+
+	//the triangle has to reach every corner of the screen, wound clockwise (negative area with y up)
+	float corners[3][2];
+	for (unsigned int v = 0; v < 3; v++)
+		SkyProjection::GetFullscreenVertex(v, corners[v]);
+	float area = (corners[1][0] - corners[0][0]) * (corners[2][1] - corners[0][1]) - (corners[2][0] - corners[0][0]) * (corners[1][1] - corners[0][1]);
+	bool covers = area < 0.0f;
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		float screenCorner[2] = { c & 1 ? 1.0f : -1.0f, c & 2 ? 1.0f : -1.0f };
+		float weights[3];
+		GetBarycentrics(corners, screenCorner, weights);
+		covers = covers && weights[0] >= 0.0f && weights[1] >= 0.0f && weights[2] >= 0.0f;
+	}
+	printf("Fullscreen triangle covers the screen, clockwise: %s\n", covers ? "yes" : "NO");
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	double worst = 0.0;
+	double total = 0.0;
+	unsigned long long samples = 0;
+	for (unsigned int c = 0; c < cameras; c++)
+	{
+		//the game's own camera first, then anything
+		float eye[3] = { 0.0f, 0.0f, -5.0f };
+		float forward[3] = { 0.0f, 0.0f, 1.0f };
+		float fovY = (float)pi / 3.0f;
+		float aspect = 1280.0f / 720.0f;
+		float nearZ = 0.01f;
+		float farZ = 1000.0f;
+		if (c > 0)
+		{
+			float yaw = unit(random) * 2.0f * (float)pi;
+			float pitch = (unit(random) - 0.5f) * 0.98f * (float)pi;
+			for (unsigned int i = 0; i < 3; i++)
+				eye[i] = (unit(random) - 0.5f) * 200.0f;
+			forward[0] = std::cos(pitch) * std::sin(yaw);
+			forward[1] = std::sin(pitch);
+			forward[2] = std::cos(pitch) * std::cos(yaw);
+			fovY = (0.3f + unit(random) * 0.6f) * (float)pi * 0.5f;
+			aspect = 0.5f + unit(random) * 2.0f;
+			nearZ = 0.01f + unit(random) * 0.5f;
+			farZ = 100.0f + unit(random) * 900.0f;
+		}
+
+		float view[16], projection[16], viewProjection[16], inverse[16];
+		LookTo(eye, forward, view);
+		Perspective(fovY, aspect, nearZ, farZ, projection);
+		SkyProjection::GetViewProjection(view, projection, viewProjection);
+		if (!SkyProjection::GetInverseViewProjection(view, projection, inverse))
+		{
+			printf("Camera %u: view-projection can't be inverted\n", c);
+			return 1;
+		}
+
+		//what the fullscreen vertex shader outputs at each corner
+		float cornerDirections[3][3];
+		for (unsigned int v = 0; v < 3; v++)
+			SkyProjection::ReconstructDirection(inverse, corners[v][0], corners[v][1], cornerDirections[v]);
+
+		for (unsigned int d = 0; d < directions; d++)
+		{
+			//a direction anywhere around the camera, kept if the cube path puts it on screen
+			float z = unit(random) * 2.0f - 1.0f;
+			float phi = unit(random) * 2.0f * (float)pi;
+			float r = std::sqrt(1.0f - z * z);
+			float direction[3] = { r * std::cos(phi), r * std::sin(phi), z };
+			float ndc[2];
+			if (!SkyProjection::ProjectDirection(viewProjection, direction, ndc) || std::fabs(ndc[0]) > 1.0f || std::fabs(ndc[1]) > 1.0f)
+				continue;
+
+			float weights[3];
+			float reconstructed[3] = {};
+			GetBarycentrics(corners, ndc, weights);
+			for (unsigned int v = 0; v < 3; v++)
+			{
+				for (unsigned int i = 0; i < 3; i++)
+					reconstructed[i] += cornerDirections[v][i] * weights[v];
+			}
+
+			double angle = GetAngleDegrees(direction, reconstructed);
+			worst = angle > worst ? angle : worst;
+			total += angle;
+			samples++;
+		}
+	}
+
+	bool close = samples > 0 && worst <= toleranceDegrees;
+	printf("Fullscreen vs. cube sky directions, %llu on screen over %u cameras: %.6f deg mean, %.6f deg worst (tolerance %.6f)\n",
+		samples, cameras, samples ? total / samples : 0.0, worst, toleranceDegrees);
+	return covers && close ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+// --------------------------------------------------------
+// Block compresses each material in a PBR asset folder,
+// with full mip chains: <name>_albedo.dds as BC1 (BC7 with
+// -bc7), <name>_surface.dds as BC5 (BC7 when it carries
+// occlusion) and <name>_normals_xy.dds as BC5. The game
+// loads these ahead of the PNGs. Mips are filtered in
+// linear space for albedo and renormalized for normals,
+// with -filter box|kaiser|lanczos (Kaiser by default), and
+// materials are converted in parallel. -benchmark instead
+// goes one material at a time, reporting PSNR and
+// compression speed on one thread and on all of them.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. CompressTextures.cpp ../PngDecoder.cpp ../DdsFile.cpp ../TexturePacker.cpp
+//     ../MipGenerator.cpp ../BlockCompressor.cpp ../JobSystem.cpp ../Profiler.cpp -o CompressTextures
+//   ./CompressTextures ../Assets/PBR -benchmark
+// --------------------------------------------------------
+
+#include "../PngDecoder.h"
+#include "../DdsFile.h"
+#include "../TexturePacker.h"
+#include "../MipGenerator.h"
+#include "../BlockCompressor.h"
+#include "../JobSystem.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Peak signal to noise ratio over the first channels of both images, in dB
+static double MeasurePSNR(const TextureImage& source, const TextureImage& decoded, unsigned int channels)
+{
+	double squaredError = 0.0;
+	for (unsigned int y = 0; y < source.Height; y++)
+	{
+		for (unsigned int x = 0; x < source.Width; x++)
+		{
+			const unsigned char* a = source.GetPixel(x, y);
+			const unsigned char* b = decoded.GetPixel(x, y);
+			for (unsigned int c = 0; c < channels; c++)
+				squaredError += (double)(a[c] - b[c]) * (a[c] - b[c]);
+		}
+	}
+
+	double meanSquaredError = squaredError / ((double)source.Width * source.Height * channels);
+	return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : 99.0;
+}
+
+// Mip chain of the image, each level block compressed
+static bool WriteCompressed(const fs::path& path, const TextureImage& image, BlockFormat format, const MipSettings& mipSettings, JobSystem* jobs, size_t* bytes)
+{
+	std::vector<TextureImage> mips;
+	MipGenerator::Generate(image, mips, mipSettings, jobs);
+
+	std::vector<DdsLevel> levels;
+	for (const TextureImage& mip : mips)
+	{
+		DdsLevel level = { mip.Width, mip.Height, {} };
+		BlockCompressor::Compress(mip, format, level.Data, jobs);
+		*bytes += level.Data.size();
+		levels.push_back(std::move(level));
+	}
+	return DdsFile::Write(path.string(), BlockCompressor::GetDdsFormat(format), levels);
+}
+
+// Quality and speed of one format on the top level of an image, whose
+// first channels are the ones that matter
+static void Benchmark(const char* label, const TextureImage& image, unsigned int channels, BlockFormat format, JobSystem& jobs)
+{
+	std::vector<unsigned char> serial;
+	auto start = std::chrono::steady_clock::now();
+	BlockCompressor::Compress(image, format, serial);
+	double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<unsigned char> parallel;
+	start = std::chrono::steady_clock::now();
+	BlockCompressor::Compress(image, format, parallel, &jobs);
+	double parallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	TextureImage decoded;
+	BlockCompressor::Decompress(parallel.data(), image.Width, image.Height, format, decoded);
+
+	const char* names[] = { "BC1", "BC4", "BC5", "BC7" };
+	double megaTexels = (double)image.Width * image.Height / 1e6;
+	printf("  %-22s %-4s %7.2f dB %9.2f %9.2f MTexel/s%s\n", label, names[format], MeasurePSNR(image, decoded, std::min(channels, decoded.Channels)),
+		megaTexels / serialSeconds, megaTexels / parallelSeconds, serial == parallel ? "" : "  (thread results differ!)");
+}
+
+struct Options
+{
+	bool AlbedoBC7 = false;
+	bool Benchmark = false;
+	MipSettings Mips;
+};
+
+// Writes one material's three DDS files, adding their sizes to bytes
+static void CompressMaterial(const fs::path& directory, const std::string& name, const Options& options, JobSystem* jobs, size_t* bytes, int* failures)
+{
+	MipSettings albedoMips = options.Mips;
+	albedoMips.Content = MipContentSRGB;
+	MipSettings normalMips = options.Mips;
+	normalMips.Content = MipContentNormals;
+
+	TextureImage albedo;
+	if (PngDecoder::Load((directory / (name + "_albedo.png")).string(), albedo))
+	{
+		if (options.Benchmark)
+		{
+			Benchmark((name + " albedo").c_str(), albedo, 3, BlockFormatBC1, *jobs);
+			Benchmark((name + " albedo").c_str(), albedo, 3, BlockFormatBC7, *jobs);
+		}
+		if (!WriteCompressed(directory / (name + "_albedo.dds"), albedo, options.AlbedoBC7 ? BlockFormatBC7 : BlockFormatBC1, albedoMips, jobs, bytes))
+		{
+			fprintf(stderr, "%s: couldn't write the albedo map\n", name.c_str());
+			(*failures)++;
+		}
+	}
+
+	TextureImage roughness;
+	TextureImage metalness;
+	TextureImage occlusion;
+	bool hasRoughness = PngDecoder::Load((directory / (name + "_roughness.png")).string(), roughness);
+	bool hasMetalness = PngDecoder::Load((directory / (name + "_metal.png")).string(), metalness);
+	bool hasOcclusion = PngDecoder::Load((directory / (name + "_ao.png")).string(), occlusion);
+
+	TextureImage surface;
+	if (TexturePacker::PackSurface(hasRoughness ? &roughness : 0, hasMetalness ? &metalness : 0, hasOcclusion ? &occlusion : 0, surface))
+	{
+		//BC5 keeps two channels at BC7's size with better quality; occlusion needs a third
+		BlockFormat format = surface.Channels == 2 ? BlockFormatBC5 : BlockFormatBC7;
+		if (options.Benchmark)
+			Benchmark((name + " surface").c_str(), surface, surface.Channels == 2 ? 2 : 3, format, *jobs);
+		if (!WriteCompressed(directory / (name + "_surface.dds"), surface, format, options.Mips, jobs, bytes))
+		{
+			fprintf(stderr, "%s: couldn't write the surface map\n", name.c_str());
+			(*failures)++;
+		}
+	}
+
+	TextureImage normals;
+	if (PngDecoder::Load((directory / (name + "_normals.png")).string(), normals))
+	{
+		TextureImage packedNormals;
+		TexturePacker::PackNormals(normals, packedNormals);
+		if (options.Benchmark)
+			Benchmark((name + " normals").c_str(), packedNormals, 2, BlockFormatBC5, *jobs);
+		if (!WriteCompressed(directory / (name + "_normals_xy.dds"), packedNormals, BlockFormatBC5, normalMips, jobs, bytes))
+		{
+			fprintf(stderr, "%s: couldn't write the normal map\n", name.c_str());
+			(*failures)++;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	fs::path directory = "Assets/PBR";
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-bc7") == 0)
+			options.AlbedoBC7 = true;
+		else if (strcmp(argv[i], "-benchmark") == 0)
+			options.Benchmark = true;
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			i++;
+			options.Mips.Filter = strcmp(argv[i], "box") == 0 ? MipFilterBox : (strcmp(argv[i], "lanczos") == 0 ? MipFilterLanczos : MipFilterKaiser);
+		}
+		else
+			directory = argv[i];
+	}
+	if (!fs::is_directory(directory))
+	{
+		fprintf(stderr, "Usage: CompressTextures [PBR asset directory] [-bc7] [-filter box|kaiser|lanczos] [-benchmark]\n");
+		return 1;
+	}
+
+	std::vector<std::string> names;
+	const std::string albedoSuffix = "_albedo.png";
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+	{
+		std::string file = entry.path().filename().string();
+		if (file.size() > albedoSuffix.size() && file.compare(file.size() - albedoSuffix.size(), albedoSuffix.size(), albedoSuffix) == 0)
+			names.push_back(file.substr(0, file.size() - albedoSuffix.size()));
+	}
+	std::sort(names.begin(), names.end());
+
+	JobSystem jobs(0);
+	if (options.Benchmark)
+		printf("Threads: %u\n  %-22s %-4s %10s %9s %9s\n", jobs.GetThreadCount(), "Map", "", "PSNR", "1 thread", "All");
+
+	//benchmarks time each map alone, so only plain runs overlap materials
+	std::vector<size_t> bytes(names.size(), 0);
+	std::vector<int> failures(names.size(), 0);
+	JobCounter counter;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (options.Benchmark)
+			CompressMaterial(directory, names[i], options, &jobs, &bytes[i], &failures[i]);
+		else
+			jobs.Run([&, i]() { CompressMaterial(directory, names[i], options, &jobs, &bytes[i], &failures[i]); }, &counter);
+	}
+	jobs.Wait(&counter);
+
+	size_t total = 0;
+	int failureCount = 0;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		printf("%-14s %12zu bytes with mips\n", names[i].c_str(), bytes[i]);
+		total += bytes[i];
+		failureCount += failures[i];
+	}
+
+	printf("%-14s %12zu bytes with mips\n", "Total", total);
+	return failureCount ? 1 : 0;
+}
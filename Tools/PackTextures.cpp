@@ -0,0 +1,129 @@
+// --------------------------------------------------------
+// Packs each material's maps in a PBR asset folder into the
+// layout the pixel shader samples: <name>_surface.dds with
+// roughness, metalness and optional occlusion, and
+// <name>_normals_xy.dds with two channel normals, both with
+// full mip chains. Prints texture memory before and after.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. PackTextures.cpp ../PngDecoder.cpp ../DdsFile.cpp ../TexturePacker.cpp
+//     ../MipGenerator.cpp ../JobSystem.cpp ../Profiler.cpp -o PackTextures
+//   ./PackTextures ../Assets/PBR
+// --------------------------------------------------------
+
+#include "../PngDecoder.h"
+#include "../DdsFile.h"
+#include "../TexturePacker.h"
+#include "../MipGenerator.h"
+#include "../JobSystem.h"
+#include <cstdio>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Bytes per texel the WIC loader uses for a PNG with this many channels:
+// grey loads as R8, everything else expands to RGBA8
+static size_t LoadedTexelBytes(unsigned int sourceChannels)
+{
+	return sourceChannels == 1 ? 1 : 4;
+}
+
+// Loads <directory>/<name>_<suffix>.png, adding its loaded size to bytesBefore
+static bool LoadMap(const fs::path& directory, const std::string& name, const char* suffix, TextureImage& image, size_t* bytesBefore)
+{
+	fs::path path = directory / (name + "_" + suffix + ".png");
+	unsigned int sourceChannels = 0;
+	if (!fs::exists(path) || !PngDecoder::Load(path.string(), image, &sourceChannels))
+		return false;
+
+	*bytesBefore += (size_t)image.Width * image.Height * LoadedTexelBytes(sourceChannels);
+	return true;
+}
+
+// Writes the image's mip chain, adding the top level's size to bytesAfter
+static bool WriteImage(const fs::path& path, const TextureImage& image, const MipSettings& mipSettings, JobSystem* jobs, size_t* bytesAfter)
+{
+	std::vector<TextureImage> mips;
+	MipGenerator::Generate(image, mips, mipSettings, jobs);
+
+	std::vector<DdsLevel> levels;
+	for (const TextureImage& mip : mips)
+		levels.push_back({ mip.Width, mip.Height, mip.Pixels });
+
+	unsigned int format = image.Channels == 2 ? DDS_FORMAT_R8G8_UNORM : DDS_FORMAT_R8G8B8A8_UNORM;
+	*bytesAfter += levels[0].Data.size();
+	return DdsFile::Write(path.string(), format, levels);
+}
+
+int main(int argc, char** argv)
+{
+	fs::path directory = argc > 1 ? argv[1] : "Assets/PBR";
+	if (!fs::is_directory(directory))
+	{
+		fprintf(stderr, "Usage: PackTextures [PBR asset directory]\n");
+		return 1;
+	}
+
+	//every material has an albedo map, which stays as it is
+	std::vector<std::string> names;
+	const std::string albedoSuffix = "_albedo.png";
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+	{
+		std::string file = entry.path().filename().string();
+		if (file.size() > albedoSuffix.size() && file.compare(file.size() - albedoSuffix.size(), albedoSuffix.size(), albedoSuffix) == 0)
+			names.push_back(file.substr(0, file.size() - albedoSuffix.size()));
+	}
+	std::sort(names.begin(), names.end());
+
+	JobSystem jobs(0);
+	MipSettings normalMips;
+	normalMips.Content = MipContentNormals;
+
+	size_t totalBefore = 0;
+	size_t totalAfter = 0;
+	int failures = 0;
+	printf("%-14s %12s %12s %8s\n", "Material", "Before", "After", "Saved");
+	for (const std::string& name : names)
+	{
+		size_t before = 0;
+		size_t after = 0;
+
+		TextureImage roughness;
+		TextureImage metalness;
+		TextureImage occlusion;
+		bool hasRoughness = LoadMap(directory, name, "roughness", roughness, &before);
+		bool hasMetalness = LoadMap(directory, name, "metal", metalness, &before);
+		bool hasOcclusion = LoadMap(directory, name, "ao", occlusion, &before);
+
+		TextureImage surface;
+		if (TexturePacker::PackSurface(hasRoughness ? &roughness : 0, hasMetalness ? &metalness : 0, hasOcclusion ? &occlusion : 0, surface)
+			&& !WriteImage(directory / (name + "_surface.dds"), surface, MipSettings(), &jobs, &after))
+		{
+			fprintf(stderr, "%s: couldn't write the surface map\n", name.c_str());
+			failures++;
+		}
+
+		TextureImage normals;
+		if (LoadMap(directory, name, "normals", normals, &before))
+		{
+			TextureImage packedNormals;
+			TexturePacker::PackNormals(normals, packedNormals);
+			if (!WriteImage(directory / (name + "_normals_xy.dds"), packedNormals, normalMips, &jobs, &after))
+			{
+				fprintf(stderr, "%s: couldn't write the normal map\n", name.c_str());
+				failures++;
+			}
+		}
+
+		printf("%-14s %12zu %12zu %7.1f%%\n", name.c_str(), before, after, before ? 100.0 * (1.0 - (double)after / before) : 0.0);
+		totalBefore += before;
+		totalAfter += after;
+	}
+
+	//mip chains add a third to both sides, so the ratio holds
+	printf("%-14s %12zu %12zu %7.1f%%\n", "Total", totalBefore, totalAfter, totalBefore ? 100.0 * (1.0 - (double)totalAfter / totalBefore) : 0.0);
+	printf("Texture fetches per pixel for these maps: 3 -> 2\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+// --------------------------------------------------------
+// Builds the image based lighting cache of a sky cube map:
+// <name>_irradiance.txt (spherical harmonics for diffuse),
+// <name>_specular.dds (GGX prefiltered, a roughness per mip)
+// and brdf_lut.dds beside it. The game does the same at
+// startup when these are missing or stale, so running this
+// ahead of time only saves that wait. -size, -mips and
+// -samples set the specular cube, -force rebuilds a current
+// cache, and -synthetic N first writes an N sized procedural
+// sky (sun, gradient and ground) to the cube map path, for
+// machines without the sky asset. -benchmark instead times
+// each stage on one thread and on all of them, and measures
+// how far the spherical harmonics are from irradiance
+// integrated over every texel.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. PrefilterEnvironment.cpp ../EnvironmentLighting.cpp ../DdsFile.cpp
+//     ../BlockCompressor.cpp ../JobSystem.cpp ../Profiler.cpp -o PrefilterEnvironment
+//   ./PrefilterEnvironment ../../Assets/Textures/SunnyCubeMap.dds -benchmark
+// --------------------------------------------------------
+
+#include "../EnvironmentLighting.h"
+#include "../DdsFile.h"
+#include "../JobSystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const float pi = 3.14159265358979f;
+
+	struct Options
+	{
+		std::string Path = "SunnyCubeMap.dds";
+		EnvironmentSettings Settings;
+		unsigned int SyntheticSize = 0;
+		bool Force = false;
+		bool Benchmark = false;
+	};
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// A clear sky: blue overhead fading to haze at the horizon, brown ground below and a small bright sun
+	void BuildSyntheticSky(unsigned int size, CubeImage& cube)
+	{
+		float sun[3] = { 0.3f, 0.6f, 0.5f };
+		float sunLength = std::sqrt(sun[0] * sun[0] + sun[1] * sun[1] + sun[2] * sun[2]);
+
+		cube.Allocate(size);
+		for (unsigned int face = 0; face < ENVIRONMENT_FACES; face++)
+		{
+			for (unsigned int y = 0; y < size; y++)
+			{
+				for (unsigned int x = 0; x < size; x++)
+				{
+					float d[3];
+					EnvironmentLighting::GetTexelDirection(face, x, y, size, d);
+					float* texel = cube.GetTexel(face, x, y);
+
+					float up = d[1] > 0.0f ? std::sqrt(d[1]) : 0.0f;
+					float horizon[3] = { 0.8f, 0.85f, 0.9f };
+					float zenith[3] = { 0.15f, 0.35f, 0.8f };
+					float ground[3] = { 0.25f, 0.2f, 0.15f };
+					float sunCos = (d[0] * sun[0] + d[1] * sun[1] + d[2] * sun[2]) / sunLength;
+					float sunLight = sunCos > 0.9995f ? 200.0f : 2.0f * std::pow(sunCos > 0.0f ? sunCos : 0.0f, 64.0f);
+					for (unsigned int c = 0; c < 3; c++)
+					{
+						float sky = horizon[c] + (zenith[c] - horizon[c]) * up;
+						texel[c] = (d[1] >= 0.0f ? sky : ground[c]) + sunLight;
+					}
+					texel[3] = 1.0f;
+				}
+			}
+		}
+	}
+
+	bool WriteCube(const std::string& path, const CubeImage& cube)
+	{
+		std::vector<DdsLevel> faces;
+		for (unsigned int face = 0; face < ENVIRONMENT_FACES; face++)
+		{
+			DdsLevel level = { cube.Size, cube.Size, {} };
+			level.Data.resize((size_t)cube.Size * cube.Size * 16);
+			memcpy(level.Data.data(), cube.GetTexel(face, 0, 0), level.Data.size());
+			faces.push_back(std::move(level));
+		}
+		return DdsFile::WriteCube(path, DDS_FORMAT_R32G32B32A32_FLOAT, faces);
+	}
+
+	// Irradiance over pi facing n, summed over every texel of the cube
+	void IntegrateIrradiance(const CubeImage& cube, const float n[3], float color[3])
+	{
+		double sum[3] = {};
+		double angle = 0.0;
+		for (unsigned int face = 0; face < ENVIRONMENT_FACES; face++)
+		{
+			for (unsigned int y = 0; y < cube.Size; y++)
+			{
+				for (unsigned int x = 0; x < cube.Size; x++)
+				{
+					float d[3];
+					EnvironmentLighting::GetTexelDirection(face, x, y, cube.Size, d);
+					float texelAngle = EnvironmentLighting::GetTexelSolidAngle(x, y, cube.Size);
+					float cosine = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+					angle += texelAngle;
+					if (cosine <= 0.0f)
+						continue;
+
+					const float* texel = cube.GetTexel(face, x, y);
+					for (unsigned int c = 0; c < 3; c++)
+						sum[c] += texel[c] * cosine * texelAngle;
+				}
+			}
+		}
+
+		for (unsigned int c = 0; c < 3; c++)
+			color[c] = (float)(sum[c] * (4.0 * pi / angle) / pi);
+	}
+
+	void Benchmark(const CubeImage& cube, const EnvironmentSettings& settings, JobSystem& jobs)
+	{
+		printf("Threads: %u, cube %u, specular %u x %u mips, %u samples\n  %-22s %9s %9s\n", jobs.GetThreadCount(), cube.Size,
+			settings.SpecularSize, settings.SpecularMips, settings.SpecularSamples, "Stage", "1 thread", "All");
+
+		SHIrradiance serialSH, parallelSH;
+		auto start = std::chrono::steady_clock::now();
+		EnvironmentLighting::ProjectIrradiance(cube, serialSH);
+		double serial = Seconds(start);
+		start = std::chrono::steady_clock::now();
+		EnvironmentLighting::ProjectIrradiance(cube, parallelSH, &jobs);
+		double parallel = Seconds(start);
+		bool same = memcmp(&serialSH, &parallelSH, sizeof(SHIrradiance)) == 0;
+		printf("  %-22s %8.1fms %8.1fms%s\n", "SH projection", serial * 1000.0, parallel * 1000.0, same ? "" : "  (thread results differ!)");
+
+		std::vector<CubeImage> serialLevels, parallelLevels;
+		start = std::chrono::steady_clock::now();
+		EnvironmentLighting::PrefilterSpecular(cube, settings, serialLevels);
+		serial = Seconds(start);
+		start = std::chrono::steady_clock::now();
+		EnvironmentLighting::PrefilterSpecular(cube, settings, parallelLevels, &jobs);
+		parallel = Seconds(start);
+		same = true;
+		for (size_t m = 0; m < serialLevels.size(); m++)
+			same = same && serialLevels[m].Texels == parallelLevels[m].Texels;
+		printf("  %-22s %8.1fms %8.1fms%s\n", "Specular prefilter", serial * 1000.0, parallel * 1000.0, same ? "" : "  (thread results differ!)");
+
+		std::vector<float> serialBrdf, parallelBrdf;
+		start = std::chrono::steady_clock::now();
+		EnvironmentLighting::IntegrateBrdf(settings, serialBrdf);
+		serial = Seconds(start);
+		start = std::chrono::steady_clock::now();
+		EnvironmentLighting::IntegrateBrdf(settings, parallelBrdf, &jobs);
+		parallel = Seconds(start);
+		same = serialBrdf == parallelBrdf;
+		printf("  %-22s %8.1fms %8.1fms%s\n", "BRDF table", serial * 1000.0, parallel * 1000.0, same ? "" : "  (thread results differ!)");
+
+		//normals spread over the sphere by the golden angle
+		const unsigned int normals = 64;
+		double totalError = 0.0;
+		double worstError = 0.0;
+		for (unsigned int i = 0; i < normals; i++)
+		{
+			float z = 1.0f - 2.0f * (i + 0.5f) / normals;
+			float r = std::sqrt(1.0f - z * z);
+			float phi = i * 2.39996323f;
+			float n[3] = { r * std::cos(phi), z, r * std::sin(phi) };
+
+			float exact[3], approximate[3];
+			IntegrateIrradiance(cube, n, exact);
+			EnvironmentLighting::EvaluateIrradiance(parallelSH, n, approximate);
+			double exactLength = std::sqrt(exact[0] * exact[0] + exact[1] * exact[1] + exact[2] * exact[2]);
+			double difference = std::sqrt((exact[0] - approximate[0]) * (exact[0] - approximate[0]) + (exact[1] - approximate[1]) * (exact[1] - approximate[1])
+				+ (exact[2] - approximate[2]) * (exact[2] - approximate[2]));
+			double error = difference / (exactLength > 1e-6 ? exactLength : 1e-6);
+			totalError += error;
+			worstError = error > worstError ? error : worstError;
+		}
+		printf("SH irradiance vs. every texel, %u normals: %.2f%% mean, %.2f%% worst relative error\n", normals,
+			100.0 * totalError / normals, 100.0 * worstError);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-size") == 0 && i + 1 < argc)
+			options.Settings.SpecularSize = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-mips") == 0 && i + 1 < argc)
+			options.Settings.SpecularMips = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-samples") == 0 && i + 1 < argc)
+			options.Settings.SpecularSamples = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-synthetic") == 0 && i + 1 < argc)
+			options.SyntheticSize = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-force") == 0)
+			options.Force = true;
+		else if (strcmp(argv[i], "-benchmark") == 0)
+			options.Benchmark = true;
+		else
+			options.Path = argv[i];
+	}
+
+	//every mip has to be at least a texel
+	const EnvironmentSettings& settings = options.Settings;
+	if (settings.SpecularSize == 0 || settings.SpecularMips == 0 || settings.SpecularSamples == 0 || (settings.SpecularSize >> (settings.SpecularMips - 1)) == 0)
+	{
+		fprintf(stderr, "Usage: PrefilterEnvironment [cube map.dds] [-size N] [-mips N] [-samples N] [-synthetic N] [-force] [-benchmark]\n");
+		return 1;
+	}
+
+	if (options.SyntheticSize)
+	{
+		CubeImage sky;
+		BuildSyntheticSky(options.SyntheticSize, sky);
+		if (!WriteCube(options.Path, sky))
+		{
+			fprintf(stderr, "Couldn't write %s\n", options.Path.c_str());
+			return 1;
+		}
+	}
+
+	JobSystem jobs(0);
+	if (options.Benchmark)
+	{
+		CubeImage cube;
+		if (!EnvironmentLighting::ReadCube(options.Path, cube))
+		{
+			fprintf(stderr, "Couldn't read the cube map %s\n", options.Path.c_str());
+			return 1;
+		}
+		Benchmark(cube, settings, jobs);
+		return 0;
+	}
+
+	//a missing irradiance file marks the whole cache stale
+	if (options.Force)
+		remove(EnvironmentLighting::GetIrradiancePath(options.Path).c_str());
+
+	SHIrradiance irradiance;
+	bool built = false;
+	auto start = std::chrono::steady_clock::now();
+	if (!EnvironmentLighting::LoadOrBuild(options.Path, settings, irradiance, &jobs, &built))
+	{
+		fprintf(stderr, "Couldn't build the lighting of %s\n", options.Path.c_str());
+		return 1;
+	}
+
+	printf("%s %s, %s and %s in %.2fs\n", built ? "Wrote" : "Already current:", EnvironmentLighting::GetIrradiancePath(options.Path).c_str(),
+		EnvironmentLighting::GetSpecularPath(options.Path).c_str(), EnvironmentLighting::GetBrdfPath(options.Path).c_str(), Seconds(start));
+	return 0;
+}
@@ -0,0 +1,351 @@
+// --------------------------------------------------------
+// Runs thousands of headless frames with no device: a
+// random scene moves and changes in an EntityRegistry, its
+// bounds update on the job system, RenderQueueBuilder culls
+// it and fills the queue, and RenderQueueSubmitter issues
+// every pass into NullRenderBackend, alternating plain and
+// instanced frames. Every frame is checked: each shadow
+// pass holds every caster, the opaque pass holds exactly
+// the visible entities the camera sees under their
+// material's sort key, each draw reaches the backend with
+// a shader, vertex and index buffer bound and the bound
+// mesh's index count, draw and instance counts match the
+// queue, and no resources leak. Prints the time each stage
+// takes per frame. Needs DirectXMath, e.g.
+//   g++ -O2 -std=c++17 -pthread -I.. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs
+//     RunHeadlessFrames.cpp ../RenderQueueBuilder.cpp ../RenderQueueSubmitter.cpp ../NullRenderBackend.cpp
+//     ../RenderBindingCache.cpp ../RenderQueue.cpp ../InstanceBatcher.cpp ../EntityRegistry.cpp
+//     ../Transform.cpp ../JobSystem.cpp ../Profiler.cpp -o RunHeadlessFrames
+//   ./RunHeadlessFrames -frames 5000 -entities 2000
+// --------------------------------------------------------
+
+#include "../RenderQueueBuilder.h"
+#include "../RenderQueueSubmitter.h"
+#include "../NullRenderBackend.h"
+#include "../EntityRegistry.h"
+#include "Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	struct Options
+	{
+		unsigned int Frames = 5000;
+		unsigned int Entities = 2000;
+	};
+
+	// Scene content; the last materials are "in the table" and sort as one
+	const unsigned int meshCount = 8;
+	const unsigned int materialCount = 16;
+	const unsigned int shaderCount = 3;
+	const unsigned int tabledMaterials = 4;
+	const float farClip = 100.0f;
+
+	double Seconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	unsigned int RandomFlags(std::mt19937& random)
+	{
+		unsigned int roll = random() % 10;
+		return (roll < 9 ? ENTITY_FLAG_VISIBLE : 0) | (roll < 6 || roll == 9 ? ENTITY_FLAG_CASTS_SHADOW : 0);
+	}
+
+	EntityHandle AddEntity(EntityRegistry& entities, std::mt19937& random, const std::vector<BoundingBox>& meshBounds)
+	{
+		std::uniform_real_distribution<float> place(-80.0f, 80.0f);
+		unsigned int mesh = random() % meshCount;
+		EntityHandle handle = entities.Create(mesh, random() % materialCount, meshBounds[mesh], RandomFlags(random));
+		Transform* transform = entities.GetTransform(handle);
+		transform->SetPosition(place(random), place(random) * 0.1f, place(random));
+		transform->SetRotation(0.0f, place(random), 0.0f);
+		float scale = 0.5f + (random() % 4) * 0.5f;
+		transform->SetScale(scale, scale, scale);
+		return handle;
+	}
+
+	// --------------------------------------------------------
+	// Replays a frame's commands, checking every draw has what
+	// it needs bound. Returns the draws seen.
+	// --------------------------------------------------------
+	unsigned int CheckCommands(NullRenderBackend& backend, const std::vector<unsigned int>& indexCounts, unsigned int frame)
+	{
+		RenderHandle vertexShader = RENDER_HANDLE_NULL;
+		RenderHandle vertexBuffers[2] = { RENDER_HANDLE_NULL, RENDER_HANDLE_NULL };
+		RenderHandle indexBuffer = RENDER_HANDLE_NULL;
+		bool targetBound = false;
+		unsigned int draws = 0;
+		for (const RenderCommand& command : backend.GetCommands())
+		{
+			switch (command.Type)
+			{
+			case RenderCommandSetShader:
+				if (command.Args[0] == RenderStageVertex)
+					vertexShader = command.Args[1];
+				break;
+			case RenderCommandSetVertexBuffer:
+				if (command.Args[0] < 2)
+					vertexBuffers[command.Args[0]] = command.Args[1];
+				break;
+			case RenderCommandSetIndexBuffer:
+				indexBuffer = command.Args[0];
+				break;
+			case RenderCommandSetRenderTarget:
+				targetBound = command.Args[0] != RENDER_HANDLE_NULL || command.Args[1] != RENDER_HANDLE_NULL;
+				break;
+			case RenderCommandDrawIndexed:
+			case RenderCommandDrawIndexedInstanced:
+			{
+				bool instanced = command.Type == RenderCommandDrawIndexedInstanced;
+				Expect(targetBound && vertexShader != RENDER_HANDLE_NULL, "A draw reached the backend with no target or vertex shader", "Frame", frame);
+				Expect(vertexBuffers[0] != RENDER_HANDLE_NULL && (!instanced || vertexBuffers[1] != RENDER_HANDLE_NULL), "A draw reached the backend without its vertex buffers", "Frame", frame);
+				Expect(indexBuffer < indexCounts.size() && indexCounts[indexBuffer] == command.Args[0], "A draw's index count isn't the bound mesh's", "Frame", frame);
+				draws++;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+		return draws;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseCheckOptions(argc, argv, "RunHeadlessFrames", { { "-frames", &options.Frames }, { "-entities", &options.Entities } }))
+		return 1;
+
+	std::shared_ptr<JobSystem> jobSystem = std::make_shared<JobSystem>(0);
+	std::shared_ptr<NullRenderBackend> backend = std::make_shared<NullRenderBackend>();
+	RenderQueueSubmitter submitter(backend);
+	RenderQueueBuilder builder(jobSystem);
+	RenderQueue queue;
+
+	//meshes of different sizes and index counts, keyed by index buffer handle
+	std::mt19937 random(11);
+	std::vector<BoundingBox> meshBounds;
+	std::vector<unsigned int> indexCounts;
+	for (unsigned int m = 0; m < meshCount; m++)
+	{
+		SubmitMesh mesh = {};
+		mesh.IndexCount = 36 * (m + 1);
+		mesh.VertexBuffer = backend->CreateBuffer({ RenderBufferVertex, 24 * 44, false }, 0);
+		mesh.IndexBuffer = backend->CreateBuffer({ RenderBufferIndex, mesh.IndexCount * 4, false }, 0);
+		submitter.AddMesh(mesh);
+		indexCounts.resize(mesh.IndexBuffer + 1, 0);
+		indexCounts[mesh.IndexBuffer] = mesh.IndexCount;
+		float extent = 0.5f + m * 0.25f;
+		meshBounds.push_back(BoundingBox(XMFLOAT3(0, 0, 0), XMFLOAT3(extent, extent, extent)));
+	}
+
+	RenderHandle sampler = backend->CreateSampler(false);
+	for (unsigned int m = 0; m < materialCount; m++)
+	{
+		SubmitMaterial material = {};
+		material.TextureCount = 1 + m % SUBMIT_MATERIAL_TEXTURES;
+		for (unsigned int t = 0; t < material.TextureCount; t++)
+			material.Textures[t] = backend->CreateTexture({ 256, 256, 9, RenderFormatRGBA8, false, true }, 0);
+		material.Sampler = sampler;
+		material.ColorTint = XMFLOAT3(1, 1, 1);
+		submitter.AddMaterial(material);
+	}
+
+	//a shader pair per id, plus the table's after them
+	for (unsigned int s = 0; s <= shaderCount; s++)
+	{
+		SubmitShader shader = {};
+		shader.VertexShader = backend->CreateShader(RenderStageVertex, "vs", 2);
+		shader.InstancedVertexShader = backend->CreateShader(RenderStageVertex, "ivs", 3);
+		shader.PixelShader = backend->CreateShader(RenderStagePixel, "ps", 2);
+		submitter.AddShader(shader);
+	}
+	submitter.SetShadowShaders(backend->CreateShader(RenderStageVertex, "svs", 3), backend->CreateShader(RenderStageVertex, "sivs", 4));
+
+	RenderHandle shadowMaps[SUBMIT_SHADOW_MAPS];
+	for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+		shadowMaps[i] = backend->CreateTexture({ 1024, 1024, 1, RenderFormatR32Typeless, true, true }, 0);
+	submitter.SetTargets(
+		backend->CreateTexture({ 1280, 720, 1, RenderFormatRGBA8, true, false }, 0),
+		backend->CreateTexture({ 1280, 720, 1, RenderFormatDepth24Stencil8, true, false }, 0),
+		shadowMaps, backend->CreateSampler(true));
+
+	std::vector<RenderQueueMaterial> materialKeys(materialCount);
+	for (unsigned int m = 0; m < materialCount; m++)
+	{
+		bool tabled = m >= materialCount - tabledMaterials;
+		materialKeys[m].Shader = tabled ? shaderCount : m % shaderCount;
+		materialKeys[m].Material = tabled ? 0 : m;
+	}
+
+	EntityRegistry entities;
+	std::vector<EntityHandle> handles;
+	for (unsigned int e = 0; e < options.Entities; e++)
+		handles.push_back(AddEntity(entities, random, meshBounds));
+
+	Light light = {};
+	light.Type = LIGHT_TYPE_DIRECTIONAL;
+	light.Direction = XMFLOAT3(0, -1, 0);
+	light.Intensity = 1.0f;
+	XMFLOAT4X4 projection;
+	XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 1280.0f / 720.0f, 0.1f, farClip));
+
+	double boundsSeconds = 0.0;
+	double buildSeconds = 0.0;
+	double submitSeconds = 0.0;
+	unsigned long long totalDraws = 0;
+	unsigned int liveResources = 0;
+	std::vector<unsigned int> expected;
+	std::vector<unsigned int> queued;
+	std::vector<InstanceBatch> batches;
+	for (unsigned int frame = 0; frame < options.Frames; frame++)
+	{
+		//move some entities, and now and then swap one out or change its flags
+		std::uniform_real_distribution<float> nudge(-0.5f, 0.5f);
+		for (unsigned int m = 0; m < handles.size() / 10; m++)
+		{
+			Transform* transform = entities.GetTransform(handles[random() % handles.size()]);
+			transform->MoveAbsolute(nudge(random), 0.0f, nudge(random));
+			transform->Rotate(0.0f, nudge(random), 0.0f);
+		}
+		if (frame % 7 == 0 && !handles.empty())
+		{
+			unsigned int which = random() % (unsigned int)handles.size();
+			entities.Destroy(handles[which]);
+			handles[which] = AddEntity(entities, random, meshBounds);
+			entities.SetFlags(handles[random() % handles.size()], RandomFlags(random));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		JobCounter boundsUpdated;
+		jobSystem->ParallelFor(entities.GetCount(), 256, [&entities](unsigned int begin, unsigned int end)
+		{
+			entities.UpdateBounds(begin, end);
+		}, &boundsUpdated);
+		jobSystem->Wait(&boundsUpdated);
+		boundsSeconds += Seconds(start);
+
+		//orbit the middle of the scene
+		float angle = frame * 0.01f;
+		XMVECTOR eye = XMVectorSet(cosf(angle) * 60.0f, 15.0f, sinf(angle) * 60.0f, 0.0f);
+		XMVECTOR direction = XMVectorSubtract(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), eye);
+		RenderQueueScene scene = {};
+		scene.EntityCount = entities.GetCount();
+		scene.Flags = entities.GetFlags();
+		scene.Meshes = entities.GetMeshes();
+		scene.Materials = entities.GetMaterials();
+		scene.WorldBounds = entities.GetWorldBounds();
+		scene.MaterialKeys = materialKeys.data();
+		XMStoreFloat4x4(&scene.View, XMMatrixLookToLH(eye, direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+		scene.Projection = projection;
+		scene.FarClip = farClip;
+
+		start = std::chrono::steady_clock::now();
+		builder.Build(scene, queue);
+		buildSeconds += Seconds(start);
+
+		SubmitFrame submit = {};
+		submit.View = scene.View;
+		submit.Projection = projection;
+		for (unsigned int i = 0; i < SUBMIT_SHADOW_MAPS; i++)
+			submit.ShadowViews[i] = scene.View;
+		submit.ShadowProjection = projection;
+		submit.Lights = &light;
+		submit.LightCount = 1;
+		submit.Width = 1280;
+		submit.Height = 720;
+		submit.ShadowResolution = 1024;
+		submit.UseInstancing = frame % 2 == 1;
+
+		start = std::chrono::steady_clock::now();
+		backend->BeginFrame();
+		submitter.Submit(queue, entities.GetTransforms(), submit);
+		backend->EndFrame();
+		submitSeconds += Seconds(start);
+
+		//every caster in each shadow pass
+		unsigned int casters = 0;
+		for (unsigned int i : entities.View(ENTITY_FLAG_CASTS_SHADOW))
+		{
+			(void)i;
+			casters++;
+		}
+		for (unsigned int pass = RENDER_PASS_SHADOW_0; pass <= RENDER_PASS_SHADOW_2; pass++)
+		{
+			unsigned int count;
+			queue.GetPassItems(pass, &count);
+			Expect(count == casters, "A shadow pass doesn't hold every caster", "Frame", frame);
+		}
+
+		//the opaque pass holds exactly the visible entities in the frustum
+		BoundingFrustum frustum(XMLoadFloat4x4(&projection));
+		frustum.Transform(frustum, XMMatrixInverse(0, XMLoadFloat4x4(&scene.View)));
+		expected.clear();
+		for (unsigned int i = 0; i < scene.EntityCount; i++)
+		{
+			if ((scene.Flags[i] & ENTITY_FLAG_VISIBLE) && frustum.Intersects(scene.WorldBounds[i]))
+				expected.push_back(i);
+		}
+		unsigned int opaqueCount;
+		const RenderItem* opaque = queue.GetPassItems(RENDER_PASS_OPAQUE, &opaqueCount);
+		queued.clear();
+		for (unsigned int d = 0; d < opaqueCount; d++)
+		{
+			unsigned int entity = opaque[d].EntityIndex;
+			queued.push_back(entity);
+			const RenderQueueMaterial& key = materialKeys[scene.Materials[entity]];
+			Expect(RenderQueue::GetShader(opaque[d].Key) == key.Shader && RenderQueue::GetMaterial(opaque[d].Key) == key.Material, "An opaque draw doesn't sort under its material's key", "Frame", frame);
+			Expect(RenderQueue::GetMesh(opaque[d].Key) == scene.Meshes[entity], "An opaque draw has the wrong mesh", "Frame", frame);
+		}
+		std::sort(queued.begin(), queued.end());
+		Expect(queued == expected, "The opaque pass isn't the visible entities in the frustum", "Frame", frame);
+		Expect(builder.GetVisibleCount() == expected.size(), "GetVisibleCount doesn't match the opaque pass", "Frame", frame);
+		for (unsigned int i = 0; i < scene.EntityCount; i++)
+		{
+			if (builder.IsVisible(i) != std::binary_search(expected.begin(), expected.end(), i) && (scene.Flags[i] & ENTITY_FLAG_VISIBLE))
+			{
+				Expect(false, "IsVisible disagrees with the opaque pass", "Frame", frame);
+				break;
+			}
+		}
+
+		//one draw per item, or per batch when instanced
+		unsigned int expectedDraws = queue.GetCount();
+		if (submit.UseInstancing)
+		{
+			expectedDraws = 0;
+			for (unsigned int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+			{
+				unsigned int count;
+				const RenderItem* items = queue.GetPassItems(pass, &count);
+				batches.clear();
+				InstanceBatcher::BuildBatches(items, count, queue.GetPassStart(pass), batches);
+				expectedDraws += (unsigned int)batches.size();
+			}
+		}
+		RenderBackendStats stats = backend->GetFrameStats();
+		Expect(stats.DrawCalls == expectedDraws, "Draw calls don't match the queue", "Frame", frame);
+		Expect(stats.Instances == queue.GetCount(), "Instances drawn don't match the queue", "Frame", frame);
+		Expect(CheckCommands(*backend, indexCounts, frame) == stats.DrawCalls, "Recorded draws don't match the draw count", "Frame", frame);
+		totalDraws += stats.DrawCalls;
+
+		//the instance buffer is made on the first instanced frame, then only replaced
+		if (frame == 1)
+			liveResources = backend->GetLiveResourceCount();
+		else if (frame > 1)
+			Expect(backend->GetLiveResourceCount() == liveResources, "Resources leaked", "Frame", frame);
+	}
+
+	double frames = options.Frames ? options.Frames : 1;
+	printf("%u frames of %u entities, %llu draws\n  Update bounds %8.3f ms\n  Build queue   %8.3f ms\n  Submit        %8.3f ms\n",
+		options.Frames, options.Entities, totalDraws, boundsSeconds * 1e3 / frames, buildSeconds * 1e3 / frames, submitSeconds * 1e3 / frames);
+	return FinishCheck();
+}
@@ -0,0 +1,269 @@
+// --------------------------------------------------------
+// Runs the texture streaming policy over a simulated scene
+// with no device: a camera loops through a field of objects,
+// each visible object feeds back the mips its material's
+// textures need, and loads land after the time a disk of
+// the given bandwidth takes to read them. Prints, for each
+// budget, how much memory stayed resident, how often draws
+// sampled the mip they asked for, and how much was loaded.
+// Portable C++17, e.g.
+//   g++ -O2 -std=c++17 -I.. SimulateStreaming.cpp ../MipResidency.cpp ../DdsFile.cpp -o SimulateStreaming
+//   ./SimulateStreaming -frames 3600 -bandwidth 400
+// --------------------------------------------------------
+
+#include "../MipResidency.h"
+#include "../DdsFile.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace
+{
+	const float pi = 3.14159265358979f;
+
+	struct Options
+	{
+		unsigned int Frames = 3600;
+		unsigned int Materials = 32;
+		unsigned int TextureSize = 2048;
+		unsigned int Objects = 400;
+		float BandwidthMB = 400.0f;		// Disk reads per second
+		unsigned int LatencyFrames = 2;	// Added to every read
+		unsigned int RetainFrames = MipResidencySettings().RetainFrames;
+		unsigned int BudgetMB = 0;		// 0 sweeps a range of budgets
+	};
+
+	struct SimObject
+	{
+		float X;
+		float Z;
+		float Radius;
+		float UVPerWorldUnit;
+		unsigned int Material;
+	};
+
+	struct SimLoad
+	{
+		MipTransition Load;
+		double DoneFrame;
+	};
+
+	struct SimResult
+	{
+		double PeakMB;
+		double AverageMB;
+		double SharpPercent;		// Texture samples at or finer than requested
+		double MeanDeficit;			// Levels coarser than requested, per sample
+		double AverageBias;
+		unsigned long long Loads;
+		unsigned long long Evictions;
+		double LoadedMB;
+	};
+
+	// Same sequence every run, so budgets are compared on the same scene
+	unsigned int NextRandom(unsigned int& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+
+	float RandomRange(unsigned int& state, float low, float high)
+	{
+		return low + (high - low) * (NextRandom(state) & 0xFFFF) / 65535.0f;
+	}
+
+	std::vector<size_t> GetLevelBytes(unsigned int format, unsigned int size)
+	{
+		std::vector<size_t> levels;
+		for (unsigned int level = size; ; level /= 2)
+		{
+			levels.push_back(DdsFile::GetLevelSize(format, level, level));
+			if (level == 1)
+				break;
+		}
+		return levels;
+	}
+
+	std::vector<SimObject> BuildScene(const Options& options)
+	{
+		unsigned int random = 12345;
+		std::vector<SimObject> objects;
+		for (unsigned int i = 0; i < options.Objects; i++)
+		{
+			SimObject object;
+			object.X = RandomRange(random, -100.0f, 100.0f);
+			object.Z = RandomRange(random, -100.0f, 100.0f);
+			object.Radius = RandomRange(random, 0.5f, 4.0f);
+			object.UVPerWorldUnit = 1.0f / (2.0f * object.Radius); //one repeat of the texture across it
+			object.Material = NextRandom(random) % options.Materials;
+			objects.push_back(object);
+		}
+		return objects;
+	}
+
+	SimResult Simulate(const Options& options, const std::vector<SimObject>& objects, size_t budgetBytes)
+	{
+		MipResidencySettings settings;
+		settings.BudgetBytes = budgetBytes;
+		settings.RetainFrames = options.RetainFrames;
+		MipResidency residency(settings);
+
+		//albedo as BC1, normals and surface as BC5, like Tools/CompressTextures writes
+		std::vector<std::vector<StreamingHandle>> materials(options.Materials);
+		unsigned int formats[] = { DDS_FORMAT_BC1_UNORM, DDS_FORMAT_BC5_UNORM, DDS_FORMAT_BC5_UNORM };
+		for (unsigned int m = 0; m < options.Materials; m++)
+		{
+			for (unsigned int format : formats)
+			{
+				std::vector<size_t> levels = GetLevelBytes(format, options.TextureSize);
+				materials[m].push_back(residency.Register("material", levels, options.TextureSize, options.TextureSize));
+			}
+		}
+
+		//1080p at a 60 degree vertical field of view, like the game's camera
+		float halfFov = pi / 6.0f;
+		float pixelsPerWorldUnit = 540.0f / std::tan(halfFov);
+		double bytesPerFrame = options.BandwidthMB * 1048576.0 / 60.0;
+
+		SimResult result = {};
+		std::deque<SimLoad> inFlight;
+		std::vector<MipTransition> loads;
+		std::vector<MipTransition> evictions;
+		double diskFreeAt = 0.0;
+		double residentSum = 0.0;
+		double biasSum = 0.0;
+		unsigned long long samples = 0;
+		unsigned long long sharp = 0;
+		unsigned long long deficit = 0;
+		for (unsigned int frame = 0; frame < options.Frames; frame++)
+		{
+			//reads that landed, in the order the disk served them
+			while (!inFlight.empty() && inFlight.front().DoneFrame <= frame)
+			{
+				residency.CompleteLoad(inFlight.front().Load, true);
+				inFlight.pop_front();
+			}
+
+			//a loop through the field, weaving in and out so objects come close
+			float t = 2.0f * pi * frame / options.Frames;
+			float pathRadius = 60.0f + 30.0f * std::sin(5.0f * t);
+			float cameraX = pathRadius * std::cos(t);
+			float cameraZ = pathRadius * std::sin(t);
+			float forwardX = -std::sin(t);
+			float forwardZ = std::cos(t);
+
+			for (const SimObject& object : objects)
+			{
+				float toX = object.X - cameraX;
+				float toZ = object.Z - cameraZ;
+				float centerDistance = std::sqrt(toX * toX + toZ * toZ);
+				float along = (toX * forwardX + toZ * forwardZ);
+				bool inside = centerDistance < object.Radius;
+				bool inView = along > 0.0f && std::acos(std::min(along / centerDistance, 1.0f)) < halfFov * 1.8f + object.Radius / centerDistance;
+				if (!inside && (!inView || centerDistance > 300.0f))
+					continue;
+
+				float distance = std::max(centerDistance - object.Radius, 0.0f);
+				for (StreamingHandle texture : materials[object.Material])
+				{
+					float mip = MipResidency::ComputeMip(options.TextureSize, options.TextureSize, object.UVPerWorldUnit, distance, pixelsPerWorldUnit);
+					residency.Request(texture, mip);
+
+					//what the draw samples with what is resident now
+					unsigned int wanted = std::min((unsigned int)mip, residency.GetMipCount(texture) - 1);
+					unsigned int resident = residency.GetResidentMip(texture);
+					samples++;
+					if (resident <= wanted)
+						sharp++;
+					else
+						deficit += resident - wanted;
+				}
+			}
+
+			residency.Update(loads, evictions);
+			for (const MipTransition& load : loads)
+			{
+				size_t bytes = 0;
+				for (unsigned int mip = load.ToMip; mip < load.FromMip; mip++)
+					bytes += DdsFile::GetLevelSize(formats[load.Texture % 3], std::max(options.TextureSize >> mip, 1u), std::max(options.TextureSize >> mip, 1u));
+
+				diskFreeAt = std::max(diskFreeAt, (double)frame) + bytes / bytesPerFrame;
+				inFlight.push_back({ load, std::ceil(diskFreeAt) + options.LatencyFrames });
+			}
+
+			const MipResidencyStats& stats = residency.GetStats();
+			double residentMB = stats.ResidentBytes / 1048576.0;
+			result.PeakMB = std::max(result.PeakMB, residentMB);
+			residentSum += residentMB;
+			biasSum += stats.MipBias;
+		}
+
+		const MipResidencyStats& stats = residency.GetStats();
+		result.AverageMB = residentSum / options.Frames;
+		result.AverageBias = biasSum / options.Frames;
+		result.SharpPercent = samples ? 100.0 * sharp / samples : 100.0;
+		result.MeanDeficit = samples ? (double)deficit / samples : 0.0;
+		result.Loads = stats.Loads;
+		result.Evictions = stats.Evictions;
+		result.LoadedMB = stats.BytesLoaded / 1048576.0;
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		unsigned int value = (unsigned int)atoi(argv[i + 1]);
+		if (strcmp(argv[i], "-frames") == 0 && value)
+			options.Frames = value;
+		else if (strcmp(argv[i], "-materials") == 0 && value)
+			options.Materials = value;
+		else if (strcmp(argv[i], "-size") == 0 && value && (value & (value - 1)) == 0)
+			options.TextureSize = value;
+		else if (strcmp(argv[i], "-objects") == 0 && value)
+			options.Objects = value;
+		else if (strcmp(argv[i], "-bandwidth") == 0 && value)
+			options.BandwidthMB = (float)value;
+		else if (strcmp(argv[i], "-retain") == 0)
+			options.RetainFrames = value;
+		else if (strcmp(argv[i], "-budget") == 0 && value)
+			options.BudgetMB = value;
+		else
+		{
+			fprintf(stderr, "Usage: SimulateStreaming [-frames N] [-materials N] [-size N] [-objects N] [-bandwidth MB/s] [-retain N] [-budget MB]\n");
+			return 1;
+		}
+	}
+
+	//everything resident at every mip, what the game does without streaming
+	size_t fullBytes = 0;
+	unsigned int formats[] = { DDS_FORMAT_BC1_UNORM, DDS_FORMAT_BC5_UNORM, DDS_FORMAT_BC5_UNORM };
+	for (unsigned int format : formats)
+	{
+		for (size_t level : GetLevelBytes(format, options.TextureSize))
+			fullBytes += level * options.Materials;
+	}
+
+	std::vector<SimObject> objects = BuildScene(options);
+	printf("%u materials of 3 %ux%u textures, %u objects, %u frames, %.0f MB/s reads\n", options.Materials, options.TextureSize,
+		options.TextureSize, options.Objects, options.Frames, options.BandwidthMB);
+	printf("Fully resident: %.1f MB\n", fullBytes / 1048576.0);
+	printf("%10s %9s %9s %8s %9s %6s %7s %9s %10s\n", "Budget MB", "Peak MB", "Avg MB", "Sharp", "Deficit", "Bias", "Loads", "Evictions", "Loaded MB");
+
+	std::vector<unsigned int> budgets = { 16, 32, 64, 128, 256 };
+	if (options.BudgetMB)
+		budgets = { options.BudgetMB };
+	for (unsigned int budget : budgets)
+	{
+		SimResult result = Simulate(options, objects, (size_t)budget * 1048576);
+		printf("%10u %9.1f %9.1f %7.1f%% %9.3f %6.2f %7llu %9llu %10.1f\n", budget, result.PeakMB, result.AverageMB, result.SharpPercent,
+			result.MeanDeficit, result.AverageBias, result.Loads, result.Evictions, result.LoadedMB);
+	}
+	return 0;
+}
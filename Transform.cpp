@@ -1,4 +1,6 @@
 #include "Transform.h"
+#include <cmath>
+#include <cfloat>
 
 using namespace DirectX;
 
@@ -8,7 +10,8 @@ Transform::Transform()
 	XMStoreFloat4x4(&worldInverseTransposeMatrix, XMMatrixIdentity());
 	
 	position = XMFLOAT3(0, 0, 0);
-	rotation = XMFLOAT3(0, 0, 0);
+	XMStoreFloat4(&orientation, XMQuaternionIdentity());
+	pitchYawRoll = XMFLOAT3(0, 0, 0);
 	scale = XMFLOAT3(1, 1, 1);
 
 	right = XMFLOAT3(1, 0, 0);
@@ -17,6 +20,7 @@ Transform::Transform()
 
 	isWorldMatrixDirty = false; 
 	isRotated = false;
+	isPitchYawRollDirty = false;
 }
 
 Transform::~Transform() {}
@@ -31,7 +35,17 @@ void Transform::SetRotation(float pitch, float yaw, float roll)
 {
 	isRotated = true;
 	isWorldMatrixDirty = true;
-	rotation = XMFLOAT3(pitch, yaw, roll);
+	isPitchYawRollDirty = false;
+	pitchYawRoll = XMFLOAT3(pitch, yaw, roll);
+	XMStoreFloat4(&orientation, XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+}
+
+void Transform::SetRotation(XMFLOAT4 quaternion)
+{
+	isRotated = true;
+	isWorldMatrixDirty = true;
+	isPitchYawRollDirty = true;
+	XMStoreFloat4(&orientation, XMQuaternionNormalize(XMLoadFloat4(&quaternion)));
 }
 
 void Transform::SetScale(float x, float y, float z)
@@ -47,7 +61,16 @@ XMFLOAT3 Transform::GetPosition()
 
 XMFLOAT3 Transform::GetPitchYawRoll()
 {
-	return rotation;
+	if (isPitchYawRollDirty)
+	{
+		UpdatePitchYawRoll();
+	}
+	return pitchYawRoll;
+}
+
+XMFLOAT4 Transform::GetRotation()
+{
+	return orientation;
 }
 
 XMFLOAT3 Transform::GetScale()
@@ -112,11 +135,10 @@ void Transform::MoveAbsolute(float x, float y, float z)
 
 void Transform::MoveRelative(float x, float y, float z)
 {
-	//convert Euler Angles to Quaternion
-	XMVECTOR rot = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+	isWorldMatrixDirty = true;
 
 	//relative movement to add to position
-	XMVECTOR relVec = XMVector3Rotate(XMVectorSet(x, y, z, 1), rot);
+	XMVECTOR relVec = XMVector3Rotate(XMVectorSet(x, y, z, 0), XMLoadFloat4(&orientation));
 	
 	//updating position
 	XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&position), relVec));
@@ -126,9 +148,23 @@ void Transform::Rotate(float pitch, float yaw, float roll)
 {
 	isRotated = true;
 	isWorldMatrixDirty = true;
-	XMVECTOR rot = XMLoadFloat3(&rotation);
-	rot = XMVectorAdd(rot, XMVectorSet(pitch, yaw, roll, 0.0f));
-	XMStoreFloat3(&rotation, rot);
+	isPitchYawRollDirty = true;
+
+	//pitch and roll are applied in local space (before the current orientation),
+	//yaw is applied about the world up axis (after it). With no roll this matches
+	//accumulating the euler angles, so camera mouse look behaves as before.
+	XMVECTOR rot = XMLoadFloat4(&orientation);
+	if (pitch != 0.0f || roll != 0.0f)
+	{
+		rot = XMQuaternionMultiply(XMQuaternionRotationRollPitchYaw(pitch, 0.0f, roll), rot);
+	}
+	if (yaw != 0.0f)
+	{
+		rot = XMQuaternionMultiply(rot, XMQuaternionRotationNormal(XMVectorSet(0, 1, 0, 0), yaw));
+	}
+
+	//renormalize so float drift does not accumulate over many small rotations
+	XMStoreFloat4(&orientation, XMQuaternionNormalize(rot));
 }
 
 void Transform::Scale(float x, float y, float z)
@@ -142,7 +178,7 @@ void Transform::Scale(float x, float y, float z)
 void Transform::UpdateMatrices()
 {
 	XMMATRIX transMat = XMMatrixTranslationFromVector(XMLoadFloat3(&position));
-	XMMATRIX rotMat = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+	XMMATRIX rotMat = XMMatrixRotationQuaternion(XMLoadFloat4(&orientation));
 	XMMATRIX scaleMat = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
 
 	XMMATRIX world = scaleMat * rotMat * transMat;
@@ -155,8 +191,7 @@ void Transform::UpdateMatrices()
 
 void Transform::UpdateOrientation()
 {
-	//convert Euler Angles to Quaternion
-	XMVECTOR rot = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+	XMVECTOR rot = XMLoadFloat4(&orientation);
 
 	//Update orientation vectors
 	XMStoreFloat3(&right, XMVector3Rotate(XMVectorSet(1, 0, 0,0), rot));
@@ -165,3 +200,27 @@ void Transform::UpdateOrientation()
 
 	isRotated = false;
 }
+
+void Transform::UpdatePitchYawRoll()
+{
+	//extract euler angles matching XMQuaternionRotationRollPitchYaw from the rotation matrix
+	XMFLOAT4X4 rotMat;
+	XMStoreFloat4x4(&rotMat, XMMatrixRotationQuaternion(XMLoadFloat4(&orientation)));
+
+	float cosPitch = sqrtf(rotMat._31 * rotMat._31 + rotMat._33 * rotMat._33);
+	pitchYawRoll.x = atan2f(-rotMat._32, cosPitch);
+
+	if (cosPitch > 16.0f * FLT_EPSILON)
+	{
+		pitchYawRoll.y = atan2f(rotMat._31, rotMat._33);
+		pitchYawRoll.z = atan2f(rotMat._12, rotMat._22);
+	}
+	else
+	{
+		//gimbal lock, fold all of the rotation into roll
+		pitchYawRoll.y = 0.0f;
+		pitchYawRoll.z = atan2f(-rotMat._21, rotMat._11);
+	}
+
+	isPitchYawRollDirty = false;
+}
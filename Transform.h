@@ -6,15 +6,17 @@ class Transform
 public:
 	Transform();
 	~Transform();
-	
+
 	//Setters
 	void SetPosition(float x, float y, float z);
 	void SetRotation(float pitch, float yaw, float roll);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 
 	//Getters
 	DirectX::XMFLOAT3 GetPosition();
-	DirectX::XMFLOAT3 GetPitchYawRoll();
+	DirectX::XMFLOAT3 GetPitchYawRoll(); //derived from the quaternion, meant for UI only
+	DirectX::XMFLOAT4 GetRotation();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
@@ -26,24 +28,27 @@ public:
 	//Transformers
 	void MoveAbsolute(float x, float y, float z);
 	void MoveRelative(float x, float y, float z); //relative to orientation of transform
-	void Rotate(float pitch, float yaw, float roll);
+	void Rotate(float pitch, float yaw, float roll); //pitch and roll about local axes, yaw about world up
 	void Scale(float x, float y, float z);
 
 private:
 	DirectX::XMFLOAT4X4 worldMatrix;
 	DirectX::XMFLOAT4X4 worldInverseTransposeMatrix;
 	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 rotation;
+	DirectX::XMFLOAT4 orientation; //normalized quaternion, source of truth for rotation
+	DirectX::XMFLOAT3 pitchYawRoll; //cached euler angles for GetPitchYawRoll()
 	DirectX::XMFLOAT3 scale;
-	
+
 	DirectX::XMFLOAT3 right;
 	DirectX::XMFLOAT3 up;
 	DirectX::XMFLOAT3 forward;
 
 	bool isWorldMatrixDirty; //true if matrix needs to be updated.
-	bool isRotated; //true if only rotation has been updated.
+	bool isRotated; //true if orientation vectors need to be updated.
+	bool isPitchYawRollDirty; //true if euler angles need to be re-derived.
 
 	void UpdateMatrices();
 	void UpdateOrientation();
+	void UpdatePitchYawRoll();
 };
 
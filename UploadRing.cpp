@@ -0,0 +1,31 @@
+#include "UploadRing.h"
+
+UploadRing::UploadRing(unsigned int capacity, unsigned int alignment)
+{
+	this->alignment = alignment > 0 ? alignment : 1;
+	Reset(capacity);
+}
+
+UploadRing::~UploadRing() {}
+
+unsigned int UploadRing::Allocate(unsigned int size, bool* wrapped)
+{
+	//round the start up to the alignment
+	unsigned int start = (head + alignment - 1) / alignment * alignment;
+
+	//nothing reserved yet, or no room left before the end
+	*wrapped = start == 0 || start > capacity || size > capacity - start;
+	if (*wrapped)
+	{
+		start = 0;
+	}
+
+	head = start + size;
+	return start;
+}
+
+void UploadRing::Reset(unsigned int capacity)
+{
+	this->capacity = capacity;
+	head = 0;
+}
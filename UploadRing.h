@@ -0,0 +1,31 @@
+#pragma once
+
+// --------------------------------------------------------
+// Linear ring allocator handing out aligned byte offsets
+// into an upload buffer. The owner maps its buffer
+// according to the wrapped flag.
+// --------------------------------------------------------
+class UploadRing
+{
+public:
+	UploadRing(unsigned int capacity, unsigned int alignment);
+	~UploadRing();
+
+	//Reserves size bytes and returns their offset. wrapped is set when the
+	//reservation starts over at the beginning, meaning every earlier
+	//reservation may be overwritten (map with discard). size must not
+	//exceed the capacity.
+	unsigned int Allocate(unsigned int size, bool* wrapped);
+
+	//Starts over with a new capacity, the next allocation wraps
+	void Reset(unsigned int capacity);
+
+	unsigned int GetCapacity() { return capacity; }
+	unsigned int GetAlignment() { return alignment; }
+	unsigned int GetHead() { return head; }
+
+private:
+	unsigned int capacity;
+	unsigned int alignment;
+	unsigned int head; //first byte past the last reservation
+};
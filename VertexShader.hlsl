@@ -1,11 +1,9 @@
 #include "ShaderIncludes.hlsli"
 #include "ShaderHelpers.hlsli"
 
-//constant buffer definition
-cbuffer ExternalData : register(b0)
+//constant buffers, grouped by how often they change
+cbuffer PerFrame : register(b0)
 {
-	matrix world;
-    matrix worldInvTranspose;
 	matrix view;
 	matrix projection;
 	
@@ -13,6 +11,13 @@ cbuffer ExternalData : register(b0)
     matrix shadowProjection;
 }
 
+cbuffer PerObject : register(b1)
+{
+	matrix world;
+    matrix worldInvTranspose;
+    uint materialIndex;
+}
+
 VertexToPixel main( VertexShaderInput input )
 {
 	// Set up output struct
@@ -34,5 +39,7 @@ VertexToPixel main( VertexShaderInput input )
         output.posForShadow[i] = mul(mul(shadowProjection, mul(shadowView[i], world)), float4(input.localPosition, 1.0f));
     }
 	
+    output.materialIndex = materialIndex;
+	
 	return output;
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "ShaderIncludes.hlsli"
+#include "ShaderHelpers.hlsli"
+
+//per frame constants only, world matrices and material come from the instance buffer
+cbuffer PerFrame : register(b0)
+{
+	matrix view;
+	matrix projection;
+	
+    matrix shadowView[3];
+    matrix shadowProjection;
+}
+
+VertexToPixel main( VertexShaderInput_Instanced input )
+{
+	// Set up output struct
+	VertexToPixel output;
+
+	matrix wvp = mul(projection, mul(view, input.world));
+	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	output.uv = input.uv;
+	    
+    output.normal = mul((float3x3) input.worldInvTranspose, input.normal);
+
+    output.tangent = mul((float3x3) input.world, input.tangent);
+	
+    output.worldPosition = mul(input.world, float4(input.localPosition, 1)).xyz;
+	
+	// Calculate where this vertex is from the light's point of view
+    for (int i = 0; i < 3; i++)
+    {
+        output.posForShadow[i] = mul(mul(shadowProjection, mul(shadowView[i], input.world)), float4(input.localPosition, 1.0f));
+    }
+	
+    output.materialIndex = input.materialIndex;
+	
+	return output;
+}
\ No newline at end of file
@@ -1,13 +1,20 @@
 #include "ShaderIncludes.hlsli"
 #include "ShaderHelpers.hlsli"
 
-cbuffer externalData : register(b0)
+cbuffer PerFrame : register(b0)
 {
-    matrix world;
     matrix view;
     matrix projection;
 };
 
+//same layout as the main vertex shader so object blocks can be shared
+cbuffer PerObject : register(b1)
+{
+    matrix world;
+    matrix worldInvTranspose;
+    uint materialIndex;
+};
+
 VertexToPixel_Shadow main(VertexShaderInput input)
 {
     VertexToPixel_Shadow output;
@@ -0,0 +1,18 @@
+#include "ShaderIncludes.hlsli"
+#include "ShaderHelpers.hlsli"
+
+cbuffer PerFrame : register(b0)
+{
+    matrix view;
+    matrix projection;
+};
+
+VertexToPixel_Shadow main(VertexShaderInput_Instanced input)
+{
+    VertexToPixel_Shadow output;
+    
+    matrix wvp = mul(projection, mul(view, input.world));
+    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "ShaderIncludes.hlsli"
+
+//constant buffer definition
+cbuffer ExternalData : register(b0)
+{
+    matrix inverseViewProjection; //of the view without translation, see SkyProjection
+}
+
+//one triangle over the whole screen, its corners from the vertex id alone, so nothing is bound to the input assembler
+VertexToPixel_Sky main(uint vertexId : SV_VertexID)
+{
+    VertexToPixel_Sky output;
+
+    float2 corner = float2((vertexId << 1) & 2, vertexId & 2);
+    float2 ndc = corner * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+
+    //on the far plane, so pixels already covered fail the depth test before shading
+    output.screenPosition = float4(ndc, 1.0f, 1.0f);
+
+    //back through the camera onto the far plane. Left undivided: w is the same across the plane
+    //for a perspective projection, so xyz already points the right way and interpolates linearly
+    //over the screen, while w itself is a near cancellation that would skew each corner differently
+    float4 farPoint = mul(inverseViewProjection, float4(ndc, 1.0f, 1.0f));
+    output.sampleDir = farPoint.xyz;
+
+    return output;
+}